@@ -117,6 +117,8 @@
 #define MOD_CFG_MAP_SHADOW_ALPHA      "SHADOW_ALPHA"
 #define MOD_CFG_MAP_SHOWTRACKS        "SHOWTRACKS"
 #define MOD_CFG_MAP_HIDECOVS          "HIDECOVS"
+#define MOD_CFG_MAP_ROUTE_BY_SKR      "ROUTE_BY_SKR"    /* live path by largest bottleneck SKR */
+#define MOD_CFG_MAP_BULK_THRESHOLD    "BULK_THRESHOLD"  /* constellation layer above this many sats */
 
 /* polar view specific */
 #define MOD_CFG_POLAR_SECTION          "POLAR"
@@ -168,6 +170,15 @@
 #define MOD_CFG_MAX_PATH_VIEW_REFRESH        "MAX_PATH_VIEW_REFRESH"
 #define MOD_CFG_MAX_PATH_VIEW_FIELDS         "MAX_PATH_VIEW_FIELDS"
 #define MOD_CFG_MAX_PATH_VIEW_SELECT         "MAX_PATH_VIEW_SELECTED"
+#define MOD_CFG_MAX_PATH_VIEW_FIBRE_DIST     "MAX_PATH_VIEW_FIBRE_DISTANCE"
+#define MOD_CFG_MAX_PATH_VIEW_FIBRE_FILE     "MAX_PATH_VIEW_FIBRE_FILE"
+#define MOD_CFG_MAX_PATH_VIEW_VIS_FILE       "MAX_PATH_VIEW_VISIBILITY_FILE"
+#define MOD_CFG_MAX_PATH_VIEW_CN2_FILE       "MAX_PATH_VIEW_CN2_FILE"
+#define MOD_CFG_MAX_PATH_VIEW_WEATHER_CACHE  "MAX_PATH_VIEW_WEATHER_CACHE"
+#define MOD_CFG_MAX_PATH_VIEW_ENSEMBLE       "MAX_PATH_VIEW_ENSEMBLE_MEMBERS"
+#define MOD_CFG_MAX_PATH_VIEW_KEY_TOTALS     "MAX_PATH_VIEW_KEY_BUDGET_FILE"
+#define MOD_CFG_MAX_PATH_VIEW_KEY_SERIES     "MAX_PATH_VIEW_KEY_SERIES_FILE"
+#define MOD_CFG_MAX_PATH_VIEW_KEY_USE        "MAX_PATH_VIEW_KEY_CONSUMPTION"
 
 /* event list */
 #define MOD_CFG_EVENT_LIST_SECTION  "EVENT_LIST"
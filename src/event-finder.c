@@ -0,0 +1,249 @@
+/*
+ * AOS/LOS search by bracketing the horizon crossing and Brent's method.
+ *
+ * The elevation seen from the ground station only depends on the satellite
+ * radius r and the central angle psi between the station and the
+ * sub-satellite point, and it is zero at psi = acos(R / r). psi changes no
+ * faster than the angular rate of the satellite over the rotating Earth,
+ * h / r^2 plus the rotation of the Earth, so a step of the remaining angle to
+ * the horizon over that rate cannot step over a crossing. r is taken as low
+ * as the radial speed lets it get within the step, which matters for
+ * eccentric orbits. Far from the horizon the walk takes long steps, near it
+ * short ones. It stops at the first step whose ends have the wanted sign change,
+ * and Brent's method then solves for the crossing inside that bracket to the
+ * requested resolution.
+ *
+ * Every propagation counts against one budget, so no orbit can keep a search
+ * going forever.
+ */
+#include <float.h>
+#include <math.h>
+
+#include "event-finder.h"
+
+/* Shortest step of the walk; passes shorter than this may be stepped over */
+#define EVENT_MIN_STEP      (1.0 / 1440.0)
+
+/* Margin on the step bound for radial motion and the oblate Earth */
+#define EVENT_SAFETY        0.5
+
+/* Rotation of the Earth, rad/day */
+#define EARTH_RATE          (twopi * 1.00273790934)
+
+typedef struct {
+    sat_t          *sat;
+    geodetic_t      obs;
+    gdouble         h;          /* angular momentum over mass, km^2 rad/day */
+    gdouble         rp;         /* perigee radius, km */
+    gdouble         vr;         /* largest radial speed, km/day */
+    gdouble         radius;     /* of the ground station, km */
+    gdouble         r;          /* of the satellite at the last evaluation, km */
+    guint           evals;
+} event_search_t;
+
+static void search_init(event_search_t * s, sat_t * sat, qth_t * qth)
+{
+    gdouble         n, e, a;
+
+    s->sat = sat;
+    s->obs.lon = qth->lon * de2ra;
+    s->obs.lat = qth->lat * de2ra;
+    s->obs.alt = qth->alt / 1000.0;
+    s->obs.theta = 0;
+    s->evals = 0;
+
+    /* same semi major axis in km as has_aos() */
+    n = twopi * sat->meanmo;
+    e = sat->tle.eo;
+    a = 331.25 * exp(log(1440.0 / sat->meanmo) * (2.0 / 3.0));
+
+    s->h = n * a * a * sqrt(1.0 - e * e);
+    s->rp = a * (1.0 - e);
+    s->vr = n * a * e / sqrt(1.0 - e * e);
+    s->radius = xkmper + s->obs.alt;
+}
+
+/* Elevation in radians at t, without the rest of predict_calc() */
+static gdouble elevation(event_search_t * s, gdouble t)
+{
+    sat_t          *sat = s->sat;
+    obs_set_t       obs_set;
+
+    s->evals++;
+
+    sat->jul_utc = t;
+    sat->tsince = (sat->jul_utc - sat->jul_epoch) * xmnpda;
+
+    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+        SDP4(sat, sat->tsince);
+    else
+        SGP4(sat, sat->tsince);
+
+    Convert_Sat_State(&sat->pos, &sat->vel);
+    Calculate_Obs(sat->jul_utc, &sat->pos, &sat->vel, &s->obs, &obs_set);
+    s->r = sqrt(sat->pos.x * sat->pos.x + sat->pos.y * sat->pos.y +
+                sat->pos.z * sat->pos.z);
+
+    return obs_set.el;
+}
+
+/* Shortest time in which the satellite can get from el to the horizon */
+static gdouble horizon_time(event_search_t * s, gdouble el)
+{
+    gdouble         k, dpsi, dt, rmin;
+
+    /* below the surface after a decay, nothing to go by */
+    k = s->radius / s->r;
+    if (k >= 1.0)
+        return 0.0;
+
+    dpsi = fabs(pio2 - el - asin(k * cos(el)) - acos(k));
+
+    /* time at the current rate, then at the rate of the lowest radius
+       reachable in that time, which is shorter */
+    dt = dpsi / (s->h / (s->r * s->r) + EARTH_RATE);
+    rmin = MAX(s->r - s->vr * dt, s->rp);
+
+    return dpsi / (s->h / (rmin * rmin) + EARTH_RATE);
+}
+
+/*
+ * Zero of the elevation in [a, b], fa and fb of opposite sign. Brent's
+ * method as in Brent (1973), "Algorithms for Minimization without
+ * Derivatives", ch. 4: inverse quadratic or secant steps while they shrink
+ * the bracket fast enough, bisection otherwise.
+ */
+static gdouble brent(event_search_t * s, gdouble a, gdouble fa,
+                     gdouble b, gdouble fb, gdouble tol)
+{
+    gdouble         c = a, fc = fa;
+    gdouble         d = b - a, e = d;
+    gdouble         tol1, xm, p, q, r, sr;
+
+    while (s->evals < EVENT_MAX_EVALS)
+    {
+        if ((fb > 0.0) == (fc > 0.0))
+        {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (fabs(fc) < fabs(fb))
+        {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        tol1 = 2.0 * DBL_EPSILON * fabs(b) + 0.5 * tol;
+        xm = 0.5 * (c - b);
+        if (fabs(xm) <= tol1 || fb == 0.0)
+            break;
+
+        if (fabs(e) >= tol1 && fabs(fa) > fabs(fb))
+        {
+            sr = fb / fa;
+            if (a == c)
+            {
+                /* secant */
+                p = 2.0 * xm * sr;
+                q = 1.0 - sr;
+            }
+            else
+            {
+                /* inverse quadratic interpolation */
+                q = fa / fc;
+                r = fb / fc;
+                p = sr * (2.0 * xm * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (sr - 1.0);
+            }
+            if (p > 0.0)
+                q = -q;
+            p = fabs(p);
+
+            if (2.0 * p < MIN(3.0 * xm * q - fabs(tol1 * q), fabs(e * q)))
+            {
+                e = d;
+                d = p / q;
+            }
+            else
+            {
+                d = xm;
+                e = d;
+            }
+        }
+        else
+        {
+            d = xm;
+            e = d;
+        }
+
+        a = b;
+        fa = fb;
+        b += (fabs(d) > tol1) ? d : (xm > 0.0 ? tol1 : -tol1);
+        fb = elevation(s, b);
+    }
+
+    return b;
+}
+
+static gdouble find_crossing(sat_t * sat, qth_t * qth, gdouble start,
+                             gdouble maxdt, gboolean rising, gdouble tol,
+                             guint * evals)
+{
+    event_search_t  s;
+    gdouble         tend, t0, t1, el0, el1, step;
+    gdouble         event = 0.0;
+
+    if (sat->meanmo <= 0.0)
+    {
+        if (evals != NULL)
+            *evals = 0;
+        return 0.0;
+    }
+
+    search_init(&s, sat, qth);
+    tend = (maxdt > 0.0) ? start + maxdt : G_MAXDOUBLE;
+
+    t0 = start;
+    el0 = elevation(&s, t0);
+
+    while (s.evals < EVENT_MAX_EVALS && t0 <= tend)
+    {
+        step = MAX(EVENT_SAFETY * horizon_time(&s, el0), EVENT_MIN_STEP);
+
+        t1 = t0 + step;
+        el1 = elevation(&s, t1);
+
+        if (rising ? (el0 < 0.0 && el1 >= 0.0) : (el0 > 0.0 && el1 <= 0.0))
+        {
+            event = brent(&s, t0, el0, t1, el1, tol);
+            if (event > tend)
+                event = 0.0;
+            break;
+        }
+
+        t0 = t1;
+        el0 = el1;
+    }
+
+    if (evals != NULL)
+        *evals = s.evals;
+
+    return event;
+}
+
+gdouble event_find_aos(sat_t * sat, qth_t * qth, gdouble start, gdouble maxdt,
+                       gdouble tol, guint * evals)
+{
+    return find_crossing(sat, qth, start, maxdt, TRUE, tol, evals);
+}
+
+gdouble event_find_los(sat_t * sat, qth_t * qth, gdouble start, gdouble maxdt,
+                       gdouble tol, guint * evals)
+{
+    return find_crossing(sat, qth, start, maxdt, FALSE, tol, evals);
+}
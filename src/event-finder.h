@@ -0,0 +1,41 @@
+#ifndef __EVENT_FINDER_H__
+#define __EVENT_FINDER_H__
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Elevation evaluations one search may use before it gives up */
+#define EVENT_MAX_EVALS 2000
+
+/* AOS/LOS times are shown to the second */
+#define EVENT_RESOLUTION (1.0 / 86400.0)
+
+/*
+ * Time of the first AOS (LOS) after start, found to within tol days, or 0.0
+ * when there is none before start + maxdt or the search ran out of its
+ * EVENT_MAX_EVALS budget. maxdt = 0.0 means no time limit. A pass going on
+ * at start is skipped by the AOS search and ended by the LOS search, the
+ * same events find_aos() and find_los() have always returned.
+ *
+ * sat is propagated by the search and left at some time near the event.
+ * evals, if not NULL, is set to the number of orbit propagations used.
+ */
+gdouble event_find_aos(sat_t * sat, qth_t * qth, gdouble start, gdouble maxdt,
+                       gdouble tol, guint * evals);
+gdouble event_find_los(sat_t * sat, qth_t * qth, gdouble start, gdouble maxdt,
+                       gdouble tol, guint * evals);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * Satellites of a module ordered by when their AOS/LOS next needs work.
+ *
+ * The key of a satellite is its earliest AOS or LOS: until then both stay
+ * valid, because they were found as the first events after the time they
+ * were computed at. Each module cycle only pops the satellites whose key has
+ * passed, and at most a budget of them, so the searches are spread over the
+ * cycles instead of all landing on one. Ties are broken by the order the
+ * satellites were last refreshed in, which makes stale satellites go round
+ * robin when the budget cannot take all of them at once.
+ */
+#include "event-finder.h"
+#include "event-queue.h"
+#include "orbit-tools.h"
+
+typedef struct {
+    gdouble         due;        /* module time the entry needs a refresh at */
+    guint64         seq;        /* refresh order, breaks ties on due */
+    gboolean        stale;      /* AOS and LOS are both recomputed */
+    sat_t          *sat;
+} event_entry;
+
+struct event_queue {
+    GArray         *heap;       /* binary min heap of event_entry */
+    guint64         seq;
+};
+
+static gboolean entry_before(const event_entry * a, const event_entry * b)
+{
+    if (a->due != b->due)
+        return a->due < b->due;
+
+    return a->seq < b->seq;
+}
+
+static gint entry_cmp_seq(gconstpointer a, gconstpointer b)
+{
+    const event_entry *ea = a;
+    const event_entry *eb = b;
+
+    return (ea->seq > eb->seq) - (ea->seq < eb->seq);
+}
+
+static void heap_push(event_queue * q, event_entry * e)
+{
+    event_entry    *nodes;
+    guint           i, parent;
+
+    g_array_append_val(q->heap, *e);
+    nodes = (event_entry *) q->heap->data;
+
+    for (i = q->heap->len - 1; i > 0; i = parent)
+    {
+        parent = (i - 1) / 2;
+        if (!entry_before(e, &nodes[parent]))
+            break;
+        nodes[i] = nodes[parent];
+    }
+    nodes[i] = *e;
+}
+
+static void heap_pop(event_queue * q, event_entry * top)
+{
+    event_entry    *nodes;
+    event_entry     last;
+    guint           n, i, child;
+
+    n = q->heap->len - 1;
+    *top = g_array_index(q->heap, event_entry, 0);
+    last = g_array_index(q->heap, event_entry, n);
+    g_array_set_size(q->heap, n);
+
+    if (n == 0)
+        return;
+
+    nodes = (event_entry *) q->heap->data;
+
+    for (i = 0; (child = 2 * i + 1) < n; i = child)
+    {
+        if (child + 1 < n && entry_before(&nodes[child + 1], &nodes[child]))
+            child++;
+        if (!entry_before(&nodes[child], &last))
+            break;
+        nodes[i] = nodes[child];
+    }
+    nodes[i] = last;
+}
+
+/* Recompute what has expired and return the time of the next refresh */
+static gdouble refresh(event_entry * e, qth_t * qth, gdouble now, gdouble maxdt)
+{
+    sat_t          *sat = e->sat;
+
+    /* no events until the location moves or the elements are reloaded */
+    if (!has_aos(sat, qth))
+    {
+        sat->aos = 0.0;
+        sat->los = 0.0;
+        return G_MAXDOUBLE;
+    }
+
+    /* 0.0 means none within maxdt before, so it is searched again too */
+    if (e->stale || sat->aos < now)
+        sat->aos = event_find_aos(sat, qth, now, maxdt, EVENT_RESOLUTION, NULL);
+    if (e->stale || sat->los < now)
+        sat->los = event_find_los(sat, qth, now, maxdt, EVENT_RESOLUTION, NULL);
+
+    if (sat->aos > 0.0 && sat->los > 0.0)
+        return MIN(sat->aos, sat->los);
+    if (sat->aos > 0.0)
+        return sat->aos;
+    if (sat->los > 0.0)
+        return sat->los;
+
+    /* e.g. a parking orbit whose next AOS is beyond maxdt */
+    return now + EVENT_QUEUE_RETRY;
+}
+
+event_queue    *event_queue_new(void)
+{
+    event_queue    *q = g_new0(event_queue, 1);
+
+    q->heap = g_array_new(FALSE, FALSE, sizeof(event_entry));
+
+    return q;
+}
+
+void event_queue_free(event_queue * q)
+{
+    if (q == NULL)
+        return;
+
+    g_array_free(q->heap, TRUE);
+    g_free(q);
+}
+
+void event_queue_add(event_queue * q, sat_t * sat)
+{
+    event_entry     e;
+
+    e.due = -G_MAXDOUBLE;
+    e.seq = q->seq++;
+    e.stale = TRUE;
+    e.sat = sat;
+
+    heap_push(q, &e);
+}
+
+void event_queue_clear(event_queue * q)
+{
+    g_array_set_size(q->heap, 0);
+}
+
+void event_queue_expire_all(event_queue * q)
+{
+    event_entry    *nodes = (event_entry *) q->heap->data;
+    guint           i;
+
+    for (i = 0; i < q->heap->len; i++)
+    {
+        nodes[i].due = -G_MAXDOUBLE;
+        nodes[i].stale = TRUE;
+    }
+
+    /* all due the same now, and an array sorted by seq is a valid heap */
+    g_array_sort(q->heap, entry_cmp_seq);
+}
+
+guint event_queue_update(event_queue * q, qth_t * qth, gdouble now,
+                         gdouble maxdt, guint budget)
+{
+    event_entry     e;
+    guint           done = 0;
+
+    while (done < budget && q->heap->len > 0 &&
+           g_array_index(q->heap, event_entry, 0).due <= now)
+    {
+        heap_pop(q, &e);
+
+        e.due = refresh(&e, qth, now, maxdt);
+        e.seq = q->seq++;
+        e.stale = FALSE;
+        heap_push(q, &e);
+
+        done++;
+    }
+
+    return done;
+}
+
+guint event_queue_due(event_queue * q, gdouble now)
+{
+    guint           i, n = 0;
+
+    for (i = 0; i < q->heap->len; i++)
+        if (g_array_index(q->heap, event_entry, i).due <= now)
+            n++;
+
+    return n;
+}
@@ -0,0 +1,53 @@
+#ifndef __EVENT_QUEUE_H__
+#define __EVENT_QUEUE_H__
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Module time after which a satellite without AOS/LOS is searched again, days */
+#define EVENT_QUEUE_RETRY (1.0 / 1440.0)
+
+typedef struct event_queue event_queue;
+
+event_queue    *event_queue_new(void);
+void            event_queue_free(event_queue * q);
+
+/* Track sat, its AOS and LOS are computed on the next update */
+void            event_queue_add(event_queue * q, sat_t * sat);
+
+/* Forget every satellite, e.g. before they are reloaded */
+void            event_queue_clear(event_queue * q);
+
+/*
+ * Mark the AOS/LOS of every satellite as stale, when the ground station
+ * moved or the module time went backwards. They are recomputed in the
+ * order they were last computed in, so a run of updates with a small budget
+ * gets through all of them.
+ */
+void            event_queue_expire_all(event_queue * q);
+
+/*
+ * Recompute sat->aos and sat->los of satellites whose AOS or LOS is before
+ * now, or that are stale, earliest first and at most budget satellites.
+ * Returns the number of satellites done.
+ */
+guint           event_queue_update(event_queue * q, qth_t * qth, gdouble now,
+                                   gdouble maxdt, guint budget);
+
+/* Number of satellites still due at now */
+guint           event_queue_due(event_queue * q, gdouble now);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
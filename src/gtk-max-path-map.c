@@ -49,6 +49,7 @@
 #include "calc-dist-two-sat.h"
 #include "sat-graph.h"
 #include "qth-data.h"
+#include "range-circle.h"
 
 #include "max-capacity-path/link-capacity-path.h"
 #include "max-capacity-path/satellite-history.h"
@@ -67,6 +68,12 @@ static void     size_allocate_cb(GtkWidget * widget,
                                  GtkAllocation * allocation, gpointer data);
 static void     update_map_size(GtkMaxPathMap * satmap);
 static void     update_sat(gpointer key, gpointer value, gpointer data);
+static gboolean footprint_changed(GtkMaxPathMap * satmap, max_path_map_obj_t * obj,
+                                  sat_t * sat);
+static void     update_sats(GtkMaxPathMap * satmap);
+static void     update_layer(GtkMaxPathMap * satmap);
+static void     set_obj_colour(max_path_map_obj_t * obj, guint32 col);
+static void     set_layer_projection(GtkMaxPathMap * satmap);
 static void     plot_sat(gpointer key, gpointer value, gpointer data);
 static void     free_sat_obj(gpointer key, gpointer value, gpointer data);
 static void     lonlat_to_xy(GtkMaxPathMap * m, gdouble lon, gdouble lat,
@@ -77,6 +84,9 @@ static gboolean on_motion_notify(GooCanvasItem * item, GooCanvasItem * target,
                                  GdkEventMotion * event, gpointer data);
 static void     on_item_created(GooCanvas * canvas, GooCanvasItem * item,
                                 GooCanvasItemModel * model, gpointer data);
+static gboolean on_query_tooltip(GooCanvasItem * item, gdouble x, gdouble y,
+                                 gboolean keyboard_mode, GtkTooltip * tooltip,
+                                 gpointer data);
 static void     on_canvas_realized(GtkWidget * canvas, gpointer data);
 static gboolean on_button_press(GooCanvasItem * item,
                                 GooCanvasItem * target,
@@ -84,10 +94,19 @@ static gboolean on_button_press(GooCanvasItem * item,
 static gboolean on_button_release(GooCanvasItem * item,
                                   GooCanvasItem * target,
                                   GdkEventButton * event, gpointer data);
+static gboolean sat_button_press(GtkMaxPathMap * satmap, gint catnum,
+                                 GdkEventButton * event);
+static gboolean sat_button_release(GtkMaxPathMap * satmap, gint catnum,
+                                   GdkEventButton * event);
+static gboolean on_layer_button_press(GooCanvasItem * item,
+                                      GooCanvasItem * target,
+                                      GdkEventButton * event, gpointer data);
+static gboolean on_layer_button_release(GooCanvasItem * item,
+                                        GooCanvasItem * target,
+                                        GdkEventButton * event, gpointer data);
 static void     clear_selection(gpointer key, gpointer val, gpointer data);
 static void     load_map_file(GtkMaxPathMap * satmap, float clon);
 static GooCanvasItemModel *create_canvas_model(GtkMaxPathMap * satmap);
-static gdouble  arccos(gdouble, gdouble);
 static gboolean pole_is_covered(sat_t * sat, gdouble beta);
 static gboolean north_pole_is_covered(sat_t * sat, gdouble beta);
 static gboolean south_pole_is_covered(sat_t * sat, gdouble beta);
@@ -109,13 +128,14 @@ static void     redraw_grid_lines(GtkMaxPathMap * satmap);
 static void     draw_terminator(GtkMaxPathMap * satmap, GooCanvasItemModel * root);
 static void     redraw_terminator(GtkMaxPathMap * satmap);
 static gchar   *aoslos_time_to_str(GtkMaxPathMap * satmap, sat_t * sat);
+static gchar   *sat_tooltip(GtkMaxPathMap * satmap, sat_t * sat);
 static void     gtk_max_path_map_load_showtracks(GtkMaxPathMap * map);
 static void     gtk_max_path_map_store_showtracks(GtkMaxPathMap * satmap);
 static void     gtk_max_path_map_load_hide_coverages(GtkMaxPathMap * map);
 static void     gtk_max_path_map_store_hidecovs(GtkMaxPathMap * satmap);
 static void     reset_ground_track(gpointer key, gpointer value,
                                    gpointer user_data);
-void destroy_path_lines(GList *lines, GooCanvasItemModel *root);
+void destroy_path_lines(GPtrArray *arcs, GooCanvasItemModel *root);
 void destroy_path_end_marks(GList *path_end_marks, GooCanvasItemModel *root);
 
 static GtkVBoxClass *parent_class = NULL;
@@ -186,6 +206,7 @@ static void gtk_max_path_map_init(GtkMaxPathMap * satmap,
     satmap->qth_marks = NULL;
     satmap->path_end_marks = NULL;
     satmap->obj = NULL;
+    satmap->layer = NULL;
     satmap->showtracks = g_hash_table_new_full(g_int_hash, g_int_equal,
                                                NULL, NULL);
     satmap->hidecovs = g_hash_table_new_full(g_int_hash, g_int_equal,
@@ -224,6 +245,9 @@ static void gtk_max_path_map_destroy(GtkWidget * widget)
         g_hash_table_destroy(satmap->obj);
         satmap->obj = NULL;
 
+        sat_map_layer_free(satmap->layer);
+        satmap->layer = NULL;
+
         /* these objects destruct themselves cleanly */
         g_object_unref(satmap->origmap);
         satmap->origmap = NULL;
@@ -296,16 +320,30 @@ static void gtk_max_path_map_destroy(GtkWidget * widget)
     (*GTK_WIDGET_CLASS(parent_class)->destroy) (widget);
 }
 
-void destroy_path_lines(GList *lines, GooCanvasItemModel *root) {
+// Drops the polylines of arc from index first on
+static void remove_arc_lines(mpm_path_arc_t *arc, guint first, GooCanvasItemModel *root) {
     gint idx = 0;
-    if (!lines || !root) return;
 
-    for (GList *i = lines; i!=NULL; i=i->next) {
-        idx = goo_canvas_item_model_find_child(root, i->data);
+    for (guint i = first; i < arc->lines->len; i++) {
+        idx = goo_canvas_item_model_find_child(root, g_ptr_array_index(arc->lines, i));
         if (idx != -1) goo_canvas_item_model_remove_child(root, idx);
+        g_object_unref(g_ptr_array_index(arc->lines, i));
     }
-    
-    g_list_free_full(lines, g_object_unref);
+    g_ptr_array_set_size(arc->lines, first);
+}
+
+void destroy_path_lines(GPtrArray *arcs, GooCanvasItemModel *root) {
+    if (!arcs || !root) return;
+
+    for (guint i = 0; i < arcs->len; i++) {
+        mpm_path_arc_t *arc = g_ptr_array_index(arcs, i);
+        remove_arc_lines(arc, 0, root);
+        g_ptr_array_free(arc->lines, TRUE);
+        g_free(arc->color);
+        g_free(arc);
+    }
+
+    g_ptr_array_free(arcs, TRUE);
 }
 
 void destroy_path_end_marks(GList *path_end_marks, GooCanvasItemModel *root) {
@@ -404,6 +442,23 @@ GtkWidget      *gtk_max_path_map_new(GKeyFile * cfgdata, GHashTable * sats,
 
     gtk_widget_show(satmap->canvas);
 
+    /* too many satellites for canvas items, draw them in one layer */
+    if (sat_map_use_layer(cfgdata, MOD_CFG_MAP_SECTION, sats))
+    {
+        satmap->layer = sat_map_layer_new(satmap->canvas, MARKER_SIZE_HALF);
+        sat_map_layer_set_colours(satmap->layer,
+                                  mod_cfg_get_int(cfgdata, MOD_CFG_MAP_SECTION,
+                                                  MOD_CFG_MAP_SAT_COL,
+                                                  SAT_CFG_INT_MAP_SAT_COL),
+                                  mod_cfg_get_int(cfgdata, MOD_CFG_MAP_SECTION,
+                                                  MOD_CFG_MAP_SAT_SEL_COL,
+                                                  SAT_CFG_INT_MAP_SAT_SEL_COL),
+                                  mod_cfg_get_int(cfgdata, MOD_CFG_MAP_SECTION,
+                                                  MOD_CFG_MAP_SAT_COV_COL,
+                                                  SAT_CFG_INT_MAP_SAT_COV_COL));
+        set_layer_projection(satmap);
+    }
+
     root = create_canvas_model(satmap);
     goo_canvas_set_root_item_model(GOO_CANVAS(satmap->canvas), root);
     g_object_unref(root);
@@ -493,9 +548,9 @@ static GooCanvasItemModel *create_canvas_model(GtkMaxPathMap * satmap)
                                             "fill-color-rgba", col,
                                             "use-markup", TRUE, NULL);
 
-    satmap->capacity_path_nodes = NULL;
+    satmap->capacity_path_result = NULL;
     satmap->capacity_path_colors = NULL;
-    satmap->capacity_path_nodes = NULL;
+    satmap->capacity_path = NULL;
     satmap->path_end_marks = NULL;
      
     return root;
@@ -585,30 +640,47 @@ static void update_map_size(GtkMaxPathMap * satmap)
                      "x", (gdouble) satmap->x0 + satmap->width - 2,
                      "y", (gdouble) satmap->y0 + satmap->height - 1, NULL);
 
-        g_hash_table_foreach(satmap->sats, update_sat, satmap);
+        set_layer_projection(satmap);
+        update_sats(satmap);
         satmap->resize = FALSE;
     }
 }
 
-static void generate_qth_mark(GtkMaxPathMap *satmap, path_node *node, gdouble time, gboolean write_time, gchar *col) {
+/* Update every satellite, refilling the constellation layer if there is one */
+static void update_sats(GtkMaxPathMap * satmap)
+{
+    if (satmap->layer)
+        sat_map_layer_clear(satmap->layer);
+
+    g_hash_table_foreach(satmap->sats, update_sat, satmap);
+
+    if (satmap->layer)
+        sat_map_layer_commit(satmap->layer);
+}
+
+static void set_layer_projection(GtkMaxPathMap * satmap)
+{
+    if (satmap->layer)
+        sat_map_layer_set_projection(satmap->layer, satmap->x0, satmap->y0,
+                                     satmap->width, satmap->height,
+                                     satmap->left_side_lon);
+}
+
+/* Redraw the layer after a selection change without waiting for the next refresh */
+static void update_layer(GtkMaxPathMap * satmap)
+{
+    if (satmap->layer)
+        update_sats(satmap);
+}
+
+static void generate_qth_mark(GtkMaxPathMap *satmap, gdouble lat, gdouble lon, gdouble time, gboolean write_time, gchar *col) {
     gfloat x, y;
     GooCanvasItemModel *root = goo_canvas_get_root_item_model(GOO_CANVAS(satmap->canvas));
     mpm_qth_marks *marking = malloc(sizeof(mpm_qth_marks));
     satmap->path_end_marks = g_list_append(satmap->path_end_marks, marking);
 
-    if (node->type == path_SATELLITE) {
-        qth_t dummy_q;
-        sat_t dummy_s;
-        memcpy(&dummy_s, (sat_t *)node->obj, sizeof(sat_t));
-        predict_calc(&dummy_s, &dummy_q, time);
-        marking->lat = dummy_s.ssplat;
-        marking->lon = dummy_s.ssplon;
-
-    } else if (node->type == path_STATION) {
-        qth_t * station = (qth_t *)node->obj;
-        marking->lat = station->lat;
-        marking->lon = station->lon;
-    }
+    marking->lat = lat;
+    marking->lon = lon;
 
     gchar fmted_time[25];
     daynum_to_str(fmted_time, 25, "%d/%m/%G - %H:%M", time);
@@ -635,85 +707,19 @@ static void generate_qth_mark(GtkMaxPathMap *satmap, path_node *node, gdouble ti
                                     NULL);
 }
 
-void generate_arc(
-    GtkMaxPathMap *map, 
-    GooCanvasItemModel *root, 
-    GdkRGBA *color,
-    sat_t *satellite,
-    gdouble t_start, 
-    gdouble t_end) {
-
-    guint len = (guint)((t_end - t_start) * 1440); //draw point for every min
-    const gdouble t_step = 1.0 / 1440.0;
-
-    sat_t dummy_s;
-    memcpy(&dummy_s, satellite, sizeof(sat_t));
-    qth_t dummy_q = {0};
-    gfloat x, y;
-
-    GList *canvas_arcs = g_list_append(NULL, g_array_new(FALSE, FALSE, sizeof(gdouble)));
-
-    predict_calc(&dummy_s, &dummy_q, t_start);
-    gdouble prev_lon = dummy_s.ssplon;
-    gdouble prev_lat = dummy_s.ssplat;
-    gdouble replace = 0;
-
-    for (guint i = 0; i < len + 1; i++) {
-        //make sure we get endpoint correct
-        if (i == len) {                  
-            predict_calc(&dummy_s, &dummy_q, t_end);
-        } else {
-            predict_calc(&dummy_s, &dummy_q, t_start + i * t_step);
-        }
-
-        //check for wrap around map
-        // lat: -90, 90,  lon: -180, 180
-        if ((prev_lat < -60 && dummy_s.ssplat > 60)
-            || (prev_lat > 75 && dummy_s.ssplat < -75)) {
-
-            replace = (prev_lat < -60) ? -90 : 90;
-            lonlat_to_xy(map, dummy_s.ssplon, replace, &x, &y);
-            canvas_arcs->data = g_array_append_vals(canvas_arcs->data, &(gdouble[2]){x, y}, 2);
-
-            canvas_arcs = g_list_prepend(canvas_arcs, g_array_new(FALSE, FALSE, sizeof(gdouble)));
-
-            lonlat_to_xy(map, prev_lon, -1 * replace, &x, &y);
-            canvas_arcs->data = g_array_append_vals(canvas_arcs->data, &(gdouble[2]){x, y}, 2);
-
-        } else if ((prev_lon < -150 && dummy_s.ssplon > 150)
-            || (prev_lon > 150 && dummy_s.ssplon < -150)) { 
-            
-            replace = (prev_lon < -150) ? -180 : 180;
-            lonlat_to_xy(map, replace, dummy_s.ssplat, &x, &y);
-            canvas_arcs->data = g_array_append_vals(canvas_arcs->data, &(gdouble[2]){x, y}, 2);
-
-            canvas_arcs = g_list_prepend(canvas_arcs, g_array_new(FALSE, FALSE, sizeof(gdouble))); 
-
-            lonlat_to_xy(map, -1 * replace, prev_lat, &x, &y);
-            canvas_arcs->data = g_array_append_vals(canvas_arcs->data, &(gdouble[2]){x, y}, 2);
-        }
+// Sets the points of the index-th polyline of arc, creating it when missing
+static void set_arc_line(GtkMaxPathMap *map, GooCanvasItemModel *root, mpm_path_arc_t *arc,
+                         guint index, GArray *coords) {
+    GooCanvasPoints *points = goo_canvas_points_new(coords->len / 2);
+    memcpy(points->coords, coords->data, coords->len * sizeof(gdouble));
 
-        lonlat_to_xy(map, dummy_s.ssplon, dummy_s.ssplat, &x, &y);
-        canvas_arcs->data = g_array_append_vals(canvas_arcs->data, &(gdouble[2]){x, y}, 2);
-
-        prev_lat = dummy_s.ssplat;
-        prev_lon = dummy_s.ssplon;
-    }
-
-    for (GList *arc = canvas_arcs; arc != NULL; arc=arc->next) {
-        GArray *arc_array = (GArray *)arc->data;
-        gsize array_len = 0;
-    
-        GooCanvasPoints *points = goo_canvas_points_new((guint)(arc_array->len / 2));
-        points->coords = g_array_steal(arc_array, &array_len);
-
-        gpointer *line = g_object_new(GOO_TYPE_CANVAS_POLYLINE_MODEL,
+    if (index < arc->lines->len) {
+        g_object_set(g_ptr_array_index(arc->lines, index), "points", points, NULL);
+    } else {
+        GooCanvasItemModel *line = g_object_new(GOO_TYPE_CANVAS_POLYLINE_MODEL,
                         "parent", root,
                         "points", points,
-                        "stroke-color", fmted_to_string("#%.2X%.2X%.2X",
-                            (int)(250*color->red),
-                            (int)(250*color->green),
-                            (int)(250*color->blue)),
+                        "stroke-color", arc->color,
                         "line-width", 2.0,
                         "arrow-length", 10.0,
                         "arrow-width", 10.0,
@@ -723,24 +729,85 @@ void generate_arc(
                         NULL);
 
         //place item at bottom of stack, just above the map
-        goo_canvas_item_model_lower(GOO_CANVAS_ITEM_MODEL(line), NULL);
-        goo_canvas_item_model_raise(GOO_CANVAS_ITEM_MODEL(line), map->map);
+        goo_canvas_item_model_lower(line, NULL);
+        goo_canvas_item_model_raise(line, map->map);
 
-        map->capacity_path = g_list_append(map->capacity_path, line);
+        g_ptr_array_add(arc->lines, line);
+    }
+
+    goo_canvas_points_unref(points);
+}
+
+/**
+ * Projects the cached track of arc onto the map. The track is split where it
+ * leaves one side of the map and comes back on the other, the existing
+ * polylines get the new points and only missing ones are created.
+ */
+static void project_arc(GtkMaxPathMap *map, GooCanvasItemModel *root, mpm_path_arc_t *arc) {
+    const path_track_t *track = arc->track;
+    GArray *coords = g_array_sized_new(FALSE, FALSE, sizeof(gdouble), 2 * track->len);
+    guint pieces = 0;
+    gfloat x, y, prev_x = 0, prev_y = 0;
+
+    for (guint i = 0; i < track->len; i++) {
+        lonlat_to_xy(map, track->lon[i], track->lat[i], &x, &y);
+
+        if (i > 0 && fabs(x - prev_x) > map->width / 2.0) {
+            //crossed the map edge, finish at it and continue from the other one
+            gdouble edge = (x < prev_x) ? map->width : 0;
+            gdouble unwrapped = (x < prev_x) ? x + map->width : x - map->width;
+            gdouble edge_y = prev_y + (edge - prev_x) / (unwrapped - prev_x) * (y - prev_y);
+
+            g_array_append_vals(coords, &(gdouble[2]){edge, edge_y}, 2);
+            set_arc_line(map, root, arc, pieces++, coords);
+
+            g_array_set_size(coords, 0);
+            g_array_append_vals(coords, &(gdouble[2]){map->width - edge, edge_y}, 2);
+        }
 
-        g_array_free(arc->data, TRUE);
+        g_array_append_vals(coords, &(gdouble[2]){x, y}, 2);
+        prev_x = x;
+        prev_y = y;
     }
+    set_arc_line(map, root, arc, pieces++, coords);
+    remove_arc_lines(arc, pieces, root);
+
+    g_array_free(coords, TRUE);
+}
+
+// Reprojects the drawn path after the map size or centre changed, no propagation
+static void reproject_capacity_paths(GtkMaxPathMap *map) {
+    if (!map->capacity_path) return;
+
+    GooCanvasItemModel *root = goo_canvas_get_root_item_model(GOO_CANVAS(map->canvas));
+
+    for (guint i = 0; i < map->capacity_path->len; i++)
+        project_arc(map, root, g_ptr_array_index(map->capacity_path, i));
+}
+
+void generate_arc(
+    GtkMaxPathMap *map, 
+    GooCanvasItemModel *root, 
+    gchar *color,
+    const path_track_t *track) {
 
-    g_list_free(canvas_arcs);
+    mpm_path_arc_t *arc = g_new0(mpm_path_arc_t, 1);
+    arc->track = track;
+    arc->color = g_strdup(color);
+    arc->lines = g_ptr_array_new();
+
+    project_arc(map, root, arc);
+    g_ptr_array_add(map->capacity_path, arc);
 }
 
 
-void draw_capacity_paths(GtkMaxPathMap *map, GList *path, GList *colors) {
-    if (!map || !path || !colors) return;
+void draw_capacity_paths(GtkMaxPathMap *map, max_path_t *result, GList *colors) {
+    if (!map) return;
 
     GooCanvasItemModel *root = goo_canvas_get_root_item_model(GOO_CANVAS(map->canvas));
     path_node *node;
     path_node *next_node;
+    path_track_t *track;
     GdkRGBA *color;
 
     if (map->capacity_path) {
@@ -753,49 +820,63 @@ void draw_capacity_paths(GtkMaxPathMap *map, GList *path, GList *colors) {
         map->path_end_marks = NULL; 
     }
 
+    if (!result || !result->path || !colors) return;
+
+    GPtrArray *tracks = max_path_tracks(result);
+    map->capacity_path = g_ptr_array_new();
+
     GList *c_iter = colors;
-    for (GList *p_iter = path; p_iter->next != NULL; p_iter = p_iter->next) {
+    guint index = 0;
+    gchar *color_str = NULL;
+    for (GList *p_iter = result->path; p_iter != NULL; p_iter = p_iter->next, index++) {
         color = (GdkRGBA *)c_iter->data;
         node = (path_node *)p_iter->data;
-        next_node = (path_node *)p_iter->next->data;
+        track = g_ptr_array_index(tracks, index);
 
-        gchar *color_str = g_strdup_printf("#%.2X%.2X%.2X",
+        g_free(color_str);
+        color_str = g_strdup_printf("#%.2X%.2X%.2X",
             (int)(250*color->red),
             (int)(250*color->green),
             (int)(250*color->blue));
 
+        //last node only gets its end mark
+        if (p_iter->next == NULL) break;
+        next_node = (path_node *)p_iter->next->data;
+
         switch (node->type) {
             case path_SATELLITE:
-                generate_arc(map, root, color, node->obj, node->time, next_node->time);
-                generate_qth_mark(map, node, node->time, TRUE, color_str);
-                generate_qth_mark(map, node, next_node->time, FALSE, color_str);
+                generate_arc(map, root, color_str, track);
+                generate_qth_mark(map, track->lat[0], track->lon[0], node->time, TRUE, color_str);
+                generate_qth_mark(map, track->lat[track->len - 1], track->lon[track->len - 1],
+                                  next_node->time, FALSE, color_str);
                 break;
             case path_STATION:
-                generate_qth_mark(map, node, node->time, FALSE, color_str);
+                generate_qth_mark(map, ((qth_t *)node->obj)->lat, ((qth_t *)node->obj)->lon,
+                                  node->time, FALSE, color_str);
                 break;
             default:
                 sat_log_log(SAT_LOG_LEVEL_ERROR, 
-                    "%s: unknown max path node type -> %s", 
+                    "%s: unknown max path node type -> %d", 
                     __func__, node->type);
         }
 
-        g_free(color_str);
         c_iter = c_iter->next;
     }    
 
-    GList *last_p = g_list_last(path);
-    GList *last_c = g_list_last(colors); 
-    node = (path_node *)last_p->data;
-    color = (GdkRGBA *)last_c->data;
-    generate_qth_mark(map, node, node->time, FALSE, g_strdup_printf("#%.2X%.2X%.2X",
-                                                    (int)(250*color->red),
-                                                    (int)(250*color->green),
-                                                    (int)(250*color->blue)));
+    //end of the path, colours run out together with the nodes
+    node = (path_node *)g_list_last(result->path)->data;
+    track = g_ptr_array_index(tracks, tracks->len - 1);
+    if (node->type == path_SATELLITE)
+        generate_qth_mark(map, track->lat[0], track->lon[0], node->time, FALSE, color_str);
+    else
+        generate_qth_mark(map, ((qth_t *)node->obj)->lat, ((qth_t *)node->obj)->lon,
+                          node->time, FALSE, color_str);
+    g_free(color_str);
 }
 
 
-void set_max_capacity_path(GtkMaxPathMap *map, GList *path, GList *colors) {
-    map->capacity_path_nodes = path;
+void set_max_capacity_path(GtkMaxPathMap *map, max_path_t *path, GList *colors) {
+    map->capacity_path_result = path;
     map->capacity_path_colors = colors;
     draw_capacity_paths(map, path, colors);
 }
@@ -818,7 +899,7 @@ void gtk_max_path_map_update(GtkWidget * widget)
     /* check whether there are any pending resize requests */
     if (satmap->resize){
         update_map_size(satmap);
-        draw_capacity_paths(satmap, satmap->capacity_path_nodes, satmap->capacity_path_colors);
+        reproject_capacity_paths(satmap);
     }
 
     /* check refresh rate and refresh sats/qth if time */
@@ -838,7 +919,7 @@ void gtk_max_path_map_update(GtkWidget * widget)
         qth_marking_update_pos(satmap, satmap->path_end_marks);
 
 
-        g_hash_table_foreach(satmap->sats, update_sat, satmap);
+        update_sats(satmap);
 
         /* Update the Solar Terminator if necessary */
         // Solar terminator is a moving line that divides the daylit side and
@@ -895,6 +976,9 @@ static gboolean on_motion_notify(GooCanvasItem * item,
     (void)target;
     (void)item;
 
+    if (satmap->layer)
+        sat_map_layer_hover(satmap->layer, event->x, event->y);
+
     /* set text only if QTH info is enabled */
     if (satmap->cursinfo)
     {
@@ -933,6 +1017,15 @@ static void on_item_created(GooCanvas * canvas,
         /* root item / canvas */
         g_signal_connect(item, "motion_notify_event",
                          (GCallback) on_motion_notify, data);
+
+        /* satellites drawn by the layer have no items of their own */
+        if (GTK_MAX_PATH_MAP(data)->layer)
+        {
+            g_signal_connect(item, "button_press_event",
+                             (GCallback) on_layer_button_press, data);
+            g_signal_connect(item, "button_release_event",
+                             (GCallback) on_layer_button_release, data);
+        }
     }
     else if (!g_object_get_data(G_OBJECT(item), "skip-signal-connection"))
     {
@@ -940,22 +1033,67 @@ static void on_item_created(GooCanvas * canvas,
                          (GCallback) on_button_press, data);
         g_signal_connect(item, "button_release_event",
                          (GCallback) on_button_release, data);
+        g_signal_connect(item, "query-tooltip",
+                         (GCallback) on_query_tooltip, data);
     }
 }
 
+/**
+ * Build the tooltip of a satellite marker or label when it is shown.
+ *
+ * The tooltip holds the current position and AOS/LOS countdown, which change
+ * on almost every cycle, so it is not kept up to date on the items.
+ */
+static gboolean on_query_tooltip(GooCanvasItem * item, gdouble x, gdouble y,
+                                 gboolean keyboard_mode, GtkTooltip * tooltip,
+                                 gpointer data)
+{
+    GtkMaxPathMap  *satmap = GTK_MAX_PATH_MAP(data);
+    GooCanvasItemModel *model = goo_canvas_item_get_model(item);
+    gint            catnum;
+    max_path_map_obj_t *obj;
+    sat_t          *sat;
+    gchar          *text;
+
+    (void)x;
+    (void)y;
+    (void)keyboard_mode;
+
+    catnum = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(model), "catnum"));
+    obj = MAX_PATH_MAP_OBJ(g_hash_table_lookup(satmap->obj, &catnum));
+    sat = SAT(g_hash_table_lookup(satmap->sats, &catnum));
+
+    /* the range circles carry the catnum too but have no tooltip */
+    if (obj == NULL || sat == NULL ||
+        (model != obj->marker && model != obj->label))
+        return FALSE;
+
+    text = sat_tooltip(satmap, sat);
+    gtk_tooltip_set_markup(tooltip, text);
+    g_free(text);
+
+    return TRUE;
+}
+
 static gboolean on_button_press(GooCanvasItem * item,
                                 GooCanvasItem * target, GdkEventButton * event,
                                 gpointer data)
 {
     GooCanvasItemModel *model = goo_canvas_item_get_model(item);
-    GtkMaxPathMap      *satmap = GTK_MAX_PATH_MAP(data);
     gint            catnum =
         GPOINTER_TO_INT(g_object_get_data(G_OBJECT(model), "catnum"));
-    gint           *catpoint = NULL;
-    sat_t          *sat = NULL;
 
     (void)target;
 
+    return sat_button_press(GTK_MAX_PATH_MAP(data), catnum, event);
+}
+
+static gboolean sat_button_press(GtkMaxPathMap * satmap, gint catnum,
+                                 GdkEventButton * event)
+{
+    gint           *catpoint = NULL;
+    sat_t          *sat = NULL;
+
     switch (event->button)
     {
         /* double-left-click */
@@ -968,7 +1106,7 @@ static gboolean on_button_press(GooCanvasItem * item,
             sat = SAT(g_hash_table_lookup(satmap->sats, catpoint));
             if (sat != NULL)
             {
-                show_sat_info(sat, gtk_widget_get_toplevel(GTK_WIDGET(data)));
+                show_sat_info(sat, gtk_widget_get_toplevel(GTK_WIDGET(satmap)));
             }
             else
             {
@@ -1007,15 +1145,21 @@ static gboolean on_button_release(GooCanvasItem * item,
                                   GdkEventButton * event, gpointer data)
 {
     GooCanvasItemModel *model = goo_canvas_item_get_model(item);
-    GtkMaxPathMap      *satmap = GTK_MAX_PATH_MAP(data);
     gint            catnum =
         GPOINTER_TO_INT(g_object_get_data(G_OBJECT(model), "catnum"));
+
+    (void)target;
+
+    return sat_button_release(GTK_MAX_PATH_MAP(data), catnum, event);
+}
+
+static gboolean sat_button_release(GtkMaxPathMap * satmap, gint catnum,
+                                   GdkEventButton * event)
+{
     gint           *catpoint = NULL;
     max_path_map_obj_t  *obj = NULL;
     guint32         col;
 
-    (void)target;
-
     catpoint = g_try_new0(gint, 1);
     *catpoint = catnum;
 
@@ -1053,19 +1197,11 @@ static gboolean on_button_release(GooCanvasItem * item,
                 g_object_set(satmap->sel, "text", "", NULL);
             }
 
-            g_object_set(obj->marker,
-                         "fill-color-rgba", col,
-                         "stroke-color-rgba", col, NULL);
-            g_object_set(obj->label,
-                         "fill-color-rgba", col,
-                         "stroke-color-rgba", col, NULL);
-            g_object_set(obj->range1, "stroke-color-rgba", col, NULL);
-
-            if (obj->oldrcnum == 2)
-                g_object_set(obj->range2, "stroke-color-rgba", col, NULL);
+            set_obj_colour(obj, col);
 
             /* clear other selections */
             g_hash_table_foreach(satmap->obj, clear_selection, catpoint);
+            update_layer(satmap);
         }
         break;
     default:
@@ -1077,6 +1213,51 @@ static gboolean on_button_release(GooCanvasItem * item,
     return TRUE;
 }
 
+/* Clicks on the background go to the satellite the layer has drawn there */
+static gboolean on_layer_button_press(GooCanvasItem * item,
+                                      GooCanvasItem * target,
+                                      GdkEventButton * event, gpointer data)
+{
+    GtkMaxPathMap  *satmap = GTK_MAX_PATH_MAP(data);
+    sat_t          *sat = sat_map_layer_pick(satmap->layer, event->x, event->y,
+                                             2 * MARKER_SIZE_HALF + 3);
+
+    (void)item;
+    (void)target;
+
+    return sat ? sat_button_press(satmap, sat->tle.catnr, event) : FALSE;
+}
+
+static gboolean on_layer_button_release(GooCanvasItem * item,
+                                        GooCanvasItem * target,
+                                        GdkEventButton * event, gpointer data)
+{
+    GtkMaxPathMap  *satmap = GTK_MAX_PATH_MAP(data);
+    sat_t          *sat = sat_map_layer_pick(satmap->layer, event->x, event->y,
+                                             2 * MARKER_SIZE_HALF + 3);
+
+    (void)item;
+    (void)target;
+
+    return sat ? sat_button_release(satmap, sat->tle.catnr, event) : FALSE;
+}
+
+/* Colour the canvas items of a satellite, the layer colours by flag instead */
+static void set_obj_colour(max_path_map_obj_t * obj, guint32 col)
+{
+    if (obj->marker == NULL)
+        return;
+
+    g_object_set(obj->marker,
+                 "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
+    g_object_set(obj->label,
+                 "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
+    g_object_set(obj->range1, "stroke-color-rgba", col, NULL);
+
+    if (obj->oldrcnum == 2)
+        g_object_set(obj->range2, "stroke-color-rgba", col, NULL);
+}
+
 static void clear_selection(gpointer key, gpointer val, gpointer data)
 {
     gint           *old = key;
@@ -1091,14 +1272,7 @@ static void clear_selection(gpointer key, gpointer val, gpointer data)
         /** FIXME: this is only global default; need the satmap here! */
         col = sat_cfg_get_int(SAT_CFG_INT_MAP_SAT_COL);
 
-        g_object_set(obj->marker,
-                     "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
-        g_object_set(obj->label,
-                     "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
-        g_object_set(obj->range1, "stroke-color-rgba", col, NULL);
-
-        if (obj->oldrcnum == 2)
-            g_object_set(obj->range2, "stroke-color-rgba", col, NULL);
+        set_obj_colour(obj, col);
     }
 }
 
@@ -1128,17 +1302,11 @@ void gtk_max_path_map_select_sat(GtkWidget * satmap, gint catnum)
                               MOD_CFG_MAP_SAT_SEL_COL,
                               SAT_CFG_INT_MAP_SAT_SEL_COL);
 
-        g_object_set(obj->marker,
-                     "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
-        g_object_set(obj->label,
-                     "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
-        g_object_set(obj->range1, "stroke-color-rgba", col, NULL);
-
-        if (obj->oldrcnum == 2)
-            g_object_set(obj->range2, "stroke-color-rgba", col, NULL);
+        set_obj_colour(obj, col);
 
         /* clear other selections */
         g_hash_table_foreach(smap->obj, clear_selection, catpoint);
+        update_layer(smap);
     }
 
     g_free(catpoint);
@@ -1259,19 +1427,6 @@ static void load_map_file(GtkMaxPathMap * satmap, float clon)
         satmap->left_side_lon = 180.0 + clon;
 }
 
-static gdouble arccos(gdouble x, gdouble y)
-{
-    if (x && y)
-    {
-        if (y > 0.0)
-            return acos(x / y);
-        else if (y < 0.0)
-            return pi + acos(x / y);
-    }
-
-    return 0.0;
-}
-
 /* Check whether the footprint covers the North or South pole. */
 static gboolean pole_is_covered(sat_t * sat, gdouble beta)
 {
@@ -1407,8 +1562,9 @@ static guint calculate_footprint(GtkMaxPathMap * satmap, sat_t * sat)
 {
     guint           azi;
     gfloat          sx, sy, msx, msy, ssx, ssy;
-    gdouble         ssplat, ssplon, beta, azimuth, num, dem;
-    gdouble         rangelon, rangelat, mlon;
+    gdouble         beta, mlon;
+    gdouble         rangelat[RANGE_CIRCLE_POINTS];
+    gdouble         rangelon[RANGE_CIRCLE_POINTS];
     gboolean        warped = FALSE;
     guint           numrc = 1;
 
@@ -1417,47 +1573,21 @@ static guint calculate_footprint(GtkMaxPathMap * satmap, sat_t * sat)
      * who borrowed from John Magliacane, KD2BD.
      * Optimized by Alexandru Csete and William J Beksi.
      */
-    ssplat = sat->ssplat * de2ra;
-    ssplon = sat->ssplon * de2ra;
     
     gdouble degree = 30;
     beta = asin(sat->pos.w * sin(degree * de2ra) / xkmper) - (degree * de2ra); 
 
-    for (azi = 0; azi < 180; azi++)
-    {
-        azimuth = de2ra * (double)azi;
-        rangelat = asin(sin(ssplat) * cos(beta) + cos(azimuth) *
-                        sin(beta) * cos(ssplat));
-        num = cos(beta) - (sin(ssplat) * sin(rangelat));
-        dem = cos(ssplat) * cos(rangelat);
-
-        if (azi == 0 && north_pole_is_covered(sat, beta))
-            rangelon = ssplon + pi;
-        else if (fabs(num / dem) > 1.0)
-            rangelon = ssplon;
-        else
-        {
-            if ((180.0 - azi) >= 0)
-                rangelon = ssplon - arccos(num, dem);
-            else
-                rangelon = ssplon + arccos(num, dem);
-        }
-
-        while (rangelon < -pi)
-            rangelon += twopi;
-
-        while (rangelon > (pi))
-            rangelon -= twopi;
-
-        rangelat = rangelat / de2ra;
-        rangelon = rangelon / de2ra; 
+    range_circle_half(sat->ssplat, sat->ssplon, beta,
+                      north_pole_is_covered(sat, beta), rangelat, rangelon);
 
+    for (azi = 0; azi < RANGE_CIRCLE_POINTS; azi++)
+    {
         /* mirror longitude */
-        if (mirror_lon(sat, rangelon, &mlon, satmap->left_side_lon))
+        if (mirror_lon(sat, rangelon[azi], &mlon, satmap->left_side_lon))
             warped = TRUE;
 
-        lonlat_to_xy(satmap, rangelon, rangelat, &sx, &sy);
-        lonlat_to_xy(satmap, mlon, rangelat, &msx, &msy);
+        lonlat_to_xy(satmap, rangelon[azi], rangelat[azi], &sx, &sy);
+        lonlat_to_xy(satmap, mlon, rangelat[azi], &msx, &msy);
 
         points1->coords[2 * azi] = sx;
         points1->coords[2 * azi + 1] = sy;
@@ -1872,7 +2002,6 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
     gint           *catnum;
     guint32         col, covcol, shadowcol;
     gfloat          x, y;
-    gchar          *tooltip;
 
     (void)key;
 
@@ -1924,6 +2053,22 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
     obj->track_data.latlon = NULL;
     obj->track_data.lines = NULL;
     obj->track_orbit = 0;
+    obj->x = x;
+    obj->y = y;
+    obj->footprint = sat->footprint;
+    obj->nickname = g_strdup(sat->nickname);
+
+    if (satmap->layer)
+    {
+        /* drawn by the constellation layer, no canvas items */
+        obj->marker = NULL;
+        obj->shadowm = NULL;
+        obj->label = NULL;
+        obj->shadowl = NULL;
+        obj->range1 = NULL;
+        g_hash_table_insert(satmap->obj, catnum, obj);
+        return;
+    }
 
     root = goo_canvas_get_root_item_model(GOO_CANVAS(satmap->canvas));
 
@@ -1957,15 +2102,7 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
                                 MOD_CFG_MAP_SHADOW_ALPHA,
                                 SAT_CFG_INT_MAP_SHADOW_ALPHA);
 
-    /* create tooltip */
-    tooltip = g_markup_printf_escaped("<b>%s</b>\n"
-                                      "Lon: %5.1f\302\260\n"
-                                      "Lat: %5.1f\302\260\n"
-                                      " Az: %5.1f\302\260\n"
-                                      " El: %5.1f\302\260",
-                                      sat->nickname,
-                                      sat->ssplon, sat->ssplat,
-                                      sat->az, sat->el);
+    /* tooltips are built when shown, see on_query_tooltip() */
 
     /* create satellite marker and label + shadows. We create shadows first */
     obj->shadowm = goo_canvas_rect_model_new(root,
@@ -1983,7 +2120,7 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
                                             2 * MARKER_SIZE_HALF,
                                             "fill-color-rgba", col,
                                             "stroke-color-rgba", col,
-                                            "tooltip", tooltip, NULL);
+                                            NULL);
 
     obj->shadowl = goo_canvas_text_model_new(root, sat->nickname,
                                              x + 1,
@@ -1999,10 +2136,7 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
                                            -1,
                                            GOO_CANVAS_ANCHOR_NORTH,
                                            "font", "Sans 8",
-                                           "fill-color-rgba", col,
-                                           "tooltip", tooltip, NULL);
-
-    g_free(tooltip);
+                                           "fill-color-rgba", col, NULL);
 
     g_object_set_data(G_OBJECT(obj->marker), "catnum",
                       GINT_TO_POINTER(*catnum));
@@ -2116,6 +2250,9 @@ static void free_sat_obj(gpointer key, gpointer value, gpointer data)
         goo_canvas_item_model_remove_child(root, idx);
     obj->range2 = NULL;
 
+    g_free(obj->nickname);
+    obj->nickname = NULL;
+
     if (obj->showtrack)
     {
         sat = SAT(g_hash_table_lookup(satmap->sats, &obj->catnum));
@@ -2123,100 +2260,53 @@ static void free_sat_obj(gpointer key, gpointer value, gpointer data)
     }
 }
 
-/** Update a given satellite. */
-static void update_sat(gpointer key, gpointer value, gpointer data)
+/**
+ * Check whether the footprint radius has changed by a pixel or more since the
+ * range circle was last drawn. The footprint is a diameter in km and one pixel
+ * north-south is pi * xkmper / height km.
+ */
+static gboolean footprint_changed(GtkMaxPathMap * satmap, max_path_map_obj_t * obj,
+                                  sat_t * sat)
+{
+    return fabs(sat->footprint - obj->footprint) * 0.5 * satmap->height >=
+        pi * xkmper;
+}
+
+/** Move the canvas items of a satellite, the map is not using the layer. */
+static void update_sat_items(GtkMaxPathMap * satmap, sat_t * sat,
+                             max_path_map_obj_t * obj)
 {
-    gint           *catnum;
-    GtkMaxPathMap      *satmap = GTK_MAX_PATH_MAP(data);
-    max_path_map_obj_t  *obj = NULL;
-    sat_t          *sat = SAT(value);
     gfloat          x, y;
-    gdouble         oldx, oldy;
-    gdouble         now;        // = get_current_daynum ();
+    gboolean        moved;
     GooCanvasItemModel *root;
     gint            idx;
     guint32         col, covcol;
-    gchar          *tooltip;
-    gchar          *aosstr;
-
-    //gdouble sspla,ssplo;
 
     root = goo_canvas_get_root_item_model(GOO_CANVAS(satmap->canvas));
 
-    catnum = g_new0(gint, 1);
-    *catnum = sat->tle.catnr;
-
-    now = satmap->tstamp;
-
-    /* update next AOS */
-    if (sat->aos > now)
-    {
-        if ((sat->aos < satmap->naos) || (satmap->naos == 0.0))
-        {
-            satmap->naos = sat->aos;
-            satmap->ncat = sat->tle.catnr;
-        }
-    }
-
-    obj = MAX_PATH_MAP_OBJ(g_hash_table_lookup(satmap->obj, catnum));
-
-    /* get rid of a decayed satellite */
-    if (decayed(sat) && obj != NULL)
-    {
-        free_sat_obj(NULL, obj, satmap);
-        g_hash_table_remove(satmap->obj, catnum);
-        return;
-    }
-
-    if (obj == NULL)
-    {
-        if (decayed(sat))
-        {
-            return;
-        }
-        else
-        {
-            /* satellite was decayed now is visible
-               time controller backed up time */
-            plot_sat(key, value, data);
-            return;
-        }
-    }
-
-    if (obj->selected)
+    /* every property set makes the canvas redraw the item */
+    if (g_strcmp0(sat->nickname, obj->nickname))
     {
-        /* update satmap->sel */
-        update_selected(satmap, sat);
+        g_object_set(obj->label, "text", sat->nickname, NULL);
+        g_object_set(obj->shadowl, "text", sat->nickname, NULL);
+        g_free(obj->nickname);
+        obj->nickname = g_strdup(sat->nickname);
     }
 
-    g_object_set(obj->label, "text", sat->nickname, NULL);
-    g_object_set(obj->shadowl, "text", sat->nickname, NULL);
-
-    aosstr = aoslos_time_to_str(satmap, sat);
-    tooltip = g_markup_printf_escaped("<b>%s</b>\n"
-                                      "Lon: %5.1f\302\260\n"
-                                      "Lat: %5.1f\302\260\n"
-                                      " Az: %5.1f\302\260\n"
-                                      " El: %5.1f\302\260\n"
-                                      "%s",
-                                      sat->nickname,
-                                      sat->ssplon, sat->ssplat,
-                                      sat->az, sat->el, aosstr);
-    g_object_set(obj->marker, "tooltip", tooltip, NULL);
-    g_object_set(obj->label, "tooltip", tooltip, NULL);
-    g_free(tooltip);
-    g_free(aosstr);
-
     lonlat_to_xy(satmap, sat->ssplon, sat->ssplat, &x, &y);
 
     /* update only if satellite has moved at least
        2 * MARKER_SIZE_HALF (no need to drain CPU all the time)
      */
-    g_object_get(obj->marker, "x", &oldx, "y", &oldy, NULL);
+    moved = satmap->resize ||
+        (fabs(obj->x - x) >= 2 * MARKER_SIZE_HALF) ||
+        (fabs(obj->y - y) >= 2 * MARKER_SIZE_HALF);
 
-    if ((fabs(oldx - x) >= 2 * MARKER_SIZE_HALF) ||
-        (fabs(oldy - y) >= 2 * MARKER_SIZE_HALF))
+    if (moved)
     {
+        obj->x = x;
+        obj->y = y;
+
         g_object_set(obj->marker,
                      "x", (gdouble) (x - MARKER_SIZE_HALF),
                      "y", (gdouble) (y - MARKER_SIZE_HALF), NULL);
@@ -2266,6 +2356,12 @@ static void update_sat(gpointer key, gpointer value, gpointer data)
                          "y", (gdouble) (y + 2 + 1),
                          "anchor", GOO_CANVAS_ANCHOR_NORTH, NULL);
         }
+    }
+
+    /* slow GEO and MEO satellites keep their range circle for many cycles */
+    if (moved || footprint_changed(satmap, obj, sat))
+    {
+        obj->footprint = sat->footprint;
 
         /* initialize points for footprint */
         points1 = goo_canvas_points_new(360);
@@ -2320,7 +2416,7 @@ static void update_sat(gpointer key, gpointer value, gpointer data)
                                                             CAIRO_LINE_JOIN_MITER,
                                                             NULL);
                 g_object_set_data(G_OBJECT(obj->range2), "catnum",
-                                  GINT_TO_POINTER(*catnum));
+                                  GINT_TO_POINTER(obj->catnum));
             }
             else
             {
@@ -2347,6 +2443,73 @@ static void update_sat(gpointer key, gpointer value, gpointer data)
         goo_canvas_points_unref(points1);
         goo_canvas_points_unref(points2);
     }
+}
+
+/** Update a given satellite. */
+static void update_sat(gpointer key, gpointer value, gpointer data)
+{
+    gint           *catnum;
+    GtkMaxPathMap      *satmap = GTK_MAX_PATH_MAP(data);
+    max_path_map_obj_t  *obj = NULL;
+    sat_t          *sat = SAT(value);
+    gdouble         now;        // = get_current_daynum ();
+
+    catnum = g_new0(gint, 1);
+    *catnum = sat->tle.catnr;
+
+    now = satmap->tstamp;
+
+    /* update next AOS */
+    if (sat->aos > now)
+    {
+        if ((sat->aos < satmap->naos) || (satmap->naos == 0.0))
+        {
+            satmap->naos = sat->aos;
+            satmap->ncat = sat->tle.catnr;
+        }
+    }
+
+    obj = MAX_PATH_MAP_OBJ(g_hash_table_lookup(satmap->obj, catnum));
+
+    /* get rid of a decayed satellite */
+    if (decayed(sat) && obj != NULL)
+    {
+        free_sat_obj(NULL, obj, satmap);
+        g_hash_table_remove(satmap->obj, catnum);
+        return;
+    }
+
+    if (obj == NULL)
+    {
+        if (decayed(sat))
+        {
+            return;
+        }
+        else
+        {
+            /* satellite was decayed now is visible
+               time controller backed up time */
+            plot_sat(key, value, data);
+            return;
+        }
+    }
+
+    if (obj->selected)
+    {
+        /* update satmap->sel */
+        update_selected(satmap, sat);
+    }
+
+    if (satmap->layer)
+    {
+        sat_map_layer_add(satmap->layer, sat,
+                          (obj->selected ? SAT_MAP_LAYER_SELECTED : 0) |
+                          (obj->showcov ? SAT_MAP_LAYER_FOOTPRINT : 0));
+    }
+    else
+    {
+        update_sat_items(satmap, sat, obj);
+    }
 
     /* if ground track is visible check whether we have passed into a
        new orbit, in which case we need to recalculate the ground track
@@ -2858,6 +3021,27 @@ static void reset_ground_track(gpointer key, gpointer value,
     obj->track_orbit = 0;
 }
 
+/** Tooltip markup of a satellite marker at the current time. */
+static gchar   *sat_tooltip(GtkMaxPathMap * satmap, sat_t * sat)
+{
+    gchar          *tooltip;
+    gchar          *aosstr;
+
+    aosstr = aoslos_time_to_str(satmap, sat);
+    tooltip = g_markup_printf_escaped("<b>%s</b>\n"
+                                      "Lon: %5.1f\302\260\n"
+                                      "Lat: %5.1f\302\260\n"
+                                      " Az: %5.1f\302\260\n"
+                                      " El: %5.1f\302\260\n"
+                                      "%s",
+                                      sat->nickname,
+                                      sat->ssplon, sat->ssplat,
+                                      sat->az, sat->el, aosstr);
+    g_free(aosstr);
+
+    return tooltip;
+}
+
 static gchar   *aoslos_time_to_str(GtkMaxPathMap * satmap, sat_t * sat)
 {
     guint           h, m, s;
@@ -11,6 +11,8 @@
 #include "calc-dist-two-sat.h"
 #include "sat-graph.h"
 #include "qth-data.h"
+#include "sat-map-layer.h"
+#include "max-capacity-path/path-util.h"
 
 /* *INDENT-OFF* */
 #ifdef __cplusplus
@@ -46,6 +48,13 @@ typedef struct {
     GooCanvasItemModel *label;
 } mpm_qth_marks;
 
+/** Satellite segment of the capacity path */
+typedef struct {
+    const path_track_t *track;  /*!< Sub-satellite points, owned by the max_path_t. */
+    gchar          *color;      /*!< Stroke colour. */
+    GPtrArray      *lines;      /*!< GooCanvasPolylineModel per piece between the map edges. */
+} mpm_path_arc_t;
+
 /**
  * Satellite object.
  *
@@ -79,6 +88,12 @@ typedef struct {
     mpm_ground_track_t  track_data; /*!< Ground track data. */
     long            track_orbit;        /*!< Orbit when the ground track has been updated. */
 
+    /* state of the last canvas update, items are only touched when it changes */
+    gfloat          x;          /*!< Projected position of the marker. */
+    gfloat          y;
+    gdouble         footprint;  /*!< Footprint diameter (km) of the range circle. */
+    gchar          *nickname;   /*!< Text currently set on the label. */
+
 } max_path_map_obj_t;
 
 #define MAX_PATH_MAP_OBJ(obj) ((max_path_map_obj_t *)obj)
@@ -106,9 +121,9 @@ typedef struct {
     GooCanvasItemModel *gridh[5];       /*!< Horizontal grid lines, 30 deg resolution. */
     GooCanvasItemModel *gridhlab[5];    /*!< Horizontal grid labels. */
 
-    GList *capacity_path_nodes;                 //GList of path_node. Owned by gtk-sat-module.c 
-    GList *capacity_path_colors;                //GList of GdkRGBA. Owned by gtk-sat-module.c
-    GList *capacity_path;                      //GList of GooCanvasItem. Path lines on the map
+    max_path_t *capacity_path_result;           //Owned by GtkMaxPathView
+    GList *capacity_path_colors;                //GList of GdkRGBA. Owned by GtkMaxPathView
+    GPtrArray *capacity_path;                   //mpm_path_arc_t per satellite segment, reprojected on resize
     GList *path_end_marks;                     //GList of mpm_qth_marks, mark end spot and time of path segments
 
     GooCanvasItemModel *terminator;     /*!< Outline of sun shadow on Earth. */
@@ -146,6 +161,8 @@ typedef struct {
 
     GdkPixbuf      *origmap;    /*!< Original map kept here for high quality scaling. */
 
+    sat_map_layer  *layer;      /*!< Draws all satellites above the bulk threshold, NULL for canvas items. */
+
 } GtkMaxPathMap;
 
 struct _GtkMaxPathMapClass {
@@ -164,7 +181,7 @@ void            gtk_max_path_map_lonlat_to_xy(GtkMaxPathMap * m,
 void            gtk_max_path_map_reload_sats(GtkWidget * satmap, GHashTable * sats);
 void            gtk_max_path_map_select_sat(GtkWidget * satmap, gint catnum);
 
-void            set_max_capacity_path(GtkMaxPathMap *map, GList *path, GList *colors);
+void            set_max_capacity_path(GtkMaxPathMap *map, max_path_t *path, GList *colors);
 
 /* *INDENT-OFF* */
 #ifdef __cplusplus
@@ -22,6 +22,10 @@
 
 #include "max-capacity-path/link-capacity-path.h"
 #include "max-capacity-path/satellite-history.h"
+#include "max-capacity-path/fibre-backbone.h"
+#include "max-capacity-path/key-budget.h"
+#include "max-capacity-path/search-prep.h"
+#include "weather-data/calc-weather-data.h"
 
 
 /* Column titles indexed with column symb. refs */
@@ -381,6 +385,8 @@ gdouble get_overlay_values(GtkWidget *overlay, gchar **text) {
 
 MaxSearchParams *get_path_search_fields(GtkWidget *controls) {
     MaxSearchParams *params = malloc(sizeof(MaxSearchParams));
+    params->weather = NULL;
+    params->fibre = NULL;
 
     GtkWidget *src_select = gtk_grid_get_child_at(GTK_GRID(controls), 1, 0);
     params->src = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(src_select));
@@ -479,11 +485,160 @@ GList *generate_path_colors(GList *path_colors, GList *path) {
     return new_colors;
 }
 
+/**
+ * Builds fibre links between ground stations. Uses the module's adjacency
+ * file if one is configured, otherwise connects all stations within the max
+ * fibre distance (km). A distance of 0 means no limit on adjacency file
+ * links and disables the automatic ones.
+ */
+static GHashTable *load_fibre_backbone(GKeyFile *cfgdata, GSList *qths) {
+    gdouble max_distance = FIBRE_DEFAULT_MAX_DISTANCE;
+    gchar *filename = NULL;
+
+    if (cfgdata != NULL && g_key_file_has_key(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                              MOD_CFG_MAX_PATH_VIEW_FIBRE_DIST, NULL)) {
+        max_distance = g_key_file_get_double(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                             MOD_CFG_MAX_PATH_VIEW_FIBRE_DIST, NULL);
+    }
+
+    if (cfgdata != NULL) {
+        filename = g_key_file_get_string(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                         MOD_CFG_MAX_PATH_VIEW_FIBRE_FILE, NULL);
+    }
+
+    if (filename != NULL) {
+        GHashTable *backbone = fibre_backbone_from_file(qths, filename, max_distance);
+        g_free(filename);
+        return backbone;
+    }
+
+    if (max_distance <= 0) return NULL;
+
+    return fibre_backbone_from_distance(qths, max_distance);
+}
+
+/** \brief ERA5 files configured for the module, NULL when not set */
+typedef struct {
+    gchar *vis_file;
+    gchar *cn2_file;
+    gchar *cache_file;
+} weather_files;
+
+static void read_weather_files(GKeyFile *cfgdata, weather_files *files) {
+    files->vis_file = files->cn2_file = files->cache_file = NULL;
+    if (cfgdata == NULL) return;
+
+    files->vis_file = g_key_file_get_string(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                            MOD_CFG_MAX_PATH_VIEW_VIS_FILE, NULL);
+    files->cn2_file = g_key_file_get_string(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                            MOD_CFG_MAX_PATH_VIEW_CN2_FILE, NULL);
+    files->cache_file = g_key_file_get_string(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                              MOD_CFG_MAX_PATH_VIEW_WEATHER_CACHE, NULL);
+}
+
+/**
+ * Weather loader for prepare_search(), runs on the prefetch thread. Reads
+ * the window from the cache (or the ERA5 files) and resamples it onto the
+ * history time grid.
+ */
+static GHashTable *load_search_weather(gpointer user_data, GSList *qths, gdouble t_start, gdouble t_step, guint len) {
+    weather_files *files = (weather_files *)user_data;
+
+    GHashTable *ogs_weather = load_cached_turbulence_data(
+        files->vis_file,
+        files->cn2_file,
+        files->cache_file,
+        qths,
+        t_start,
+        t_start + len * t_step);
+
+    if (ogs_weather == NULL) return NULL;
+
+    GHashTable *weather = weather_to_history_grid(ogs_weather, qths, t_start, t_step, len);
+    g_hash_table_destroy(ogs_weather);
+
+    return weather;
+}
+
+/**
+ * Reruns the search over sampled weather when the module asks for an
+ * ensemble, reusing the satellite history and weather of the search.
+ * Returns NULL when the ensemble is disabled (0 members, the default).
+ */
+static skr_ensemble_t *run_capacity_ensemble(GKeyFile *cfgdata, GSList *sats, GSList *qths,
+                                             search_prep_t *prep, MaxSearchParams *search) {
+    gint members = 0;
+
+    if (cfgdata != NULL) {
+        members = g_key_file_get_integer(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                         MOD_CFG_MAX_PATH_VIEW_ENSEMBLE, NULL);
+    }
+    if (members <= 0) return NULL;
+
+    EnsembleParams ens_params = {
+        .members = (guint)members,
+        .threads = 0,
+        .seed = 0,
+        .vis_sigma = ENSEMBLE_DEFAULT_VIS_SIGMA,
+        .cn2_sigma = ENSEMBLE_DEFAULT_CN2_SIGMA,
+        .base_weather = prep->weather
+    };
+
+    return run_skr_ensemble(sats, prep->sat_history, prep->sat_hist_len, qths, search, &ens_params);
+}
+
+/**
+ * Simulates the key pools of every node over the search window when the
+ * module names a key budget file, and writes the totals and/or the pool
+ * levels over time as csv. Ground stations draw the configured consumption
+ * (kilobytes per day, 0 by default) from their pools.
+ */
+static void run_search_key_budget(GKeyFile *cfgdata, GSList *sats, GSList *qths,
+                                  search_prep_t *prep, MaxSearchParams *search) {
+    if (cfgdata == NULL) return;
+
+    gchar *totals_file = g_key_file_get_string(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                               MOD_CFG_MAX_PATH_VIEW_KEY_TOTALS, NULL);
+    gchar *series_file = g_key_file_get_string(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                               MOD_CFG_MAX_PATH_VIEW_KEY_SERIES, NULL);
+    if (totals_file == NULL && series_file == NULL) return;
+
+    KeyBudgetParams params = {
+        .t_start = search->t_start,
+        .t_step = search->t_step,
+        .threads = 0,
+        .max_isl_range = 0,
+        .station_consumption = g_key_file_get_double(cfgdata, MOD_CFG_MAX_PATH_VIEW_SECTION,
+                                                     MOD_CFG_MAX_PATH_VIEW_KEY_USE, NULL),
+        .sat_consumption = 0,
+        .pool_capacity = 0,
+        .weather = prep->weather,
+        .fibre = search->fibre
+    };
+
+    key_budget_t *budget = run_key_budget(sats, prep->sat_history, prep->sat_hist_len, qths, &params);
+
+    //failures are logged by the writers
+    if (totals_file != NULL) key_budget_save_totals(budget, totals_file);
+    if (series_file != NULL) key_budget_save_series(budget, series_file);
+
+    key_budget_free(budget);
+    g_free(totals_file);
+    g_free(series_file);
+}
+
 void calculate_max_capacity_path(GtkWidget *button, gpointer data) {
     UNUSED(button);
     GtkMaxPathView *obj = (GtkMaxPathView *)data;
 
-    if (obj->max_capacity_path != NULL) free(obj->max_capacity_path); 
+    //maps hold on to the path's cached tracks, let them drop it before it is freed
+    if (obj->max_capacity_path != NULL) {
+        max_path_free(obj->max_capacity_path);
+        obj->max_capacity_path = NULL;
+        g_signal_emit_by_name(obj, "update_path");
+    }
+    skr_ensemble_free(obj->capacity_ensemble);
+    obj->capacity_ensemble = NULL;
 
     MaxSearchParams *search = get_path_search_fields(obj->search_controls);
     if (search == NULL) {
@@ -495,32 +650,50 @@ void calculate_max_capacity_path(GtkWidget *button, gpointer data) {
     double cpu_time_used;
     timer_start = clock();
 
-    guint sat_hist_len = 0;
-    //GHashtable {gint catnr : lw_sat_t[] history}
-    GHashTable *sat_history = generate_sat_pos_data(
-        obj->sats, 
-        &sat_hist_len, 
-        search->t_start, 
-        search->t_end, 
-        search->t_step);
+    //weather is read on its own thread while the satellites are propagated
+    weather_files files;
+    read_weather_files(obj->cfgdata, &files);
+
+    PrepParams prep_params = {
+        .t_start = search->t_start,
+        .t_end = search->t_end,
+        .t_step = search->t_step,
+        .threads = 0,
+        .load_weather = (files.vis_file != NULL && files.cn2_file != NULL ? load_search_weather : NULL),
+        .loader_data = &files
+    };
+    search_prep_t *prep = prepare_search(obj->sats, obj->qths, &prep_params);
  
+    search->weather = prep->weather;
+    search->fibre = load_fibre_backbone(obj->cfgdata, obj->qths);
+
     //returns GList of path_node
     obj->max_capacity_path = get_max_link_path(
         obj->sats, 
-        sat_history, 
-        sat_hist_len, 
+        prep->sat_history, 
+        prep->sat_hist_len, 
         obj->qths,
         search);
 
-    g_hash_table_destroy(sat_history);
+    if (obj->max_capacity_path != NULL && obj->max_capacity_path->size > 0) {
+        obj->capacity_ensemble = run_capacity_ensemble(obj->cfgdata, obj->sats, obj->qths, prep, search);
+    }
+    run_search_key_budget(obj->cfgdata, obj->sats, obj->qths, prep, search);
+
+    search_prep_free(prep);
+    fibre_backbone_free(search->fibre);
+    g_free(files.vis_file);
+    g_free(files.cn2_file);
+    g_free(files.cache_file);
 
     timer_end = clock();
     cpu_time_used = ((double)(timer_end - timer_start)) / CLOCKS_PER_SEC;
     printf("Function took %f seconds to execute (CPU time).\n", cpu_time_used);
 
-    if (obj->max_capacity_path->size == 0) return;
+    if (obj->max_capacity_path == NULL || obj->max_capacity_path->size == 0) return;
 
     obj->path_colors = generate_path_colors(obj->path_colors, obj->max_capacity_path->path);
+    max_path_tracks(obj->max_capacity_path);
 
     g_signal_emit_by_name(obj, "update_path");
 }
@@ -872,12 +1045,22 @@ void update_path_display(GtkWidget *button, gpointer data) {
         gchar *str_data_size = fmted_to_string("Max Data Tranferable: %.2f (kb)", 
             max_path_view->max_capacity_path->size);
         gtk_grid_attach(GTK_GRID(grid), gtk_label_new(str_data_size), 0, 0, 1, 1);
+        guint row = 1;
+
+        skr_ensemble_t *ens = max_path_view->capacity_ensemble;
+        if (ens != NULL) {
+            gchar *str_ensemble = fmted_to_string("Over %u weather samples: p5 %.2f, p50 %.2f, p95 %.2f (kb)",
+                ens->members, skr_ensemble_percentile(ens, 5), skr_ensemble_percentile(ens, 50),
+                skr_ensemble_percentile(ens, 95));
+            gtk_grid_attach(GTK_GRID(grid), gtk_label_new(str_ensemble), 0, row++, 1, 1);
+            free(str_ensemble);
+        }
 
         GList *node = max_path_view->max_capacity_path->path;
         GList *color = max_path_view->path_colors;
         guint node_len = g_list_length(node);
         
-        for (guint i = 1; i < node_len+1; i++) {
+        for (guint i = row; i < node_len+row; i++) {
             gtk_grid_attach(
                 GTK_GRID(grid),
                 new_path_grid_panel((path_node *)node->data, (GdkRGBA *)color->data),
@@ -1079,23 +1262,15 @@ GtkWidget *gtk_max_path_view_new(GKeyFile * cfgdata, GHashTable * sats,
         g_array_append_val(max_path_view->selected, i);
     } 
 
-    // Populate k-d tree for calcuating nearest sat
-    GHashTableIter iter;
-    gpointer key, value;
-    sat_t *sati;
-
-    g_hash_table_iter_init(&iter, sats);
-    max_path_view->kdtree = sat_kdtree_create();
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        sati = SAT(value);
-        sat_kdtree_insert(max_path_view->kdtree, sati);
-    }
+    // Nearest sat lookups use the module's k-d tree, set after creation
+    max_path_view->kdtree = NULL;
 
     max_path_view->qths = qths;
     max_path_view->qth = qth;
 
     max_path_view->path_colors = NULL;
     max_path_view->max_capacity_path = NULL;
+    max_path_view->capacity_ensemble = NULL;
     
     max_path_view->cfgdata = cfgdata;
 
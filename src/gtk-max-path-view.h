@@ -7,6 +7,7 @@
 
 #include "qth-data.h"
 #include "max-capacity-path/path-util.h"
+#include "max-capacity-path/skr-ensemble.h"
 #include "sat-kdtree-utils.h"
 
 
@@ -90,6 +91,7 @@ struct _gtk_max_path_view {
 
     max_path_t      *max_capacity_path;
     GList           *path_colors;               //GList of GdkRGBA
+    skr_ensemble_t  *capacity_ensemble;         //capacity over sampled weather, NULL when disabled
 
     GtkWidget       *search_controls;
     GtkWidget       *display_path;
@@ -110,7 +112,7 @@ struct _gtk_max_path_view {
     
     //gint            selected[NUMBER_OF_SATS];   // Index of selected sat
     GArray          *selected;
-    Kdtree          *kdtree;    // k-d tree to hold satellites
+    Kdtree          *kdtree;    // k-d tree of the module's satellites, not owned
 
     gdouble         tstamp;     // Time stamp of calculations - update by GtkSatModule
 
@@ -927,7 +927,6 @@ GtkWidget *gtk_multiple_sat_new(GKeyFile * cfgdata, GHashTable * sats,
     GtkMultipleSat  *multiple_sat;
     guint           i;
     //gint            selectedcatnum[NUMBER_OF_SATS];
-    sat_t           *sati;
 
     widget = g_object_new(GTK_TYPE_MULTIPLE_SAT, NULL);
     gtk_orientable_set_orientation(GTK_ORIENTABLE(widget),
@@ -959,17 +958,8 @@ GtkWidget *gtk_multiple_sat_new(GKeyFile * cfgdata, GHashTable * sats,
     multiple_sat->qth = qth;
     multiple_sat->cfgdata = cfgdata;
 
-    // Populate k-d tree for calcuating nearest sat
-    GHashTableIter iter;
-    gpointer key, value;
-
-    g_hash_table_iter_init(&iter, sats);
-    multiple_sat->kdtree = sat_kdtree_create();
-    while (g_hash_table_iter_next(&iter, &key, &value))
-    {
-        sati = SAT(value);
-        sat_kdtree_insert(multiple_sat->kdtree, sati);
-    }
+    // Nearest sat lookups use the module's k-d tree, set after creation
+    multiple_sat->kdtree = NULL;
 
     // Initialise column flags
     if (fields > 0)
@@ -148,7 +148,7 @@ struct _gtk_multiple_sat {
 
     void            (*update) (GtkWidget * widget, guint index);     /*!< update function */
 
-    Kdtree          *kdtree;    // k-d tree to hold satellites
+    Kdtree          *kdtree;    // k-d tree of the module's satellites, not owned
 };
 
 struct _GtkMultipleSatClass {
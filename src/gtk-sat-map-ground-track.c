@@ -50,6 +50,8 @@ static void     create_polylines(GtkSatMap * satmap, sat_t * sat, qth_t * qth,
                                  sat_map_obj_t * obj);
 static gboolean ssp_wrap_detected(GtkSatMap * satmap, gdouble x1, gdouble x2);
 static void     free_ssp(gpointer ssp, gpointer data);
+static void     stack_line(GtkSatMap * satmap, sat_map_obj_t * obj,
+                           GooCanvasItemModel * line);
 
 
 /**
@@ -377,7 +379,7 @@ static void create_polylines(GtkSatMap * satmap, sat_t * sat, qth_t * qth,
                                                          CAIRO_LINE_JOIN_MITER,
                                                          NULL);
                     goo_canvas_points_unref(gpoints);
-                    goo_canvas_item_model_lower(line, obj->marker);
+                    stack_line(satmap, obj, line);
 
                     /* store line in sat object */
                     obj->track_data.lines =
@@ -441,7 +443,7 @@ static void create_polylines(GtkSatMap * satmap, sat_t * sat, qth_t * qth,
                                              "line-join",
                                              CAIRO_LINE_JOIN_MITER, NULL);
         goo_canvas_points_unref(gpoints);
-        goo_canvas_item_model_lower(line, obj->marker);
+        stack_line(satmap, obj, line);
 
         /* store line in sat object */
         obj->track_data.lines = g_slist_append(obj->track_data.lines, line);
@@ -452,6 +454,19 @@ static void create_polylines(GtkSatMap * satmap, sat_t * sat, qth_t * qth,
     }
 }
 
+/**
+ * Put a track segment below the satellite marker, or just above the
+ * background when the satellite is drawn by the constellation layer.
+ */
+static void stack_line(GtkSatMap * satmap, sat_map_obj_t * obj,
+                       GooCanvasItemModel * line)
+{
+    if (obj->marker)
+        goo_canvas_item_model_lower(line, obj->marker);
+    else
+        goo_canvas_item_model_raise(line, satmap->map);
+}
+
 /** Check whether ground track wraps around map borders */
 static gboolean ssp_wrap_detected(GtkSatMap * satmap, gdouble x1, gdouble x2)
 {
@@ -205,6 +205,10 @@ static void coverage_toggled(GtkCheckMenuItem * item, gpointer data)
         covcol = 0x00000000;
     }
 
+    /* the constellation layer picks up showcov on the next update */
+    if (obj->range1 == NULL)
+        return;
+
     g_object_set(obj->range1, "fill-color-rgba", covcol, NULL);
 
     if (obj->newrcnum == 2)
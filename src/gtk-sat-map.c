@@ -47,8 +47,9 @@
 #include "sgpsdp/sgp4sdp4.h"
 #include "time-tools.h"
 #include "calc-dist-two-sat.h"
-#include "sat-graph.h"
+#include "live-path.h"
 #include "qth-data.h"
+#include "range-circle.h"
 
 #define MARKER_SIZE_HALF    1
 
@@ -64,6 +65,12 @@ static void     size_allocate_cb(GtkWidget * widget,
                                  GtkAllocation * allocation, gpointer data);
 static void     update_map_size(GtkSatMap * satmap);
 static void     update_sat(gpointer key, gpointer value, gpointer data);
+static gboolean footprint_changed(GtkSatMap * satmap, sat_map_obj_t * obj,
+                                  sat_t * sat);
+static void     update_sats(GtkSatMap * satmap);
+static void     update_layer(GtkSatMap * satmap);
+static void     set_obj_colour(sat_map_obj_t * obj, guint32 col);
+static void     set_layer_projection(GtkSatMap * satmap);
 static void     plot_sat(gpointer key, gpointer value, gpointer data);
 static void     free_sat_obj(gpointer key, gpointer value, gpointer data);
 static void     lonlat_to_xy(GtkSatMap * m, gdouble lon, gdouble lat,
@@ -74,6 +81,9 @@ static gboolean on_motion_notify(GooCanvasItem * item, GooCanvasItem * target,
                                  GdkEventMotion * event, gpointer data);
 static void     on_item_created(GooCanvas * canvas, GooCanvasItem * item,
                                 GooCanvasItemModel * model, gpointer data);
+static gboolean on_query_tooltip(GooCanvasItem * item, gdouble x, gdouble y,
+                                 gboolean keyboard_mode, GtkTooltip * tooltip,
+                                 gpointer data);
 static void     on_canvas_realized(GtkWidget * canvas, gpointer data);
 static gboolean on_button_press(GooCanvasItem * item,
                                 GooCanvasItem * target,
@@ -81,10 +91,19 @@ static gboolean on_button_press(GooCanvasItem * item,
 static gboolean on_button_release(GooCanvasItem * item,
                                   GooCanvasItem * target,
                                   GdkEventButton * event, gpointer data);
+static gboolean sat_button_press(GtkSatMap * satmap, gint catnum,
+                                 GdkEventButton * event);
+static gboolean sat_button_release(GtkSatMap * satmap, gint catnum,
+                                   GdkEventButton * event);
+static gboolean on_layer_button_press(GooCanvasItem * item,
+                                      GooCanvasItem * target,
+                                      GdkEventButton * event, gpointer data);
+static gboolean on_layer_button_release(GooCanvasItem * item,
+                                        GooCanvasItem * target,
+                                        GdkEventButton * event, gpointer data);
 static void     clear_selection(gpointer key, gpointer val, gpointer data);
 static void     load_map_file(GtkSatMap * satmap, float clon);
 static GooCanvasItemModel *create_canvas_model(GtkSatMap * satmap);
-static gdouble  arccos(gdouble, gdouble);
 static gboolean pole_is_covered(sat_t * sat);
 static gboolean north_pole_is_covered(sat_t * sat);
 static gboolean south_pole_is_covered(sat_t * sat);
@@ -106,6 +125,7 @@ static void     redraw_grid_lines(GtkSatMap * satmap);
 static void     draw_terminator(GtkSatMap * satmap, GooCanvasItemModel * root);
 static void     redraw_terminator(GtkSatMap * satmap);
 static gchar   *aoslos_time_to_str(GtkSatMap * satmap, sat_t * sat);
+static gchar   *sat_tooltip(GtkSatMap * satmap, sat_t * sat);
 static void     gtk_sat_map_load_showtracks(GtkSatMap * map);
 static void     gtk_sat_map_store_showtracks(GtkSatMap * satmap);
 static void     gtk_sat_map_load_hide_coverages(GtkSatMap * map);
@@ -175,6 +195,8 @@ static void gtk_sat_map_init(GtkSatMap * satmap,
     satmap->qth = NULL;
     satmap->qth2 = NULL;
     satmap->obj = NULL;
+    satmap->live_path = NULL;
+    satmap->layer = NULL;
     satmap->showtracks = g_hash_table_new_full(g_int_hash, g_int_equal,
                                                NULL, NULL);
     satmap->hidecovs = g_hash_table_new_full(g_int_hash, g_int_equal,
@@ -216,6 +238,9 @@ static void gtk_sat_map_destroy(GtkWidget * widget)
         g_hash_table_destroy(satmap->obj);
         satmap->obj = NULL;
 
+        sat_map_layer_free(satmap->layer);
+        satmap->layer = NULL;
+
         /* these objects destruct themselves cleanly */
         g_object_unref(satmap->origmap);
         satmap->origmap = NULL;
@@ -306,6 +331,10 @@ static void gtk_sat_map_destroy(GtkWidget * widget)
         if (idx != -1)
             goo_canvas_item_model_remove_child(root, idx);
         satmap->map = NULL;
+
+        /* Stop the path worker before its lines go away */
+        live_path_free(satmap->live_path);
+        satmap->live_path = NULL;
         
         /* Clean up shortest path lines */
         if (shortest_path_line_qth1_sat) {
@@ -439,6 +468,23 @@ GtkWidget      *gtk_sat_map_new(GKeyFile * cfgdata, GHashTable * sats,
 
     gtk_widget_show(satmap->canvas);
 
+    /* too many satellites for canvas items, draw them in one layer */
+    if (sat_map_use_layer(cfgdata, MOD_CFG_MAP_SECTION, sats))
+    {
+        satmap->layer = sat_map_layer_new(satmap->canvas, MARKER_SIZE_HALF);
+        sat_map_layer_set_colours(satmap->layer,
+                                  mod_cfg_get_int(cfgdata, MOD_CFG_MAP_SECTION,
+                                                  MOD_CFG_MAP_SAT_COL,
+                                                  SAT_CFG_INT_MAP_SAT_COL),
+                                  mod_cfg_get_int(cfgdata, MOD_CFG_MAP_SECTION,
+                                                  MOD_CFG_MAP_SAT_SEL_COL,
+                                                  SAT_CFG_INT_MAP_SAT_SEL_COL),
+                                  mod_cfg_get_int(cfgdata, MOD_CFG_MAP_SECTION,
+                                                  MOD_CFG_MAP_SAT_COV_COL,
+                                                  SAT_CFG_INT_MAP_SAT_COV_COL));
+        set_layer_projection(satmap);
+    }
+
     root = create_canvas_model(satmap);
     goo_canvas_set_root_item_model(GOO_CANVAS(satmap->canvas), root);
     g_object_unref(root);
@@ -757,11 +803,39 @@ static void update_map_size(GtkSatMap * satmap)
                      "x", (gdouble) satmap->x0 + satmap->width - 2,
                      "y", (gdouble) satmap->y0 + satmap->height - 1, NULL);
 
-        g_hash_table_foreach(satmap->sats, update_sat, satmap);
+        set_layer_projection(satmap);
+        update_sats(satmap);
         satmap->resize = FALSE;
     }
 }
 
+/* Update every satellite, refilling the constellation layer if there is one */
+static void update_sats(GtkSatMap * satmap)
+{
+    if (satmap->layer)
+        sat_map_layer_clear(satmap->layer);
+
+    g_hash_table_foreach(satmap->sats, update_sat, satmap);
+
+    if (satmap->layer)
+        sat_map_layer_commit(satmap->layer);
+}
+
+static void set_layer_projection(GtkSatMap * satmap)
+{
+    if (satmap->layer)
+        sat_map_layer_set_projection(satmap->layer, satmap->x0, satmap->y0,
+                                     satmap->width, satmap->height,
+                                     satmap->left_side_lon);
+}
+
+/* Redraw the layer after a selection change without waiting for the next refresh */
+static void update_layer(GtkSatMap * satmap)
+{
+    if (satmap->layer)
+        update_sats(satmap);
+}
+
 static void on_canvas_realized(GtkWidget * canvas, gpointer data)
 {
     GtkSatMap      *satmap = GTK_SAT_MAP(data);
@@ -857,7 +931,7 @@ void gtk_sat_map_update(GtkWidget * widget)
                       "x", (gdouble) satmap->x0 + 4,
                       "y", (gdouble) satmap->y0 + 2, NULL);
 
-        g_hash_table_foreach(satmap->sats, update_sat, satmap);
+        update_sats(satmap);
 
         /* Update the Solar Terminator if necessary */
         // Solar terminator is a moving line that divides the daylit side and
@@ -1006,6 +1080,9 @@ static gboolean on_motion_notify(GooCanvasItem * item,
     (void)target;
     (void)item;
 
+    if (satmap->layer)
+        sat_map_layer_hover(satmap->layer, event->x, event->y);
+
     /* set text only if QTH info is enabled */
     if (satmap->cursinfo)
     {
@@ -1044,6 +1121,15 @@ static void on_item_created(GooCanvas * canvas,
         /* root item / canvas */
         g_signal_connect(item, "motion_notify_event",
                          (GCallback) on_motion_notify, data);
+
+        /* satellites drawn by the layer have no items of their own */
+        if (GTK_SAT_MAP(data)->layer)
+        {
+            g_signal_connect(item, "button_press_event",
+                             (GCallback) on_layer_button_press, data);
+            g_signal_connect(item, "button_release_event",
+                             (GCallback) on_layer_button_release, data);
+        }
     }
     else if (!g_object_get_data(G_OBJECT(item), "skip-signal-connection"))
     {
@@ -1051,22 +1137,67 @@ static void on_item_created(GooCanvas * canvas,
                          (GCallback) on_button_press, data);
         g_signal_connect(item, "button_release_event",
                          (GCallback) on_button_release, data);
+        g_signal_connect(item, "query-tooltip",
+                         (GCallback) on_query_tooltip, data);
     }
 }
 
+/**
+ * Build the tooltip of a satellite marker or label when it is shown.
+ *
+ * The tooltip holds the current position and AOS/LOS countdown, which change
+ * on almost every cycle, so it is not kept up to date on the items.
+ */
+static gboolean on_query_tooltip(GooCanvasItem * item, gdouble x, gdouble y,
+                                 gboolean keyboard_mode, GtkTooltip * tooltip,
+                                 gpointer data)
+{
+    GtkSatMap      *satmap = GTK_SAT_MAP(data);
+    GooCanvasItemModel *model = goo_canvas_item_get_model(item);
+    gint            catnum;
+    sat_map_obj_t  *obj;
+    sat_t          *sat;
+    gchar          *text;
+
+    (void)x;
+    (void)y;
+    (void)keyboard_mode;
+
+    catnum = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(model), "catnum"));
+    obj = SAT_MAP_OBJ(g_hash_table_lookup(satmap->obj, &catnum));
+    sat = SAT(g_hash_table_lookup(satmap->sats, &catnum));
+
+    /* the range circles carry the catnum too but have no tooltip */
+    if (obj == NULL || sat == NULL ||
+        (model != obj->marker && model != obj->label))
+        return FALSE;
+
+    text = sat_tooltip(satmap, sat);
+    gtk_tooltip_set_markup(tooltip, text);
+    g_free(text);
+
+    return TRUE;
+}
+
 static gboolean on_button_press(GooCanvasItem * item,
                                 GooCanvasItem * target, GdkEventButton * event,
                                 gpointer data)
 {
     GooCanvasItemModel *model = goo_canvas_item_get_model(item);
-    GtkSatMap      *satmap = GTK_SAT_MAP(data);
     gint            catnum =
         GPOINTER_TO_INT(g_object_get_data(G_OBJECT(model), "catnum"));
-    gint           *catpoint = NULL;
-    sat_t          *sat = NULL;
 
     (void)target;
 
+    return sat_button_press(GTK_SAT_MAP(data), catnum, event);
+}
+
+static gboolean sat_button_press(GtkSatMap * satmap, gint catnum,
+                                 GdkEventButton * event)
+{
+    gint           *catpoint = NULL;
+    sat_t          *sat = NULL;
+
     switch (event->button)
     {
         /* double-left-click */
@@ -1079,7 +1210,7 @@ static gboolean on_button_press(GooCanvasItem * item,
             sat = SAT(g_hash_table_lookup(satmap->sats, catpoint));
             if (sat != NULL)
             {
-                show_sat_info(sat, gtk_widget_get_toplevel(GTK_WIDGET(data)));
+                show_sat_info(sat, gtk_widget_get_toplevel(GTK_WIDGET(satmap)));
             }
             else
             {
@@ -1118,15 +1249,21 @@ static gboolean on_button_release(GooCanvasItem * item,
                                   GdkEventButton * event, gpointer data)
 {
     GooCanvasItemModel *model = goo_canvas_item_get_model(item);
-    GtkSatMap      *satmap = GTK_SAT_MAP(data);
     gint            catnum =
         GPOINTER_TO_INT(g_object_get_data(G_OBJECT(model), "catnum"));
+
+    (void)target;
+
+    return sat_button_release(GTK_SAT_MAP(data), catnum, event);
+}
+
+static gboolean sat_button_release(GtkSatMap * satmap, gint catnum,
+                                   GdkEventButton * event)
+{
     gint           *catpoint = NULL;
     sat_map_obj_t  *obj = NULL;
     guint32         col;
 
-    (void)target;
-
     catpoint = g_try_new0(gint, 1);
     *catpoint = catnum;
 
@@ -1164,19 +1301,11 @@ static gboolean on_button_release(GooCanvasItem * item,
                 g_object_set(satmap->sel, "text", "", NULL);
             }
 
-            g_object_set(obj->marker,
-                         "fill-color-rgba", col,
-                         "stroke-color-rgba", col, NULL);
-            g_object_set(obj->label,
-                         "fill-color-rgba", col,
-                         "stroke-color-rgba", col, NULL);
-            g_object_set(obj->range1, "stroke-color-rgba", col, NULL);
-
-            if (obj->oldrcnum == 2)
-                g_object_set(obj->range2, "stroke-color-rgba", col, NULL);
+            set_obj_colour(obj, col);
 
             /* clear other selections */
             g_hash_table_foreach(satmap->obj, clear_selection, catpoint);
+            update_layer(satmap);
         }
         break;
     default:
@@ -1188,6 +1317,51 @@ static gboolean on_button_release(GooCanvasItem * item,
     return TRUE;
 }
 
+/* Clicks on the background go to the satellite the layer has drawn there */
+static gboolean on_layer_button_press(GooCanvasItem * item,
+                                      GooCanvasItem * target,
+                                      GdkEventButton * event, gpointer data)
+{
+    GtkSatMap      *satmap = GTK_SAT_MAP(data);
+    sat_t          *sat = sat_map_layer_pick(satmap->layer, event->x, event->y,
+                                             2 * MARKER_SIZE_HALF + 3);
+
+    (void)item;
+    (void)target;
+
+    return sat ? sat_button_press(satmap, sat->tle.catnr, event) : FALSE;
+}
+
+static gboolean on_layer_button_release(GooCanvasItem * item,
+                                        GooCanvasItem * target,
+                                        GdkEventButton * event, gpointer data)
+{
+    GtkSatMap      *satmap = GTK_SAT_MAP(data);
+    sat_t          *sat = sat_map_layer_pick(satmap->layer, event->x, event->y,
+                                             2 * MARKER_SIZE_HALF + 3);
+
+    (void)item;
+    (void)target;
+
+    return sat ? sat_button_release(satmap, sat->tle.catnr, event) : FALSE;
+}
+
+/* Colour the canvas items of a satellite, the layer colours by flag instead */
+static void set_obj_colour(sat_map_obj_t * obj, guint32 col)
+{
+    if (obj->marker == NULL)
+        return;
+
+    g_object_set(obj->marker,
+                 "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
+    g_object_set(obj->label,
+                 "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
+    g_object_set(obj->range1, "stroke-color-rgba", col, NULL);
+
+    if (obj->oldrcnum == 2)
+        g_object_set(obj->range2, "stroke-color-rgba", col, NULL);
+}
+
 static void clear_selection(gpointer key, gpointer val, gpointer data)
 {
     gint           *old = key;
@@ -1202,14 +1376,7 @@ static void clear_selection(gpointer key, gpointer val, gpointer data)
         /** FIXME: this is only global default; need the satmap here! */
         col = sat_cfg_get_int(SAT_CFG_INT_MAP_SAT_COL);
 
-        g_object_set(obj->marker,
-                     "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
-        g_object_set(obj->label,
-                     "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
-        g_object_set(obj->range1, "stroke-color-rgba", col, NULL);
-
-        if (obj->oldrcnum == 2)
-            g_object_set(obj->range2, "stroke-color-rgba", col, NULL);
+        set_obj_colour(obj, col);
     }
 }
 
@@ -1239,17 +1406,11 @@ void gtk_sat_map_select_sat(GtkWidget * satmap, gint catnum)
                               MOD_CFG_MAP_SAT_SEL_COL,
                               SAT_CFG_INT_MAP_SAT_SEL_COL);
 
-        g_object_set(obj->marker,
-                     "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
-        g_object_set(obj->label,
-                     "fill-color-rgba", col, "stroke-color-rgba", col, NULL);
-        g_object_set(obj->range1, "stroke-color-rgba", col, NULL);
-
-        if (obj->oldrcnum == 2)
-            g_object_set(obj->range2, "stroke-color-rgba", col, NULL);
+        set_obj_colour(obj, col);
 
         /* clear other selections */
         g_hash_table_foreach(smap->obj, clear_selection, catpoint);
+        update_layer(smap);
     }
 
     g_free(catpoint);
@@ -1370,19 +1531,6 @@ static void load_map_file(GtkSatMap * satmap, float clon)
         satmap->left_side_lon = 180.0 + clon;
 }
 
-static gdouble arccos(gdouble x, gdouble y)
-{
-    if (x && y)
-    {
-        if (y > 0.0)
-            return acos(x / y);
-        else if (y < 0.0)
-            return pi + acos(x / y);
-    }
-
-    return 0.0;
-}
-
 /* Check whether the footprint covers the North or South pole. */
 static gboolean pole_is_covered(sat_t * sat)
 {
@@ -1516,8 +1664,9 @@ static guint calculate_footprint(GtkSatMap * satmap, sat_t * sat)
 {
     guint           azi;
     gfloat          sx, sy, msx, msy, ssx, ssy;
-    gdouble         ssplat, ssplon, beta, azimuth, num, dem;
-    gdouble         rangelon, rangelat, mlon;
+    gdouble         beta, mlon;
+    gdouble         rangelat[RANGE_CIRCLE_POINTS];
+    gdouble         rangelon[RANGE_CIRCLE_POINTS];
     gboolean        warped = FALSE;
     guint           numrc = 1;
 
@@ -1526,45 +1675,19 @@ static guint calculate_footprint(GtkSatMap * satmap, sat_t * sat)
      * who borrowed from John Magliacane, KD2BD.
      * Optimized by Alexandru Csete and William J Beksi.
      */
-    ssplat = sat->ssplat * de2ra;
-    ssplon = sat->ssplon * de2ra;
     beta = (0.5 * sat->footprint) / xkmper;
 
-    for (azi = 0; azi < 180; azi++)
-    {
-        azimuth = de2ra * (double)azi;
-        rangelat = asin(sin(ssplat) * cos(beta) + cos(azimuth) *
-                        sin(beta) * cos(ssplat));
-        num = cos(beta) - (sin(ssplat) * sin(rangelat));
-        dem = cos(ssplat) * cos(rangelat);
-
-        if (azi == 0 && north_pole_is_covered(sat))
-            rangelon = ssplon + pi;
-        else if (fabs(num / dem) > 1.0)
-            rangelon = ssplon;
-        else
-        {
-            if ((180.0 - azi) >= 0)
-                rangelon = ssplon - arccos(num, dem);
-            else
-                rangelon = ssplon + arccos(num, dem);
-        }
-
-        while (rangelon < -pi)
-            rangelon += twopi;
-
-        while (rangelon > (pi))
-            rangelon -= twopi;
-
-        rangelat = rangelat / de2ra;
-        rangelon = rangelon / de2ra;
+    range_circle_half(sat->ssplat, sat->ssplon, beta, north_pole_is_covered(sat),
+                      rangelat, rangelon);
 
+    for (azi = 0; azi < RANGE_CIRCLE_POINTS; azi++)
+    {
         /* mirror longitude */
-        if (mirror_lon(sat, rangelon, &mlon, satmap->left_side_lon))
+        if (mirror_lon(sat, rangelon[azi], &mlon, satmap->left_side_lon))
             warped = TRUE;
 
-        lonlat_to_xy(satmap, rangelon, rangelat, &sx, &sy);
-        lonlat_to_xy(satmap, mlon, rangelat, &msx, &msy);
+        lonlat_to_xy(satmap, rangelon[azi], rangelat[azi], &sx, &sy);
+        lonlat_to_xy(satmap, mlon, rangelat[azi], &msx, &msy);
 
         points1->coords[2 * azi] = sx;
         points1->coords[2 * azi + 1] = sy;
@@ -1979,7 +2102,6 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
     gint           *catnum;
     guint32         col, covcol, shadowcol;
     gfloat          x, y;
-    gchar          *tooltip;
 
     (void)key;
 
@@ -2031,6 +2153,22 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
     obj->track_data.latlon = NULL;
     obj->track_data.lines = NULL;
     obj->track_orbit = 0;
+    obj->x = x;
+    obj->y = y;
+    obj->footprint = sat->footprint;
+    obj->nickname = g_strdup(sat->nickname);
+
+    if (satmap->layer)
+    {
+        /* drawn by the constellation layer, no canvas items */
+        obj->marker = NULL;
+        obj->shadowm = NULL;
+        obj->label = NULL;
+        obj->shadowl = NULL;
+        obj->range1 = NULL;
+        g_hash_table_insert(satmap->obj, catnum, obj);
+        return;
+    }
 
     root = goo_canvas_get_root_item_model(GOO_CANVAS(satmap->canvas));
 
@@ -2064,15 +2202,7 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
                                 MOD_CFG_MAP_SHADOW_ALPHA,
                                 SAT_CFG_INT_MAP_SHADOW_ALPHA);
 
-    /* create tooltip */
-    tooltip = g_markup_printf_escaped("<b>%s</b>\n"
-                                      "Lon: %5.1f\302\260\n"
-                                      "Lat: %5.1f\302\260\n"
-                                      " Az: %5.1f\302\260\n"
-                                      " El: %5.1f\302\260",
-                                      sat->nickname,
-                                      sat->ssplon, sat->ssplat,
-                                      sat->az, sat->el);
+    /* tooltips are built when shown, see on_query_tooltip() */
 
     /* create satellite marker and label + shadows. We create shadows first */
     obj->shadowm = goo_canvas_rect_model_new(root,
@@ -2090,7 +2220,7 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
                                             2 * MARKER_SIZE_HALF,
                                             "fill-color-rgba", col,
                                             "stroke-color-rgba", col,
-                                            "tooltip", tooltip, NULL);
+                                            NULL);
 
     obj->shadowl = goo_canvas_text_model_new(root, sat->nickname,
                                              x + 1,
@@ -2106,10 +2236,7 @@ static void plot_sat(gpointer key, gpointer value, gpointer data)
                                            -1,
                                            GOO_CANVAS_ANCHOR_NORTH,
                                            "font", "Sans 8",
-                                           "fill-color-rgba", col,
-                                           "tooltip", tooltip, NULL);
-
-    g_free(tooltip);
+                                           "fill-color-rgba", col, NULL);
 
     g_object_set_data(G_OBJECT(obj->marker), "catnum",
                       GINT_TO_POINTER(*catnum));
@@ -2223,6 +2350,9 @@ static void free_sat_obj(gpointer key, gpointer value, gpointer data)
         goo_canvas_item_model_remove_child(root, idx);
     obj->range2 = NULL;
 
+    g_free(obj->nickname);
+    obj->nickname = NULL;
+
     if (obj->showtrack)
     {
         sat = SAT(g_hash_table_lookup(satmap->sats, &obj->catnum));
@@ -2230,100 +2360,53 @@ static void free_sat_obj(gpointer key, gpointer value, gpointer data)
     }
 }
 
-/** Update a given satellite. */
-static void update_sat(gpointer key, gpointer value, gpointer data)
+/**
+ * Check whether the footprint radius has changed by a pixel or more since the
+ * range circle was last drawn. The footprint is a diameter in km and one pixel
+ * north-south is pi * xkmper / height km.
+ */
+static gboolean footprint_changed(GtkSatMap * satmap, sat_map_obj_t * obj,
+                                  sat_t * sat)
+{
+    return fabs(sat->footprint - obj->footprint) * 0.5 * satmap->height >=
+        pi * xkmper;
+}
+
+/** Move the canvas items of a satellite, the map is not using the layer. */
+static void update_sat_items(GtkSatMap * satmap, sat_t * sat,
+                             sat_map_obj_t * obj)
 {
-    gint           *catnum;
-    GtkSatMap      *satmap = GTK_SAT_MAP(data);
-    sat_map_obj_t  *obj = NULL;
-    sat_t          *sat = SAT(value);
     gfloat          x, y;
-    gdouble         oldx, oldy;
-    gdouble         now;        // = get_current_daynum ();
+    gboolean        moved;
     GooCanvasItemModel *root;
     gint            idx;
     guint32         col, covcol;
-    gchar          *tooltip;
-    gchar          *aosstr;
-
-    //gdouble sspla,ssplo;
 
     root = goo_canvas_get_root_item_model(GOO_CANVAS(satmap->canvas));
 
-    catnum = g_new0(gint, 1);
-    *catnum = sat->tle.catnr;
-
-    now = satmap->tstamp;
-
-    /* update next AOS */
-    if (sat->aos > now)
-    {
-        if ((sat->aos < satmap->naos) || (satmap->naos == 0.0))
-        {
-            satmap->naos = sat->aos;
-            satmap->ncat = sat->tle.catnr;
-        }
-    }
-
-    obj = SAT_MAP_OBJ(g_hash_table_lookup(satmap->obj, catnum));
-
-    /* get rid of a decayed satellite */
-    if (decayed(sat) && obj != NULL)
-    {
-        free_sat_obj(NULL, obj, satmap);
-        g_hash_table_remove(satmap->obj, catnum);
-        return;
-    }
-
-    if (obj == NULL)
-    {
-        if (decayed(sat))
-        {
-            return;
-        }
-        else
-        {
-            /* satellite was decayed now is visible
-               time controller backed up time */
-            plot_sat(key, value, data);
-            return;
-        }
-    }
-
-    if (obj->selected)
+    /* every property set makes the canvas redraw the item */
+    if (g_strcmp0(sat->nickname, obj->nickname))
     {
-        /* update satmap->sel */
-        update_selected(satmap, sat);
+        g_object_set(obj->label, "text", sat->nickname, NULL);
+        g_object_set(obj->shadowl, "text", sat->nickname, NULL);
+        g_free(obj->nickname);
+        obj->nickname = g_strdup(sat->nickname);
     }
 
-    g_object_set(obj->label, "text", sat->nickname, NULL);
-    g_object_set(obj->shadowl, "text", sat->nickname, NULL);
-
-    aosstr = aoslos_time_to_str(satmap, sat);
-    tooltip = g_markup_printf_escaped("<b>%s</b>\n"
-                                      "Lon: %5.1f\302\260\n"
-                                      "Lat: %5.1f\302\260\n"
-                                      " Az: %5.1f\302\260\n"
-                                      " El: %5.1f\302\260\n"
-                                      "%s",
-                                      sat->nickname,
-                                      sat->ssplon, sat->ssplat,
-                                      sat->az, sat->el, aosstr);
-    g_object_set(obj->marker, "tooltip", tooltip, NULL);
-    g_object_set(obj->label, "tooltip", tooltip, NULL);
-    g_free(tooltip);
-    g_free(aosstr);
-
     lonlat_to_xy(satmap, sat->ssplon, sat->ssplat, &x, &y);
 
     /* update only if satellite has moved at least
        2 * MARKER_SIZE_HALF (no need to drain CPU all the time)
      */
-    g_object_get(obj->marker, "x", &oldx, "y", &oldy, NULL);
+    moved = satmap->resize ||
+        (fabs(obj->x - x) >= 2 * MARKER_SIZE_HALF) ||
+        (fabs(obj->y - y) >= 2 * MARKER_SIZE_HALF);
 
-    if ((fabs(oldx - x) >= 2 * MARKER_SIZE_HALF) ||
-        (fabs(oldy - y) >= 2 * MARKER_SIZE_HALF))
+    if (moved)
     {
+        obj->x = x;
+        obj->y = y;
+
         g_object_set(obj->marker,
                      "x", (gdouble) (x - MARKER_SIZE_HALF),
                      "y", (gdouble) (y - MARKER_SIZE_HALF), NULL);
@@ -2373,6 +2456,12 @@ static void update_sat(gpointer key, gpointer value, gpointer data)
                          "y", (gdouble) (y + 2 + 1),
                          "anchor", GOO_CANVAS_ANCHOR_NORTH, NULL);
         }
+    }
+
+    /* slow GEO and MEO satellites keep their range circle for many cycles */
+    if (moved || footprint_changed(satmap, obj, sat))
+    {
+        obj->footprint = sat->footprint;
 
         /* initialize points for footprint */
         points1 = goo_canvas_points_new(360);
@@ -2427,7 +2516,7 @@ static void update_sat(gpointer key, gpointer value, gpointer data)
                                                             CAIRO_LINE_JOIN_MITER,
                                                             NULL);
                 g_object_set_data(G_OBJECT(obj->range2), "catnum",
-                                  GINT_TO_POINTER(*catnum));
+                                  GINT_TO_POINTER(obj->catnum));
             }
             else
             {
@@ -2454,6 +2543,73 @@ static void update_sat(gpointer key, gpointer value, gpointer data)
         goo_canvas_points_unref(points1);
         goo_canvas_points_unref(points2);
     }
+}
+
+/** Update a given satellite. */
+static void update_sat(gpointer key, gpointer value, gpointer data)
+{
+    gint           *catnum;
+    GtkSatMap      *satmap = GTK_SAT_MAP(data);
+    sat_map_obj_t  *obj = NULL;
+    sat_t          *sat = SAT(value);
+    gdouble         now;        // = get_current_daynum ();
+
+    catnum = g_new0(gint, 1);
+    *catnum = sat->tle.catnr;
+
+    now = satmap->tstamp;
+
+    /* update next AOS */
+    if (sat->aos > now)
+    {
+        if ((sat->aos < satmap->naos) || (satmap->naos == 0.0))
+        {
+            satmap->naos = sat->aos;
+            satmap->ncat = sat->tle.catnr;
+        }
+    }
+
+    obj = SAT_MAP_OBJ(g_hash_table_lookup(satmap->obj, catnum));
+
+    /* get rid of a decayed satellite */
+    if (decayed(sat) && obj != NULL)
+    {
+        free_sat_obj(NULL, obj, satmap);
+        g_hash_table_remove(satmap->obj, catnum);
+        return;
+    }
+
+    if (obj == NULL)
+    {
+        if (decayed(sat))
+        {
+            return;
+        }
+        else
+        {
+            /* satellite was decayed now is visible
+               time controller backed up time */
+            plot_sat(key, value, data);
+            return;
+        }
+    }
+
+    if (obj->selected)
+    {
+        /* update satmap->sel */
+        update_selected(satmap, sat);
+    }
+
+    if (satmap->layer)
+    {
+        sat_map_layer_add(satmap->layer, sat,
+                          (obj->selected ? SAT_MAP_LAYER_SELECTED : 0) |
+                          (obj->showcov ? SAT_MAP_LAYER_FOOTPRINT : 0));
+    }
+    else
+    {
+        update_sat_items(satmap, sat, obj);
+    }
 
     /* if ground track is visible check whether we have passed into a
        new orbit, in which case we need to recalculate the ground track
@@ -2965,192 +3121,145 @@ static void reset_ground_track(gpointer key, gpointer value,
     obj->track_orbit = 0;
 }
 
-static void draw_shortest_path_on_map(GtkSatMap *satmap)
+/* Current sub satellite point of a path node, falls back to where the worker saw it */
+static void path_node_xy(GtkSatMap *satmap, const live_path_node *node, gfloat *x, gfloat *y)
+{
+    sat_t *sat = g_hash_table_lookup(satmap->sats, &node->catnr);
+
+    if (sat)
+        lonlat_to_xy(satmap, sat->ssplon, sat->ssplat, x, y);
+    else
+        lonlat_to_xy(satmap, node->ssplon, node->ssplat, x, y);
+}
+
+static void draw_path_lines(GtkSatMap *satmap, GArray *path,
+                            GooCanvasItemModel *qth1_sat,
+                            GooCanvasItemModel *sats,
+                            GooCanvasItemModel *sat_qth2)
 {
     GooCanvasPoints *points;
-    GList *sat_list = NULL;
-    sat_t *closest_sat1 = NULL;
-    sat_t *closest_sat2 = NULL;
-    gdouble min_dist1 = DBL_MAX;
-    gdouble min_dist2 = DBL_MAX;
+    gfloat x1, y1, x2, y2;
 
-    /* Ensure ground stations and satellites exist */
-    if (!satmap->qth || !satmap->qth2 || !satmap->sats || g_hash_table_size(satmap->sats) == 0) {
-        // Hide all lines if no data
-        g_object_set(shortest_path_line_qth1_sat, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-        g_object_set(shortest_path_line_sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-        g_object_set(shortest_path_line_sat_qth2, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-        g_object_set(unrealistic_path_line_qth1_sat, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-        g_object_set(unrealistic_path_line_sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-        g_object_set(unrealistic_path_line_sat_qth2, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+    if (!path || path->len == 0) {
+        g_object_set(qth1_sat, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+        g_object_set(sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+        g_object_set(sat_qth2, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
         return;
     }
 
-    /* 1. Find closest satellites to each QTH */
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, satmap->sats);
-    while (g_hash_table_iter_next(&iter, &key, &value))
-    {
-        sat_t *current_sat = (sat_t *)value;
-        if (decayed(current_sat)) continue;
-
-        sat_list = g_list_append(sat_list, current_sat);
-
-        gdouble dist1 = sat_qth_distance(current_sat, satmap->qth);
-        if (dist1 < min_dist1) {
-            min_dist1 = dist1;
-            closest_sat1 = current_sat;
-        }
+    lonlat_to_xy(satmap, satmap->qth->lon, satmap->qth->lat, &x1, &y1);
+    path_node_xy(satmap, &g_array_index(path, live_path_node, 0), &x2, &y2);
+    points = goo_canvas_points_new(2);
+    points->coords[0] = x1; points->coords[1] = y1;
+    points->coords[2] = x2; points->coords[3] = y2;
+    g_object_set(qth1_sat, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
+    goo_canvas_points_unref(points);
 
-        gdouble dist2 = sat_qth_distance(current_sat, satmap->qth2);
-        if (dist2 < min_dist2) {
-            min_dist2 = dist2;
-            closest_sat2 = current_sat;
+    if (path->len > 1) {
+        points = goo_canvas_points_new(path->len);
+        for (guint i = 0; i < path->len; i++) {
+            gfloat temp_x, temp_y;
+            path_node_xy(satmap, &g_array_index(path, live_path_node, i), &temp_x, &temp_y);
+            points->coords[i*2] = temp_x;
+            points->coords[i*2+1] = temp_y;
         }
+        g_object_set(sats, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
+        goo_canvas_points_unref(points);
+    } else {
+        g_object_set(sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
     }
 
-    if (!closest_sat1 || !closest_sat2) {
-        g_list_free(sat_list);
-        return; // No satellites to work with
-    }
-
-    /* --- 2. REALISTIC PATH (GREEN) --- */
-    {
-        SatGraph *realistic_graph = sat_graph_new();
-        GList *path = NULL;
+    path_node_xy(satmap, &g_array_index(path, live_path_node, path->len - 1), &x1, &y1);
+    lonlat_to_xy(satmap, satmap->qth2->lon, satmap->qth2->lat, &x2, &y2);
+    points = goo_canvas_points_new(2);
+    points->coords[0] = x1; points->coords[1] = y1;
+    points->coords[2] = x2; points->coords[3] = y2;
+    g_object_set(sat_qth2, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
+    goo_canvas_points_unref(points);
+}
 
-        // Build realistic graph with LOS check
-        for (GList *l1 = sat_list; l1 != NULL; l1 = l1->next) {
-            sat_t *s1 = (sat_t *)l1->data;
-            sat_graph_add_vertex(realistic_graph, s1);
-            for (GList *l2 = g_list_next(l1); l2 != NULL; l2 = g_list_next(l2)) {
-                sat_t *s2 = (sat_t *)l2->data;
-                if (is_los_clear(s1, s2)) {
-                    sat_graph_add_edge(realistic_graph, s1, s2);
-                }
-            }
-        }
-        
-        // Calculate and draw path
-        path = sat_graph_dijkstra(realistic_graph, closest_sat1, closest_sat2);
-
-        if (!path) {
-            g_object_set(shortest_path_line_qth1_sat, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-            g_object_set(shortest_path_line_sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-            g_object_set(shortest_path_line_sat_qth2, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-        } else {
-            gfloat x1, y1, x2, y2;
-            sat_t *start_sat = (sat_t *)path->data;
-            lonlat_to_xy(satmap, satmap->qth->lon, satmap->qth->lat, &x1, &y1);
-            lonlat_to_xy(satmap, start_sat->ssplon, start_sat->ssplat, &x2, &y2);
-            points = goo_canvas_points_new(2);
-            points->coords[0] = x1; points->coords[1] = y1;
-            points->coords[2] = x2; points->coords[3] = y2;
-            g_object_set(shortest_path_line_qth1_sat, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
-            goo_canvas_points_unref(points);
-
-            if (g_list_length(path) > 1) {
-                points = goo_canvas_points_new(g_list_length(path));
-                gint i = 0;
-                for (GList *l = path; l != NULL; l = g_list_next(l)) {
-                    sat_t *sat_on_path = (sat_t *)l->data;
-                    gfloat temp_x, temp_y;
-                    lonlat_to_xy(satmap, sat_on_path->ssplon, sat_on_path->ssplat, &temp_x, &temp_y);
-                    points->coords[i*2] = temp_x;
-                    points->coords[i*2+1] = temp_y;
-                    i++;
-                }
-                g_object_set(shortest_path_line_sats, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
-                goo_canvas_points_unref(points);
-            } else {
-                g_object_set(shortest_path_line_sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-            }
+/* Draws the latest paths found by the worker, the previous ones stay up until then */
+static void draw_live_path(GtkSatMap *satmap)
+{
+    const live_path_result *result = live_path_last(satmap->live_path);
 
-            sat_t *end_sat = (sat_t *)g_list_last(path)->data;
-            lonlat_to_xy(satmap, end_sat->ssplon, end_sat->ssplat, &x1, &y1);
-            lonlat_to_xy(satmap, satmap->qth2->lon, satmap->qth2->lat, &x2, &y2);
-            points = goo_canvas_points_new(2);
-            points->coords[0] = x1; points->coords[1] = y1;
-            points->coords[2] = x2; points->coords[3] = y2;
-            g_object_set(shortest_path_line_sat_qth2, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
-            goo_canvas_points_unref(points);
-        }
-        if (path) g_list_free(path);
-        sat_graph_free(realistic_graph);
-    }
+    if (!shortest_path_line_qth1_sat || !satmap->qth || !satmap->qth2 || !satmap->sats)
+        return;
 
-    /* --- 3. UNREALISTIC PATH (RED) --- */
-    {
-        SatGraph *unrealistic_graph = sat_graph_new();
-        GList *path = NULL;
+    /* Realistic path (green) over satellite pairs with clear LOS */
+    draw_path_lines(satmap, result ? result->path : NULL,
+                    shortest_path_line_qth1_sat,
+                    shortest_path_line_sats,
+                    shortest_path_line_sat_qth2);
 
-        // Build unrealistic graph (fully connected)
-        for (GList *l1 = sat_list; l1 != NULL; l1 = l1->next) {
-            sat_t *s1 = (sat_t *)l1->data;
-            sat_graph_add_vertex(unrealistic_graph, s1);
-            for (GList *l2 = g_list_next(l1); l2 != NULL; l2 = g_list_next(l2)) {
-                sat_t *s2 = (sat_t *)l2->data;
-                sat_graph_add_edge(unrealistic_graph, s1, s2);
-            }
-        }
-        
-        // Calculate and draw path
-        path = sat_graph_dijkstra(unrealistic_graph, closest_sat1, closest_sat2);
-
-        if (!path) {
-            g_object_set(unrealistic_path_line_qth1_sat, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-            g_object_set(unrealistic_path_line_sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-            g_object_set(unrealistic_path_line_sat_qth2, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-        } else {
-            gfloat x1, y1, x2, y2;
-            sat_t *start_sat = (sat_t *)path->data;
-            lonlat_to_xy(satmap, satmap->qth->lon, satmap->qth->lat, &x1, &y1);
-            lonlat_to_xy(satmap, start_sat->ssplon, start_sat->ssplat, &x2, &y2);
-            points = goo_canvas_points_new(2);
-            points->coords[0] = x1; points->coords[1] = y1;
-            points->coords[2] = x2; points->coords[3] = y2;
-            g_object_set(unrealistic_path_line_qth1_sat, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
-            goo_canvas_points_unref(points);
-
-            if (g_list_length(path) > 1) {
-                points = goo_canvas_points_new(g_list_length(path));
-                gint i = 0;
-                for (GList *l = path; l != NULL; l = g_list_next(l)) {
-                    sat_t *sat_on_path = (sat_t *)l->data;
-                    gfloat temp_x, temp_y;
-                    lonlat_to_xy(satmap, sat_on_path->ssplon, sat_on_path->ssplat, &temp_x, &temp_y);
-                    points->coords[i*2] = temp_x;
-                    points->coords[i*2+1] = temp_y;
-                    i++;
-                }
-                g_object_set(unrealistic_path_line_sats, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
-                goo_canvas_points_unref(points);
-            } else {
-                g_object_set(unrealistic_path_line_sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
-            }
+    /* Unrealistic path (red) over a fully connected graph */
+    draw_path_lines(satmap, result ? result->direct : NULL,
+                    unrealistic_path_line_qth1_sat,
+                    unrealistic_path_line_sats,
+                    unrealistic_path_line_sat_qth2);
 
-            sat_t *end_sat = (sat_t *)g_list_last(path)->data;
-            lonlat_to_xy(satmap, end_sat->ssplon, end_sat->ssplat, &x1, &y1);
-            lonlat_to_xy(satmap, satmap->qth2->lon, satmap->qth2->lat, &x2, &y2);
-            points = goo_canvas_points_new(2);
-            points->coords[0] = x1; points->coords[1] = y1;
-            points->coords[2] = x2; points->coords[3] = y2;
-            g_object_set(unrealistic_path_line_sat_qth2, "points", points, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
-            goo_canvas_points_unref(points);
-        }
-        if (path) g_list_free(path);
-        sat_graph_free(unrealistic_graph);
-    }
-    
-    /* --- 4. SET STACKING ORDER --- */
     /* Raise the green line to be on top of the red line in case of overlap */
     goo_canvas_item_model_raise(shortest_path_line_qth1_sat, NULL);
     goo_canvas_item_model_raise(shortest_path_line_sats, NULL);
     goo_canvas_item_model_raise(shortest_path_line_sat_qth2, NULL);
+}
+
+static void live_path_ready(live_path *lp, gpointer user_data)
+{
+    (void)lp;
+
+    draw_live_path(GTK_SAT_MAP(user_data));
+}
+
+/*
+ * Hands the current satellite positions to the path worker and redraws the
+ * last result. The graph search runs off the main loop, when it finishes
+ * live_path_ready draws the new paths.
+ */
+static void draw_shortest_path_on_map(GtkSatMap *satmap)
+{
+    /* Ensure ground stations and satellites exist */
+    if (!satmap->qth || !satmap->qth2 || !satmap->sats || g_hash_table_size(satmap->sats) == 0) {
+        // Hide all lines if no data
+        g_object_set(shortest_path_line_qth1_sat, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+        g_object_set(shortest_path_line_sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+        g_object_set(shortest_path_line_sat_qth2, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+        g_object_set(unrealistic_path_line_qth1_sat, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+        g_object_set(unrealistic_path_line_sats, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+        g_object_set(unrealistic_path_line_sat_qth2, "visibility", GOO_CANVAS_ITEM_HIDDEN, NULL);
+        return;
+    }
+
+    if (!satmap->live_path)
+        satmap->live_path = live_path_new(live_path_ready, satmap);
+
+    live_path_set_mode(satmap->live_path,
+                       g_key_file_get_boolean(satmap->cfgdata, MOD_CFG_MAP_SECTION,
+                                              MOD_CFG_MAP_ROUTE_BY_SKR, NULL) ?
+                       LIVE_PATH_WIDEST : LIVE_PATH_SHORTEST);
+    live_path_update(satmap->live_path, satmap->sats, satmap->qth, satmap->qth2, satmap->tstamp);
+    draw_live_path(satmap);
+}
+
+/** Tooltip markup of a satellite marker at the current time. */
+static gchar   *sat_tooltip(GtkSatMap * satmap, sat_t * sat)
+{
+    gchar          *tooltip;
+    gchar          *aosstr;
+
+    aosstr = aoslos_time_to_str(satmap, sat);
+    tooltip = g_markup_printf_escaped("<b>%s</b>\n"
+                                      "Lon: %5.1f\302\260\n"
+                                      "Lat: %5.1f\302\260\n"
+                                      " Az: %5.1f\302\260\n"
+                                      " El: %5.1f\302\260\n"
+                                      "%s",
+                                      sat->nickname,
+                                      sat->ssplon, sat->ssplat,
+                                      sat->az, sat->el, aosstr);
+    g_free(aosstr);
 
-    /* Clean up */
-    g_list_free(sat_list);
+    return tooltip;
 }
 
 static gchar   *aoslos_time_to_str(GtkSatMap * satmap, sat_t * sat)
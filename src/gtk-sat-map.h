@@ -10,6 +10,8 @@
 #include "gtk-sat-data.h"
 #include "calc-dist-two-sat.h"
 #include "sat-graph.h"
+#include "live-path.h"
+#include "sat-map-layer.h"
 #include "qth-data.h"
 
 /* *INDENT-OFF* */
@@ -73,6 +75,12 @@ typedef struct {
     ground_track_t  track_data; /*!< Ground track data. */
     long            track_orbit;        /*!< Orbit when the ground track has been updated. */
 
+    /* state of the last canvas update, items are only touched when it changes */
+    gfloat          x;          /*!< Projected position of the marker. */
+    gfloat          y;
+    gdouble         footprint;  /*!< Footprint diameter (km) of the range circle. */
+    gchar          *nickname;   /*!< Text currently set on the label. */
+
 } sat_map_obj_t;
 
 #define SAT_MAP_OBJ(obj) ((sat_map_obj_t *)obj)
@@ -142,6 +150,10 @@ typedef struct {
 
     GdkPixbuf      *origmap;    /*!< Original map kept here for high quality scaling. */
 
+    live_path      *live_path;  /*!< Worker finding the path between the two QTHs. */
+
+    sat_map_layer  *layer;      /*!< Draws all satellites above the bulk threshold, NULL for canvas items. */
+
 } GtkSatMap;
 
 struct _GtkSatMapClass {
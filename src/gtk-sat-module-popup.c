@@ -42,6 +42,7 @@
 #include "sat-log.h"
 #include "sgpsdp/sgp4sdp4.h"
 #include "sat-graph.h"
+#include "live-path.h"
 #include "calc-dist-two-sat.h"
 #include "predict-tools.h"
 #include "orbit-tools.h"
@@ -1249,6 +1250,50 @@ static void format_path_string(GString *str, GList *path, qth_t *qth1, qth_t *qt
     g_free(skr_str);
 }
 
+/* Route from qth to qth2 with the largest bottleneck SKR, NULL if there is none */
+static GList *widest_sat_path(GtkSatModule *module, GList *sats)
+{
+    GArray *nodes = g_array_new(FALSE, FALSE, sizeof(live_path_node));
+    GArray *path = g_array_new(FALSE, FALSE, sizeof(live_path_node));
+    GList *result = NULL;
+    gdouble skr;
+
+    for (GList *l = sats; l; l = l->next) {
+        sat_t *sat = SAT(l->data);
+        live_path_node node;
+
+        node.catnr = sat->tle.catnr;
+        node.pos = sat->pos;
+        node.vel = sat->vel;
+        node.speed = 0.0;
+        node.ssplat = sat->ssplat;
+        node.ssplon = sat->ssplon;
+        g_array_append_val(nodes, node);
+    }
+
+    if (live_path_widest(nodes, module->qth, module->qth2, module->tmgCdnum, path, &skr)) {
+        for (guint i = path->len; i > 0; i--) {
+            gint catnr = g_array_index(path, live_path_node, i - 1).catnr;
+            sat_t *sat = g_hash_table_lookup(module->satellites, &catnr);
+            if (sat)
+                result = g_list_prepend(result, sat);
+        }
+    }
+
+    g_array_free(nodes, TRUE);
+    g_array_free(path, TRUE);
+    return result;
+}
+
+/* Live map route by bottleneck key rate instead of distance */
+static void route_by_skr_cb(GtkCheckMenuItem * menuitem, gpointer data)
+{
+    GtkSatModule *module = GTK_SAT_MODULE(data);
+
+    g_key_file_set_boolean(module->cfgdata, MOD_CFG_MAP_SECTION,
+                           MOD_CFG_MAP_ROUTE_BY_SKR,
+                           gtk_check_menu_item_get_active(menuitem));
+}
 
 static void shortest_path_cb(GtkWidget *widget, gpointer data)
 {
@@ -1315,25 +1360,27 @@ static void shortest_path_cb(GtkWidget *widget, gpointer data)
 
 
     // --- 2. Realistic Path (LOS-constrained graph) ---
-    SatGraph *realistic_graph = sat_graph_new();
-    for (GList *l1 = sats; l1; l1 = l1->next) {
-        sat_t *sat1 = SAT(l1->data);
-        if (decayed(sat1)) continue;
-        sat_graph_add_vertex(realistic_graph, sat1);
-        for (GList *l2 = g_list_next(l1); l2; l2 = g_list_next(l2)) {
-            sat_t *sat2 = SAT(l2->data);
-            if (decayed(sat2)) continue;
-            if (is_los_clear(sat1, sat2)) { // The key difference!
-                sat_graph_add_edge(realistic_graph, sat1, sat2);
-            }
-        }
+    GList *live = NULL;
+    for (GList *l = sats; l; l = l->next) {
+        if (!decayed(SAT(l->data)))
+            live = g_list_prepend(live, l->data);
     }
+    live = g_list_reverse(live);
+    // Only pairs near enough to see each other are LOS tested
+    SatGraph *realistic_graph = sat_graph_new_los(live, 0);
     GList *realistic_path = sat_graph_dijkstra(realistic_graph, start_sat, end_sat);
     format_path_string(dialog_text, realistic_path, module->qth, module->qth2, "Realistic Path (With Line of Sight)");
     if (realistic_path) g_list_free(realistic_path);
     sat_graph_free(realistic_graph);
 
 
+    // --- 3. Widest Path (largest bottleneck SKR, any satellites) ---
+    GList *widest_path = widest_sat_path(module, live);
+    format_path_string(dialog_text, widest_path, module->qth, module->qth2, "Widest Path (Largest Key Rate)");
+    if (widest_path) g_list_free(widest_path);
+    g_list_free(live);
+
+
     // --- Display Dialog ---
     GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
                                                GTK_MESSAGE_INFO, GTK_BUTTONS_OK,
@@ -1542,6 +1589,16 @@ void gtk_sat_module_popup(GtkSatModule * module)
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), menuitem);
     g_signal_connect(menuitem, "activate", G_CALLBACK(shortest_path_cb), module);
 
+    /* route the live map path by key rate */
+    menuitem = gtk_check_menu_item_new_with_label(_("Route by Key Rate"));
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(menuitem),
+                                   g_key_file_get_boolean(module->cfgdata,
+                                                          MOD_CFG_MAP_SECTION,
+                                                          MOD_CFG_MAP_ROUTE_BY_SKR,
+                                                          NULL));
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), menuitem);
+    g_signal_connect(menuitem, "activate", G_CALLBACK(route_by_skr_cb), module);
+
     gtk_widget_show_all(menu);
 
     /* gtk_menu_popup got deprecated in 3.22, first available in Ubuntu 18.04 */
@@ -209,7 +209,7 @@ static void update_max_capacity_path_callback(GtkWidget *view, gpointer user_dat
     for (GSList *i = module->views; i != NULL; i = i->next) {
        if (GTK_IS_MAX_PATH_MAP(i->data)) {
             GtkMaxPathMap *map = GTK_MAX_PATH_MAP(i->data);
-            set_max_capacity_path(map, path_view->max_capacity_path->path, path_view->path_colors);
+            set_max_capacity_path(map, path_view->max_capacity_path, path_view->path_colors);
        } 
     }
 }
@@ -282,12 +282,24 @@ static void gtk_sat_module_destroy(GtkWidget * widget)
     }
 
     /* clean up satellites */
+    if (module->snapshot)
+    {
+        sat_snapshot_free(module->snapshot);
+        module->snapshot = NULL;
+    }
+
     if (module->satellites)
     {
         g_hash_table_destroy(module->satellites);
         module->satellites = NULL;
     }
 
+    if (module->kdtree)
+    {
+        kdtree_free(module->kdtree);
+        module->kdtree = NULL;
+    }
+
     if (module->qths) 
     {
         g_slist_free_full(module->qths, g_free);
@@ -342,6 +354,8 @@ static void gtk_sat_module_init(GtkSatModule * module,
                                                g_free, gtk_sat_module_free_sat);
 
     module->qths = NULL;
+    module->kdtree = sat_kdtree_create();
+    module->snapshot = sat_snapshot_new(0);
 
     module->rotctrlwin = NULL;
     module->rotctrl = NULL;
@@ -460,12 +474,14 @@ static GtkWidget *create_view(GtkSatModule * module, guint num)
     case GTK_SAT_MOD_VIEW_MULTIPLE:
         view = gtk_multiple_sat_new(module->cfgdata,
                                     module->satellites, module->qth, 0);
+        GTK_MULTIPLE_SAT(view)->kdtree = module->kdtree;
         sat_log_log(SAT_LOG_LEVEL_DEBUG, "%s %d: GtkMultipleSat case called", __FILE__, __LINE__);
         break;
 
     case GTK_SAT_MOD_VIEW_MAXPATH:
         view = gtk_max_path_view_new(module->cfgdata,
                                     module->satellites, module->qths, module->qth, 0);
+        GTK_MAX_PATH_VIEW(view)->kdtree = module->kdtree;
         g_signal_connect(view, "update-path", G_CALLBACK(update_max_capacity_path_callback), module);
         break;
     case GTK_SAT_MOD_VIEW_PATHMAP:
@@ -686,10 +702,9 @@ static void gtk_sat_module_load_sats(GtkSatModule * module)
  * GtkSkyGlance widget was last updated and triggers an update if necessary.
  * The current distance is set to 1km.
  *
- * This is a cheap/lazy implementation of automatic update. Instead of
- * performing a real update by "moving" the objects on the GtkSkyGlance canvas,
- * we simply replace the current GtkSkyGlance object with a new one.
- * Ugly but safe.
+ * A time update slides the existing GtkSkyGlance forward, which only has to
+ * predict the passes at the new end of the timeline. A new location changes
+ * every pass, so in that case the widget is replaced with a new one.
  *
  * To ensure smooth performance while running in simulated real time with high
  * throttle value or manual time mode, the caller is responsible for only calling
@@ -697,9 +712,8 @@ static void gtk_sat_module_load_sats(GtkSatModule * module)
  */
 static void update_skg(GtkSatModule * module)
 {
-    /* update SKG if ~60 seconds have passed or we have moved 1 km */
-    if (G_UNLIKELY(fabs(module->tmgCdnum - module->lastSkgUpd) > 7.0e-4) ||
-        G_UNLIKELY(qth_small_dist(module->qth, module->lastSkgUpdqth) > 1.0))
+    /* replace SKG if we have moved 1 km */
+    if (G_UNLIKELY(qth_small_dist(module->qth, module->lastSkgUpdqth) > 1.0))
     {
 
         sat_log_log(SAT_LOG_LEVEL_INFO,
@@ -716,6 +730,16 @@ static void update_skg(GtkSatModule * module)
         module->lastSkgUpd = module->tmgCdnum;
         qth_small_save(module->qth, &(module->lastSkgUpdqth));
     }
+    /* slide SKG if ~60 seconds have passed */
+    else if (G_UNLIKELY(fabs(module->tmgCdnum - module->lastSkgUpd) > 7.0e-4))
+    {
+        /* modules without satellites only have a label */
+        if (GTK_IS_SKY_GLANCE(module->skg))
+            gtk_sky_glance_update(GTK_SKY_GLANCE(module->skg),
+                                  module->tmgCdnum);
+
+        module->lastSkgUpd = module->tmgCdnum;
+    }
 }
 
 static void update_header(GtkSatModule * module)
@@ -835,90 +859,21 @@ static void update_child(GtkWidget * child, gdouble tstamp)
 }
 
 /**
- * Update a given satellite.
+ * Hand the module time and location to the simulation thread.
  *
- * @param key The hash table key (catnum)
- * @param val The hash table value (sat_t structure)
- * @param data User data (the GtkSatModule widget).
+ * @param module Pointer to the GtkSatModule widget
  *
- * This function updates the tracking data for a given satellite. It is called by
- * the timeout handler for each element in the hash table.
+ * The thread produces a snapshot every module timeout and moves the time on
+ * by itself between calls at the current throttle. We use
+ * SAT_CFG_INT_PRED_LOOK_AHEAD for the AOS/LOS upper time limit.
  */
-static void gtk_sat_module_update_sat(gpointer key, gpointer val,
-                                      gpointer data)
+static void set_snapshot_clock(GtkSatModule * module)
 {
-    sat_t          *sat;
-    GtkSatModule   *module;
-    gdouble         daynum;
     gdouble         maxdt;
 
-    (void)key;
-
-    g_return_if_fail((val != NULL) && (data != NULL));
-
-    sat = SAT(val);
-    module = GTK_SAT_MODULE(data);
     maxdt = (gdouble) sat_cfg_get_int(SAT_CFG_INT_PRED_LOOK_AHEAD);
-
-    /* get current time (real or simulated */
-    daynum = module->tmgCdnum;
-
-    /* update events if the event counter has been reset
-       and the other requirements are fulfilled */
-    if ((GTK_SAT_MODULE(module)->event_count == 0) &&
-        has_aos(sat, module->qth))
-    {
-        /* Note that has_aos may return TRUE for geostationary sats
-           whose orbit deviate from a true-geostat orbit, however,
-           find_aos and find_los will not go beyond the time limit
-           we specify (in those cases they return 0.0 for AOS/LOS times.
-           We use SAT_CFG_INT_PRED_LOOK_AHEAD for upper time limit */
-        sat->aos = find_aos(sat, module->qth, daynum, maxdt);
-        sat->los = find_los(sat, module->qth, daynum, maxdt);
-    }
-    /*
-       Update AOS and LOS for this satellite if it was known and is before
-       the current time.
-
-       daynum is the current time in the module.
-
-       The conditional aos < daynum is merely saying that aos occurred
-       in the past. Therefore it cannot be the next event or aos/los
-       for that satellite.
-
-       The conditional aos > 0.0 is a short hand for saying that the
-       aos was successfully computed before. find_aos returns 0.0 when it
-       cannot find an AOS.
-
-       This code should not execute find_aos(los) if the conditional before
-       is triggered as the newly computed aos(los) should either be in
-       the future (aos > daynum) or (aos == 0 ).
-
-       Single sat/list/event/map views all use these values and they
-       should be up to date.
-
-       The above code is still required for dealing with circumstances
-       where the qth moves from someplace where the qth can have an AOS and
-       where qth does not and for satellites in parking orbits where the
-       AOS may be further than maxdt out results in aos==0.0 until the
-       next aos is closer than maxdt. It also prevents the aos from
-       being computed every pass through the module for the parking orbits.
-
-       To be completely correct, when time can move forward and backwards
-       as it can with the time controller, the time the aos/los was
-       computed should be stored and associated with aos/los. That way
-       if daynum <time_computed, the aos can be recomputed as there is
-       no assurance that the current stored aos is the next aos. As a
-       practical matter the above code handles time reversing acceptably
-       for most circumstances.
-     */
-    if (sat->aos > 0 && sat->aos < daynum)
-        sat->aos = find_aos(sat, module->qth, daynum, maxdt);
-
-    if (sat->los > 0 && sat->los < daynum)
-        sat->los = find_los(sat, module->qth, daynum, maxdt);
-
-    predict_calc(sat, module->qth, daynum);
+    sat_snapshot_set_clock(module->snapshot, module->qth, module->tmgCdnum,
+                           module->throttle, maxdt, module->timeout);
 }
 
 /** Module timeout callback. */
@@ -929,6 +884,8 @@ static gboolean gtk_sat_module_timeout_cb(gpointer module)
     gboolean        needupdate = FALSE;
     GdkWindowState  state;
     gdouble         delta;
+    gdouble         tstamp;
+    gdouble         ctrl_tstamp;
     guint           i;
 
     /*update the qth position */
@@ -986,36 +943,34 @@ static gboolean gtk_sat_module_timeout_cb(gpointer module)
             update_header(mod);
         }
 
-        /* reset event update counter if is has expired or if we have moved
-           significantly */
-        if (mod->event_count == mod->event_timeout ||
-            qth_small_dist(mod->qth, mod->qth_event) > 1.0)
-        {
-            mod->event_count = 0;       // will trigger find_aos() and find_los()
-        }
+        /* the simulation thread follows the module time and location */
+        set_snapshot_clock(mod);
 
-        /* if the events are going to be recalculated store the position */
-        if (mod->event_count == 0)
+        /* take the newest satellite data it has finished */
+        if (mod->satellites != NULL && sat_snapshot_acquire(mod->snapshot))
         {
-            qth_small_save(mod->qth, &(mod->qth_event));
+            sat_snapshot_restore(mod->snapshot);
+
+            /* nearest satellite lookups in the views use the new positions */
+            sat_kdtree_rebuild(mod->kdtree, mod->satellites);
         }
+        tstamp = sat_snapshot_time(mod->snapshot);
 
-        /* update satellite data */
-        if (mod->satellites != NULL)
-            g_hash_table_foreach(mod->satellites,
-                                 gtk_sat_module_update_sat, module);
+        /* radio and rotator steer by the module time until a current
+           snapshot is available, e.g. right after the module was hidden */
+        ctrl_tstamp = sat_snapshot_current(mod->snapshot) ?
+            tstamp : mod->tmgCdnum;
 
         /* update children */
         for (i = 0; i < mod->nviews; i++)
         {
             child = GTK_WIDGET(g_slist_nth_data(mod->views, i));
-            update_child(child, mod->tmgCdnum);
+            update_child(child, tstamp);
         }
 
-        /* update satellite data (it may have got out of sync during child updates) */
+        /* restore satellite data (it may have got out of sync during child updates) */
         if (mod->satellites != NULL)
-            g_hash_table_foreach(mod->satellites,
-                                 gtk_sat_module_update_sat, module);
+            sat_snapshot_restore(mod->snapshot);
 
         /* update target if autotracking is enabled */
         if (mod->autotrack)
@@ -1024,11 +979,21 @@ static gboolean gtk_sat_module_timeout_cb(gpointer module)
             update_autotrack_second_sat(mod);
         }
 
-        /* send notice to radio and rotator controller */
+        /* send notice to radio and rotator controller; their targets are
+           module satellites, which hold the stale snapshot in that case */
+        if (ctrl_tstamp != tstamp)
+        {
+            if (mod->rigctrl && GTK_RIG_CTRL(mod->rigctrl)->target)
+                predict_calc(GTK_RIG_CTRL(mod->rigctrl)->target, mod->qth,
+                             ctrl_tstamp);
+            if (mod->rotctrl && GTK_ROT_CTRL(mod->rotctrl)->target)
+                predict_calc(GTK_ROT_CTRL(mod->rotctrl)->target, mod->qth,
+                             ctrl_tstamp);
+        }
         if (mod->rigctrl)
-            gtk_rig_ctrl_update(GTK_RIG_CTRL(mod->rigctrl), mod->tmgCdnum);
+            gtk_rig_ctrl_update(GTK_RIG_CTRL(mod->rigctrl), ctrl_tstamp);
         if (mod->rotctrl)
-            gtk_rot_ctrl_update(GTK_ROT_CTRL(mod->rotctrl), mod->tmgCdnum);
+            gtk_rot_ctrl_update(GTK_ROT_CTRL(mod->rotctrl), ctrl_tstamp);
 
         /* check and update Sky at glance */
         /* FIXME: We should have some timeout counter to ensure that we don't
@@ -1038,8 +1003,6 @@ static gboolean gtk_sat_module_timeout_cb(gpointer module)
         if (mod->skg)
             update_skg(mod);
 
-        mod->event_count++;
-
         /* store time keeping variables */
         mod->rtPrev = mod->rtNow;
         mod->tmgPdnum = mod->tmgCdnum;
@@ -1321,6 +1284,8 @@ GtkWidget *gtk_sat_module_new(const gchar * cfgfile)
     module->tmgCdnum = get_current_daynum();
 
     gtk_sat_module_load_sats(module);
+    set_snapshot_clock(module);
+    sat_snapshot_set_sats(module->snapshot, module->satellites);
     gtk_sat_module_load_qths(module);
 
     /* menu */
@@ -1341,12 +1306,6 @@ GtkWidget *gtk_sat_module_new(const gchar * cfgfile)
     module->head_timeout = module->timeout > 1000 ? 1 :
         (guint) floor(1000 / module->timeout);
 
-    /* Event timeout updates every minute */
-    module->event_timeout = module->timeout > 60000 ? 1 :
-         (guint) floor(60000 / module->timeout);
-    /* force update the first time */
-    module->event_count = module->event_timeout;
-
     butbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
     gtk_box_pack_start(GTK_BOX(butbox),
                        module->header, FALSE, FALSE, 10);
@@ -1727,14 +1686,17 @@ void gtk_sat_module_reload_sats(GtkSatModule * module)
                 _("%s: Reloading satellites for module %s"),
                 __func__, module->name);
 
-    /* remove each element from the hash table, but keep the hash table */
+    /* stop the simulation of the old satellites, then remove each element
+       from the hash table, but keep the hash table */
+    sat_snapshot_set_sats(module->snapshot, NULL);
     g_hash_table_remove_all(module->satellites);
 
-    /* reset event counter so that next AOS/LOS gets re-calculated */
-    module->event_count = 0;
-
     /* load satellites */
     gtk_sat_module_load_sats(module);
+    sat_snapshot_set_sats(module->snapshot, module->satellites);
+
+    /* the tree still points to the old satellites */
+    sat_kdtree_rebuild(module->kdtree, module->satellites);
 
     /* update children */
     for (i = 0; i < module->nviews; i++)
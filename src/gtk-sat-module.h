@@ -8,6 +8,8 @@
 #include "qth-data.h"
 #include "gtk-sat-data.h"
 #include "sat-graph.h"
+#include "sat-kdtree-utils.h"
+#include "sat-snapshot.h"
 #include "calc-dist-two-sat.h"
 
 /* *INDENT-OFF* */
@@ -73,8 +75,6 @@ struct _gtk_sat_module {
     GtkWidget      *header;
     guint           head_count;
     guint           head_timeout;
-    guint           event_count;
-    guint           event_timeout;
 
     /* layout and children */
     guint          *grid;       /*!< The grid layout array [(type,left,right,top,bottom),...] */
@@ -84,9 +84,10 @@ struct _gtk_sat_module {
     GKeyFile       *cfgdata;    /*!< Configuration data. */
     qth_t          *qth;        /*!< QTH information. */
     qth_t          *qth2;       /*<! Second QTH information. */
-    qth_small_t     qth_event;  /*!< QTH information for last AOS/LOS update. */
+    sat_snapshot   *snapshot;   /*!< Simulation thread and its latest satellite data */
     GHashTable     *satellites; /*!< Satellites. */
     GSList         *qths;       /*!< Ground stations */
+    Kdtree         *kdtree;     /*!< Satellite positions, rebuilt every cycle and shared by the views */
 
     guint32         timeout;    /*!< Timeout value [msec] */
 
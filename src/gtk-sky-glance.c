@@ -37,6 +37,10 @@
  *
  * When we get additional space due to resizing, the space will be allocated
  * to make the rectangles taller.
+ *
+ * The passes are predicted on worker threads (see sky-passes.c) and drawn
+ * as each satellite finishes. gtk_sky_glance_update() slides the timeline
+ * and only predicts the time that was added at its end.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -57,6 +61,7 @@
 #include "sat-cfg.h"
 #include "sat-log.h"
 #include "sgpsdp/sgp4sdp4.h"
+#include "sky-passes.h"
 #include "time-tools.h"
 
 
@@ -66,6 +71,7 @@
 #define SKG_MARGIN              15
 #define SKG_FOOTER              50
 #define SKG_CURSOR_WIDTH        0.5
+#define SKG_NUM_PASSES          10
 
 static GtkVBoxClass *parent_class = NULL;
 
@@ -77,7 +83,9 @@ static void gtk_sky_glance_init(GtkSkyGlance * skg,
     skg->sats = NULL;
     skg->qth = NULL;
     skg->passes = NULL;
-    skg->satlab = NULL;
+    skg->rows = NULL;
+    skg->pred = NULL;
+    skg->serial = 0;
     skg->x0 = 0;
     skg->y0 = 0;
     skg->w = 0;
@@ -104,6 +112,13 @@ static void gtk_sky_glance_destroy(GtkWidget * widget)
     sky_pass_t     *skypass;
     guint           i, n;
 
+    /* stop the predictions first, they must not call back into a dead widget */
+    if (GTK_SKY_GLANCE(widget)->pred != NULL)
+    {
+        sky_passes_free(GTK_SKY_GLANCE(widget)->pred);
+        GTK_SKY_GLANCE(widget)->pred = NULL;
+    }
+
     /* free passes */
     /* FIXME: TBC whether this is enough */
     if (GTK_SKY_GLANCE(widget)->passes != NULL)
@@ -125,10 +140,10 @@ static void gtk_sky_glance_destroy(GtkWidget * widget)
     /* for the rest we only need to free the GSList because the
        canvas items will be freed when removed from canvas.
      */
-    if (GTK_SKY_GLANCE(widget)->satlab != NULL)
+    if (GTK_SKY_GLANCE(widget)->rows != NULL)
     {
-        g_slist_free(GTK_SKY_GLANCE(widget)->satlab);
-        GTK_SKY_GLANCE(widget)->satlab = NULL;
+        g_hash_table_destroy(GTK_SKY_GLANCE(widget)->rows);
+        GTK_SKY_GLANCE(widget)->rows = NULL;
     }
     if (GTK_SKY_GLANCE(widget)->majors != NULL)
     {
@@ -226,6 +241,169 @@ static gdouble x2t(GtkSkyGlance * skg, gdouble x)
     return (skg->ts + frac * (skg->te - skg->ts));
 }
 
+/**
+ * Position the time ticks and hour labels.
+ *
+ * The hour labels are updated as well because the ticks move to other
+ * hours when the time window slides.
+ */
+static void layout_ticks(GtkSkyGlance * skg)
+{
+    GooCanvasPoints *pts;
+    GSList         *major, *minor, *label;
+    gdouble         th, tm;
+    gdouble         xh, xm;
+    gchar           buff[3];
+
+    /* get the first hour and first 30 min slot */
+    th = ceil(skg->ts * 24.0) / 24.0;
+
+    /* workaround for bug 1839140 (first hour incorrexct) */
+    th += 0.00069;
+
+    /* the first 30 min tick can be either before
+       or after the first hour tick
+     */
+    if ((th - skg->ts) > 0.0208333)
+    {
+        tm = th - 0.0208333;
+    }
+    else
+    {
+        tm = th + 0.0208333;
+    }
+
+    /* there is one tick of each kind for every hour */
+    for (major = skg->majors, minor = skg->minors, label = skg->labels;
+         major != NULL && minor != NULL && label != NULL;
+         major = major->next, minor = minor->next, label = label->next)
+    {
+        xh = t2x(skg, th);
+
+        pts = goo_canvas_points_new(2);
+        pts->coords[0] = xh;
+        pts->coords[1] = skg->h;
+        pts->coords[2] = xh;
+        pts->coords[3] = skg->h + 10;
+        g_object_set(major->data, "points", pts, NULL);
+        goo_canvas_points_unref(pts);
+
+        /* hour tick label */
+        daynum_to_str(buff, 3, "%H", th);
+        g_object_set(label->data,
+                     "text", buff,
+                     "x", (gdouble) xh,
+                     "y", (gdouble) (skg->h + 12), NULL);
+
+        /* 30 min tick */
+        xm = t2x(skg, tm);
+
+        pts = goo_canvas_points_new(2);
+        pts->coords[0] = xm;
+        pts->coords[1] = skg->h;
+        pts->coords[2] = xm;
+        pts->coords[3] = skg->h + 5;
+        g_object_set(minor->data, "points", pts, NULL);
+        goo_canvas_points_unref(pts);
+
+        th += 0.0416667;
+        tm += 0.0416667;
+    }
+}
+
+/** Position the box of a pass in the row of its satellite. */
+static void place_pass(GtkSkyGlance * skg, sky_pass_t * skp)
+{
+    gdouble         x, y, w, h;
+
+    x = t2x(skg, skp->pass->aos);
+    w = t2x(skg, skp->pass->los) - x;
+    y = skp->row * (skg->pps + SKG_MARGIN) + SKG_MARGIN;
+    h = skg->pps;
+
+    g_object_set(skp->box, "x", x, "y", y, "width", w, "height", h, NULL);
+}
+
+/**
+ * Position the satellite label next to the first pass of its row.
+ *
+ * @param skp The first pass of the row or NULL to hide the label.
+ */
+static void place_label(GtkSkyGlance * skg, sky_row_t * row, sky_pass_t * skp)
+{
+    gdouble         x, y, w;
+
+    if (skp == NULL)
+    {
+        g_object_set(row->label, "visibility", GOO_CANVAS_ITEM_INVISIBLE,
+                     NULL);
+        return;
+    }
+
+    x = t2x(skg, skp->pass->aos);
+    w = t2x(skg, skp->pass->los) - x;
+    y = row->index * (skg->pps + SKG_MARGIN) + SKG_MARGIN + skg->pps / 2.0;
+
+    if (x > (skg->x0 + 100))
+        g_object_set(row->label, "x", x - 5, "y", y,
+                     "anchor", GOO_CANVAS_ANCHOR_E,
+                     "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
+    else
+        g_object_set(row->label, "x", x + w + 5, "y", y,
+                     "anchor", GOO_CANVAS_ANCHOR_W,
+                     "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
+}
+
+/** Find the first pass of a row, which is the earliest one. */
+static sky_pass_t *first_pass(GtkSkyGlance * skg, guint row)
+{
+    GSList         *elm;
+
+    for (elm = skg->passes; elm != NULL; elm = elm->next)
+        if (SKY_PASS_T(elm->data)->row == row)
+            return SKY_PASS_T(elm->data);
+
+    return NULL;
+}
+
+/**
+ * Position all pass boxes and satellite labels.
+ *
+ * The passes of a row are kept in time order in skg->passes, so the first
+ * one found for a row is the one the label goes next to.
+ */
+static void layout_passes(GtkSkyGlance * skg)
+{
+    GHashTableIter  iter;
+    gpointer        value;
+    sky_pass_t    **first;
+    sky_pass_t     *skp;
+    GSList         *elm;
+
+    first = g_new0(sky_pass_t *, skg->numsat);
+
+    for (elm = skg->passes; elm != NULL; elm = elm->next)
+    {
+        skp = SKY_PASS_T(elm->data);
+        place_pass(skg, skp);
+        /* need to raise item, otherwise it will not receive new events */
+        goo_canvas_item_raise(skp->box, NULL);
+
+        if (first[skp->row] == NULL)
+            first[skp->row] = skp;
+    }
+
+    g_hash_table_iter_init(&iter, skg->rows);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+        sky_row_t      *row = value;
+
+        place_label(skg, row, first[row->index]);
+    }
+
+    g_free(first);
+}
+
 /**
  * Manage new size allocation.
  *
@@ -237,14 +415,6 @@ static void size_allocate_cb(GtkWidget * widget, GtkAllocation * allocation,
                              gpointer data)
 {
     GtkSkyGlance   *skg;
-    GooCanvasPoints *pts;
-    GooCanvasItem  *obj;
-    gint            i, j, n;
-    guint           curcat;
-    gdouble         th, tm;
-    gdouble         xh, xm;
-    sky_pass_t     *skp;
-    gdouble         x, y, w, h;
 
     if (gtk_widget_get_realized(widget))
     {
@@ -281,94 +451,8 @@ static void size_allocate_cb(GtkWidget * widget, GtkAllocation * allocation,
                      "x", (gdouble) (skg->w / 2),
                      "y", (gdouble) (skg->h + SKG_FOOTER - 5), NULL);
 
-        /* get the first hour and first 30 min slot */
-        th = ceil(skg->ts * 24.0) / 24.0;
-
-        /* workaround for bug 1839140 (first hour incorrexct) */
-        th += 0.00069;
-
-        if ((th - skg->ts) > 0.0208333)
-        {
-            tm = th - 0.0208333;
-        }
-        else
-        {
-            tm = th + 0.0208333;
-        }
-
-        /* the number of steps equals the number of hours */
-        n = sat_cfg_get_int(SAT_CFG_INT_SKYATGL_TIME);
-        for (i = 0; i < n; i++)
-        {
-            xh = t2x(skg, th);
-
-            pts = goo_canvas_points_new(2);
-            pts->coords[0] = xh;
-            pts->coords[1] = skg->h;
-            pts->coords[2] = xh;
-            pts->coords[3] = skg->h + 10;
-            obj = g_slist_nth_data(skg->majors, i);
-            g_object_set(obj, "points", pts, NULL);
-            goo_canvas_points_unref(pts);
-
-            obj = g_slist_nth_data(skg->labels, i);
-            g_object_set(obj,
-                         "x", (gdouble) xh,
-                         "y", (gdouble) (skg->h + 12), NULL);
-
-            /* 30 min tick */
-            xm = t2x(skg, tm);
-
-            pts = goo_canvas_points_new(2);
-            pts->coords[0] = xm;
-            pts->coords[1] = skg->h;
-            pts->coords[2] = xm;
-            pts->coords[3] = skg->h + 5;
-            obj = g_slist_nth_data(skg->minors, i);
-            g_object_set(obj, "points", pts, NULL);
-            goo_canvas_points_unref(pts);
-
-            th += 0.04167;
-            tm += 0.04167;
-        }
-
-        /* update pass items */
-        n = g_slist_length(skg->passes);
-        j = -1;
-        curcat = 0;
-        y = 10.0;
-        h = 10.0;
-        for (i = 0; i < n; i++)
-        {
-            /* get pass */
-            skp = (sky_pass_t *) g_slist_nth_data(skg->passes, i);
-
-            x = t2x(skg, skp->pass->aos);
-            w = t2x(skg, skp->pass->los) - x;
-
-            /* new satellite? */
-            if (skp->catnum != curcat)
-            {
-                j++;
-                curcat = skp->catnum;
-                y = j * (skg->pps + SKG_MARGIN) + SKG_MARGIN;
-                h = skg->pps;
-
-                /* update label */
-                obj = g_slist_nth_data(skg->satlab, j);
-                if (x > (skg->x0 + 100))
-                    g_object_set(obj, "x", x - 5, "y", y + h / 2.0,
-                                 "anchor", GOO_CANVAS_ANCHOR_E, NULL);
-                else
-                    g_object_set(obj, "x", x + w + 5, "y", y + h / 2.0,
-                                 "anchor", GOO_CANVAS_ANCHOR_W, NULL);
-            }
-
-            g_object_set(skp->box,
-                         "x", x, "y", y, "width", w, "height", h, NULL);
-            /* need to raise item, otherwise it will not receive new events */
-            goo_canvas_item_raise(skp->box, NULL);
-        }
+        layout_ticks(skg);
+        layout_passes(skg);
     }
 }
 
@@ -480,9 +564,6 @@ static void create_canvas_items(GtkSkyGlance * skg)
     GooCanvasItem  *root;
     GooCanvasItem  *hrt, *hrl, *hrm;
     guint           i, n;
-    gdouble         th, tm;
-    gdouble         xh, xm;
-    gchar           buff[3];
 
     sat_log_log(SAT_LOG_LEVEL_DEBUG, "%s: Function called", __func__);
 
@@ -534,46 +615,24 @@ static void create_canvas_items(GtkSkyGlance * skg)
                                          "fill-color-rgba", 0xFFFFFFFF, NULL);
 
 
-    /* get the first hour and first 30 min slot */
-    th = ceil(skg->ts * 24.0) / 24.0;
-
-    /* workaround for bug 1839140 (first hour incorrexct) */
-    th += 0.00069;
-
-    /* the first 30 min tick can be either before
-       or after the first hour tick
-     */
-    if ((th - skg->ts) > 0.0208333)
-    {
-        tm = th - 0.0208333;
-    }
-    else
-    {
-        tm = th + 0.0208333;
-    }
-
-    /* the number of steps equals the number of hours */
+    /* the number of steps equals the number of hours,
+       layout_ticks() puts the items in place */
     n = sat_cfg_get_int(SAT_CFG_INT_SKYATGL_TIME);
     for (i = 0; i < n; i++)
     {
         /* hour tick */
-        xh = t2x(skg, th);
-        hrt =
-            goo_canvas_polyline_new_line(root, xh, skg->h, xh, skg->h + 10,
-                                         "stroke-color-rgba", 0xFFFFFFFF,
-                                         NULL);
+        hrt = goo_canvas_polyline_new_line(root, 0, skg->h, 0, skg->h + 10,
+                                           "stroke-color-rgba", 0xFFFFFFFF,
+                                           NULL);
 
         /* hour tick label */
-        daynum_to_str(buff, 3, "%H", th);
-
-        hrl = goo_canvas_text_new(root, buff, xh, skg->h + 12,
+        hrl = goo_canvas_text_new(root, "", 0, skg->h + 12,
                                   -1, GOO_CANVAS_ANCHOR_N,
                                   "font", "Sans 8",
                                   "fill-color-rgba", 0xFFFFFFFF, NULL);
 
         /* 30 min tick */
-        xm = t2x(skg, tm);
-        hrm = goo_canvas_polyline_new_line(root, xm, skg->h, xm, skg->h + 5,
+        hrm = goo_canvas_polyline_new_line(root, 0, skg->h, 0, skg->h + 5,
                                            "stroke-color-rgba", 0xFFFFFFFF,
                                            NULL);
 
@@ -581,10 +640,9 @@ static void create_canvas_items(GtkSkyGlance * skg)
         skg->majors = g_slist_append(skg->majors, hrt);
         skg->labels = g_slist_append(skg->labels, hrl);
         skg->minors = g_slist_append(skg->minors, hrm);
-
-        th += 0.0416667;
-        tm += 0.0416667;
     }
+
+    layout_ticks(skg);
 }
 
 /** Fetch the basic colour and add alpha channel */
@@ -653,133 +711,188 @@ static void get_colors(guint i, guint * bcol, guint * fcol)
 }
 
 /**
- * Create canvas items for a satellite
+ * Create the row of a satellite.
  *
  * @param key Pointer to the hash key (catnum of sat)
  * @param value Pointer to the current satellite.
  * @param data Pointer to the GtkSkyGlance object.
  *
  * This function is called by g_hash_table_foreach with each satellite in
- * the satellite hash table. It gets the passes for the current satellite
- * and creates the corresponding canvas items.
+ * the satellite hash table. The label stays hidden until the satellite has
+ * passes on the graph.
  */
-// Crashes from 2nd iter of create_sat
 static void create_sat(gpointer key, gpointer value, gpointer data)
 {
     sat_t          *sat = SAT(value);
     GtkSkyGlance   *skg = GTK_SKY_GLANCE(data);
-    GSList         *passes = NULL;
-    gdouble         maxdt;
-    guint           i, n;
-    pass_t         *tmppass = NULL;
-    sky_pass_t     *skypass;
-    guint           bcol, fcol; /* colors */
     GooCanvasItem  *root;
-    GooCanvasItem  *label;
+    sky_row_t      *row;
+
+    (void)key;
+
+    root = goo_canvas_get_root_item(GOO_CANVAS(skg->canvas));
+
+    row = g_new0(sky_row_t, 1);
+    row->catnum = sat->tle.catnr;
+    row->index = skg->satcnt++;
+    row->until = skg->ts;
+    get_colors(row->index, &row->bcol, &row->fcol);
+
+    row->label = goo_canvas_text_new(root, sat->nickname,
+                                     5, 0, -1, GOO_CANVAS_ANCHOR_W,
+                                     "font", "Sans 8",
+                                     "fill-color-rgba", row->bcol,
+                                     "visibility", GOO_CANVAS_ITEM_INVISIBLE,
+                                     NULL);
 
-    sat_log_log(SAT_LOG_LEVEL_DEBUG, "%s: Function called, sat is: %s", __func__, sat->nickname);
+    g_hash_table_insert(skg->rows, GUINT_TO_POINTER(row->catnum), row);
+}
+
+/**
+ * Request the passes of a satellite that are not on the graph yet.
+ *
+ * @param key Pointer to the hash key (catnum of sat)
+ * @param value Pointer to the current satellite.
+ * @param data Pointer to the GtkSkyGlance object.
+ *
+ * The prediction covers the time from where the known passes end to the
+ * end of the graph. Rows with a prediction running are skipped, they catch
+ * up on the next update.
+ */
+static void request_sat(gpointer key, gpointer value, gpointer data)
+{
+    sat_t          *sat = SAT(value);
+    GtkSkyGlance   *skg = GTK_SKY_GLANCE(data);
+    sky_row_t      *row;
+    gdouble         start;
 
     (void)key;
 
+    row = g_hash_table_lookup(skg->rows, GUINT_TO_POINTER(sat->tle.catnr));
+    if (row == NULL || row->pending)
+        return;
+
+    /* a pass still going on at row->until is already on the graph;
+       get_passes() steps 20 min past each LOS the same way */
+    start = MAX(row->until, row->last_los + 0.014);
+    if (start >= skg->te)
+        return;
+
+    row->until = skg->te;
+    row->pending = TRUE;
+    sky_passes_request(skg->pred, sat, skg->qth, start, skg->te - start,
+                       SKG_NUM_PASSES, skg->serial);
+}
+
+/** Create the canvas item for a pass. The pass is owned by the new sky_pass_t. */
+static sky_pass_t *create_pass(GtkSkyGlance * skg, sky_row_t * row,
+                               pass_t * pass)
+{
+    sky_pass_t     *skypass;
+    GooCanvasItem  *root;
+
     /* tooltips vars */
     gchar          *tooltip;    /* the complete tooltips string */
     gchar           aosstr[100];        /* AOS time string */
     gchar           losstr[100];        /* LOS time string */
     gchar           tcastr[100];        /* TCA time string */
 
-    /* get canvas root */
     root = goo_canvas_get_root_item(GOO_CANVAS(skg->canvas));
-    get_colors(skg->satcnt++, &bcol, &fcol);
-    maxdt = skg->te - skg->ts;
 
-    // Until here, no issues
+    skypass = g_new(sky_pass_t, 1);
+    skypass->catnum = row->catnum;
+    skypass->row = row->index;
+    skypass->pass = pass;
+
+    daynum_to_str(aosstr, TIME_FORMAT_MAX_LENGTH,
+                  sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT), pass->aos);
+    daynum_to_str(losstr, TIME_FORMAT_MAX_LENGTH,
+                  sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT), pass->los);
+    daynum_to_str(tcastr, TIME_FORMAT_MAX_LENGTH,
+                  sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT), pass->tca);
+
+    /* box tooltip will contain pass summary */
+    tooltip = g_strdup_printf(_("<b>%s</b>\n"
+                              "AOS: %s  Az:%.0f\302\260\n"
+                              "TCA: %s  Az:%.0f\302\260  El:%.1f\302\260\n"
+                              "LOS: %s  Az:%.0f\302\260\n"
+                              "<i>Click for details</i>"),
+                              pass->satname,
+                              aosstr, pass->aos_az,
+                              tcastr, pass->maxel_az,
+                              pass->max_el, losstr, pass->los_az);
+
+    skypass->box = goo_canvas_rect_new(root, 10, 10, 20, 20,
+                                       "stroke-color-rgba", row->bcol,
+                                       "fill-color-rgba", row->fcol,
+                                       "line-width", 1.0,
+                                       "antialias",
+                                       CAIRO_ANTIALIAS_NONE, "tooltip",
+                                       tooltip, "can-focus", TRUE, NULL);
+    g_free(tooltip);
+
+    /* store a pointer to the pass data in the GooCanvasItem so that we
+       can access it later during various events, e.g mouse click */
+    g_object_set_data(G_OBJECT(skypass->box), "pass", skypass->pass);
+
+    g_signal_connect(skypass->box, "button_release_event",
+                     (GCallback) on_button_release, skg);
+
+    return skypass;
+}
 
-    /* get passes for satellite */
-    // get_passes causes problems on 2nd iter onwards
-    passes = get_passes(sat, skg->qth, skg->ts, maxdt, 10);
-    n = g_slist_length(passes);
-    sat_log_log(SAT_LOG_LEVEL_DEBUG,
-                _("%s:%d: %s has %d passes within %.4f days\n"),
-                __FILE__, __LINE__, sat->nickname, n, maxdt);
+/**
+ * Draw the passes of a satellite when their prediction has finished.
+ *
+ * @param catnum Catalog number of the satellite.
+ * @param serial The serial the prediction was requested with.
+ * @param passes The predicted passes, owned by this function.
+ * @param data Pointer to the GtkSkyGlance object.
+ *
+ * Called from the main loop by sky_passes, one satellite at a time, so the
+ * graph fills in while the remaining satellites are still computed.
+ */
+static void passes_ready(guint catnum, guint serial, GSList * passes,
+                         gpointer data)
+{
+    GtkSkyGlance   *skg = GTK_SKY_GLANCE(data);
+    sky_row_t      *row;
+    sky_pass_t     *skypass;
+    GSList         *items = NULL;
+    GSList         *elm;
+    guint           n;
+
+    row = g_hash_table_lookup(skg->rows, GUINT_TO_POINTER(catnum));
 
-    /* add sky_pass_t items to skg->passes */
-    if (passes != NULL)
+    /* predictions requested before the last reset are out of date */
+    if (row == NULL || serial != skg->serial)
     {
-        /* add pass items */
-        for (i = 0; i < n; i++)
-        {
-            sat_log_log(SAT_LOG_LEVEL_DEBUG, "%s: Allocating memory for item %d", __func__, i);
-            skypass = g_try_new(sky_pass_t, 1);
-            if (skypass == NULL)
-            {
-                sat_log_log(SAT_LOG_LEVEL_ERROR,
-                            _("%s:%s: Could not allocate memory."),
-                            __FILE__, __func__);
-                continue;
-            }
-
-            /* create pass structure items */
-            skypass->catnum = sat->tle.catnr;
-            tmppass = (pass_t *) g_slist_nth_data(passes, i);
-            skypass->pass = copy_pass(tmppass);
-
-            daynum_to_str(aosstr, TIME_FORMAT_MAX_LENGTH,
-                          sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT),
-                          skypass->pass->aos);
-            daynum_to_str(losstr, TIME_FORMAT_MAX_LENGTH,
-                          sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT),
-                          skypass->pass->los);
-            daynum_to_str(tcastr, TIME_FORMAT_MAX_LENGTH,
-                          sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT),
-                          skypass->pass->tca);
-
-            /* box tooltip will contain pass summary */
-            tooltip = g_strdup_printf(_("<b>%s</b>\n"
-                                      "AOS: %s  Az:%.0f\302\260\n"
-                                      "TCA: %s  Az:%.0f\302\260  El:%.1f\302\260\n"
-                                      "LOS: %s  Az:%.0f\302\260\n"
-                                      "<i>Click for details</i>"),
-                                      skypass->pass->satname,
-                                      aosstr, skypass->pass->aos_az,
-                                      tcastr, skypass->pass->maxel_az,
-                                      skypass->pass->max_el, losstr,
-                                      skypass->pass->los_az);
-
-            skypass->box = goo_canvas_rect_new(root, 10, 10, 20, 20,
-                                               "stroke-color-rgba", bcol,
-                                               "fill-color-rgba", fcol,
-                                               "line-width", 1.0,
-                                               "antialias",
-                                               CAIRO_ANTIALIAS_NONE, "tooltip",
-                                               tooltip, "can-focus", TRUE,
-                                               NULL);
-            g_free(tooltip);
+        free_passes(passes);
+        return;
+    }
 
-            /* store this pass in list */
-            skg->passes = g_slist_append(skg->passes, skypass);
+    row->pending = FALSE;
+    n = g_slist_length(passes);
+    sat_log_log(SAT_LOG_LEVEL_DEBUG,
+                _("%s:%d: %d has %d passes until %.4f\n"),
+                __FILE__, __LINE__, catnum, n, row->until);
 
-            /* store a pointer to the pass data in the GooCanvasItem so that we
-               can access it later during various events, e.g mouse click */
-            g_object_set_data(G_OBJECT(skypass->box), "pass", skypass->pass);
+    for (elm = passes; elm != NULL; elm = elm->next)
+    {
+        skypass = create_pass(skg, row, (pass_t *) elm->data);
+        place_pass(skg, skypass);
+        row->last_los = skypass->pass->los;
+        items = g_slist_prepend(items, skypass);
+    }
+    g_slist_free(passes);
 
-            g_signal_connect(skypass->box, "button_release_event",
-                             (GCallback) on_button_release, skg);
-        }
+    /* stopped by the number of passes, the rest of the window is unknown */
+    if (n == SKG_NUM_PASSES)
+        row->until = row->last_los;
 
-        free_passes(passes);
+    skg->passes = g_slist_concat(skg->passes, g_slist_reverse(items));
 
-        /* add satellite label */
-        label = goo_canvas_text_new(root, sat->nickname,
-                                    5, 0, -1, GOO_CANVAS_ANCHOR_W,
-                                    "font", "Sans 8",
-                                    "fill-color-rgba", bcol, NULL);
-        skg->satlab = g_slist_append(skg->satlab, label);
-    }
-    else
-    {
-        ; // no op
-        sat_log_log(SAT_LOG_LEVEL_DEBUG, "%s: Pass is NULL", __func__);
-    }
+    place_label(skg, row, first_pass(skg, row->index));
 }
 
 /**
@@ -836,13 +949,77 @@ GtkWidget      *gtk_sky_glance_new(GHashTable * sats, qth_t * qth, gdouble ts)
 
     /* Create the canvas items */
     create_canvas_items(skg);
-    // this works fine
-    //sat_log_log(SAT_LOG_LEVEL_DEBUG, "%s: line %d breakpoint log", __FILE__, __LINE__);
-    // Below line crashes program with 100% CPU usage, possibly within create_sat
+
+    /* create the satellite rows; the passes are drawn as they arrive */
+    skg->rows = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                      NULL, g_free);
+    skg->pred = sky_passes_new(passes_ready, skg);
     g_hash_table_foreach(skg->sats, create_sat, skg);
-    //sat_log_log(SAT_LOG_LEVEL_DEBUG, "%s: line %d breakpoint log", __FILE__, __LINE__);
+    g_hash_table_foreach(skg->sats, request_sat, skg);
 
     gtk_box_pack_start(GTK_BOX(skg), skg->canvas, TRUE, TRUE, 0);
 
     return GTK_WIDGET(skg);
 }
+
+/**
+ * Move the time window of a GtkSkyGlance widget.
+ *
+ * @param skg The GtkSkyGlance widget.
+ * @param ts The new start time of the timeline.
+ *
+ * Passes that ended before ts are removed, the rest are moved, and only the
+ * time added at the end of the window is predicted. Going back in time or
+ * beyond the current window drops all passes and predicts the whole window
+ * again.
+ */
+void gtk_sky_glance_update(GtkSkyGlance * skg, gdouble ts)
+{
+    GHashTableIter  iter;
+    gpointer        value;
+    sky_pass_t     *skp;
+    GSList         *elm, *next;
+    gdouble         span;
+    gboolean        reset;
+
+    span = skg->te - skg->ts;
+    reset = (ts < skg->ts) || (ts >= skg->te);
+
+    for (elm = skg->passes; elm != NULL; elm = next)
+    {
+        next = elm->next;
+        skp = SKY_PASS_T(elm->data);
+
+        if (reset || skp->pass->los < ts)
+        {
+            goo_canvas_item_remove(skp->box);
+            free_pass(skp->pass);
+            g_free(skp);
+            skg->passes = g_slist_delete_link(skg->passes, elm);
+        }
+    }
+
+    if (reset)
+    {
+        /* results of the running predictions are dropped when they arrive */
+        skg->serial++;
+
+        g_hash_table_iter_init(&iter, skg->rows);
+        while (g_hash_table_iter_next(&iter, NULL, &value))
+        {
+            sky_row_t      *row = value;
+
+            row->until = ts;
+            row->last_los = 0.0;
+            row->pending = FALSE;
+        }
+    }
+
+    skg->ts = ts;
+    skg->te = ts + span;
+
+    layout_ticks(skg);
+    layout_passes(skg);
+
+    g_hash_table_foreach(skg->sats, request_sat, skg);
+}
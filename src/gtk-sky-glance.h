@@ -35,6 +35,7 @@
 #include "gtk-sat-data.h"
 
 #include "predict-tools.h"
+#include "sky-passes.h"
 
 /* *INDENT-OFF* */
 #ifdef __cplusplus
@@ -58,12 +59,25 @@ typedef struct {
     guint           catnum;     /* Catalog number of satellite */
     pass_t         *pass;       /* Details of the corresponding pass. */
     GooCanvasItem  *box;        /* Canvas item showing the pass */
+    guint           row;        /* Row of the satellite on the graph */
 } sky_pass_t;
 
 
 #define SKY_PASS_T(obj) ((sky_pass_t *)obj)
 
 
+/** Satellite row on graph. */
+typedef struct {
+    guint           catnum;     /* Catalog number of satellite */
+    guint           index;      /* Row number, also selects the colour */
+    guint           bcol, fcol; /* Border and fill colours */
+    GooCanvasItem  *label;      /* Satellite name, hidden while there are no passes */
+    gdouble         until;      /* Passes are known up to this time */
+    gdouble         last_los;   /* LOS of the last known pass */
+    gboolean        pending;    /* A prediction is running for this row */
+} sky_row_t;
+
+
 /** GtkSkyGlance widget */
 struct _GtkSkyGlance {
     GtkBox          vbox;
@@ -76,7 +90,9 @@ struct _GtkSkyGlance {
     GSList         *passes;     /* Canvas items representing each pass.
                                  * Each element in the list is of type sky_pass_t.
                                  */
-    GSList         *satlab;     /* Canvas items showing satellite names. */
+    GHashTable     *rows;       /* Rows of sky_row_t keyed by catnum. */
+    sky_passes     *pred;       /* Pass predictions running in the background */
+    guint           serial;     /* Predictions made with an older serial are dropped */
 
 
     guint           x0;
@@ -113,6 +129,7 @@ struct _GtkSkyGlanceClass {
 
 GType           gtk_sky_glance_get_type(void);
 GtkWidget      *gtk_sky_glance_new(GHashTable * sats, qth_t * qth, gdouble ts);
+void            gtk_sky_glance_update(GtkSkyGlance * skg, gdouble ts);
 
 /* *INDENT-OFF* */
 #ifdef __cplusplus
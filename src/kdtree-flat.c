@@ -0,0 +1,377 @@
+/*
+ * Implicit kd-tree over flat arrays.
+ *
+ * The build sorts an index array in place: the median along the axis of
+ * widest spread goes to the middle of the range, the points before it are no
+ * larger and the ones after no smaller, and both halves are split the same
+ * way. Coordinates and data are then copied out in that order, so a query
+ * walks index ranges instead of pointers and the leaves it scans are
+ * contiguous. Queries write into caller buffers and never allocate, and a
+ * rebuild only allocates when the tree grows past its previous size.
+ */
+#include <string.h>
+
+#include "kdtree-flat.h"
+
+#define LEAF_SIZE 8         // ranges this small are scanned without splitting
+
+kdflat *kdflat_new(guint dim, kdflat_precision precision)
+{
+    kdflat *tree;
+
+    g_return_val_if_fail(dim > 0 && dim <= KDFLAT_MAX_DIM, NULL);
+
+    tree = g_new0(kdflat, 1);
+    tree->dim = dim;
+    tree->precision = precision;
+    return tree;
+}
+
+void kdflat_free(kdflat *tree)
+{
+    if (!tree)
+        return;
+    g_free(tree->pos64);
+    g_free(tree->pos32);
+    g_free(tree->data);
+    g_free(tree->axis);
+    g_free(tree->order);
+    g_free(tree);
+}
+
+static void reserve(kdflat *tree, guint n)
+{
+    if (n <= tree->capacity)
+        return;
+
+    tree->capacity = MAX(n, 2 * tree->capacity);
+    if (tree->precision == KDFLAT_DOUBLE)
+        tree->pos64 = g_renew(gdouble, tree->pos64, (gsize)tree->capacity * tree->dim);
+    else
+        tree->pos32 = g_renew(gfloat, tree->pos32, (gsize)tree->capacity * tree->dim);
+    tree->data = g_renew(gpointer, tree->data, tree->capacity);
+    tree->axis = g_renew(guint8, tree->axis, tree->capacity);
+    tree->order = g_renew(guint, tree->order, tree->capacity);
+}
+
+/* Wirth's selection of the k-th smallest along axis within order[lo..hi] */
+static void select_kth(const gdouble *coords, guint dim, guint axis, guint *order,
+                       gint lo, gint hi, gint k)
+{
+    while (lo < hi) {
+        gdouble x = coords[(gsize)order[k] * dim + axis];
+        gint i = lo, j = hi;
+
+        do {
+            while (coords[(gsize)order[i] * dim + axis] < x) i++;
+            while (x < coords[(gsize)order[j] * dim + axis]) j--;
+            if (i <= j) {
+                guint tmp = order[i];
+                order[i] = order[j];
+                order[j] = tmp;
+                i++;
+                j--;
+            }
+        } while (i <= j);
+
+        if (j < k) lo = i;
+        if (k < i) hi = j;
+    }
+}
+
+static void build_range(kdflat *tree, const gdouble *coords, guint lo, guint hi)
+{
+    gdouble min[KDFLAT_MAX_DIM], max[KDFLAT_MAX_DIM];
+    guint mid, axis = 0;
+
+    if (hi - lo <= LEAF_SIZE)
+        return;
+
+    for (guint d = 0; d < tree->dim; d++) {
+        min[d] = G_MAXDOUBLE;
+        max[d] = -G_MAXDOUBLE;
+    }
+    for (guint i = lo; i < hi; i++) {
+        const gdouble *p = coords + (gsize)tree->order[i] * tree->dim;
+        for (guint d = 0; d < tree->dim; d++) {
+            min[d] = MIN(min[d], p[d]);
+            max[d] = MAX(max[d], p[d]);
+        }
+    }
+    for (guint d = 1; d < tree->dim; d++) {
+        if (max[d] - min[d] > max[axis] - min[axis])
+            axis = d;
+    }
+
+    mid = lo + (hi - lo) / 2;
+    select_kth(coords, tree->dim, axis, tree->order, lo, hi - 1, mid);
+    tree->axis[mid] = axis;
+
+    build_range(tree, coords, lo, mid);
+    build_range(tree, coords, mid + 1, hi);
+}
+
+gboolean kdflat_build(kdflat *tree, const gdouble *coords, gpointer *data, guint n)
+{
+    g_return_val_if_fail(tree != NULL && (coords != NULL || n == 0), FALSE);
+
+    reserve(tree, n);
+    tree->n = n;
+    for (guint i = 0; i < n; i++)
+        tree->order[i] = i;
+
+    build_range(tree, coords, 0, n);
+
+    for (guint i = 0; i < n; i++) {
+        const gdouble *p = coords + (gsize)tree->order[i] * tree->dim;
+        if (tree->precision == KDFLAT_DOUBLE) {
+            memcpy(tree->pos64 + (gsize)i * tree->dim, p, tree->dim * sizeof(gdouble));
+        } else {
+            for (guint d = 0; d < tree->dim; d++)
+                tree->pos32[(gsize)i * tree->dim + d] = (gfloat)p[d];
+        }
+        tree->data[i] = data ? data[tree->order[i]] : NULL;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Bounded max-heap of the best candidates so far, held in the caller's
+ * arrays. The slots hold point indices until the search is done.
+ */
+typedef struct {
+    guint num;
+    guint size;
+    gpointer *data;
+    gdouble *dist_sq;
+} knn_heap;
+
+static void heap_sift_down(knn_heap *heap, guint i, guint size)
+{
+    gpointer data = heap->data[i];
+    gdouble dist_sq = heap->dist_sq[i];
+    guint child;
+
+    while ((child = 2 * i + 1) < size) {
+        if (child + 1 < size && heap->dist_sq[child + 1] > heap->dist_sq[child])
+            child++;
+        if (heap->dist_sq[child] <= dist_sq)
+            break;
+        heap->data[i] = heap->data[child];
+        heap->dist_sq[i] = heap->dist_sq[child];
+        i = child;
+    }
+    heap->data[i] = data;
+    heap->dist_sq[i] = dist_sq;
+}
+
+static inline void heap_offer(knn_heap *heap, gpointer data, gdouble dist_sq)
+{
+    if (heap->size < heap->num) {
+        guint i = heap->size++;
+        while (i > 0 && heap->dist_sq[(i - 1) / 2] < dist_sq) {
+            heap->data[i] = heap->data[(i - 1) / 2];
+            heap->dist_sq[i] = heap->dist_sq[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap->data[i] = data;
+        heap->dist_sq[i] = dist_sq;
+    } else if (dist_sq < heap->dist_sq[0]) {
+        heap->data[0] = data;
+        heap->dist_sq[0] = dist_sq;
+        heap_sift_down(heap, 0, heap->size);
+    }
+}
+
+static inline gboolean heap_accepts(const knn_heap *heap, gdouble dist_sq)
+{
+    return heap->size < heap->num || dist_sq < heap->dist_sq[0];
+}
+
+typedef struct {
+    guint count;
+    guint max;
+    gpointer *data;
+    gdouble *dist_sq;
+} range_out;
+
+/*
+ * The searches are the same for both precisions apart from the coordinate
+ * type, so they are stamped out once per type. Distances are summed in the
+ * storage type, which lets the float tree stay in single precision.
+ */
+#define KDFLAT_SEARCH(T, POS, SUFFIX)                                           \
+static void nearest_##SUFFIX(const kdflat *tree, const T *q, guint lo, guint hi, \
+                             gconstpointer skip, knn_heap *heap)                \
+{                                                                               \
+    const guint dim = tree->dim;                                                \
+                                                                                \
+    while (hi > lo) {                                                           \
+        if (hi - lo <= LEAF_SIZE) {                                             \
+            for (guint i = lo; i < hi; i++) {                                   \
+                const T *p = tree->POS + (gsize)i * dim;                        \
+                T d2 = 0;                                                       \
+                for (guint d = 0; d < dim; d++)                                 \
+                    d2 += (p[d] - q[d]) * (p[d] - q[d]);                        \
+                if (tree->data[i] != skip || skip == NULL)                      \
+                    heap_offer(heap, GUINT_TO_POINTER(i), d2);                  \
+            }                                                                   \
+            return;                                                             \
+        }                                                                       \
+                                                                                \
+        guint mid = lo + (hi - lo) / 2;                                         \
+        const T *p = tree->POS + (gsize)mid * dim;                              \
+        T d2 = 0;                                                               \
+        for (guint d = 0; d < dim; d++)                                         \
+            d2 += (p[d] - q[d]) * (p[d] - q[d]);                                \
+        if (tree->data[mid] != skip || skip == NULL)                            \
+            heap_offer(heap, GUINT_TO_POINTER(mid), d2);                        \
+                                                                                \
+        T dx = q[tree->axis[mid]] - p[tree->axis[mid]];                         \
+        if (dx <= 0) {                                                          \
+            nearest_##SUFFIX(tree, q, lo, mid, skip, heap);                     \
+            if (!heap_accepts(heap, (gdouble)dx * dx))                          \
+                return;                                                         \
+            lo = mid + 1;                                                       \
+        } else {                                                                \
+            nearest_##SUFFIX(tree, q, mid + 1, hi, skip, heap);                 \
+            if (!heap_accepts(heap, (gdouble)dx * dx))                          \
+                return;                                                         \
+            hi = mid;                                                           \
+        }                                                                       \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static void within_##SUFFIX(const kdflat *tree, const T *q, T range, guint lo,  \
+                            guint hi, gconstpointer skip, range_out *out)       \
+{                                                                               \
+    const guint dim = tree->dim;                                                \
+    const T r2 = range * range;                                                 \
+                                                                                \
+    while (hi > lo) {                                                           \
+        guint mid = lo + (hi - lo) / 2;                                         \
+        gboolean leaf = (hi - lo <= LEAF_SIZE);                                 \
+        guint from = leaf ? lo : mid;                                           \
+        guint to = leaf ? hi : mid + 1;                                         \
+                                                                                \
+        for (guint i = from; i < to; i++) {                                     \
+            const T *p = tree->POS + (gsize)i * dim;                            \
+            T d2 = 0;                                                           \
+            for (guint d = 0; d < dim; d++)                                     \
+                d2 += (p[d] - q[d]) * (p[d] - q[d]);                            \
+            if (d2 <= r2 && (tree->data[i] != skip || skip == NULL)) {          \
+                if (out->count < out->max) {                                    \
+                    out->data[out->count] = tree->data[i];                      \
+                    if (out->dist_sq)                                           \
+                        out->dist_sq[out->count] = d2;                          \
+                }                                                               \
+                out->count++;                                                   \
+            }                                                                   \
+        }                                                                       \
+        if (leaf)                                                               \
+            return;                                                             \
+                                                                                \
+        const T *p = tree->POS + (gsize)mid * dim;                              \
+        T dx = q[tree->axis[mid]] - p[tree->axis[mid]];                         \
+        if (dx <= 0) {                                                          \
+            if (-dx <= range)                                                   \
+                within_##SUFFIX(tree, q, range, mid + 1, hi, skip, out);        \
+            hi = mid;                                                           \
+        } else {                                                                \
+            if (dx <= range)                                                    \
+                within_##SUFFIX(tree, q, range, lo, mid, skip, out);            \
+            lo = mid + 1;                                                       \
+        }                                                                       \
+    }                                                                           \
+}
+
+KDFLAT_SEARCH(gdouble, pos64, f64)
+KDFLAT_SEARCH(gfloat, pos32, f32)
+
+/* Fills slots with the indices of up to k nearest points, closest first */
+static guint nearest_indices(const kdflat *tree, const gdouble *pos, guint k, gconstpointer skip,
+                             gpointer *slots, gdouble *dist_sq)
+{
+    knn_heap heap = {k, 0, slots, dist_sq};
+
+    if (k == 0 || tree->n == 0)
+        return 0;
+
+    if (tree->precision == KDFLAT_DOUBLE) {
+        nearest_f64(tree, pos, 0, tree->n, skip, &heap);
+    } else {
+        gfloat q[KDFLAT_MAX_DIM];
+        for (guint d = 0; d < tree->dim; d++)
+            q[d] = (gfloat)pos[d];
+        nearest_f32(tree, q, 0, tree->n, skip, &heap);
+    }
+
+    // heap sort in place, the largest goes to the back each round
+    for (guint last = heap.size; last > 1; last--) {
+        gpointer tmp_slot = slots[0];
+        gdouble tmp_dist = dist_sq[0];
+        slots[0] = slots[last - 1];
+        dist_sq[0] = dist_sq[last - 1];
+        slots[last - 1] = tmp_slot;
+        dist_sq[last - 1] = tmp_dist;
+        heap_sift_down(&heap, 0, last - 1);
+    }
+
+    return heap.size;
+}
+
+guint kdflat_nearest_k(const kdflat *tree, const gdouble *pos, guint k, gconstpointer skip,
+                       gpointer *data, gdouble *dist_sq)
+{
+    guint found;
+
+    g_return_val_if_fail(tree != NULL && pos != NULL, 0);
+
+    found = nearest_indices(tree, pos, k, skip, data, dist_sq);
+    for (guint i = 0; i < found; i++)
+        data[i] = tree->data[GPOINTER_TO_UINT(data[i])];
+
+    return found;
+}
+
+gpointer kdflat_nearest(const kdflat *tree, const gdouble *pos, gdouble *out_pos)
+{
+    gpointer slot;
+    gdouble dist_sq;
+    guint i;
+
+    g_return_val_if_fail(tree != NULL && pos != NULL, NULL);
+
+    if (nearest_indices(tree, pos, 1, NULL, &slot, &dist_sq) == 0)
+        return NULL;
+
+    i = GPOINTER_TO_UINT(slot);
+    for (guint d = 0; out_pos && d < tree->dim; d++) {
+        out_pos[d] = (tree->precision == KDFLAT_DOUBLE) ?
+                     tree->pos64[(gsize)i * tree->dim + d] :
+                     tree->pos32[(gsize)i * tree->dim + d];
+    }
+    return tree->data[i];
+}
+
+guint kdflat_within(const kdflat *tree, const gdouble *pos, gdouble range, gconstpointer skip,
+                    gpointer *data, gdouble *dist_sq, guint max)
+{
+    range_out out = {0, max, data, dist_sq};
+
+    g_return_val_if_fail(tree != NULL && pos != NULL, 0);
+    if (tree->n == 0 || range < 0)
+        return 0;
+
+    if (tree->precision == KDFLAT_DOUBLE) {
+        within_f64(tree, pos, range, 0, tree->n, skip, &out);
+    } else {
+        gfloat q[KDFLAT_MAX_DIM];
+        for (guint d = 0; d < tree->dim; d++)
+            q[d] = (gfloat)pos[d];
+        within_f32(tree, q, (gfloat)range, 0, tree->n, skip, &out);
+    }
+
+    return out.count;
+}
@@ -0,0 +1,61 @@
+#ifndef __KDTREE_FLAT_H__
+#define __KDTREE_FLAT_H__
+
+#include <glib.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#define KDFLAT_MAX_DIM 16
+
+/* Storage precision of the coordinates */
+typedef enum {
+    KDFLAT_DOUBLE = 0,      // physics, distances between satellites
+    KDFLAT_FLOAT            // display, half the memory per point
+} kdflat_precision;
+
+/*
+ * Static kd-tree kept as flat arrays in build order. The points of every
+ * subtree are a contiguous range [lo, hi) with the splitting point at its
+ * middle, so no child pointers are stored and small subtrees are scanned
+ * as plain arrays.
+ */
+typedef struct {
+    guint dim;
+    kdflat_precision precision;
+    guint n;
+    guint capacity;
+    gdouble *pos64;         // n * dim, KDFLAT_DOUBLE
+    gfloat *pos32;          // n * dim, KDFLAT_FLOAT
+    gpointer *data;         // n
+    guint8 *axis;           // split axis of the point at each index
+    guint *order;           // build scratch
+} kdflat;
+
+kdflat *kdflat_new(guint dim, kdflat_precision precision);
+void kdflat_free(kdflat *tree);
+
+// Replace the contents with n points of dim coords each, buffers are reused
+gboolean kdflat_build(kdflat *tree, const gdouble *coords, gpointer *data, guint n);
+
+// Nearest point, out_pos (may be NULL) gets its stored coordinates
+gpointer kdflat_nearest(const kdflat *tree, const gdouble *pos, gdouble *out_pos);
+
+// Up to k nearest points other than skip, closest first, into the caller's arrays
+guint kdflat_nearest_k(const kdflat *tree, const gdouble *pos, guint k, gconstpointer skip,
+                       gpointer *data, gdouble *dist_sq);
+
+// Points within range other than skip, at most max written, returns the number in range
+guint kdflat_within(const kdflat *tree, const gdouble *pos, gdouble range, gconstpointer skip,
+                    gpointer *data, gdouble *dist_sq, guint max);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
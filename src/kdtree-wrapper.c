@@ -1,32 +1,99 @@
 #include "kdtree-wrapper.h"
 #include "kdtree.h"
+#include "kdtree-flat.h"
+
+#define IS_FLAT(tree) ((tree)->backend != KDTREE_BACKEND_NODES)
 
 Kdtree *kdtree_new(gint k) {
+    return kdtree_new_backend(k, KDTREE_BACKEND_NODES);
+}
+
+Kdtree *kdtree_new_backend(gint k, KdtreeBackend backend) {
     g_return_val_if_fail(k > 0, NULL);
+    g_return_val_if_fail(backend == KDTREE_BACKEND_NODES || k <= KDFLAT_MAX_DIM, NULL);
 
     Kdtree *wrapper = g_new0(Kdtree, 1);
-    wrapper->tree = kd_create(k);
     wrapper->dimensions = k;
+    wrapper->backend = backend;
+    if (IS_FLAT(wrapper)) {
+        wrapper->flat = kdflat_new(k, backend == KDTREE_BACKEND_FLAT ? KDFLAT_DOUBLE : KDFLAT_FLOAT);
+        wrapper->coords = g_array_new(FALSE, FALSE, sizeof(gdouble));
+        wrapper->data = g_ptr_array_new();
+    } else {
+        wrapper->tree = kd_create(k);
+    }
     return wrapper;
 }
 
 void kdtree_set_data_destroy_func(Kdtree *tree, GDestroyNotify func) {
     g_return_if_fail(tree != NULL);
-    kd_data_destructor(tree->tree, func);
+    if (IS_FLAT(tree))
+        tree->destroy = func;
+    else
+        kd_data_destructor(tree->tree, func);
+}
+
+// Drops the collected points of a flat backend, as kd_clear does for nodes
+static void flat_clear(Kdtree *tree) {
+    if (tree->destroy) {
+        for (guint i = 0; i < tree->data->len; i++)
+            tree->destroy(g_ptr_array_index(tree->data, i));
+    }
+    g_array_set_size(tree->coords, 0);
+    g_ptr_array_set_size(tree->data, 0);
+    tree->dirty = TRUE;
+}
+
+// Brings the flat tree up to date with the collected points
+static kdflat *flat_ready(Kdtree *tree) {
+    if (tree->dirty) {
+        kdflat_build(tree->flat, (gdouble *)tree->coords->data, tree->data->pdata, tree->data->len);
+        tree->dirty = FALSE;
+    }
+    return tree->flat;
 }
 
 void kdtree_free(Kdtree *tree) {
     if (tree) {
-        kd_free(tree->tree);
+        if (IS_FLAT(tree)) {
+            flat_clear(tree);
+            kdflat_free(tree->flat);
+            g_array_free(tree->coords, TRUE);
+            g_ptr_array_free(tree->data, TRUE);
+        } else {
+            kd_free(tree->tree);
+        }
         g_free(tree);
     }
 }
 
 gboolean kdtree_insert(Kdtree *tree, const gdouble *coords, gpointer data) {
     g_return_val_if_fail(tree != NULL && coords != NULL, FALSE);
+
+    if (IS_FLAT(tree)) {
+        g_array_append_vals(tree->coords, coords, tree->dimensions);
+        g_ptr_array_add(tree->data, data);
+        tree->dirty = TRUE;
+        return TRUE;
+    }
     return kd_insert(tree->tree, coords, data) == 0;
 }
 
+gboolean kdtree_build(Kdtree *tree, const gdouble *coords, gpointer *data, guint n) {
+    g_return_val_if_fail(tree != NULL && (coords != NULL || n == 0), FALSE);
+
+    if (IS_FLAT(tree)) {
+        flat_clear(tree);
+        g_array_append_vals(tree->coords, coords, n * tree->dimensions);
+        g_ptr_array_set_size(tree->data, n);
+        for (guint i = 0; i < n; i++)
+            g_ptr_array_index(tree->data, i) = data ? data[i] : NULL;
+        flat_ready(tree);
+        return TRUE;
+    }
+    return kd_build(tree->tree, coords, data, (int)n) == 0;
+}
+
 gboolean kdtree_insert1(Kdtree *tree, gdouble x, gpointer data) {
     gdouble pos[1] = { x };
     return kdtree_insert(tree, pos, data);
@@ -34,12 +101,20 @@ gboolean kdtree_insert1(Kdtree *tree, gdouble x, gpointer data) {
 
 gboolean kdtree_insert3(Kdtree *tree, gdouble x, gdouble y, gdouble z, gpointer data) {
     g_return_val_if_fail(tree != NULL && tree->dimensions == 3, FALSE);
+
+    if (IS_FLAT(tree)) {
+        gdouble pos[3] = { x, y, z };
+        return kdtree_insert(tree, pos, data);
+    }
     return kd_insert3(tree->tree, x, y, z, data) == 0;
 }
 
 gpointer kdtree_nearest(Kdtree *tree, const gdouble *coords, gdouble *out_coords) {
     g_return_val_if_fail(tree != NULL && coords != NULL, NULL);
 
+    if (IS_FLAT(tree))
+        return kdflat_nearest(flat_ready(tree), coords, out_coords);
+
     struct kdres *res = kd_nearest(tree->tree, coords);
     if (!res || kd_res_end(res)) {
         if (res) kd_res_free(res);
@@ -63,20 +138,31 @@ gpointer kdtree_nearest3(Kdtree *tree, gdouble x, gdouble y, gdouble z,
                          gdouble *out_x, gdouble *out_y, gdouble *out_z) {
     g_return_val_if_fail(tree != NULL && tree->dimensions == 3, NULL);
 
-    struct kdres *res = kd_nearest3(tree->tree, x, y, z);
-    if (!res || kd_res_end(res)) {
-        if (res) kd_res_free(res);
-        return NULL;
-    }
-
+    gdouble input[3] = { x, y, z };
     gdouble pos[3];
-    gpointer data = kd_res_item(res, pos);
+    gpointer data = kdtree_nearest(tree, input, pos);
     if (data) {
         if (out_x) *out_x = pos[0];
         if (out_y) *out_y = pos[1];
         if (out_z) *out_z = pos[2];
     }
-
-    kd_res_free(res);
     return data;
 }
+
+guint kdtree_nearest_k(Kdtree *tree, const gdouble *coords, guint k, gconstpointer skip,
+                       gpointer *data, gdouble *dist_sq) {
+    g_return_val_if_fail(tree != NULL && coords != NULL && data != NULL && dist_sq != NULL, 0);
+
+    if (IS_FLAT(tree))
+        return kdflat_nearest_k(flat_ready(tree), coords, k, skip, data, dist_sq);
+    return kd_nearest_n_buf(tree->tree, coords, (int)k, skip, data, dist_sq);
+}
+
+guint kdtree_within(Kdtree *tree, const gdouble *coords, gdouble range, gconstpointer skip,
+                    gpointer *data, gdouble *dist_sq, guint max) {
+    g_return_val_if_fail(tree != NULL && coords != NULL && (data != NULL || max == 0), 0);
+
+    if (IS_FLAT(tree))
+        return kdflat_within(flat_ready(tree), coords, range, skip, data, dist_sq, max);
+    return kd_nearest_range_buf(tree->tree, coords, range, skip, data, dist_sq, (int)max);
+}
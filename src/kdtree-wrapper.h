@@ -3,20 +3,40 @@
 
 #include <glib.h>
 #include "kdtree.h"
+#include "kdtree-flat.h"
 
 G_BEGIN_DECLS
 
 // Opaque kd-tree object
 typedef struct _Kdtree Kdtree;
 
+// Storage behind a Kdtree
+typedef enum {
+    KDTREE_BACKEND_NODES = 0,   // kdtree.c, one heap node per point
+    KDTREE_BACKEND_FLAT,        // kdtree-flat.c, implicit tree in double precision
+    KDTREE_BACKEND_FLAT_FLOAT   // kdtree-flat.c in single precision, for display lookups
+} KdtreeBackend;
+
 struct _Kdtree {
-    struct kdtree *tree;
+    struct kdtree *tree;        // KDTREE_BACKEND_NODES
     gint dimensions;
+    KdtreeBackend backend;
+
+    // flat backends: the tree is static, points are collected here and the
+    // tree is built again on the first query after they change
+    kdflat *flat;
+    GArray *coords;
+    GPtrArray *data;
+    gboolean dirty;
+    GDestroyNotify destroy;
 };
 
 // Create a new kd-tree with `k` dimensions
 Kdtree *kdtree_new(gint k);
 
+// Create a new kd-tree with `k` dimensions on the given backend
+Kdtree *kdtree_new_backend(gint k, KdtreeBackend backend);
+
 // Free a kd-tree and its contents
 void kdtree_free(Kdtree *tree);
 
@@ -26,6 +46,10 @@ void kdtree_set_data_destroy_func(Kdtree *tree, GDestroyNotify func);
 // Insert point of arbitrary dimensions
 gboolean kdtree_insert(Kdtree *tree, const gdouble *coords, gpointer data);
 
+// Replace the contents with n points (coords holds `dimensions` values per point),
+// built balanced in O(n log n)
+gboolean kdtree_build(Kdtree *tree, const gdouble *coords, gpointer *data, guint n);
+
 // Convenience: insert 1D point
 gboolean kdtree_insert1(Kdtree *tree, gdouble x, gpointer data);
 
@@ -42,6 +66,18 @@ gpointer kdtree_nearest1(Kdtree *tree, gdouble x, gdouble *out_x);
 gpointer kdtree_nearest3(Kdtree *tree, gdouble x, gdouble y, gdouble z,
                          gdouble *out_x, gdouble *out_y, gdouble *out_z);
 
+// Up to k nearest neighbours of a point, closest first, skipping points whose
+// data is `skip` (may be NULL). Writes data and squared distances to the
+// caller's arrays, both k long, and returns how many were found.
+guint kdtree_nearest_k(Kdtree *tree, const gdouble *coords, guint k, gconstpointer skip,
+                       gpointer *data, gdouble *dist_sq);
+
+// Points within range of coords other than `skip`, at most max written to the
+// caller's arrays. Returns the number in range, which exceeds max when the
+// arrays were too short.
+guint kdtree_within(Kdtree *tree, const gdouble *coords, gdouble range, gconstpointer skip,
+                    gpointer *data, gdouble *dist_sq, guint max);
+
 G_END_DECLS
 
 #endif // KDTREE_WRAPPER_H
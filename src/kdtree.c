@@ -260,6 +260,96 @@ int kd_insert3f(struct kdtree *tree, float x, float y, float z, void *data)
 	return kd_insert(tree, buf, data);
 }
 
+/* ---- bulk build ---- */
+
+/* Wirth's selection: reorders idx[lo..hi] so that the point at idx[k] has the
+ * k-th smallest coordinate along dir, with no larger ones before it and no
+ * smaller ones after it.
+ */
+static void select_kth(const double *pos, int dim, int dir, int *idx, int lo, int hi, int k)
+{
+	while(lo < hi) {
+		double x = pos[idx[k] * dim + dir];
+		int i = lo, j = hi, tmp;
+
+		do {
+			while(pos[idx[i] * dim + dir] < x) i++;
+			while(x < pos[idx[j] * dim + dir]) j--;
+			if(i <= j) {
+				tmp = idx[i];
+				idx[i] = idx[j];
+				idx[j] = tmp;
+				i++;
+				j--;
+			}
+		} while(i <= j);
+
+		if(j < k) lo = i;
+		if(k < i) hi = j;
+	}
+}
+
+static struct kdnode *build_rec(const double *pos, void **data, int *idx, int lo, int hi, int dir, int dim, int *err)
+{
+	struct kdnode *node;
+	int mid;
+
+	if(lo >= hi || *err) return 0;
+
+	mid = lo + (hi - lo) / 2;
+	select_kth(pos, dim, dir, idx, lo, hi - 1, mid);
+
+	if(!(node = malloc(sizeof *node))) {
+		*err = 1;
+		return 0;
+	}
+	if(!(node->pos = malloc(dim * sizeof *node->pos))) {
+		free(node);
+		*err = 1;
+		return 0;
+	}
+	memcpy(node->pos, pos + idx[mid] * dim, dim * sizeof *node->pos);
+	node->data = data ? data[idx[mid]] : 0;
+	node->dir = dir;
+	node->left = build_rec(pos, data, idx, lo, mid, (dir + 1) % dim, dim, err);
+	node->right = build_rec(pos, data, idx, mid + 1, hi, (dir + 1) % dim, dim, err);
+
+	return node;
+}
+
+int kd_build(struct kdtree *tree, const double *pos, void **data, int count)
+{
+	int i, err = 0;
+	int *idx;
+
+	kd_clear(tree);
+	if(count <= 0) return 0;
+
+	if(!(idx = malloc(count * sizeof *idx))) {
+		return -1;
+	}
+	for(i=0; i<count; i++) {
+		idx[i] = i;
+	}
+
+	tree->root = build_rec(pos, data, idx, 0, count, 0, tree->dim, &err);
+	free(idx);
+	if(err) {
+		kd_clear(tree);
+		return -1;
+	}
+
+	if(!(tree->rect = hyperrect_create(tree->dim, pos, pos))) {
+		kd_clear(tree);
+		return -1;
+	}
+	for(i=1; i<count; i++) {
+		hyperrect_extend(tree->rect, pos + i * tree->dim);
+	}
+
+	return 0;
+}
+
 static int find_nearest(struct kdnode *node, const double *pos, double range, struct res_node *list, int ordered, int dim)
 {
 	double dist_sq, dx;
@@ -293,55 +383,111 @@ static int find_nearest(struct kdnode *node, const double *pos, double range, st
 	return added_res;
 }
 
-#if 0
-static int find_nearest_n(struct kdnode *node, const double *pos, double range, int num, struct rheap *heap, int dim)
+/* ---- bounded nearest N search ---- */
+
+/* max-heap on dist_sq of the closest nodes found so far, in caller arrays */
+struct knn_heap {
+	int num, size;
+	struct kdnode **item;
+	double *dist_sq;
+	const void *skip;
+};
+
+static void knn_sift_down(struct knn_heap *heap, int i, int size)
 {
-	double dist_sq, dx;
-	int i, ret, added_res = 0;
+	struct kdnode *item = heap->item[i];
+	double dist_sq = heap->dist_sq[i];
+	int child;
 
-	if(!node) return 0;
-	
-	/* if the photon is close enough, add it to the result heap */
-	dist_sq = 0;
-	for(i=0; i<dim; i++) {
-		dist_sq += SQ(node->pos[i] - pos[i]);
+	while((child = 2 * i + 1) < size) {
+		if(child + 1 < size && heap->dist_sq[child + 1] > heap->dist_sq[child]) {
+			child++;
+		}
+		if(heap->dist_sq[child] <= dist_sq) break;
+		heap->item[i] = heap->item[child];
+		heap->dist_sq[i] = heap->dist_sq[child];
+		i = child;
 	}
-	if(dist_sq <= range_sq) {
-		if(heap->size >= num) {
-			/* get furthest element */
-			struct res_node *maxelem = rheap_get_max(heap);
+	heap->item[i] = item;
+	heap->dist_sq[i] = dist_sq;
+}
 
-			/* and check if the new one is closer than that */
-			if(maxelem->dist_sq > dist_sq) {
-				rheap_remove_max(heap);
+static void knn_offer(struct knn_heap *heap, struct kdnode *node, double dist_sq)
+{
+	int i, parent;
+
+	if(heap->size < heap->num) {
+		i = heap->size++;
+		while(i > 0 && heap->dist_sq[parent = (i - 1) / 2] < dist_sq) {
+			heap->item[i] = heap->item[parent];
+			heap->dist_sq[i] = heap->dist_sq[parent];
+			i = parent;
+		}
+		heap->item[i] = node;
+		heap->dist_sq[i] = dist_sq;
+	} else if(dist_sq < heap->dist_sq[0]) {
+		heap->item[0] = node;
+		heap->dist_sq[0] = dist_sq;
+		knn_sift_down(heap, 0, heap->size);
+	}
+}
 
-				if(rheap_insert(heap, node, dist_sq) == -1) {
-					return -1;
-				}
-				added_res = 1;
+static void find_nearest_n(struct kdnode *node, const double *pos, struct knn_heap *heap, int dim)
+{
+	double dist_sq, dx;
+	int i;
 
-				range_sq = dist_sq;
-			}
-		} else {
-			if(rheap_insert(heap, node, dist_sq) == -1) {
-				return =1;
-			}
-			added_res = 1;
+	if(!node) return;
+
+	if(!heap->skip || node->data != heap->skip) {
+		dist_sq = 0;
+		for(i=0; i<dim; i++) {
+			dist_sq += SQ(node->pos[i] - pos[i]);
 		}
+		knn_offer(heap, node, dist_sq);
 	}
 
-
 	/* find signed distance from the splitting plane */
 	dx = pos[node->dir] - node->pos[node->dir];
 
-	ret = find_nearest_n(dx <= 0.0 ? node->left : node->right, pos, range, num, heap, dim);
-	if(ret >= 0 && fabs(dx) < range) {
-		added_res += ret;
-		ret = find_nearest_n(dx <= 0.0 ? node->right : node->left, pos, range, num, heap, dim);
+	find_nearest_n(dx <= 0.0 ? node->left : node->right, pos, heap, dim);
+	if(heap->size < heap->num || SQ(dx) < heap->dist_sq[0]) {
+		find_nearest_n(dx <= 0.0 ? node->right : node->left, pos, heap, dim);
+	}
+}
+
+/* fills item/dist_sq with up to num nodes, closest first */
+static int nearest_n_nodes(struct kdtree *kd, const double *pos, int num, const void *skip,
+		struct kdnode **item, double *dist_sq)
+{
+	struct knn_heap heap;
+	struct kdnode *tmp_item;
+	double tmp_dist;
+	int last;
+
+	if(!kd || num <= 0) return 0;
+
+	heap.num = num;
+	heap.size = 0;
+	heap.item = item;
+	heap.dist_sq = dist_sq;
+	heap.skip = skip;
+	find_nearest_n(kd->root, pos, &heap, kd->dim);
+
+	/* heap sort in place, the largest goes to the back each round */
+	for(last = heap.size - 1; last > 0; last--) {
+		tmp_item = item[0];
+		tmp_dist = dist_sq[0];
+		item[0] = item[last];
+		dist_sq[0] = dist_sq[last];
+		item[last] = tmp_item;
+		dist_sq[last] = tmp_dist;
+		knn_sift_down(&heap, 0, last);
 	}
 
+	return heap.size;
 }
-#endif
+
 
 static void kd_nearest_i(struct kdnode *node, const double *pos, struct kdnode **result, double *result_dist_sq, struct kdhyperrect* rect)
 {
@@ -510,11 +656,14 @@ struct kdres *kd_nearest3f(struct kdtree *tree, float x, float y, float z)
 }
 
 /* ---- nearest N search ---- */
-/*
-static kdres *kd_nearest_n(struct kdtree *kd, const double *pos, int num)
+struct kdres *kd_nearest_n(struct kdtree *kd, const double *pos, int num)
 {
-	int ret;
 	struct kdres *rset;
+	struct kdnode **item;
+	double *dist_sq;
+	int i, count;
+
+	if(!kd || num < 0) return 0;
 
 	if(!(rset = malloc(sizeof *rset))) {
 		return 0;
@@ -525,15 +674,92 @@ static kdres *kd_nearest_n(struct kdtree *kd, const double *pos, int num)
 	}
 	rset->rlist->next = 0;
 	rset->tree = kd;
+	rset->size = 0;
 
-	if((ret = find_nearest_n(kd->root, pos, range, num, rset->rlist, kd->dim)) == -1) {
+	item = malloc((num > 0 ? num : 1) * sizeof *item);
+	dist_sq = malloc((num > 0 ? num : 1) * sizeof *dist_sq);
+	if(!item || !dist_sq) {
+		free(item);
+		free(dist_sq);
 		kd_res_free(rset);
 		return 0;
 	}
-	rset->size = ret;
+
+	count = nearest_n_nodes(kd, pos, num, 0, item, dist_sq);
+	/* inserted from the back so every insert is at the head of the list */
+	for(i=count-1; i>=0; i--) {
+		if(rlist_insert(rset->rlist, item[i], -1.0) == -1) {
+			free(item);
+			free(dist_sq);
+			kd_res_free(rset);
+			return 0;
+		}
+	}
+	free(item);
+	free(dist_sq);
+
+	rset->size = count;
 	kd_res_rewind(rset);
 	return rset;
-}*/
+}
+
+struct kdres *kd_nearest_n3(struct kdtree *tree, double x, double y, double z, int num)
+{
+	double pos[3];
+	pos[0] = x;
+	pos[1] = y;
+	pos[2] = z;
+	return kd_nearest_n(tree, pos, num);
+}
+
+int kd_nearest_n_buf(struct kdtree *tree, const double *pos, int num, const void *skip,
+		void **data, double *dist_sq)
+{
+	int i, count;
+
+	/* the node pointers are collected in data and swapped for their data */
+	count = nearest_n_nodes(tree, pos, num, skip, (struct kdnode **)data, dist_sq);
+	for(i=0; i<count; i++) {
+		data[i] = ((struct kdnode *)data[i])->data;
+	}
+	return count;
+}
+
+static int find_range_buf(struct kdnode *node, const double *pos, double range, const void *skip,
+		void **data, double *dist_sq, int max, int count, int dim)
+{
+	double d_sq, dx;
+	int i;
+
+	while(node) {
+		d_sq = 0;
+		for(i=0; i<dim; i++) {
+			d_sq += SQ(node->pos[i] - pos[i]);
+		}
+		if(d_sq <= SQ(range) && (!skip || node->data != skip)) {
+			if(count < max) {
+				data[count] = node->data;
+				if(dist_sq) dist_sq[count] = d_sq;
+			}
+			count++;
+		}
+
+		dx = pos[node->dir] - node->pos[node->dir];
+		if(fabs(dx) < range) {
+			count = find_range_buf(dx <= 0.0 ? node->right : node->left, pos, range,
+					skip, data, dist_sq, max, count, dim);
+		}
+		node = dx <= 0.0 ? node->left : node->right;
+	}
+	return count;
+}
+
+int kd_nearest_range_buf(struct kdtree *tree, const double *pos, double range, const void *skip,
+		void **data, double *dist_sq, int max)
+{
+	if(!tree) return 0;
+	return find_range_buf(tree->root, pos, range, skip, data, dist_sq, max, 0, tree->dim);
+}
 
 struct kdres *kd_nearest_range(struct kdtree *kd, const double *pos, double range)
 {
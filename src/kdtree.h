@@ -56,6 +56,12 @@ int kd_insertf(struct kdtree *tree, const float *pos, void *data);
 int kd_insert3(struct kdtree *tree, double x, double y, double z, void *data);
 int kd_insert3f(struct kdtree *tree, float x, float y, float z, void *data);
 
+/* replace the contents of the tree with "count" points, pos holds k coords
+ * per point and data (may be null) their data pointers. The tree is built
+ * balanced by splitting at the median, which takes O(n log n).
+ */
+int kd_build(struct kdtree *tree, const double *pos, void **data, int count);
+
 /* Find the nearest node from a given point.
  *
  * This function returns a pointer to a result set with at most one element.
@@ -67,18 +73,23 @@ struct kdres *kd_nearest3f(struct kdtree *tree, float x, float y, float z);
 
 /* Find the N nearest nodes from a given point.
  *
- * This function returns a pointer to a result set, with at most N elements,
- * which can be manipulated with the kd_res_* functions.
+ * This function returns a pointer to a result set, with at most N elements
+ * ordered by distance, which can be manipulated with the kd_res_* functions.
  * The returned pointer can be null as an indication of an error. Otherwise
  * a valid result set is always returned which may contain 0 or more elements.
  * The result set must be deallocated with kd_res_free after use.
  */
-/*
 struct kdres *kd_nearest_n(struct kdtree *tree, const double *pos, int num);
-struct kdres *kd_nearest_nf(struct kdtree *tree, const float *pos, int num);
-struct kdres *kd_nearest_n3(struct kdtree *tree, double x, double y, double z);
-struct kdres *kd_nearest_n3f(struct kdtree *tree, float x, float y, float z);
-*/
+struct kdres *kd_nearest_n3(struct kdtree *tree, double x, double y, double z, int num);
+
+/* Same search without a result set: writes the data pointers of at most num
+ * nearest nodes to data and their squared distances to dist_sq, closest
+ * first, and returns how many were written. Nodes whose data pointer equals
+ * skip are ignored (pass null to keep all), so a point can look up its
+ * neighbours without finding itself. Nothing is allocated.
+ */
+int kd_nearest_n_buf(struct kdtree *tree, const double *pos, int num, const void *skip,
+		void **data, double *dist_sq);
 
 /* Find any nearest nodes from a given point within a range.
  *
@@ -93,6 +104,15 @@ struct kdres *kd_nearest_rangef(struct kdtree *tree, const float *pos, float ran
 struct kdres *kd_nearest_range3(struct kdtree *tree, double x, double y, double z, double range);
 struct kdres *kd_nearest_range3f(struct kdtree *tree, float x, float y, float z, float range);
 
+/* Range search without a result set: writes the data pointers of the nodes
+ * within range to data (and their squared distances to dist_sq if not null),
+ * in no particular order, stopping after max. Nodes whose data pointer equals
+ * skip are ignored as in kd_nearest_n_buf. Returns the number of nodes in
+ * range, which is larger than max if some did not fit. Nothing is allocated.
+ */
+int kd_nearest_range_buf(struct kdtree *tree, const double *pos, double range, const void *skip,
+		void **data, double *dist_sq, int max);
+
 /* frees a result set returned by kd_nearest_range() */
 void kd_res_free(struct kdres *set);
 
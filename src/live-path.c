@@ -0,0 +1,579 @@
+/*
+ * Shortest path between the two ground stations of the map, kept up to date
+ * on a worker thread.
+ *
+ * The main thread only copies the satellites into a snapshot. The worker picks
+ * up the newest snapshot, older ones are dropped when it falls behind, and hands
+ * the result back through the main loop. Only the satellite pairs within
+ * their joint horizon, the candidate pairs of the los-pairs grid, can see
+ * each other. Between snapshots the line of sight of those pairs is kept
+ * together with the time it is known to stay valid for, so a pair is only
+ * rechecked once its satellites could have moved far enough to cross the
+ * edge of the Earth.
+ *
+ * In LIVE_PATH_WIDEST mode the path instead maximises its weakest link, with
+ * the SKR of every link as edge weight. The stations join the graph through
+ * their up and downlinks and links only exist up to the distance at which
+ * the inter satellite SKR drops to zero, so the LOS pairs come from the
+ * los-pairs grid and the route from the widest path search over the CSR graph.
+ */
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calc-dist-two-sat.h"
+#include "live-path.h"
+#include "los-pairs.h"
+#include "orbit-tools.h"
+#include "sat-graph.h"
+#include "skr-utils.h"
+
+#define LOS_CLEARANCE (EARTH_RADIUS + 20)   //same sphere is_pos_los_clear tests against
+#define LOS_HORIZON_SAFETY 0.5              //speeds change along eccentric orbits
+#define LOS_HORIZON_MAX 600.0               //seconds
+#define LOS_REBASE 86400.0                  //seconds after which expiries are measured from a new base
+
+typedef struct {
+    gdouble time;
+    GArray *nodes;      //live_path_node
+    gint src;           //index of the satellite closest to qth, -1 for none
+    gint dst;           //index of the satellite closest to qth2
+    live_path_mode mode;
+    qth_t qth;          //location only
+    qth_t qth2;
+} live_path_snapshot;
+
+/*
+ * LOS of the candidate pairs (a < b) in compressed rows by a. expiry is in
+ * seconds after base, the state is one bit per pair. The rows are rebuilt
+ * from the candidates of every snapshot, so pairs that drift apart drop out.
+ */
+typedef struct {
+    guint n;
+    gint *catnr;
+    gdouble base;
+    gdouble last;
+    guint *row;         //n + 1 offsets, NULL while no pair is cached
+    guint *col;         //b of each pair, ascending within a row
+    gfloat *expiry;
+    guint8 *clear;
+} los_cache;
+
+struct live_path {
+    GThread *thread;
+    GMutex lock;
+    GCond cond;
+    gboolean quit;
+    live_path_snapshot *pending;    //newest snapshot the worker has not taken yet
+    live_path_result *finished;     //newest result not handed to the main loop yet
+    guint idle_id;
+
+    //main thread only
+    live_path_result *shown;
+    gdouble submitted;
+    live_path_mode mode;
+    live_path_ready_cb ready;
+    gpointer user_data;
+
+    //worker only
+    los_cache cache;
+};
+
+static void snapshot_free(live_path_snapshot *snap)
+{
+    if (!snap)
+        return;
+    g_array_free(snap->nodes, TRUE);
+    g_free(snap);
+}
+
+static void result_free(live_path_result *result)
+{
+    if (!result)
+        return;
+    g_array_free(result->path, TRUE);
+    g_array_free(result->direct, TRUE);
+    g_free(result);
+}
+
+static void los_cache_clear(los_cache *cache)
+{
+    g_free(cache->catnr);
+    g_free(cache->row);
+    g_free(cache->col);
+    g_free(cache->expiry);
+    g_free(cache->clear);
+    memset(cache, 0, sizeof(los_cache));
+}
+
+static void los_cache_reset(los_cache *cache, GArray *nodes, gdouble time)
+{
+    guint n = nodes->len;
+
+    los_cache_clear(cache);
+    cache->n = n;
+    cache->base = time;
+    cache->last = time;
+    cache->catnr = g_new(gint, n > 0 ? n : 1);
+    for (guint i = 0; i < n; i++)
+        cache->catnr[i] = g_array_index(nodes, live_path_node, i).catnr;
+}
+
+/* Keeps the pair states unless the satellites changed or time went backwards */
+static void los_cache_prepare(los_cache *cache, GArray *nodes, gdouble time)
+{
+    gboolean same = (cache->catnr != NULL && cache->n == nodes->len &&
+                     time >= cache->last &&
+                     (time - cache->base) * 86400.0 < LOS_REBASE);
+
+    for (guint i = 0; same && i < nodes->len; i++)
+        same = (cache->catnr[i] == g_array_index(nodes, live_path_node, i).catnr);
+
+    if (same)
+        cache->last = time;
+    else
+        los_cache_reset(cache, nodes, time);
+}
+
+static int edge_cmp(const void *a, const void *b)
+{
+    const SatCsrEdge *ea = a;
+    const SatCsrEdge *eb = b;
+
+    if (ea->a != eb->a)
+        return ea->a < eb->a ? -1 : 1;
+    return (ea->b > eb->b) - (ea->b < eb->b);
+}
+
+/*
+ * The distance between the segment and the centre of the Earth moves no faster
+ * than the faster endpoint, so the LOS state cannot flip before that endpoint
+ * has covered the gap between the segment and the clearance sphere.
+ */
+static gdouble los_horizon(live_path_node *a, live_path_node *b)
+{
+    vector_t d;
+    gdouble dd, t, cx, cy, cz, gap, speed;
+
+    d.x = b->pos.x - a->pos.x;
+    d.y = b->pos.y - a->pos.y;
+    d.z = b->pos.z - a->pos.z;
+    dd = d.x * d.x + d.y * d.y + d.z * d.z;
+    t = 0.0;
+    if (dd > 0.0) {
+        t = -(a->pos.x * d.x + a->pos.y * d.y + a->pos.z * d.z) / dd;
+        t = CLAMP(t, 0.0, 1.0);
+    }
+    cx = a->pos.x + t * d.x;
+    cy = a->pos.y + t * d.y;
+    cz = a->pos.z + t * d.z;
+    gap = fabs(sqrt(cx * cx + cy * cy + cz * cz) - LOS_CLEARANCE);
+
+    speed = MAX(a->speed, b->speed);
+    if (speed <= 0.0)
+        return LOS_HORIZON_MAX;
+    return MIN(LOS_HORIZON_SAFETY * gap / speed, LOS_HORIZON_MAX);
+}
+
+/*
+ * Candidate pairs with clear LOS at now as edges weighted by their length.
+ * A pair cached for the last snapshot keeps its state until it expires, the
+ * others are tested and counted in checks, and the cache is replaced by the
+ * current candidates.
+ */
+static GArray* los_cache_edges(los_cache *cache, GArray *nodes, gdouble now, guint *checks)
+{
+    guint n = nodes->len;
+    los_positions *pos = los_positions_new(n);
+    GArray *edges;
+    SatCsrEdge *edge;
+    guint *row, *col;
+    gfloat *expiry;
+    guint8 *clear;
+    guint kept = 0, a = G_MAXUINT, o = 0;
+
+    for (guint i = 0; i < n; i++) {
+        live_path_node *node = &g_array_index(nodes, live_path_node, i);
+        pos->x[i] = node->pos.x;
+        pos->y[i] = node->pos.y;
+        pos->z[i] = node->pos.z;
+    }
+    edges = los_candidate_pairs(pos, 0.0);
+    los_positions_free(pos);
+
+    // row by row, so the cached pairs are looked up in one forward walk
+    edge = (SatCsrEdge *)edges->data;
+    qsort(edge, edges->len, sizeof(SatCsrEdge), edge_cmp);
+
+    row = g_new0(guint, n + 1);
+    col = g_new(guint, edges->len > 0 ? edges->len : 1);
+    expiry = g_new(gfloat, edges->len > 0 ? edges->len : 1);
+    clear = g_new0(guint8, edges->len / 8 + 1);
+
+    for (guint k = 0; k < edges->len; k++) {
+        SatCsrEdge e = edge[k];
+        gboolean cached = FALSE;
+        gboolean is_clear;
+
+        if (cache->row) {
+            if (e.a != a) {
+                a = e.a;
+                o = cache->row[a];
+            }
+            while (o < cache->row[a + 1] && cache->col[o] < e.b)
+                o++;
+            cached = (o < cache->row[a + 1] && cache->col[o] == e.b && now < cache->expiry[o]);
+        }
+
+        if (cached) {
+            is_clear = (cache->clear[o >> 3] >> (o & 7)) & 1;
+            expiry[k] = cache->expiry[o];
+        } else {
+            live_path_node *na = &g_array_index(nodes, live_path_node, e.a);
+            live_path_node *nb = &g_array_index(nodes, live_path_node, e.b);
+            is_clear = is_pos_los_clear(&na->pos, &nb->pos);
+            expiry[k] = (gfloat)(now + los_horizon(na, nb));
+            (*checks)++;
+        }
+
+        row[e.a + 1]++;
+        col[k] = e.b;
+        if (is_clear) {
+            clear[k >> 3] |= (guint8)(1 << (k & 7));
+            edge[kept++] = e;
+        }
+    }
+    for (guint i = 0; i < n; i++)
+        row[i + 1] += row[i];
+    g_array_set_size(edges, kept);
+
+    g_free(cache->row);
+    g_free(cache->col);
+    g_free(cache->expiry);
+    g_free(cache->clear);
+    cache->row = row;
+    cache->col = col;
+    cache->expiry = expiry;
+    cache->clear = clear;
+
+    return edges;
+}
+
+static gdouble node_distance(live_path_node *a, live_path_node *b)
+{
+    return dist_calc_driver(a->pos.x, a->pos.y, a->pos.z,
+                            b->pos.x, b->pos.y, b->pos.z);
+}
+
+/* Dijkstra over the clear LOS edges, weighted by the current distance */
+static void find_path(los_cache *cache, live_path_snapshot *snap, live_path_result *result)
+{
+    gdouble now = (snap->time - cache->base) * 86400.0;
+    GArray *edges = los_cache_edges(cache, snap->nodes, now, &result->los_checks);
+    SatCsr *csr = sat_csr_new(snap->nodes->len, (SatCsrEdge *)edges->data, edges->len);
+    GArray *ids = g_array_new(FALSE, FALSE, sizeof(guint));
+
+    if (sat_csr_dijkstra(csr, snap->src, snap->dst, ids)) {
+        for (guint k = 0; k < ids->len; k++)
+            g_array_append_val(result->path, g_array_index(snap->nodes, live_path_node,
+                                                           g_array_index(ids, guint, k)));
+    }
+
+    g_array_free(ids, TRUE);
+    g_array_free(edges, TRUE);
+    sat_csr_free(csr);
+}
+
+/* Longer links carry less, so a link is ranked by the inverse of its length */
+static inline gdouble length_weight(gdouble length)
+{
+    return length > 0.0 ? 1.0 / length : G_MAXDOUBLE;
+}
+
+/**
+ * Widest path from qth to qth2 over nodes at time. Every satellite pair with
+ * clear LOS is a link with the rate of lw_inter_sat_link_length(), the first
+ * and last hops carry the clear sky up and downlink SKR. path gets the
+ * satellites of the route from the qth side and skr its weakest link in kB/day.
+ *
+ * The inter satellite rate only depends on the link length and never grows
+ * with it, so the search ranks links by length and the rate is only evaluated
+ * along the route found. Ground links enter the search as the length of an
+ * inter satellite link with the same rate.
+ *
+ * Returns FALSE when no link chain with a positive rate joins the stations.
+ */
+gboolean live_path_widest(GArray *nodes, qth_t *qth, qth_t *qth2, gdouble time,
+                          GArray *path, gdouble *skr)
+{
+    guint n = nodes->len;
+    los_positions *pos = los_positions_new(n);
+    gdouble *up = g_new(gdouble, n > 0 ? n : 1);
+    gdouble *down = g_new(gdouble, n > 0 ? n : 1);
+    gdouble reach = inter_sat_link_reach(G_MINDOUBLE);
+    GArray *edges, *ids;
+    SatCsr *csr;
+    gboolean found;
+
+    g_array_set_size(path, 0);
+    *skr = 0.0;
+
+    for (guint i = 0; i < n; i++) {
+        live_path_node *node = &g_array_index(nodes, live_path_node, i);
+        pos->x[i] = node->pos.x;
+        pos->y[i] = node->pos.y;
+        pos->z[i] = node->pos.z;
+    }
+
+    // links longer than the reach could never carry a key
+    edges = los_clear_pairs(pos, reach);
+    for (guint k = 0; k < edges->len; k++) {
+        SatCsrEdge *edge = &g_array_index(edges, SatCsrEdge, k);
+        edge->weight = length_weight(edge->weight);
+    }
+    los_positions_free(pos);
+
+    // the stations are vertices n and n + 1
+    for (guint i = 0; i < n; i++) {
+        live_path_node *node = &g_array_index(nodes, live_path_node, i);
+        lw_sat_t sat = {node->pos, node->vel, time};
+        gdouble el, range;
+        SatCsrEdge edge;
+
+        edge.b = i;
+        calc_topocentric_el_range(&sat, qth, &el, &range);
+        up[i] = lw_ground_to_sat_uplink(qth, el, range, SKR_DEFAULT_VISIBILITY, SKR_DEFAULT_CN2);
+        if (up[i] > 0.0) {
+            edge.a = n;
+            edge.weight = length_weight(inter_sat_link_reach(up[i]));
+            g_array_append_val(edges, edge);
+        }
+
+        calc_topocentric_el_range(&sat, qth2, &el, &range);
+        down[i] = lw_sat_to_ground_downlink(qth2, el, range, SKR_DEFAULT_VISIBILITY, SKR_DEFAULT_CN2);
+        if (down[i] > 0.0) {
+            edge.a = n + 1;
+            edge.weight = length_weight(inter_sat_link_reach(down[i]));
+            g_array_append_val(edges, edge);
+        }
+    }
+
+    csr = sat_csr_new(n + 2, (SatCsrEdge *)edges->data, edges->len);
+    ids = g_array_new(FALSE, FALSE, sizeof(guint));
+    found = sat_csr_widest(csr, n, n + 1, ids, NULL);
+    if (found) {
+        guint first = g_array_index(ids, guint, 1);
+        guint last = g_array_index(ids, guint, ids->len - 2);
+
+        *skr = MIN(up[first], down[last]);
+        for (guint k = 1; k + 1 < ids->len; k++) {
+            live_path_node *node = &g_array_index(nodes, live_path_node, g_array_index(ids, guint, k));
+            if (k > 1) {
+                live_path_node *prev = &g_array_index(path, live_path_node, path->len - 1);
+                *skr = MIN(*skr, lw_inter_sat_link_length(node_distance(prev, node)));
+            }
+            g_array_append_val(path, *node);
+        }
+    }
+
+    g_array_free(ids, TRUE);
+    g_array_free(edges, TRUE);
+    sat_csr_free(csr);
+    g_free(up);
+    g_free(down);
+    return found;
+}
+
+static live_path_result *compute_paths(los_cache *cache, live_path_snapshot *snap)
+{
+    live_path_result *result = g_new0(live_path_result, 1);
+
+    result->time = snap->time;
+    result->mode = snap->mode;
+    result->path = g_array_new(FALSE, FALSE, sizeof(live_path_node));
+    result->direct = g_array_new(FALSE, FALSE, sizeof(live_path_node));
+    if (snap->src < 0 || snap->dst < 0)
+        return result;
+
+    if (snap->mode == LIVE_PATH_WIDEST) {
+        live_path_widest(snap->nodes, &snap->qth, &snap->qth2, snap->time,
+                         result->path, &result->skr);
+    } else {
+        los_cache_prepare(cache, snap->nodes, snap->time);
+        find_path(cache, snap, result);
+    }
+
+    // with every pair connected the direct hop is never longer than a detour
+    g_array_append_val(result->direct, g_array_index(snap->nodes, live_path_node, snap->src));
+    if (snap->dst != snap->src)
+        g_array_append_val(result->direct, g_array_index(snap->nodes, live_path_node, snap->dst));
+
+    return result;
+}
+
+static gboolean dispatch_result(gpointer data)
+{
+    live_path *lp = data;
+    live_path_result *result;
+
+    g_mutex_lock(&lp->lock);
+    result = lp->finished;
+    lp->finished = NULL;
+    lp->idle_id = 0;
+    g_mutex_unlock(&lp->lock);
+
+    if (result) {
+        result_free(lp->shown);
+        lp->shown = result;
+        if (lp->ready)
+            lp->ready(lp, lp->user_data);
+    }
+
+    return FALSE;
+}
+
+static gpointer live_path_worker(gpointer data)
+{
+    live_path *lp = data;
+
+    g_mutex_lock(&lp->lock);
+    while (TRUE) {
+        while (!lp->quit && !lp->pending)
+            g_cond_wait(&lp->cond, &lp->lock);
+        if (lp->quit)
+            break;
+
+        live_path_snapshot *snap = lp->pending;
+        lp->pending = NULL;
+        g_mutex_unlock(&lp->lock);
+
+        live_path_result *result = compute_paths(&lp->cache, snap);
+        snapshot_free(snap);
+
+        g_mutex_lock(&lp->lock);
+        result_free(lp->finished);
+        lp->finished = result;
+        if (lp->idle_id == 0)
+            lp->idle_id = g_idle_add(dispatch_result, lp);
+    }
+    g_mutex_unlock(&lp->lock);
+
+    return NULL;
+}
+
+live_path *live_path_new(live_path_ready_cb ready, gpointer user_data)
+{
+    live_path *lp = g_new0(live_path, 1);
+
+    g_mutex_init(&lp->lock);
+    g_cond_init(&lp->cond);
+    lp->ready = ready;
+    lp->user_data = user_data;
+    lp->submitted = -DBL_MAX;
+    lp->thread = g_thread_new("live-path", live_path_worker, lp);
+
+    return lp;
+}
+
+/**
+ * Queue the satellites at time for the worker. Only the O(n) work of copying
+ * the satellites and finding the ones closest to each station is done here,
+ * a snapshot still waiting for the worker is replaced.
+ */
+void live_path_update(live_path *lp, GHashTable *sats, qth_t *qth, qth_t *qth2, gdouble time)
+{
+    live_path_snapshot *snap;
+    GHashTableIter iter;
+    gpointer key, value;
+    gdouble min_dist1 = DBL_MAX;
+    gdouble min_dist2 = DBL_MAX;
+
+    if (!lp || !sats || !qth || !qth2 || time == lp->submitted)
+        return;
+    lp->submitted = time;
+
+    snap = g_new0(live_path_snapshot, 1);
+    snap->time = time;
+    snap->nodes = g_array_sized_new(FALSE, FALSE, sizeof(live_path_node), g_hash_table_size(sats));
+    snap->src = -1;
+    snap->dst = -1;
+    snap->mode = lp->mode;
+    snap->qth.lat = qth->lat;
+    snap->qth.lon = qth->lon;
+    snap->qth.alt = qth->alt;
+    snap->qth2.lat = qth2->lat;
+    snap->qth2.lon = qth2->lon;
+    snap->qth2.alt = qth2->alt;
+
+    g_hash_table_iter_init(&iter, sats);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        sat_t *sat = value;
+        live_path_node node;
+
+        if (decayed(sat))
+            continue;
+
+        node.catnr = sat->tle.catnr;
+        node.pos = sat->pos;
+        node.vel = sat->vel;
+        node.speed = sqrt(sat->vel.x * sat->vel.x + sat->vel.y * sat->vel.y + sat->vel.z * sat->vel.z);
+        node.ssplat = sat->ssplat;
+        node.ssplon = sat->ssplon;
+
+        gdouble dist1 = sat_qth_distance(sat, qth);
+        if (dist1 < min_dist1) {
+            min_dist1 = dist1;
+            snap->src = snap->nodes->len;
+        }
+        gdouble dist2 = sat_qth_distance(sat, qth2);
+        if (dist2 < min_dist2) {
+            min_dist2 = dist2;
+            snap->dst = snap->nodes->len;
+        }
+        g_array_append_val(snap->nodes, node);
+    }
+
+    g_mutex_lock(&lp->lock);
+    snapshot_free(lp->pending);
+    lp->pending = snap;
+    g_cond_signal(&lp->cond);
+    g_mutex_unlock(&lp->lock);
+}
+
+/** Takes effect from the next update, even at an unchanged time */
+void live_path_set_mode(live_path *lp, live_path_mode mode)
+{
+    if (!lp || lp->mode == mode)
+        return;
+    lp->mode = mode;
+    lp->submitted = -DBL_MAX;
+}
+
+/** Latest result handed to the main loop, NULL until the first one is ready */
+const live_path_result *live_path_last(live_path *lp)
+{
+    return lp ? lp->shown : NULL;
+}
+
+void live_path_free(live_path *lp)
+{
+    if (!lp)
+        return;
+
+    g_mutex_lock(&lp->lock);
+    lp->quit = TRUE;
+    g_cond_signal(&lp->cond);
+    g_mutex_unlock(&lp->lock);
+    g_thread_join(lp->thread);
+
+    if (lp->idle_id)
+        g_source_remove(lp->idle_id);
+    snapshot_free(lp->pending);
+    result_free(lp->finished);
+    result_free(lp->shown);
+    los_cache_clear(&lp->cache);
+    g_mutex_clear(&lp->lock);
+    g_cond_clear(&lp->cond);
+    g_free(lp);
+}
@@ -0,0 +1,64 @@
+#ifndef __LIVE_PATH_H__
+#define __LIVE_PATH_H__
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Satellite as seen by the path worker, copied from sat_t on the main thread */
+typedef struct {
+    gint catnr;
+    vector_t pos;       // ECI position in km
+    vector_t vel;       // ECI velocity in km/s
+    gdouble speed;      // km/s
+    gdouble ssplat;     // sub satellite point the node was seen at
+    gdouble ssplon;
+} live_path_node;
+
+/* What the path between the ground stations is chosen by */
+typedef enum {
+    LIVE_PATH_SHORTEST = 0,     // LOS path between the closest satellites, by distance
+    LIVE_PATH_WIDEST            // largest bottleneck SKR, up and downlinks included
+} live_path_mode;
+
+/* Paths between the satellites closest to each ground station at one time step */
+typedef struct {
+    gdouble time;       // julian date of the snapshot the paths were found on
+    GArray *path;       // live_path_node from the qth side, empty when no LOS path exists
+    GArray *direct;     // shortest path ignoring LOS
+    guint los_checks;   // satellite pairs whose LOS had to be recomputed
+    live_path_mode mode;
+    gdouble skr;        // smallest link SKR along path in kB/day, LIVE_PATH_WIDEST only
+} live_path_result;
+
+typedef struct live_path live_path;
+
+// Called from the main loop each time a newer result is ready
+typedef void (*live_path_ready_cb)(live_path *lp, gpointer user_data);
+
+live_path *live_path_new(live_path_ready_cb ready, gpointer user_data);
+
+void live_path_update(live_path *lp, GHashTable *sats, qth_t *qth, qth_t *qth2, gdouble time);
+
+void live_path_set_mode(live_path *lp, live_path_mode mode);
+
+const live_path_result *live_path_last(live_path *lp);
+
+void live_path_free(live_path *lp);
+
+gboolean live_path_widest(GArray *nodes, qth_t *qth, qth_t *qth2, gdouble time,
+                          GArray *path, gdouble *skr);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
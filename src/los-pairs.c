@@ -0,0 +1,217 @@
+/*
+ * Candidate inter satellite links without testing every pair.
+ *
+ * Two satellites can only see each other if they are closer than the sum of
+ * their distances to the horizon of the clearance sphere, so satellites are
+ * binned into a uniform grid over ECI positions with cells as wide as the
+ * largest such distance (or the range limit if smaller). Only pairs in
+ * neighbouring cells are considered, and the Earth occlusion test then runs
+ * over the surviving pairs in one pass over the position arrays.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calc-dist-two-sat.h"
+#include "los-pairs.h"
+
+#define LOS_CLEARANCE (EARTH_RADIUS + 20)   //same sphere is_pos_los_clear tests against
+#define CELL_MIN 1.0                        //km, keeps the packed cell coordinates in range
+#define CELL_OFFSET (1 << 20)
+#define CELL_BITS 21
+
+typedef struct {
+    guint64 key;
+    guint idx;
+} cell_entry;
+
+los_positions* los_positions_new(guint n)
+{
+    los_positions *pos = g_new0(los_positions, 1);
+
+    pos->n = n;
+    pos->x = g_new(gdouble, n > 0 ? n : 1);
+    pos->y = g_new(gdouble, n > 0 ? n : 1);
+    pos->z = g_new(gdouble, n > 0 ? n : 1);
+    return pos;
+}
+
+/* sats holds sat_t pointers, index i of the result is sats[i] */
+los_positions* los_positions_from_sats(GPtrArray *sats)
+{
+    los_positions *pos = los_positions_new(sats->len);
+
+    for (guint i = 0; i < sats->len; i++) {
+        sat_t *sat = g_ptr_array_index(sats, i);
+        pos->x[i] = sat->pos.x;
+        pos->y[i] = sat->pos.y;
+        pos->z[i] = sat->pos.z;
+    }
+    return pos;
+}
+
+void los_positions_free(los_positions *pos)
+{
+    if (!pos)
+        return;
+    g_free(pos->x);
+    g_free(pos->y);
+    g_free(pos->z);
+    g_free(pos);
+}
+
+static guint64 cell_key(gint64 ix, gint64 iy, gint64 iz)
+{
+    return ((guint64)(ix + CELL_OFFSET) << (2 * CELL_BITS)) |
+           ((guint64)(iy + CELL_OFFSET) << CELL_BITS) |
+           (guint64)(iz + CELL_OFFSET);
+}
+
+static int cell_entry_cmp(const void *a, const void *b)
+{
+    const cell_entry *ca = a, *cb = b;
+
+    if (ca->key != cb->key)
+        return ca->key < cb->key ? -1 : 1;
+    return (ca->idx > cb->idx) - (ca->idx < cb->idx);
+}
+
+// First entry with key, n if there is none
+static guint cell_find(const cell_entry *cells, guint n, guint64 key)
+{
+    guint lo = 0, hi = n;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (cells[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo < n && cells[lo].key == key) ? lo : n;
+}
+
+static void try_pair(const los_positions *pos, const gdouble *horizon, gdouble range2,
+                     guint i, guint j, GArray *pairs)
+{
+    gdouble dx = pos->x[j] - pos->x[i];
+    gdouble dy = pos->y[j] - pos->y[i];
+    gdouble dz = pos->z[j] - pos->z[i];
+    gdouble d2 = dx * dx + dy * dy + dz * dz;
+    gdouble reach = horizon[i] + horizon[j];
+
+    if (d2 > range2 || d2 > reach * reach)
+        return;
+
+    SatCsrEdge pair;
+    pair.a = MIN(i, j);
+    pair.b = MAX(i, j);
+    pair.weight = sqrt(d2);
+    g_array_append_val(pairs, pair);
+}
+
+GArray* los_candidate_pairs(const los_positions *pos, gdouble max_range)
+{
+    GArray *pairs = g_array_new(FALSE, FALSE, sizeof(SatCsrEdge));
+    gdouble *horizon, cell, range2, max_horizon = 0;
+    gint64 *coord;
+    cell_entry *cells;
+    guint n = pos->n;
+
+    if (n < 2)
+        return pairs;
+
+    horizon = g_new(gdouble, n);
+    for (guint i = 0; i < n; i++) {
+        gdouble r2 = pos->x[i] * pos->x[i] + pos->y[i] * pos->y[i] + pos->z[i] * pos->z[i];
+        horizon[i] = sqrt(MAX(r2 - LOS_CLEARANCE * LOS_CLEARANCE, 0.0));
+        max_horizon = MAX(max_horizon, horizon[i]);
+    }
+
+    cell = 2 * max_horizon;
+    if (max_range > 0)
+        cell = MIN(cell, max_range);
+    range2 = cell * cell;
+    cell = MAX(cell, CELL_MIN);
+
+    coord = g_new(gint64, 3 * n);
+    cells = g_new(cell_entry, n);
+    for (guint i = 0; i < n; i++) {
+        coord[3 * i] = (gint64)floor(pos->x[i] / cell);
+        coord[3 * i + 1] = (gint64)floor(pos->y[i] / cell);
+        coord[3 * i + 2] = (gint64)floor(pos->z[i] / cell);
+        cells[i].key = cell_key(coord[3 * i], coord[3 * i + 1], coord[3 * i + 2]);
+        cells[i].idx = i;
+    }
+    qsort(cells, n, sizeof(cell_entry), cell_entry_cmp);
+
+    // every occupied cell against itself and the 13 neighbours after it
+    for (guint start = 0; start < n; ) {
+        guint end = start;
+        guint first = cells[start].idx;
+        while (end < n && cells[end].key == cells[start].key)
+            end++;
+
+        for (guint s = start; s < end; s++)
+            for (guint t = s + 1; t < end; t++)
+                try_pair(pos, horizon, range2, cells[s].idx, cells[t].idx, pairs);
+
+        for (gint dx = 0; dx <= 1; dx++) {
+            for (gint dy = (dx == 0 ? 0 : -1); dy <= 1; dy++) {
+                for (gint dz = (dx == 0 && dy == 0 ? 1 : -1); dz <= 1; dz++) {
+                    guint64 key = cell_key(coord[3 * first] + dx,
+                                           coord[3 * first + 1] + dy,
+                                           coord[3 * first + 2] + dz);
+                    for (guint t = cell_find(cells, n, key); t < n && cells[t].key == key; t++)
+                        for (guint s = start; s < end; s++)
+                            try_pair(pos, horizon, range2, cells[s].idx, cells[t].idx, pairs);
+                }
+            }
+        }
+        start = end;
+    }
+
+    g_free(horizon);
+    g_free(coord);
+    g_free(cells);
+    return pairs;
+}
+
+void los_filter_clear(const los_positions *pos, GArray *pairs)
+{
+    const gdouble c2 = LOS_CLEARANCE * LOS_CLEARANCE;
+    SatCsrEdge *edge = (SatCsrEdge *)pairs->data;
+    guint8 *clear = g_new(guint8, pairs->len > 0 ? pairs->len : 1);
+    guint kept = 0;
+
+    // branch free so the loop vectorises, blocked when either intersection lies on the segment
+    for (guint k = 0; k < pairs->len; k++) {
+        guint a = edge[k].a, b = edge[k].b;
+        gdouble ax = pos->x[a], ay = pos->y[a], az = pos->z[a];
+        gdouble dx = pos->x[b] - ax, dy = pos->y[b] - ay, dz = pos->z[b] - az;
+        gdouble qa = dx * dx + dy * dy + dz * dz;
+        gdouble qb = 2 * (ax * dx + ay * dy + az * dz);
+        gdouble qc = (ax * ax + ay * ay + az * az) - c2;
+        gdouble disc = qb * qb - 4 * qa * qc;
+        gdouble root = sqrt(disc > 0 ? disc : 0);
+        gdouble t1 = (-qb - root) / (2 * qa);
+        gdouble t2 = (-qb + root) / (2 * qa);
+        gboolean hit = (t1 >= 0.0 && t1 <= 1.0) | (t2 >= 0.0 && t2 <= 1.0);
+        clear[k] = !(disc >= 0 && hit);
+    }
+
+    for (guint k = 0; k < pairs->len; k++) {
+        if (clear[k])
+            edge[kept++] = edge[k];
+    }
+    g_array_set_size(pairs, kept);
+    g_free(clear);
+}
+
+GArray* los_clear_pairs(const los_positions *pos, gdouble max_range)
+{
+    GArray *pairs = los_candidate_pairs(pos, max_range);
+
+    los_filter_clear(pos, pairs);
+    return pairs;
+}
@@ -0,0 +1,40 @@
+#ifndef __LOS_PAIRS_H__
+#define __LOS_PAIRS_H__
+
+#include <glib.h>
+#include "sat-graph.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Structure of arrays copy of satellite positions, for batch LOS tests */
+typedef struct {
+    guint n;
+    gdouble *x;         // ECI km
+    gdouble *y;
+    gdouble *z;
+} los_positions;
+
+los_positions* los_positions_new(guint n);
+los_positions* los_positions_from_sats(GPtrArray *sats);
+void los_positions_free(los_positions *pos);
+
+// Pairs close enough to possibly see each other, weight is their distance in km
+GArray* los_candidate_pairs(const los_positions *pos, gdouble max_range);
+
+// Drops the pairs whose segment passes through the Earth, same test as is_pos_los_clear
+void los_filter_clear(const los_positions *pos, GArray *pairs);
+
+// SatCsrEdge of every pair with clear LOS, max_range <= 0 for no range limit
+GArray* los_clear_pairs(const los_positions *pos, gdouble max_range);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
@@ -0,0 +1,173 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fibre-backbone.h"
+#include "../skr-utils.h"
+
+static GHashTable *fibre_backbone_new(void);
+static void add_fibre_edge(GHashTable *backbone, qth_t *src, qth_t *dst, gdouble distance);
+static qth_t *find_station(GSList *ground_stations, const gchar *name);
+
+/**
+ * Connects every pair of ground stations closer than max_distance with a
+ * fibre along the great circle between them.
+ *
+ * @param ground_stations   GSList of qth_t
+ * @param max_distance      longest fibre in km, <= 0 for no limit
+ * @return {gchar *ogs name : GArray of fibre_edge_t}, free with fibre_backbone_free()
+ */
+GHashTable *fibre_backbone_from_distance(GSList *ground_stations, gdouble max_distance) {
+    GHashTable *backbone = fibre_backbone_new();
+
+    for (GSList *a = ground_stations; a != NULL; a = a->next) {
+        for (GSList *b = a->next; b != NULL; b = b->next) {
+            gdouble distance = ground_distance(a->data, b->data);
+
+            if (max_distance > 0 && distance > max_distance) continue;
+
+            add_fibre_edge(backbone, a->data, b->data, distance);
+            add_fibre_edge(backbone, b->data, a->data, distance);
+        }
+    }
+
+    return backbone;
+}
+
+/**
+ * Reads fibre links from an adjacency file. One link per line in the form
+ *
+ *      station_a;station_b[;length_km]
+ *
+ * where the names match qth names. Links without a length use the great
+ * circle distance between the stations. Empty lines and lines starting with
+ * # are ignored. Malformed lines, unknown stations, links from a station to
+ * itself, invalid lengths and links longer than max_distance are skipped.
+ *
+ * @param ground_stations   GSList of qth_t
+ * @param filename          path to the adjacency file
+ * @param max_distance      longest fibre in km, <= 0 for no limit
+ * @return {gchar *ogs name : GArray of fibre_edge_t}, NULL if file can't be read
+ */
+GHashTable *fibre_backbone_from_file(GSList *ground_stations, const gchar *filename, gdouble max_distance) {
+    gchar *contents = NULL;
+    GError *error = NULL;
+
+    if (!g_file_get_contents(filename, &contents, NULL, &error)) {
+        printf("could not read fibre adjacency file %s: %s\n", filename, error->message);
+        g_clear_error(&error);
+        return NULL;
+    }
+
+    GHashTable *backbone = fibre_backbone_new();
+    gchar **lines = g_strsplit(contents, "\n", -1);
+
+    for (guint l = 0; lines[l] != NULL; l++) {
+        gchar *line = g_strstrip(lines[l]);
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        gchar **fields = g_strsplit(line, ";", 3);
+        if (fields[0] == NULL || fields[1] == NULL) {
+            printf("fibre adjacency file %s line %u: expected station_a;station_b\n", filename, l + 1);
+            g_strfreev(fields);
+            continue;
+        }
+
+        qth_t *a = find_station(ground_stations, g_strstrip(fields[0]));
+        qth_t *b = find_station(ground_stations, g_strstrip(fields[1]));
+
+        if (a == NULL || b == NULL) {
+            printf("fibre adjacency file %s line %u: unknown station\n", filename, l + 1);
+            g_strfreev(fields);
+            continue;
+        }
+        if (a == b) {
+            printf("fibre adjacency file %s line %u: link from a station to itself\n", filename, l + 1);
+            g_strfreev(fields);
+            continue;
+        }
+
+        gdouble distance;
+        if (fields[2] != NULL) {
+            gchar *length = g_strstrip(fields[2]);
+            gchar *end = NULL;
+
+            distance = g_ascii_strtod(length, &end);
+            if (end == length || *end != '\0' || !(distance > 0) || isinf(distance)) {
+                printf("fibre adjacency file %s line %u: invalid length %s\n", filename, l + 1, length);
+                g_strfreev(fields);
+                continue;
+            }
+        } else {
+            distance = ground_distance(a, b);
+        }
+
+        if (distance > 0 && (max_distance <= 0 || distance <= max_distance)) {
+            add_fibre_edge(backbone, a, b, distance);
+            add_fibre_edge(backbone, b, a, distance);
+        }
+
+        g_strfreev(fields);
+    }
+
+    g_strfreev(lines);
+    g_free(contents);
+
+    return backbone;
+}
+
+/**
+ * Constant skr of the fibre between two ground station nodes,
+ * 0 if they are not connected.
+ */
+gdouble fibre_edge_rate(tdsp_node *src, tdsp_node *dst) {
+    GArray *edges = src->node.fibre;
+    if (edges == NULL) return 0;
+
+    for (guint i = 0; i < edges->len; i++) {
+        fibre_edge_t *edge = &g_array_index(edges, fibre_edge_t, i);
+        if (edge->dst == dst->node.obj) return edge->rate;
+    }
+
+    return 0;
+}
+
+void fibre_backbone_free(GHashTable *backbone) {
+    if (backbone == NULL) return;
+
+    g_hash_table_destroy(backbone);
+}
+
+static GHashTable *fibre_backbone_new(void) {
+    return g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_array_unref);
+}
+
+static void add_fibre_edge(GHashTable *backbone, qth_t *src, qth_t *dst, gdouble distance) {
+    GArray *edges = g_hash_table_lookup(backbone, src->name);
+
+    if (edges == NULL) {
+        edges = g_array_new(FALSE, FALSE, sizeof(fibre_edge_t));
+        g_hash_table_insert(backbone, src->name, edges);
+    }
+
+    //listed twice in adjacency file, keep the first one
+    for (guint i = 0; i < edges->len; i++) {
+        if (g_array_index(edges, fibre_edge_t, i).dst == dst) return;
+    }
+
+    fibre_edge_t edge = {
+        .dst = dst,
+        .distance = distance,
+        .rate = lw_fibre_link(distance)
+    };
+    g_array_append_val(edges, edge);
+}
+
+static qth_t *find_station(GSList *ground_stations, const gchar *name) {
+    for (GSList *elm = ground_stations; elm != NULL; elm = elm->next) {
+        if (strcmp(((qth_t *)elm->data)->name, name) == 0) return elm->data;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,28 @@
+#include <glib/gi18n.h>
+#include "path-util.h"
+#include "../qth-data.h"
+
+#ifndef FIBRE_BACKBONE_H
+#define FIBRE_BACKBONE_H
+
+#define FIBRE_DEFAULT_MAX_DISTANCE 100.0    //km, longer fibres are left out of the graph
+
+/**
+ * \brief Static fibre link from one ground station to another. Rate is
+ * constant over time and precomputed when the backbone is built.
+ */
+typedef struct {
+    qth_t *dst;
+    gdouble distance;       //fibre length in km
+    gdouble rate;           //skr in kilobytes per day, same units as satellite links
+} fibre_edge_t;
+
+GHashTable *fibre_backbone_from_distance(GSList *ground_stations, gdouble max_distance);
+
+GHashTable *fibre_backbone_from_file(GSList *ground_stations, const gchar *filename, gdouble max_distance);
+
+gdouble fibre_edge_rate(tdsp_node *src, tdsp_node *dst);
+
+void fibre_backbone_free(GHashTable *backbone);
+
+#endif
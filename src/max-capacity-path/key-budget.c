@@ -0,0 +1,478 @@
+#include <glib/gi18n.h>
+#include <stdio.h>
+#include <math.h>
+#include "key-budget.h"
+#include "fibre-backbone.h"
+#include "../qth-data.h"
+#include "../skr-utils.h"
+#include "../los-pairs.h"
+#include "../sat-log.h"
+
+#define KEY_BUDGET_CHUNK 64     //history indices sampled per worker task
+
+typedef struct {
+    guint a;
+    guint b;
+    gdouble rate;           //kilobytes per day
+} link_sample;
+
+//integration state kept next to each key_link_t
+typedef struct {
+    gint last_i;            //last history index with a non zero rate
+    gdouble last_rate;
+    gint filled;            //last index written to the cumulative series
+} link_state;
+
+//read only state shared by the sampling workers
+typedef struct {
+    tdsp_node *nodes;
+    lw_sat_t **hist;        //history of each node, NULL for ground stations
+    guint n_nodes;
+    guint n_sats;           //nodes before this index are satellites
+    KeyBudgetParams *params;
+    GArray **samples;       //GArray of link_sample per history index
+    guint len;
+} sample_shared;
+
+typedef struct {
+    guint first;
+    guint last;             //exclusive
+} sample_chunk;
+
+static void sample_links(gpointer data, gpointer user_data);
+static gdouble pair_rate(sample_shared *shared, guint a, guint b, guint i);
+static guint find_link(key_budget_t *budget, GArray *states, GHashTable *index, guint a, guint b);
+static void fill_series(key_link_t *link, link_state *state, gint upto);
+static void push_event(key_budget_t *budget, guint i, guint link, key_event_type type);
+
+/**
+ * Simulates the key each node accumulates over the history window.
+ *
+ * Runs in two passes. Rates of all node pairs (satellite-satellite,
+ * ground-satellite and fibre) are first sampled at every history index on a
+ * thread pool, keeping only the pairs with a non zero rate. The samples are
+ * then integrated in time order with the trapezoid rule, so the cost of the
+ * second pass only depends on the links that are up. Link up/down transitions
+ * are recorded as events.
+ *
+ * Key generated on a link is added to the pools of both of its nodes, after
+ * which each pool serves its consumption for the time step.
+ *
+ * @param sats              GSList of sat_t
+ * @param sat_history       output of generate_sat_pos_data()
+ * @param sat_hist_len      length of each history array
+ * @param ground_stations   GSList of qth_t
+ * @param params            time grid, consumption and link options
+ * @return simulated budget, free with key_budget_free()
+ */
+key_budget_t *run_key_budget(
+    GSList *sats,
+    GHashTable *sat_history,
+    guint sat_hist_len,
+    GSList *ground_stations,
+    KeyBudgetParams *params) {
+
+    guint n_nodes = g_slist_length(sats) + g_slist_length(ground_stations);
+    tdsp_node *nodes = calloc(n_nodes, sizeof(tdsp_node));
+    lw_sat_t **hist = calloc(n_nodes, sizeof(lw_sat_t *));
+
+    key_budget_t *budget = malloc(sizeof(key_budget_t));
+    budget->len = sat_hist_len;
+    budget->t_start = params->t_start;
+    budget->t_step = params->t_step;
+    budget->pools = g_array_sized_new(FALSE, TRUE, sizeof(key_pool_t), n_nodes);
+    budget->links = g_array_new(FALSE, TRUE, sizeof(key_link_t));
+    budget->events = g_array_new(FALSE, TRUE, sizeof(key_event_t));
+
+    //satellites first, then ground stations with negative ids as in the path search
+    guint n = 0;
+    for (GSList *elm = sats; elm != NULL; elm = elm->next, n++) {
+        sat_t *sat = (sat_t *)elm->data;
+
+        nodes[n].node.id = sat->tle.catnr;
+        nodes[n].node.type = path_SATELLITE;
+        nodes[n].node.obj = sat;
+        hist[n] = g_hash_table_lookup(sat_history, &sat->tle.catnr);
+    }
+
+    gint station_id = -1;
+    for (GSList *elm = ground_stations; elm != NULL; elm = elm->next, n++) {
+        qth_t *qth = (qth_t *)elm->data;
+
+        nodes[n].node.id = station_id--;
+        nodes[n].node.type = path_STATION;
+        nodes[n].node.obj = qth;
+        nodes[n].node.weather = (params->weather != NULL ? g_hash_table_lookup(params->weather, qth->name) : NULL);
+        nodes[n].node.fibre = (params->fibre != NULL ? g_hash_table_lookup(params->fibre, qth->name) : NULL);
+    }
+
+    for (guint p = 0; p < n_nodes; p++) {
+        key_pool_t pool = {
+            .id = nodes[p].node.id,
+            .type = nodes[p].node.type,
+            .obj = nodes[p].node.obj,
+            .series = calloc(MAX(sat_hist_len, 1), sizeof(gdouble))
+        };
+        g_array_append_val(budget->pools, pool);
+    }
+
+    // ================ pass 1: sample link rates ==============================================
+    sample_shared shared = {
+        .nodes = nodes,
+        .hist = hist,
+        .n_nodes = n_nodes,
+        .n_sats = g_slist_length(sats),
+        .params = params,
+        .samples = calloc(MAX(sat_hist_len, 1), sizeof(GArray *)),
+        .len = sat_hist_len
+    };
+
+    guint n_chunks = (sat_hist_len + KEY_BUDGET_CHUNK - 1) / KEY_BUDGET_CHUNK;
+    sample_chunk *chunks = calloc(MAX(n_chunks, 1), sizeof(sample_chunk));
+    gint threads = params->threads ? (gint)params->threads : (gint)g_get_num_processors();
+
+    GThreadPool *pool = g_thread_pool_new(sample_links, &shared, threads, TRUE, NULL);
+    for (guint c = 0; c < n_chunks; c++) {
+        chunks[c].first = c * KEY_BUDGET_CHUNK;
+        chunks[c].last = MIN(chunks[c].first + KEY_BUDGET_CHUNK, sat_hist_len);
+        g_thread_pool_push(pool, &chunks[c], NULL);
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    // ================ pass 2: integrate key over time ========================================
+    GArray *states = g_array_new(FALSE, TRUE, sizeof(link_state));
+    GHashTable *index = g_hash_table_new_full(g_int64_hash, g_int64_equal, free, NULL);
+    GArray *active = g_array_new(FALSE, FALSE, sizeof(guint));
+    GArray *next_active = g_array_new(FALSE, FALSE, sizeof(guint));
+    gdouble *generated = calloc(MAX(n_nodes, 1), sizeof(gdouble));
+    gdouble *level = calloc(MAX(n_nodes, 1), sizeof(gdouble));
+    gdouble dt = params->t_step;
+
+    for (guint i = 0; i < sat_hist_len; i++) {
+        memset(generated, 0, n_nodes * sizeof(gdouble));
+        g_array_set_size(next_active, 0);
+
+        GArray *samples = shared.samples[i];
+        for (guint s = 0; s < samples->len; s++) {
+            link_sample *sample = &g_array_index(samples, link_sample, s);
+            guint l = find_link(budget, states, index, sample->a, sample->b);
+            key_link_t *link = &g_array_index(budget->links, key_link_t, l);
+            link_state *state = &g_array_index(states, link_state, l);
+
+            gboolean was_up = (state->last_i == (gint)i - 1);
+            gdouble inc = 0;
+
+            //a link coming up ramps from zero at the previous index
+            if (i > 0) inc = 0.5 * ((was_up ? state->last_rate : 0) + sample->rate) * dt;
+            if (!was_up) push_event(budget, i, l, key_LINK_UP);
+
+            fill_series(link, state, (gint)i - 1);
+            link->total += inc;
+            link->up_time += dt;
+            fill_series(link, state, i);
+
+            generated[link->a] += inc;
+            generated[link->b] += inc;
+
+            state->last_i = i;
+            state->last_rate = sample->rate;
+            g_array_append_val(next_active, l);
+        }
+
+        //links up at the previous index but not at this one ramp down to zero
+        for (guint k = 0; k < active->len; k++) {
+            guint l = g_array_index(active, guint, k);
+            key_link_t *link = &g_array_index(budget->links, key_link_t, l);
+            link_state *state = &g_array_index(states, link_state, l);
+
+            if (state->last_i == (gint)i) continue;
+
+            gdouble inc = 0.5 * state->last_rate * dt;
+
+            fill_series(link, state, (gint)i - 1);
+            link->total += inc;
+            fill_series(link, state, i);
+
+            generated[link->a] += inc;
+            generated[link->b] += inc;
+
+            push_event(budget, i, l, key_LINK_DOWN);
+        }
+
+        GArray *swap = active;
+        active = next_active;
+        next_active = swap;
+
+        for (guint p = 0; p < n_nodes; p++) {
+            key_pool_t *kp = &g_array_index(budget->pools, key_pool_t, p);
+
+            kp->generated += generated[p];
+            level[p] += generated[p];
+
+            if (params->pool_capacity > 0 && level[p] > params->pool_capacity) {
+                kp->overflow += level[p] - params->pool_capacity;
+                level[p] = params->pool_capacity;
+            }
+
+            gdouble rate = (kp->type == path_STATION ? params->station_consumption : params->sat_consumption);
+            gdouble demand = (i > 0 ? rate * dt : 0);
+            gdouble served = MIN(level[p], demand);
+
+            level[p] -= served;
+            kp->consumed += served;
+            kp->deficit += demand - served;
+            kp->series[i] = level[p];
+        }
+
+        g_array_free(samples, TRUE);
+    }
+
+    for (guint l = 0; l < budget->links->len; l++) {
+        fill_series(&g_array_index(budget->links, key_link_t, l), &g_array_index(states, link_state, l), (gint)sat_hist_len - 1);
+    }
+
+    sat_log_log(SAT_LOG_LEVEL_DEBUG, _("%s: %u nodes, %u links, %u events over %f days"),
+        __func__, n_nodes, budget->links->len, budget->events->len, (MAX(sat_hist_len, 1) - 1) * dt);
+
+    g_array_free(states, TRUE);
+    g_array_free(active, TRUE);
+    g_array_free(next_active, TRUE);
+    g_hash_table_destroy(index);
+    free(generated);
+    free(level);
+    free(shared.samples);
+    free(chunks);
+    free(nodes);
+    free(hist);
+
+    return budget;
+}
+
+const gchar *key_pool_name(key_pool_t *pool) {
+    if (pool->type == path_STATION) return ((qth_t *)pool->obj)->name;
+
+    return ((sat_t *)pool->obj)->nickname != NULL ? ((sat_t *)pool->obj)->nickname : ((sat_t *)pool->obj)->name;
+}
+
+/**
+ * Writes pool level of every node at each history index as csv,
+ * one row per time step.
+ */
+gboolean key_budget_save_series(key_budget_t *budget, const gchar *filename) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR, _("%s: could not open %s for writing"),
+            __func__, filename);
+        return FALSE;
+    }
+
+    fprintf(file, "time");
+    for (guint p = 0; p < budget->pools->len; p++) {
+        fprintf(file, ",%s", key_pool_name(&g_array_index(budget->pools, key_pool_t, p)));
+    }
+    fprintf(file, "\n");
+
+    for (guint i = 0; i < budget->len; i++) {
+        fprintf(file, "%.8f", budget->t_start + i * budget->t_step);
+        for (guint p = 0; p < budget->pools->len; p++) {
+            fprintf(file, ",%.6e", g_array_index(budget->pools, key_pool_t, p).series[i]);
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    return TRUE;
+}
+
+/**
+ * Writes per node and per link totals over the window as csv,
+ * all amounts in kilobytes.
+ */
+gboolean key_budget_save_totals(key_budget_t *budget, const gchar *filename) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR, _("%s: could not open %s for writing"),
+            __func__, filename);
+        return FALSE;
+    }
+
+    fprintf(file, "node,generated,consumed,deficit,overflow,final\n");
+    for (guint p = 0; p < budget->pools->len; p++) {
+        key_pool_t *kp = &g_array_index(budget->pools, key_pool_t, p);
+
+        fprintf(file, "%s,%.6e,%.6e,%.6e,%.6e,%.6e\n", key_pool_name(kp),
+            kp->generated, kp->consumed, kp->deficit, kp->overflow,
+            budget->len > 0 ? kp->series[budget->len - 1] : 0);
+    }
+
+    fprintf(file, "\nnode_a,node_b,total,up_time_days\n");
+    for (guint l = 0; l < budget->links->len; l++) {
+        key_link_t *link = &g_array_index(budget->links, key_link_t, l);
+
+        fprintf(file, "%s,%s,%.6e,%.6f\n",
+            key_pool_name(&g_array_index(budget->pools, key_pool_t, link->a)),
+            key_pool_name(&g_array_index(budget->pools, key_pool_t, link->b)),
+            link->total, link->up_time);
+    }
+
+    fclose(file);
+    return TRUE;
+}
+
+void key_budget_free(key_budget_t *budget) {
+    if (budget == NULL) return;
+
+    for (guint p = 0; p < budget->pools->len; p++) {
+        free(g_array_index(budget->pools, key_pool_t, p).series);
+    }
+    for (guint l = 0; l < budget->links->len; l++) {
+        free(g_array_index(budget->links, key_link_t, l).series);
+    }
+
+    g_array_free(budget->pools, TRUE);
+    g_array_free(budget->links, TRUE);
+    g_array_free(budget->events, TRUE);
+    free(budget);
+}
+
+static int link_sample_cmp(const void *x, const void *y) {
+    const link_sample *sx = x, *sy = y;
+
+    if (sx->a != sy->a) return sx->a < sy->a ? -1 : 1;
+    return (sx->b > sy->b) - (sx->b < sy->b);
+}
+
+/**
+ * Satellite pairs only get their rate computed if the los-pairs grid finds
+ * them within range and above each other's horizon, pairs with a ground
+ * station are all sampled. Samples are sorted by node pair so links are
+ * created in the same order as a plain pair loop would.
+ */
+static void sample_links(gpointer data, gpointer user_data) {
+    sample_chunk *chunk = (sample_chunk *)data;
+    sample_shared *shared = (sample_shared *)user_data;
+
+    //satellites with a history, positions are refilled for every index
+    guint *sat_node = malloc(MAX(shared->n_sats, 1) * sizeof(guint));
+    guint n_live = 0;
+    for (guint a = 0; a < shared->n_sats; a++) {
+        if (shared->hist[a] != NULL) sat_node[n_live++] = a;
+    }
+    los_positions *pos = los_positions_new(n_live);
+
+    for (guint i = chunk->first; i < chunk->last; i++) {
+        GArray *samples = g_array_new(FALSE, FALSE, sizeof(link_sample));
+
+        for (guint k = 0; k < n_live; k++) {
+            vector_t *p = &shared->hist[sat_node[k]][i].pos;
+            pos->x[k] = p->x;
+            pos->y[k] = p->y;
+            pos->z[k] = p->z;
+        }
+
+        GArray *candidates = los_candidate_pairs(pos, shared->params->max_isl_range);
+        for (guint c = 0; c < candidates->len; c++) {
+            SatCsrEdge *pair = &g_array_index(candidates, SatCsrEdge, c);
+            guint a = sat_node[pair->a];
+            guint b = sat_node[pair->b];
+            gdouble rate = pair_rate(shared, a, b, i);
+            if (rate <= 0) continue;
+
+            link_sample sample = {.a = a, .b = b, .rate = rate};
+            g_array_append_val(samples, sample);
+        }
+        g_array_free(candidates, TRUE);
+
+        for (guint a = 0; a < shared->n_nodes; a++) {
+            for (guint b = MAX(a + 1, shared->n_sats); b < shared->n_nodes; b++) {
+                gdouble rate = pair_rate(shared, a, b, i);
+                if (rate <= 0) continue;
+
+                link_sample sample = {.a = a, .b = b, .rate = rate};
+                g_array_append_val(samples, sample);
+            }
+        }
+
+        qsort(samples->data, samples->len, sizeof(link_sample), link_sample_cmp);
+        shared->samples[i] = samples;
+    }
+
+    los_positions_free(pos);
+    free(sat_node);
+}
+
+//rate between two nodes at history index i, key can flow either way on ground links
+static gdouble pair_rate(sample_shared *shared, guint a, guint b, guint i) {
+    tdsp_node *na = &shared->nodes[a];
+    tdsp_node *nb = &shared->nodes[b];
+    lw_sat_t *ha = shared->hist[a];
+    lw_sat_t *hb = shared->hist[b];
+
+    if (na->node.type == path_STATION && nb->node.type == path_STATION) {
+        return fibre_edge_rate(na, nb);
+    }
+
+    if (na->node.type == path_SATELLITE && ha == NULL) return 0;
+    if (nb->node.type == path_SATELLITE && hb == NULL) return 0;
+
+    if (na->node.type == path_SATELLITE && nb->node.type == path_SATELLITE) {
+        gdouble max_range = shared->params->max_isl_range;
+
+        if (max_range > 0) {
+            gdouble dx = ha[i].pos.x - hb[i].pos.x;
+            gdouble dy = ha[i].pos.y - hb[i].pos.y;
+            gdouble dz = ha[i].pos.z - hb[i].pos.z;
+
+            if (dx * dx + dy * dy + dz * dz > max_range * max_range) return 0;
+        }
+
+        return get_inter_node_skr(na, nb, ha, hb, i);
+    }
+
+    gdouble down = get_inter_node_skr(na, nb, ha, hb, i);
+    gdouble up = get_inter_node_skr(nb, na, hb, ha, i);
+
+    return MAX(up, down);
+}
+
+static guint find_link(key_budget_t *budget, GArray *states, GHashTable *index, guint a, guint b) {
+    gint64 key = ((gint64)a << 32) | b;
+    gpointer found = g_hash_table_lookup(index, &key);
+
+    //indices are stored + 1, NULL means not found
+    if (found != NULL) return GPOINTER_TO_UINT(found) - 1;
+
+    key_link_t link = {
+        .a = a,
+        .b = b,
+        .series = calloc(budget->len, sizeof(gdouble))
+    };
+    link_state state = {.last_i = -2, .last_rate = 0, .filled = -1};
+
+    g_array_append_val(budget->links, link);
+    g_array_append_val(states, state);
+
+    gint64 *stored = malloc(sizeof(gint64));
+    *stored = key;
+    g_hash_table_insert(index, stored, GUINT_TO_POINTER(budget->links->len));
+
+    return budget->links->len - 1;
+}
+
+//carries the current total forward up to index upto
+static void fill_series(key_link_t *link, link_state *state, gint upto) {
+    for (gint k = state->filled + 1; k <= upto; k++) {
+        link->series[k] = link->total;
+    }
+
+    if (upto > state->filled) state->filled = upto;
+}
+
+static void push_event(key_budget_t *budget, guint i, guint link, key_event_type type) {
+    key_event_t event = {
+        .time = budget->t_start + i * budget->t_step,
+        .link = link,
+        .type = type
+    };
+    g_array_append_val(budget->events, event);
+}
@@ -0,0 +1,81 @@
+#include <glib/gi18n.h>
+#include "path-util.h"
+
+#ifndef KEY_BUDGET_H
+#define KEY_BUDGET_H
+
+typedef struct {
+    gdouble t_start;            //julian date of history index 0
+    gdouble t_step;             //history time step in days
+    guint threads;              //workers sampling link rates, 0 uses number of processors
+    gdouble max_isl_range;      //km, satellite pairs further apart are skipped, <= 0 for no limit
+    gdouble station_consumption;    //kilobytes per day drawn from each ground station pool
+    gdouble sat_consumption;        //kilobytes per day drawn from each satellite pool
+    gdouble pool_capacity;      //kilobytes a pool can hold, <= 0 for no limit
+    GHashTable *weather;        //{gchar *ogs name : lw_weather_t *}, NULL for clear sky
+    GHashTable *fibre;          //{gchar *ogs name : GArray of fibre_edge_t}, NULL for no fibre links
+} KeyBudgetParams;
+
+typedef enum {
+    key_LINK_UP,
+    key_LINK_DOWN
+} key_event_type;
+
+/**
+ * \brief Link between two nodes that carried key at some point in the window.
+ * a and b index key_budget_t.pools
+ */
+typedef struct {
+    guint a;
+    guint b;
+    gdouble total;          //kilobytes of key generated over the window
+    gdouble up_time;        //days the link had a non zero rate
+    gdouble *series;        //cumulative kilobytes at each history index
+} key_link_t;
+
+/**
+ * \brief Key held by one node. Key from every link the node is part of is
+ * added to its pool, consumption is drawn from it at a constant rate.
+ */
+typedef struct {
+    gint id;                //catnr for satellites, negative ids for ground stations
+    path_type type;
+    void *obj;              //sat_t or qth_t
+    gdouble generated;      //kilobytes added by links
+    gdouble consumed;       //kilobytes drawn by consumption
+    gdouble deficit;        //consumption that could not be served
+    gdouble overflow;       //key discarded because the pool was full
+    gdouble *series;        //pool level in kilobytes at each history index
+} key_pool_t;
+
+typedef struct {
+    gdouble time;
+    guint link;             //index into key_budget_t.links
+    key_event_type type;
+} key_event_t;
+
+typedef struct {
+    guint len;              //samples in each series
+    gdouble t_start;
+    gdouble t_step;
+    GArray *pools;          //GArray of key_pool_t
+    GArray *links;          //GArray of key_link_t
+    GArray *events;         //GArray of key_event_t, in time order
+} key_budget_t;
+
+key_budget_t *run_key_budget(
+    GSList *sats,
+    GHashTable *sat_history,
+    guint sat_hist_len,
+    GSList *ground_stations,
+    KeyBudgetParams *params);
+
+const gchar *key_pool_name(key_pool_t *pool);
+
+gboolean key_budget_save_series(key_budget_t *budget, const gchar *filename);
+
+gboolean key_budget_save_totals(key_budget_t *budget, const gchar *filename);
+
+void key_budget_free(key_budget_t *budget);
+
+#endif
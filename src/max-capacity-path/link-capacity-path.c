@@ -7,7 +7,7 @@
 #include "transfer-time.h"
 
 gboolean catnr_equal(gconstpointer a, gconstpointer b);
-void tdsp_node_from_GSList(GArray *tdsp_array, gchar *src_name, gchar *dst_name, gint *src_i, gint *dst_i, GSList *list, path_type type);
+void tdsp_node_from_GSList(GArray *tdsp_array, gchar *src_name, gchar *dst_name, gint *src_i, gint *dst_i, GSList *list, path_type type, GHashTable *weather, GHashTable *fibre);
 GList *TDSP_fixed_size(
     GArray *const_tdsp_array,
     GHashTable *sat_history,
@@ -47,8 +47,8 @@ max_path_t *get_max_link_path(
    
     gint src_i = 0;
     gint dst_i = 0;
-    tdsp_node_from_GSList(nodes, params->src, params->dst, &src_i, &dst_i, sats, path_SATELLITE);
-    tdsp_node_from_GSList(nodes, params->src, params->dst, &src_i, &dst_i, ground_stations, path_STATION);
+    tdsp_node_from_GSList(nodes, params->src, params->dst, &src_i, &dst_i, sats, path_SATELLITE, NULL, NULL);
+    tdsp_node_from_GSList(nodes, params->src, params->dst, &src_i, &dst_i, ground_stations, path_STATION, params->weather, params->fibre);
     if (src_i == 0 ||dst_i == 0) return NULL;
 
     gdouble low = 0;
@@ -114,7 +114,9 @@ void tdsp_node_from_GSList(
     gint *src_i,
     gint *dst_i,
     GSList *list,
-    path_type type) {
+    path_type type,
+    GHashTable *weather,
+    GHashTable *fibre) {
 
     gint i = -1;
     for (GSList *current = list; current != NULL; current = current->next) {
@@ -131,7 +133,11 @@ void tdsp_node_from_GSList(
             .node.id = (type == path_STATION ? i : ((sat_t *)current->data)->tle.catnr),
             .node.time = G_MAXDOUBLE,
             .node.type = type,
-            .node.obj = current->data
+            .node.obj = current->data,
+            .node.weather = (type == path_STATION && weather != NULL ?
+                g_hash_table_lookup(weather, ((qth_t *)current->data)->name) : NULL),
+            .node.fibre = (type == path_STATION && fibre != NULL ?
+                g_hash_table_lookup(fibre, ((qth_t *)current->data)->name) : NULL)
         }; 
         g_array_append_val(tdsp_array, node);
         i--;
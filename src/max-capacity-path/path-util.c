@@ -40,4 +40,106 @@ lw_sat_t sat_at_time(sat_t *sat, gdouble time) {
     answer.jul_utc = sat->jul_utc;
 
     return answer;
-}
\ No newline at end of file
+}
+
+/**
+ * Allocates weather samples for len history time steps. Values are left
+ * uninitialized, caller fills vis and cn2.
+ */
+lw_weather_t *lw_weather_new(guint len) {
+    lw_weather_t *weather = malloc(sizeof(lw_weather_t));
+
+    weather->len = len;
+    weather->vis = malloc(len * sizeof(gdouble));
+    weather->cn2 = malloc(len * sizeof(gdouble));
+
+    return weather;
+}
+
+/**
+ * Frees lw_weather_t and its sample arrays. Signature matches GDestroyNotify
+ * so it can be used as value destructor of weather hash tables.
+ */
+void lw_weather_free(gpointer weather) {
+    lw_weather_t *w = (lw_weather_t *)weather;
+    if (w == NULL) return;
+
+    free(w->vis);
+    free(w->cn2);
+    free(w);
+}
+
+static void path_track_free(gpointer track) {
+    path_track_t *t = (path_track_t *)track;
+    if (t == NULL) return;
+
+    free(t->lat);
+    free(t->lon);
+    free(t);
+}
+
+/**
+ * Propagates a copy of the satellite once per minute between t_start and
+ * t_end, the last sample is taken exactly at t_end.
+ */
+static path_track_t *path_track_new(sat_t *sat, gdouble t_start, gdouble t_end) {
+    guint steps = (t_end > t_start) ? (guint)((t_end - t_start) * 1440) : 0;
+    path_track_t *track = malloc(sizeof(path_track_t));
+    sat_t dummy_s = *sat;
+    geodetic_t geodetic;
+
+    track->len = steps + 1;
+    track->lat = malloc(track->len * sizeof(gdouble));
+    track->lon = malloc(track->len * sizeof(gdouble));
+
+    for (guint i = 0; i < track->len; i++) {
+        gdouble t = (i == steps) ? t_end : t_start + i / 1440.0;
+
+        sat_at_time(&dummy_s, t);
+        Calculate_LatLonAlt(t, &dummy_s.pos, &geodetic);
+
+        while (geodetic.lon < -pi) geodetic.lon += twopi;
+        while (geodetic.lon > pi) geodetic.lon -= twopi;
+
+        track->lat[i] = Degrees(geodetic.lat);
+        track->lon[i] = Degrees(geodetic.lon);
+    }
+
+    return track;
+}
+
+/**
+ * Sub-satellite tracks of the path, index i belongs to the i-th path node.
+ * They are propagated on the first call and kept with the path, so redrawing
+ * the path on a map only reprojects them.
+ */
+GPtrArray *max_path_tracks(max_path_t *path) {
+    if (path == NULL) return NULL;
+    if (path->tracks != NULL) return path->tracks;
+
+    path->tracks = g_ptr_array_new_with_free_func(path_track_free);
+
+    for (GList *iter = path->path; iter != NULL; iter = iter->next) {
+        path_node *node = (path_node *)iter->data;
+        path_track_t *track = NULL;
+
+        if (node->type == path_SATELLITE) {
+            gdouble t_end = iter->next ? ((path_node *)iter->next->data)->time : node->time;
+            track = path_track_new((sat_t *)node->obj, node->time, t_end);
+        }
+        g_ptr_array_add(path->tracks, track);
+    }
+
+    return path->tracks;
+}
+
+/**
+ * Frees the path nodes, the cached tracks and the max_path_t itself
+ */
+void max_path_free(max_path_t *path) {
+    if (path == NULL) return;
+
+    g_list_free_full(path->path, free);
+    if (path->tracks != NULL) g_ptr_array_free(path->tracks, TRUE);
+    free(path);
+}
@@ -11,13 +11,26 @@ typedef struct {
     gdouble t_start;
     gdouble t_end;
     gdouble t_step;
+    GHashTable *weather;    //{gchar *ogs name : lw_weather_t *}, NULL for clear sky
+    GHashTable *fibre;      //{gchar *ogs name : GArray of fibre_edge_t}, NULL for no fibre links
 } MaxSearchParams;
 
 typedef struct {
     GList *path;            //GList of path_node
     gdouble size;
+    GPtrArray *tracks;      //path_track_t per path node (NULL for stations), filled by max_path_tracks()
 } max_path_t;
 
+/**
+ * \brief Sub-satellite points of a satellite path node, one per minute from
+ * its time until the next node's time, both ends included
+ */
+typedef struct {
+    guint len;
+    gdouble *lat;           //degrees north
+    gdouble *lon;           //degrees east, -180 to 180
+} path_track_t;
+
 typedef enum {
     path_STATION,
     path_SATELLITE
@@ -28,6 +41,8 @@ typedef struct path_node{
     gint id;                //for satellites id is catnr, for ground stations, assigned negative number ids
     path_type type;
     void *obj;              //points to original objects, for satellites sat_t, for gound stations qth_t
+    struct lw_weather_t *weather;   //for ground stations, atmosphere on history time grid (NULL = clear sky)
+    GArray *fibre;                  //for ground stations, fibre_edge_t to other stations (NULL = none)
 } path_node;
 
 typedef struct tdsp_node {
@@ -47,8 +62,26 @@ typedef struct {
     gdouble jul_utc;
 } lw_sat_t;
 
+/**
+ * \brief Atmospheric conditions at a ground station sampled on the same
+ * time grid as the satellite history, index i is start_time + (i * time_step)
+ */
+typedef struct lw_weather_t {
+    guint len;
+    gdouble *vis;           //visibility in km
+    gdouble *cn2;           //refractive index structure parameter
+} lw_weather_t;
+
 lw_sat_t sat_at_time(sat_t *sat, gdouble time);
 
+lw_weather_t *lw_weather_new(guint len);
+
+void lw_weather_free(gpointer weather);
+
 char *fmted_to_string(gchar *fmt, ...);
 
+GPtrArray *max_path_tracks(max_path_t *path);
+
+void max_path_free(max_path_t *path);
+
 #endif
\ No newline at end of file
@@ -2,6 +2,21 @@
 #include "path-util.h"
 #include "../qth-data.h"
 
+/**
+ * Positions of one satellite at len time steps from start_time. Propagates
+ * the given sat_t, callers pass a copy when the original is shared.
+ * @return lw_sat_t[len], free with free()
+ */
+lw_sat_t *propagate_sat_history(sat_t *sat, guint len, gdouble start_time, gdouble time_step) {
+    lw_sat_t *entries = malloc(MAX(len, 1) * sizeof(lw_sat_t));
+
+    for (guint i = 0; i < len; i++) {
+        entries[i] = sat_at_time(sat, start_time + (i * time_step));
+    }
+
+    return entries;
+}
+
 /**
  * Generates the GHashtable {gint catnr : lw_sat_t[] history} where the history
  * array holds the satellites positions through time. index i of array is
@@ -22,13 +37,7 @@ GHashTable *generate_sat_pos_data(GSList *sats_list, guint *sat_hist_len, gdoubl
         gint *cat_nr = malloc(sizeof(gint));
         *cat_nr = sat.tle.catnr;
 
-        lw_sat_t *entries = malloc(*sat_hist_len * sizeof(lw_sat_t));
-
-        for (guint i = 0; i < *sat_hist_len; i++) {
-            entries[i] = sat_at_time(&sat, start_time + (i * time_step));
-        }
-
-        g_hash_table_insert(data_fields, cat_nr, entries);
+        g_hash_table_insert(data_fields, cat_nr, propagate_sat_history(&sat, *sat_hist_len, start_time, time_step));
     }
 
     return data_fields;
@@ -1,8 +1,16 @@
 #include <glib/gi18n.h>
+#include "path-util.h"
+
+#ifndef SATELLITE_HISTORY_H
+#define SATELLITE_HISTORY_H
 
 GHashTable *generate_sat_pos_data(
     GSList *sats_list, 
     guint *sat_hist_len, 
     gdouble start_time, 
     gdouble end_time, 
-    gdouble time_step);
\ No newline at end of file
+    gdouble time_step);
+
+lw_sat_t *propagate_sat_history(sat_t *sat, guint len, gdouble start_time, gdouble time_step);
+
+#endif
@@ -0,0 +1,140 @@
+#include <glib/gi18n.h>
+#include <stdio.h>
+#include <math.h>
+#include "search-prep.h"
+#include "satellite-history.h"
+#include "../sat-log.h"
+
+typedef struct {
+    GSList *ground_stations;
+    gdouble t_start;
+    gdouble t_step;
+    guint len;
+    prep_weather_loader load;
+    gpointer user_data;
+    GHashTable *weather;
+    gdouble seconds;
+} weather_job;
+
+typedef struct {
+    sat_t *sat;
+    lw_sat_t *entries;
+} propagation_job;
+
+//read only state shared by the propagation workers
+typedef struct {
+    guint len;
+    gdouble t_start;
+    gdouble t_step;
+} propagation_shared;
+
+static gpointer load_weather_thread(gpointer data);
+static void propagate_sat(gpointer data, gpointer user_data);
+
+/**
+ * Prepares the satellite history and station weather of a search window as
+ * one pipelined stage.
+ *
+ * Weather is read and decoded on its own I/O thread while satellites are
+ * propagated on a thread pool, so the preparation takes about as long as the
+ * slower of the two instead of their sum. Both results are on the same
+ * history time grid and can be handed to get_max_link_path() or
+ * run_key_budget() together.
+ *
+ * @param sats              GSList of sat_t, not modified
+ * @param ground_stations   GSList of qth_t, passed to the weather loader
+ * @param params            time window, worker count and weather loader
+ * @return free with search_prep_free()
+ */
+search_prep_t *prepare_search(GSList *sats, GSList *ground_stations, PrepParams *params) {
+    GTimer *timer = g_timer_new();
+    search_prep_t *prep = calloc(1, sizeof(search_prep_t));
+    prep->sat_hist_len = (guint)ceil((params->t_end - params->t_start) / params->t_step);
+
+    //started first so reading overlaps all of the propagation
+    weather_job job = {
+        .ground_stations = ground_stations,
+        .t_start = params->t_start,
+        .t_step = params->t_step,
+        .len = prep->sat_hist_len,
+        .load = params->load_weather,
+        .user_data = params->loader_data,
+        .weather = NULL,
+        .seconds = 0
+    };
+    GThread *io_thread = (params->load_weather != NULL ?
+        g_thread_new("weather-prefetch", load_weather_thread, &job) : NULL);
+
+    propagation_shared shared = {
+        .len = prep->sat_hist_len,
+        .t_start = params->t_start,
+        .t_step = params->t_step
+    };
+
+    guint n_sats = g_slist_length(sats);
+    propagation_job *jobs = calloc(MAX(n_sats, 1), sizeof(propagation_job));
+    gint threads = params->threads ? (gint)params->threads : (gint)g_get_num_processors();
+
+    GThreadPool *pool = g_thread_pool_new(propagate_sat, &shared, threads, TRUE, NULL);
+    guint n = 0;
+    for (GSList *elm = sats; elm != NULL; elm = elm->next, n++) {
+        jobs[n].sat = (sat_t *)elm->data;
+        g_thread_pool_push(pool, &jobs[n], NULL);
+    }
+
+    //waits for all queued satellites to finish
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    //hash table isn't thread safe, filled once every worker is done
+    prep->sat_history = g_hash_table_new_full(g_int_hash, g_int_equal, free, free);
+    for (n = 0; n < n_sats; n++) {
+        gint *cat_nr = malloc(sizeof(gint));
+        *cat_nr = jobs[n].sat->tle.catnr;
+
+        g_hash_table_insert(prep->sat_history, cat_nr, jobs[n].entries);
+    }
+    free(jobs);
+    prep->propagation_time = g_timer_elapsed(timer, NULL);
+
+    if (io_thread != NULL) {
+        g_thread_join(io_thread);
+        prep->weather = job.weather;
+        prep->weather_time = job.seconds;
+    }
+    prep->total_time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    sat_log_log(SAT_LOG_LEVEL_DEBUG,
+        _("%s: %u satellites x %u steps: propagation %f s, weather %f s, total %f s"),
+        __func__, n_sats, prep->sat_hist_len, prep->propagation_time, prep->weather_time, prep->total_time);
+
+    return prep;
+}
+
+void search_prep_free(search_prep_t *prep) {
+    if (prep == NULL) return;
+
+    if (prep->sat_history != NULL) g_hash_table_destroy(prep->sat_history);
+    if (prep->weather != NULL) g_hash_table_destroy(prep->weather);
+    free(prep);
+}
+
+static gpointer load_weather_thread(gpointer data) {
+    weather_job *job = (weather_job *)data;
+    GTimer *timer = g_timer_new();
+
+    job->weather = job->load(job->user_data, job->ground_stations, job->t_start, job->t_step, job->len);
+
+    job->seconds = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+    return NULL;
+}
+
+static void propagate_sat(gpointer data, gpointer user_data) {
+    propagation_job *job = (propagation_job *)data;
+    propagation_shared *shared = (propagation_shared *)user_data;
+
+    //private copy, propagation writes into the sat_t
+    sat_t sat = *job->sat;
+    job->entries = propagate_sat_history(&sat, shared->len, shared->t_start, shared->t_step);
+}
@@ -0,0 +1,41 @@
+#include <glib/gi18n.h>
+#include "path-util.h"
+
+#ifndef SEARCH_PREP_H
+#define SEARCH_PREP_H
+
+/**
+ * \brief Loads station weather on the history time grid, runs on the I/O thread.
+ * @return {gchar *ogs name : lw_weather_t *} owning its values, or NULL for clear sky
+ */
+typedef GHashTable *(*prep_weather_loader)(
+    gpointer user_data,
+    GSList *ground_stations,
+    gdouble t_start,
+    gdouble t_step,
+    guint len);
+
+typedef struct {
+    gdouble t_start;            //julian date of history index 0
+    gdouble t_end;
+    gdouble t_step;             //days
+    guint threads;              //propagation workers, 0 uses number of processors
+    prep_weather_loader load_weather;   //NULL skips weather, clear sky
+    gpointer loader_data;
+} PrepParams;
+
+/** \brief Everything a search needs that only depends on the time window */
+typedef struct {
+    GHashTable *sat_history;    //{gint catnr : lw_sat_t[] history}, same as generate_sat_pos_data()
+    guint sat_hist_len;
+    GHashTable *weather;        //{gchar *ogs name : lw_weather_t *}, NULL for clear sky
+    gdouble propagation_time;   //wall clock seconds of each stage
+    gdouble weather_time;
+    gdouble total_time;
+} search_prep_t;
+
+search_prep_t *prepare_search(GSList *sats, GSList *ground_stations, PrepParams *params);
+
+void search_prep_free(search_prep_t *prep);
+
+#endif
@@ -0,0 +1,222 @@
+#include <glib/gi18n.h>
+#include <stdio.h>
+#include <math.h>
+#include "skr-ensemble.h"
+#include "link-capacity-path.h"
+#include "../qth-data.h"
+#include "../sat-log.h"
+#include "../skr-utils.h"
+
+typedef struct {
+    guint index;
+    gdouble capacity;
+} ensemble_member;
+
+//read only state shared by every member of the ensemble
+typedef struct {
+    GSList *sats;
+    GHashTable *sat_history;
+    guint sat_hist_len;
+    GSList *ground_stations;
+    MaxSearchParams *params;
+    EnsembleParams *ens_params;
+} ensemble_shared;
+
+static void run_member(gpointer data, gpointer user_data);
+static gdouble gaussian(GRand *rand);
+static gint compare_capacity(gconstpointer a, gconstpointer b);
+
+/**
+ * Runs the max capacity search for N sampled weather realizations and
+ * collects the distribution of capacity between params->src and params->dst.
+ *
+ * Members are distributed over a thread pool. Satellite history is computed
+ * once by the caller and shared read only between all members since only the
+ * atmospheric terms of the ground links change between realizations.
+ *
+ * @param sats              GSList of sat_t
+ * @param sat_history       output of generate_sat_pos_data()
+ * @param sat_hist_len      length of each history array
+ * @param ground_stations   GSList of qth_t
+ * @param params            search parameters, params->weather is ignored
+ * @param ens_params        ensemble size, sampling spread and seed
+ * @return ensemble result, free with skr_ensemble_free()
+ */
+skr_ensemble_t *run_skr_ensemble(
+    GSList *sats,
+    GHashTable *sat_history,
+    guint sat_hist_len,
+    GSList *ground_stations,
+    MaxSearchParams *params,
+    EnsembleParams *ens_params) {
+
+    if (ens_params->members == 0) return NULL;
+
+    ensemble_shared shared = {
+        .sats = sats,
+        .sat_history = sat_history,
+        .sat_hist_len = sat_hist_len,
+        .ground_stations = ground_stations,
+        .params = params,
+        .ens_params = ens_params
+    };
+
+    gint threads = ens_params->threads ? (gint)ens_params->threads : (gint)g_get_num_processors();
+    ensemble_member *members = calloc(ens_params->members, sizeof(ensemble_member));
+
+    GThreadPool *pool = g_thread_pool_new(run_member, &shared, threads, TRUE, NULL);
+    for (guint m = 0; m < ens_params->members; m++) {
+        members[m].index = m;
+        g_thread_pool_push(pool, &members[m], NULL);
+    }
+
+    //waits for all queued members to finish
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    skr_ensemble_t *ens = malloc(sizeof(skr_ensemble_t));
+    ens->members = ens_params->members;
+    ens->capacity = malloc(ens->members * sizeof(gdouble));
+    ens->mean = 0;
+
+    for (guint m = 0; m < ens->members; m++) {
+        ens->capacity[m] = members[m].capacity;
+        ens->mean += members[m].capacity / ens->members;
+    }
+    qsort(ens->capacity, ens->members, sizeof(gdouble), compare_capacity);
+
+    sat_log_log(SAT_LOG_LEVEL_DEBUG,
+        _("%s: %s -> %s (%u members): p5 %f, p50 %f, p95 %f, mean %f (kilobytes)"),
+        __func__, params->src, params->dst, ens->members,
+        skr_ensemble_percentile(ens, 5), skr_ensemble_percentile(ens, 50),
+        skr_ensemble_percentile(ens, 95), ens->mean);
+
+    free(members);
+    return ens;
+}
+
+/**
+ * Draws one weather realization for every ground station on the satellite
+ * history time grid. Each station hour gets a mean preserving log-normal
+ * factor applied to the base visibility and Cn2 (clear sky if the station
+ * has no base weather).
+ *
+ * @param time_step     history time step in days
+ * @param seed          same seed gives the same realization
+ * @return {gchar *ogs name : lw_weather_t *}, owns its values
+ */
+GHashTable *sample_ensemble_weather(
+    GSList *ground_stations,
+    GHashTable *base_weather,
+    guint sat_hist_len,
+    gdouble time_step,
+    gdouble vis_sigma,
+    gdouble cn2_sigma,
+    guint32 seed) {
+
+    GHashTable *weather = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, lw_weather_free);
+    GRand *rand = g_rand_new_with_seed(seed);
+
+    guint hours = (guint)ceil(sat_hist_len * time_step * 24.0) + 1;
+    gdouble *vis_factor = malloc(hours * sizeof(gdouble));
+    gdouble *cn2_factor = malloc(hours * sizeof(gdouble));
+
+    for (GSList *elm = ground_stations; elm != NULL; elm = elm->next) {
+        qth_t *ogs = (qth_t *)elm->data;
+        lw_weather_t *base = (base_weather != NULL ? g_hash_table_lookup(base_weather, ogs->name) : NULL);
+
+        for (guint h = 0; h < hours; h++) {
+            vis_factor[h] = exp(vis_sigma * gaussian(rand) - 0.5 * vis_sigma * vis_sigma);
+            cn2_factor[h] = exp(cn2_sigma * gaussian(rand) - 0.5 * cn2_sigma * cn2_sigma);
+        }
+
+        lw_weather_t *sample = lw_weather_new(sat_hist_len);
+        for (guint i = 0; i < sat_hist_len; i++) {
+            //tolerance keeps time steps given as rounded fractions of a day in their hour
+            guint h = (guint)floor(i * time_step * 24.0 + 1e-6);
+            gboolean has_base = (base != NULL && i < base->len);
+
+            sample->vis[i] = (has_base ? base->vis[i] : SKR_DEFAULT_VISIBILITY) * vis_factor[h];
+            sample->cn2[i] = (has_base ? base->cn2[i] : SKR_DEFAULT_CN2) * cn2_factor[h];
+        }
+
+        g_hash_table_insert(weather, ogs->name, sample);
+    }
+
+    free(vis_factor);
+    free(cn2_factor);
+    g_rand_free(rand);
+
+    return weather;
+}
+
+/**
+ * Capacity at percentile p (0 - 100) of the ensemble, linearly interpolated
+ * between closest ranks.
+ */
+gdouble skr_ensemble_percentile(skr_ensemble_t *ens, gdouble p) {
+    if (ens == NULL || ens->members == 0) return 0;
+    if (ens->members == 1) return ens->capacity[0];
+
+    gdouble pos = CLAMP(p, 0.0, 100.0) / 100.0 * (ens->members - 1);
+    guint low = (guint)floor(pos);
+    guint high = MIN(low + 1, ens->members - 1);
+
+    return ens->capacity[low] + (pos - low) * (ens->capacity[high] - ens->capacity[low]);
+}
+
+void skr_ensemble_free(skr_ensemble_t *ens) {
+    if (ens == NULL) return;
+
+    free(ens->capacity);
+    free(ens);
+}
+
+static void run_member(gpointer data, gpointer user_data) {
+    ensemble_member *member = (ensemble_member *)data;
+    ensemble_shared *shared = (ensemble_shared *)user_data;
+    EnsembleParams *ens_params = shared->ens_params;
+
+    GHashTable *weather = sample_ensemble_weather(
+        shared->ground_stations,
+        ens_params->base_weather,
+        shared->sat_hist_len,
+        shared->params->t_step,
+        ens_params->vis_sigma,
+        ens_params->cn2_sigma,
+        ens_params->seed + member->index);
+
+    //private copy, members only differ in weather
+    MaxSearchParams search = *shared->params;
+    search.weather = weather;
+
+    max_path_t *result = get_max_link_path(
+        shared->sats,
+        shared->sat_history,
+        shared->sat_hist_len,
+        shared->ground_stations,
+        &search);
+
+    member->capacity = 0;
+    if (result != NULL) {
+        member->capacity = result->size;
+        g_list_free_full(result->path, free);
+        free(result);
+    }
+
+    g_hash_table_destroy(weather);
+}
+
+//standard normal sample, Box-Muller transform
+static gdouble gaussian(GRand *rand) {
+    gdouble u1 = 1.0 - g_rand_double(rand);     //(0, 1], keeps log() finite
+    gdouble u2 = g_rand_double(rand);
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * G_PI * u2);
+}
+
+static gint compare_capacity(gconstpointer a, gconstpointer b) {
+    gdouble x = *(const gdouble *)a;
+    gdouble y = *(const gdouble *)b;
+
+    return (x > y) - (x < y);
+}
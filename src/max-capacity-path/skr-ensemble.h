@@ -0,0 +1,46 @@
+#include <glib/gi18n.h>
+#include "path-util.h"
+
+#ifndef SKR_ENSEMBLE_H
+#define SKR_ENSEMBLE_H
+
+#define ENSEMBLE_DEFAULT_VIS_SIGMA 0.5   //log-normal spread used by the max path view
+#define ENSEMBLE_DEFAULT_CN2_SIGMA 0.5
+
+typedef struct {
+    guint members;          //number of weather realizations
+    guint threads;          //worker threads, 0 uses number of processors
+    guint32 seed;           //member m draws from seed + m, results are reproducible
+    gdouble vis_sigma;      //log-normal spread of visibility per station hour
+    gdouble cn2_sigma;      //log-normal spread of Cn2 per station hour
+    GHashTable *base_weather;   //{gchar *ogs name : lw_weather_t *}, NULL for clear sky
+} EnsembleParams;
+
+typedef struct {
+    guint members;
+    gdouble *capacity;      //max capacity (kilobytes) of each member, ascending
+    gdouble mean;
+} skr_ensemble_t;
+
+skr_ensemble_t *run_skr_ensemble(
+    GSList *sats,
+    GHashTable *sat_history,
+    guint sat_hist_len,
+    GSList *ground_stations,
+    MaxSearchParams *params,
+    EnsembleParams *ens_params);
+
+GHashTable *sample_ensemble_weather(
+    GSList *ground_stations,
+    GHashTable *base_weather,
+    guint sat_hist_len,
+    gdouble time_step,
+    gdouble vis_sigma,
+    gdouble cn2_sigma,
+    guint32 seed);
+
+gdouble skr_ensemble_percentile(skr_ensemble_t *ens, gdouble p);
+
+void skr_ensemble_free(skr_ensemble_t *ens);
+
+#endif
@@ -0,0 +1,99 @@
+#include <glib/gi18n.h>
+#include "../skr-ensemble.h"
+#include "../../qth-data.h"
+#include "../../skr-utils.h"
+#include "../../sgpsdp/sgp4sdp4.h"
+
+#include "test-headers.h"
+
+void ensemble_sample_deterministic_test() {
+    qth_t ogs1 = {.name="ogs1", .alt=100, .lat=0, .lon=0};
+    qth_t ogs2 = {.name="ogs2", .alt=0, .lat=20, .lon=20};
+    GSList *stations = g_slist_append(NULL, &ogs1);
+    stations = g_slist_append(stations, &ogs2);
+
+    gdouble step = 0.0006944444444;     //1 minute
+    guint len = 180;
+
+    GHashTable *a = sample_ensemble_weather(stations, NULL, len, step, 0.5, 0.5, 7);
+    GHashTable *b = sample_ensemble_weather(stations, NULL, len, step, 0.5, 0.5, 7);
+    GHashTable *c = sample_ensemble_weather(stations, NULL, len, step, 0.5, 0.5, 8);
+
+    lw_weather_t *wa = g_hash_table_lookup(a, "ogs2");
+    lw_weather_t *wb = g_hash_table_lookup(b, "ogs2");
+    lw_weather_t *wc = g_hash_table_lookup(c, "ogs2");
+
+    g_assert_true(wa != NULL && wb != NULL && wc != NULL);
+    g_assert_true(wa->len == len);
+
+    gboolean differs = FALSE;
+    for (guint i = 0; i < len; i++) {
+        g_assert_cmpfloat(wa->vis[i], ==, wb->vis[i]);
+        g_assert_cmpfloat(wa->cn2[i], ==, wb->cn2[i]);
+        g_assert_cmpfloat(wa->vis[i], >, 0);
+        if (wa->vis[i] != wc->vis[i]) differs = TRUE;
+    }
+    g_assert_true(differs);
+
+    //samples only change at hour boundaries
+    g_assert_cmpfloat(wa->vis[0], ==, wa->vis[59]);
+    g_assert_cmpfloat(wa->vis[60], ==, wa->vis[119]);
+
+    g_hash_table_destroy(a);
+    g_hash_table_destroy(b);
+    g_hash_table_destroy(c);
+
+    //no spread reproduces clear sky
+    GHashTable *clear = sample_ensemble_weather(stations, NULL, len, step, 0, 0, 1);
+    lw_weather_t *w = g_hash_table_lookup(clear, "ogs1");
+    g_assert_cmpfloat_with_epsilon(w->vis[10], SKR_DEFAULT_VISIBILITY, 1e-9);
+    g_assert_cmpfloat_with_epsilon(w->cn2[10], SKR_DEFAULT_CN2, 1e-25);
+    g_hash_table_destroy(clear);
+
+    g_slist_free(stations);
+}
+
+void ensemble_percentile_test() {
+    gdouble values[5] = {1, 2, 3, 4, 5};
+    skr_ensemble_t ens = {.members = 5, .capacity = values, .mean = 3};
+
+    g_assert_cmpfloat_with_epsilon(skr_ensemble_percentile(&ens, 0), 1, 1e-12);
+    g_assert_cmpfloat_with_epsilon(skr_ensemble_percentile(&ens, 25), 2, 1e-12);
+    g_assert_cmpfloat_with_epsilon(skr_ensemble_percentile(&ens, 50), 3, 1e-12);
+    g_assert_cmpfloat_with_epsilon(skr_ensemble_percentile(&ens, 10), 1.4, 1e-12);
+    g_assert_cmpfloat_with_epsilon(skr_ensemble_percentile(&ens, 100), 5, 1e-12);
+}
+
+void ensemble_weather_lowers_skr_test() {
+    qth_t ogs = {.name="ogs", .alt=0, .lat=45, .lon=10};
+    geodetic_t geo = {.lat = 45 * de2ra, .lon = 10 * de2ra, .alt = 0, .theta = 0};
+    vector_t pos, vel;
+
+    //satellite 500 km straight above the station
+    gdouble jul_utc = 2460000.5;
+    Calculate_User_PosVel(jul_utc, &geo, &pos, &vel);
+    Magnitude(&pos);
+    gdouble scale = (pos.w + 500) / pos.w;
+
+    lw_sat_t sat_hist[1] = {{
+        .pos = {.x = pos.x * scale, .y = pos.y * scale, .z = pos.z * scale},
+        .vel = vel,
+        .jul_utc = jul_utc
+    }};
+
+    lw_weather_t *hazy = lw_weather_new(1);
+    hazy->vis[0] = 5.0;
+    hazy->cn2[0] = 1e-14;
+
+    tdsp_node station = {.node={.id = -1, .type=path_STATION, .obj=&ogs}};
+    tdsp_node sat = {.node={.id = 1, .type=path_SATELLITE}};
+
+    gdouble clear_skr = get_inter_node_skr(&sat, &station, sat_hist, NULL, 0);
+    station.node.weather = hazy;
+    gdouble hazy_skr = get_inter_node_skr(&sat, &station, sat_hist, NULL, 0);
+
+    g_assert_cmpfloat(clear_skr, >, 0);
+    g_assert_cmpfloat(hazy_skr, <, clear_skr);
+
+    lw_weather_free(hazy);
+}
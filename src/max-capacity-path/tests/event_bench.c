@@ -0,0 +1,175 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "../../event-finder.h"
+#include "../../orbit-tools.h"
+#include "../../qth-data.h"
+#include "../../sgpsdp/sgp4sdp4.h"
+
+/**
+ * Counts orbit propagations per AOS/LOS event: the step heuristics find_aos()
+ * and find_los() used before the event finder, copied below, against the
+ * bracketing search with Brent's method, for a LEO and a highly eccentric
+ * orbit over a few ground stations. Also reports the largest difference
+ * between the event times of the two.
+ *
+ * Usage: event-bench [days], defaults to 3
+ */
+
+#define MAXDT 3.0   // look ahead of the module, days
+
+static const char *test_tle[2][3] = {
+    {"TEST SAT SGP 001",
+     "1 88888U          80275.98708465  .00073094  13844-3  66816-4 0     9",
+     "2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518   103"},
+    {"TEST SAT SDP 001",
+     "1 11801U          80230.29629788  .01431103  00000-0  14311-1 0     2",
+     "2 11801  46.7916 230.4354 7318036  47.4722  10.4117  2.28537848     2"}
+};
+
+static const gdouble lats[] = {-35.0, 0.0, 45.0, 60.0};
+
+static guint calls;
+
+// predict_calc() as far as find_aos() and find_los() need it
+static void ref_predict_calc(sat_t *sat, qth_t *qth, gdouble t) {
+    geodetic_t obs = {qth->lat * de2ra, qth->lon * de2ra, qth->alt / 1000.0, 0};
+    geodetic_t sat_geodetic;
+    obs_set_t obs_set;
+
+    calls++;
+    sat->jul_utc = t;
+    sat->tsince = (sat->jul_utc - sat->jul_epoch) * xmnpda;
+    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+        SDP4(sat, sat->tsince);
+    else
+        SGP4(sat, sat->tsince);
+    Convert_Sat_State(&sat->pos, &sat->vel);
+    Calculate_Obs(sat->jul_utc, &sat->pos, &sat->vel, &obs, &obs_set);
+    Calculate_LatLonAlt(sat->jul_utc, &sat->pos, &sat_geodetic);
+    sat->el = Degrees(obs_set.el);
+    sat->alt = sat_geodetic.alt;
+}
+
+static gdouble ref_find_los(sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
+
+// find_aos() before the event finder, maxdt > 0 branch
+static gdouble ref_find_aos(sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt) {
+    gdouble t = start;
+    gdouble aostime = 0.0;
+
+    ref_predict_calc(sat, qth, start);
+    if (!has_aos(sat, qth)) return 0.0;
+    if (sat->el > 0.0) t = ref_find_los(sat, qth, start, maxdt) + 0.014;
+    if (t < 0.1) return 0.0;
+    ref_predict_calc(sat, qth, t);
+
+    while ((sat->el < -1.0) && (t <= (start + maxdt))) {
+        t -= 0.00035 * (sat->el * ((sat->alt / 8400.0) + 0.46) - 2.0);
+        ref_predict_calc(sat, qth, t);
+    }
+    while ((aostime == 0.0) && (t <= (start + maxdt))) {
+        if (fabs(sat->el) < 0.005) {
+            aostime = t;
+        } else {
+            t -= sat->el * sqrt(sat->alt) / 530000.0;
+            ref_predict_calc(sat, qth, t);
+        }
+    }
+    return aostime;
+}
+
+// find_los() before the event finder, maxdt > 0 branch
+static gdouble ref_find_los(sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt) {
+    gdouble t = start;
+    gdouble lostime = 0.0;
+    gdouble eltemp;
+
+    ref_predict_calc(sat, qth, start);
+    if (!has_aos(sat, qth)) return 0.0;
+    if (sat->el < 0.0) t = ref_find_aos(sat, qth, start, maxdt) + 0.001;
+    if (t < 0.01) return 0.0;
+    ref_predict_calc(sat, qth, t);
+
+    while ((sat->el >= 1.0) && (t <= (start + maxdt))) {
+        t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
+        ref_predict_calc(sat, qth, t);
+    }
+    while ((lostime == 0.0) && (t <= (start + maxdt))) {
+        t += sat->el * sqrt(sat->alt) / 502500.0;
+        ref_predict_calc(sat, qth, t);
+        if (fabs(sat->el) < 0.005) {
+            eltemp = sat->el;
+            ref_predict_calc(sat, qth, t - 1.0 / 86400.0);
+            if (sat->el > eltemp) lostime = t;
+        }
+    }
+    return lostime;
+}
+
+static void load_sat(sat_t *sat, guint i) {
+    char lines[3][80];
+    for (guint l = 0; l < 3; l++) g_strlcpy(lines[l], test_tle[i][l], 80);
+
+    memset(sat, 0, sizeof(sat_t));
+    Get_Next_Tle_Set(lines, &sat->tle);
+    select_ephemeris(sat);
+    sat->jul_epoch = Julian_Date_of_Epoch(sat->tle.epoch);
+}
+
+static void run(guint tle, gdouble lat, gdouble days) {
+    qth_t qth = {0};
+    sat_t sat;
+    guint events = 0, ref_calls = 0, new_calls = 0, evals;
+    gdouble max_diff = 0.0;
+    GTimer *timer = g_timer_new();
+    gdouble ref_time = 0.0, new_time = 0.0;
+
+    qth.lat = lat;
+    qth.lon = 10.0;
+    load_sat(&sat, tle);
+
+    // walk from event to event like the module does
+    for (gdouble t = sat.jul_epoch; t < sat.jul_epoch + days;) {
+        gdouble ref_aos, ref_los, aos, los;
+
+        calls = 0;
+        g_timer_start(timer);
+        ref_aos = ref_find_aos(&sat, &qth, t, MAXDT);
+        ref_los = ref_find_los(&sat, &qth, t, MAXDT);
+        ref_time += g_timer_elapsed(timer, NULL);
+        ref_calls += calls;
+
+        g_timer_start(timer);
+        aos = event_find_aos(&sat, &qth, t, MAXDT, EVENT_RESOLUTION, &evals);
+        new_calls += evals;
+        los = event_find_los(&sat, &qth, t, MAXDT, EVENT_RESOLUTION, &evals);
+        new_calls += evals;
+        new_time += g_timer_elapsed(timer, NULL);
+
+        if (aos == 0.0 || los == 0.0 || ref_aos == 0.0 || ref_los == 0.0) break;
+
+        events += 2;
+        max_diff = MAX(max_diff, fabs(aos - ref_aos));
+        max_diff = MAX(max_diff, fabs(los - ref_los));
+        t = MAX(aos, los) + 1.0 / 1440.0;
+    }
+
+    if (events > 0)
+        printf("%s lat %6.1f  %4u events  old %7.1f calls %7.2f us  new %6.1f calls %7.2f us  per event"
+               "  max difference %.2f s\n",
+               test_tle[tle][0], lat, events, (gdouble)ref_calls / events, ref_time * 1e6 / events,
+               (gdouble)new_calls / events, new_time * 1e6 / events, max_diff * 86400.0);
+
+    g_timer_destroy(timer);
+}
+
+int main(int argc, char *argv[]) {
+    gdouble days = argc > 1 ? g_ascii_strtod(argv[1], NULL) : 3.0;
+
+    for (guint tle = 0; tle < G_N_ELEMENTS(test_tle); tle++)
+        for (guint i = 0; i < G_N_ELEMENTS(lats); i++) run(tle, lats[i], days);
+
+    return 0;
+}
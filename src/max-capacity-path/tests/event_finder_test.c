@@ -0,0 +1,108 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include <string.h>
+#include "../../event-finder.h"
+#include "../../qth-data.h"
+#include "../../sgpsdp/sgp4sdp4.h"
+#include "test-headers.h"
+
+//sgpsdp test-001 (near earth) and test-002 (deep space) elements
+static const char *test_tle[2][3] = {
+    {"TEST SAT SGP 001",
+     "1 88888U          80275.98708465  .00073094  13844-3  66816-4 0     9",
+     "2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518   103"},
+    {"TEST SAT SDP 001",
+     "1 11801U          80230.29629788  .01431103  00000-0  14311-1 0     2",
+     "2 11801  46.7916 230.4354 7318036  47.4722  10.4117  2.28537848     2"}
+};
+
+#define SCAN_STEP (5.0 / 86400.0)
+
+static void load_test_sat(sat_t *sat, guint i) {
+    char lines[3][80];
+    for (guint l = 0; l < 3; l++) g_strlcpy(lines[l], test_tle[i][l], 80);
+
+    memset(sat, 0, sizeof(sat_t));
+    g_assert_cmpint(Get_Next_Tle_Set(lines, &sat->tle), ==, 1);
+    select_ephemeris(sat);
+    sat->jul_epoch = Julian_Date_of_Epoch(sat->tle.epoch);
+}
+
+// Elevation in degrees the way predict_calc() computes it
+static gdouble elevation(sat_t *sat, qth_t *qth, gdouble t) {
+    geodetic_t obs = {qth->lat * de2ra, qth->lon * de2ra, qth->alt / 1000.0, 0};
+    obs_set_t obs_set;
+
+    sat->tsince = (t - sat->jul_epoch) * xmnpda;
+    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+        SDP4(sat, sat->tsince);
+    else
+        SGP4(sat, sat->tsince);
+    Convert_Sat_State(&sat->pos, &sat->vel);
+    Calculate_Obs(t, &sat->pos, &sat->vel, &obs, &obs_set);
+    return Degrees(obs_set.el);
+}
+
+// Each found AOS and LOS is the next crossing a fine scan sees
+static void check_events(guint tle, gdouble lat) {
+    qth_t qth = {0};
+    sat_t sat;
+    gdouble t0, t1 = 0.0;
+
+    qth.lat = lat;
+    qth.lon = 10.0;
+    qth.alt = 100;
+    load_test_sat(&sat, tle);
+    t0 = sat.jul_epoch;
+
+    for (gdouble t = t0; t < t0 + 1.0;) {
+        gdouble el = elevation(&sat, &qth, t);
+        gdouble want_aos = 0.0, want_los = 0.0;
+        guint evals;
+
+        // find the next rise and set by brute force
+        for (gdouble s = t; s < t0 + 2.0 && want_los == 0.0; s += SCAN_STEP) {
+            gdouble next = elevation(&sat, &qth, s + SCAN_STEP);
+            if (want_aos == 0.0 && el < 0.0 && next >= 0.0) want_aos = s + SCAN_STEP;
+            if (want_aos != 0.0 && el > 0.0 && next <= 0.0) want_los = s + SCAN_STEP;
+            el = next;
+        }
+        g_assert_cmpfloat(want_los, >, 0.0);
+
+        gdouble aos = event_find_aos(&sat, &qth, t, 2.0, EVENT_RESOLUTION, &evals);
+        g_assert_cmpfloat(fabs(aos - want_aos), <=, SCAN_STEP);
+        g_assert_cmpfloat(fabs(elevation(&sat, &qth, aos)), <, 0.05);
+        g_assert_cmpuint(evals, <, EVENT_MAX_EVALS);
+
+        t1 = event_find_los(&sat, &qth, aos, 2.0, EVENT_RESOLUTION, &evals);
+        g_assert_cmpfloat(fabs(t1 - want_los), <=, SCAN_STEP);
+        g_assert_cmpfloat(elevation(&sat, &qth, t1 - 1.0 / 1440.0), >, 0.0);
+        g_assert_cmpuint(evals, <, EVENT_MAX_EVALS);
+
+        t = t1 + 1.0 / 1440.0;
+    }
+}
+
+// Matches a brute force scan for a LEO and a highly eccentric orbit
+void event_finder_scan_test() {
+    check_events(0, 45.0);
+    check_events(0, -20.0);
+    check_events(1, 45.0);
+}
+
+// A satellite that never rises gives up after the evaluation budget
+void event_finder_budget_test() {
+    qth_t qth = {0};
+    sat_t sat;
+    guint evals;
+
+    // 72.8 deg inclination never gets above the horizon at the pole
+    qth.lat = 90.0;
+    load_test_sat(&sat, 0);
+
+    g_assert_cmpfloat(event_find_aos(&sat, &qth, sat.jul_epoch, 0.0, EVENT_RESOLUTION, &evals), ==, 0.0);
+    g_assert_cmpuint(evals, ==, EVENT_MAX_EVALS);
+
+    g_assert_cmpfloat(event_find_aos(&sat, &qth, sat.jul_epoch, 1.0, EVENT_RESOLUTION, &evals), ==, 0.0);
+    g_assert_cmpuint(evals, <, EVENT_MAX_EVALS);
+}
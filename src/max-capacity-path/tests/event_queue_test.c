@@ -0,0 +1,112 @@
+#include <glib/gi18n.h>
+#include <string.h>
+#include "../../event-finder.h"
+#include "../../event-queue.h"
+#include "../../qth-data.h"
+#include "../../sgpsdp/sgp4sdp4.h"
+#include "test-headers.h"
+
+//sgpsdp test-001 (near earth) and test-002 (deep space) elements
+static const char *test_tle[2][3] = {
+    {"TEST SAT SGP 001",
+     "1 88888U          80275.98708465  .00073094  13844-3  66816-4 0     9",
+     "2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518   103"},
+    {"TEST SAT SDP 001",
+     "1 11801U          80230.29629788  .01431103  00000-0  14311-1 0     2",
+     "2 11801  46.7916 230.4354 7318036  47.4722  10.4117  2.28537848     2"}
+};
+
+#define LOOK_AHEAD 3.0
+
+static void load_test_sat(sat_t *sat, guint i) {
+    char lines[3][80];
+    for (guint l = 0; l < 3; l++) g_strlcpy(lines[l], test_tle[i][l], 80);
+
+    memset(sat, 0, sizeof(sat_t));
+    g_assert_cmpint(Get_Next_Tle_Set(lines, &sat->tle), ==, 1);
+    select_ephemeris(sat);
+    sat->jul_epoch = Julian_Date_of_Epoch(sat->tle.epoch);
+}
+
+// Only expired satellites are refreshed, at most budget of them per update
+void event_queue_budget_test() {
+    qth_t qth = {0};
+    sat_t sats[2], copy;
+    event_queue *q = event_queue_new();
+    gdouble now, aos, los;
+
+    qth.lat = 45.0;
+    qth.lon = 10.0;
+    for (guint i = 0; i < 2; i++) {
+        load_test_sat(&sats[i], i);
+        event_queue_add(q, &sats[i]);
+    }
+    now = sats[0].jul_epoch + 1.0;
+
+    g_assert_cmpuint(event_queue_due(q, now), ==, 2);
+    g_assert_cmpuint(event_queue_update(q, &qth, now, LOOK_AHEAD, 1), ==, 1);
+    g_assert_cmpuint(event_queue_update(q, &qth, now, LOOK_AHEAD, 1), ==, 1);
+    g_assert_cmpuint(event_queue_due(q, now), ==, 0);
+
+    // same events as a direct search
+    for (guint i = 0; i < 2; i++) {
+        copy = sats[i];
+        g_assert_cmpfloat(sats[i].aos, ==, event_find_aos(&copy, &qth, now, LOOK_AHEAD, EVENT_RESOLUTION, NULL));
+        g_assert_cmpfloat(sats[i].los, ==, event_find_los(&copy, &qth, now, LOOK_AHEAD, EVENT_RESOLUTION, NULL));
+        g_assert_cmpfloat(sats[i].aos, >, now);
+    }
+
+    // nothing to do until the first event has passed
+    g_assert_cmpuint(event_queue_update(q, &qth, now + 1.0 / 86400.0, LOOK_AHEAD, 10), ==, 0);
+
+    aos = sats[0].aos;
+    los = sats[0].los;
+    now = MIN(aos, los) + 1.0 / 1440.0;
+    g_assert_cmpuint(event_queue_update(q, &qth, now, LOOK_AHEAD, 10), >=, 1);
+    g_assert_cmpfloat(MIN(sats[0].aos, sats[0].los), >, now);
+    // the event that has not passed yet is kept
+    g_assert_cmpfloat(aos < los ? sats[0].los : sats[0].aos, ==, aos < los ? los : aos);
+
+    event_queue_free(q);
+}
+
+// Stale satellites go round robin, ones without a pass are retried later
+void event_queue_expire_test() {
+    qth_t qth = {0};
+    sat_t sats[2];
+    event_queue *q = event_queue_new();
+    gdouble now;
+
+    qth.lat = 45.0;
+    qth.lon = 10.0;
+    for (guint i = 0; i < 2; i++) {
+        load_test_sat(&sats[i], i);
+        event_queue_add(q, &sats[i]);
+    }
+    now = sats[0].jul_epoch + 1.0;
+    event_queue_update(q, &qth, now, LOOK_AHEAD, 10);
+
+    event_queue_expire_all(q);
+    g_assert_cmpuint(event_queue_due(q, now), ==, 2);
+
+    sats[0].aos = sats[1].aos = -1.0;
+    g_assert_cmpuint(event_queue_update(q, &qth, now, LOOK_AHEAD, 1), ==, 1);
+    g_assert_cmpfloat(sats[0].aos, >, now);
+    g_assert_cmpfloat(sats[1].aos, ==, -1.0);
+    g_assert_cmpuint(event_queue_update(q, &qth, now, LOOK_AHEAD, 1), ==, 1);
+    g_assert_cmpfloat(sats[1].aos, >, now);
+
+    // 72.8 deg inclination never gets above the horizon at the pole
+    qth.lat = 90.0;
+    event_queue_expire_all(q);
+    g_assert_cmpuint(event_queue_update(q, &qth, now, LOOK_AHEAD, 10), ==, 2);
+    g_assert_cmpfloat(sats[0].aos, ==, 0.0);
+    g_assert_cmpfloat(sats[0].los, ==, 0.0);
+    g_assert_cmpuint(event_queue_due(q, now), ==, 0);
+    g_assert_cmpuint(event_queue_update(q, &qth, now + EVENT_QUEUE_RETRY, LOOK_AHEAD, 10), >=, 1);
+
+    event_queue_clear(q);
+    g_assert_cmpuint(event_queue_due(q, now), ==, 0);
+
+    event_queue_free(q);
+}
@@ -0,0 +1,102 @@
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include "../fibre-backbone.h"
+#include "../transfer-time.h"
+#include "../../skr-utils.h"
+#include "test-headers.h"
+
+static qth_t stations[3] = {
+    {.name = "ogs a", .lat = 45.0, .lon = -75.0},
+    {.name = "ogs b", .lat = 45.5, .lon = -75.0},   //~56 km from a
+    {.name = "ogs c", .lat = 50.0, .lon = -75.0}    //~556 km from a
+};
+
+static GSList *station_list() {
+    GSList *list = NULL;
+    for (gint i = 2; i >= 0; i--) list = g_slist_prepend(list, &stations[i]);
+
+    return list;
+}
+
+void fibre_backbone_distance_test() {
+    GSList *list = station_list();
+    GHashTable *backbone = fibre_backbone_from_distance(list, FIBRE_DEFAULT_MAX_DISTANCE);
+
+    GArray *a_edges = g_hash_table_lookup(backbone, stations[0].name);
+    GArray *b_edges = g_hash_table_lookup(backbone, stations[1].name);
+
+    g_assert_nonnull(a_edges);
+    g_assert_nonnull(b_edges);
+    g_assert_cmpuint(a_edges->len, ==, 1);
+    g_assert_cmpuint(b_edges->len, ==, 1);
+    g_assert_null(g_hash_table_lookup(backbone, stations[2].name));
+
+    fibre_edge_t *edge = &g_array_index(a_edges, fibre_edge_t, 0);
+    g_assert_true(edge->dst == &stations[1]);
+    g_assert_cmpfloat_with_epsilon(edge->distance, ground_distance(&stations[0], &stations[1]), 1e-9);
+    g_assert_cmpfloat(edge->rate, >, 0);
+    g_assert_cmpfloat_with_epsilon(edge->rate, lw_fibre_link(edge->distance), 1e-9);
+
+    fibre_backbone_free(backbone);
+    g_slist_free(list);
+}
+
+void fibre_backbone_file_test() {
+    GSList *list = station_list();
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "fibre_backbone_test.txt", NULL);
+    const gchar *adjacency =
+        "# long haul link given explicitly, second one too long\n"
+        "ogs a;ogs c;600\n"
+        "ogs b ; ogs c ; 2000\n"
+        "\n"
+        "ogs a;unknown\n"
+        "ogs a;ogs b;12x\n"
+        "ogs a;ogs b;\n"
+        "ogs b;ogs b\n";
+
+    g_assert_true(g_file_set_contents(filename, adjacency, -1, NULL));
+    GHashTable *backbone = fibre_backbone_from_file(list, filename, 1000);
+    g_remove(filename);
+
+    g_assert_nonnull(backbone);
+    // only the invalid lengths would have joined b
+    g_assert_null(g_hash_table_lookup(backbone, stations[1].name));
+
+    GArray *c_edges = g_hash_table_lookup(backbone, stations[2].name);
+    g_assert_nonnull(c_edges);
+    g_assert_cmpuint(c_edges->len, ==, 1);
+
+    fibre_edge_t *edge = &g_array_index(c_edges, fibre_edge_t, 0);
+    g_assert_true(edge->dst == &stations[0]);
+    g_assert_cmpfloat_with_epsilon(edge->distance, 600, 1e-9);
+
+    g_assert_null(fibre_backbone_from_file(list, filename, 1000));
+
+    fibre_backbone_free(backbone);
+    g_free(filename);
+    g_slist_free(list);
+}
+
+void fibre_transfer_time_test() {
+    GSList *list = station_list();
+    GHashTable *backbone = fibre_backbone_from_distance(list, FIBRE_DEFAULT_MAX_DISTANCE);
+
+    tdsp_node a = {.node={.id = -1, .type=path_STATION, .obj=&stations[0],
+                          .fibre=g_hash_table_lookup(backbone, stations[0].name)}};
+    tdsp_node b = {.node={.id = -2, .type=path_STATION, .obj=&stations[1],
+                          .fibre=g_hash_table_lookup(backbone, stations[1].name)}};
+    tdsp_node c = {.node={.id = -3, .type=path_STATION, .obj=&stations[2]}};
+
+    gdouble rate = get_inter_node_skr(&a, &b, NULL, NULL, 0);
+    g_assert_cmpfloat(rate, >, 0);
+    g_assert_cmpfloat(get_inter_node_skr(&a, &c, NULL, NULL, 0), ==, 0);
+
+    //no satellite history needed, rate is constant
+    gdouble data = rate * 0.25;
+    g_assert_cmpfloat_with_epsilon(get_transfer_time(&a, &b, data, NULL, 0, 1.0, 0.0, 2.0, 0.01), 1.25, 1e-9);
+    g_assert_cmpfloat(get_transfer_time(&a, &b, data, NULL, 0, 1.9, 0.0, 2.0, 0.01), ==, G_MAXDOUBLE);
+    g_assert_cmpfloat(get_transfer_time(&a, &c, data, NULL, 0, 1.0, 0.0, 2.0, 0.01), ==, G_MAXDOUBLE);
+
+    fibre_backbone_free(backbone);
+    g_slist_free(list);
+}
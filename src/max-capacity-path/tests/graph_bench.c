@@ -0,0 +1,92 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "../../sat-graph.h"
+
+/**
+ * Times SatGraph on random LEO constellations: building the LOS graph through
+ * the sat_t facade pair by pair and from the los-pairs grid, shortest paths
+ * between random pairs and a spanning tree.
+ *
+ * Usage: graph-bench [vertices ...], defaults to 100 1000 5000
+ */
+
+#define QUERIES 20
+
+static void place_sats(sat_t *sats, guint n, GRand *rand) {
+    memset(sats, 0, n * sizeof(sat_t));
+    for (guint i = 0; i < n; i++) {
+        gdouble r = EARTH_RADIUS + g_rand_double_range(rand, 400, 1500);
+        gdouble lat = asin(g_rand_double_range(rand, -1, 1));
+        gdouble lon = g_rand_double_range(rand, -G_PI, G_PI);
+        sats[i].pos.x = r * cos(lat) * cos(lon);
+        sats[i].pos.y = r * cos(lat) * sin(lon);
+        sats[i].pos.z = r * sin(lat);
+    }
+}
+
+static void run(guint n, GRand *rand) {
+    sat_t *sats = g_new(sat_t, n);
+    GTimer *timer = g_timer_new();
+    gdouble build, grid, path, mst;
+    guint found = 0;
+
+    place_sats(sats, n, rand);
+
+    g_timer_start(timer);
+    SatGraph *graph = sat_graph_new();
+    for (guint i = 0; i < n; i++) {
+        sat_graph_add_vertex(graph, &sats[i]);
+        for (guint j = i + 1; j < n; j++)
+            if (is_los_clear(&sats[i], &sats[j])) sat_graph_add_edge(graph, &sats[i], &sats[j]);
+    }
+    build = g_timer_elapsed(timer, NULL);
+
+    // same graph from the los-pairs grid
+    GList *list = NULL;
+    for (guint i = n; i > 0; i--) list = g_list_prepend(list, &sats[i - 1]);
+    g_timer_start(timer);
+    SatGraph *grid_graph = sat_graph_new_los(list, 0);
+    grid = g_timer_elapsed(timer, NULL);
+    if (grid_graph->edges->len != graph->edges->len)
+        printf("grid found %u edges, pairwise %u\n", grid_graph->edges->len, graph->edges->len);
+    sat_graph_free(grid_graph);
+    g_list_free(list);
+
+    g_timer_start(timer);
+    for (guint q = 0; q < QUERIES; q++) {
+        sat_t *a = &sats[g_rand_int_range(rand, 0, n)];
+        sat_t *b = &sats[g_rand_int_range(rand, 0, n)];
+        GList *p = sat_graph_dijkstra(graph, a, b);
+        if (p) found++;
+        g_list_free(p);
+    }
+    path = g_timer_elapsed(timer, NULL) / QUERIES;
+
+    g_timer_start(timer);
+    SatGraph *tree = sat_graph_prims(graph);
+    mst = g_timer_elapsed(timer, NULL);
+
+    printf("%6u vertices %9u edges  build %9.3f ms  grid build %9.3f ms  dijkstra %9.3f ms (%u/%u found)  prim %9.3f ms\n",
+           n, graph->edges->len, build * 1e3, grid * 1e3, path * 1e3, found, QUERIES, mst * 1e3);
+
+    sat_graph_free(tree);
+    sat_graph_free(graph);
+    g_timer_destroy(timer);
+    g_free(sats);
+}
+
+int main(int argc, char *argv[]) {
+    GRand *rand = g_rand_new_with_seed(35);
+    guint sizes[] = {100, 1000, 5000};
+
+    if (argc > 1) {
+        for (gint i = 1; i < argc; i++) run((guint)g_ascii_strtoull(argv[i], NULL, 10), rand);
+    } else {
+        for (guint i = 0; i < G_N_ELEMENTS(sizes); i++) run(sizes[i], rand);
+    }
+
+    g_rand_free(rand);
+    return 0;
+}
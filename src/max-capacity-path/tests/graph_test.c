@@ -0,0 +1,169 @@
+#include <glib/gi18n.h>
+#include <float.h>
+#include <string.h>
+#include "../../sat-graph.h"
+#include "test-headers.h"
+
+// Four satellites in the equatorial plane, km apart
+static void square_sats(sat_t *sats) {
+    memset(sats, 0, 4 * sizeof(sat_t));
+    sats[0].pos.x = 7000;   sats[0].pos.y = 0;
+    sats[1].pos.x = 7000;   sats[1].pos.y = 1000;
+    sats[2].pos.x = 7900;   sats[2].pos.y = 1000;
+    sats[3].pos.x = 7900;   sats[3].pos.y = -100;
+}
+
+void graph_dijkstra_test() {
+    sat_t sats[4];
+    square_sats(sats);
+
+    SatGraph *graph = sat_graph_new();
+    for (gint i = 0; i < 4; i++) sat_graph_add_vertex(graph, &sats[i]);
+    sat_graph_add_edge(graph, &sats[0], &sats[1]);
+    sat_graph_add_edge(graph, &sats[1], &sats[2]);
+    sat_graph_add_edge(graph, &sats[2], &sats[3]);
+    sat_graph_add_edge(graph, &sats[0], &sats[2]);
+
+    // a pair already in the graph is not added again, in either direction
+    sat_graph_add_edge(graph, &sats[2], &sats[0]);
+    sat_graph_add_edge(graph, &sats[0], &sats[1]);
+    g_assert_cmpuint(graph->edges->len, ==, 4);
+
+    GList *path = sat_graph_dijkstra(graph, &sats[0], &sats[2]);
+    g_assert_cmpuint(g_list_length(path), ==, 2);
+    g_list_free(path);
+
+    // without the diagonal the path goes through whichever neighbour is closer
+    sats[2].pos.x = 7300;
+    sat_graph_free(graph);
+    graph = sat_graph_new();
+    sat_graph_add_edge(graph, &sats[0], &sats[1]);
+    sat_graph_add_edge(graph, &sats[1], &sats[2]);
+    sat_graph_add_edge(graph, &sats[0], &sats[3]);
+    sat_graph_add_edge(graph, &sats[3], &sats[2]);
+
+    path = sat_graph_dijkstra(graph, &sats[0], &sats[2]);
+    g_assert_cmpuint(g_list_length(path), ==, 3);
+    g_assert_true(path->data == &sats[0]);
+    g_assert_true(path->next->data == &sats[1]);
+    g_assert_true(path->next->next->data == &sats[2]);
+    g_list_free(path);
+
+    // a vertex without edges can not be reached
+    sat_t lone;
+    memset(&lone, 0, sizeof(sat_t));
+    sat_graph_add_vertex(graph, &lone);
+    g_assert_null(sat_graph_dijkstra(graph, &sats[0], &lone));
+
+    sat_graph_free(graph);
+}
+
+// Compares the heap based Prim to an O(n^2) scan of a dense random graph
+void graph_prim_test() {
+    const guint n = 60;
+    GRand *rand = g_rand_new_with_seed(7);
+    gdouble *w = g_new(gdouble, n * n);
+    GArray *edges = g_array_new(FALSE, FALSE, sizeof(SatCsrEdge));
+
+    for (guint i = 0; i < n * n; i++) w[i] = DBL_MAX;
+    for (guint a = 0; a < n; a++) {
+        for (guint b = a + 1; b < n; b++) {
+            if (g_rand_double(rand) > 0.3) continue;
+            SatCsrEdge edge = {a, b, g_rand_double_range(rand, 1, 100)};
+            g_array_append_val(edges, edge);
+            w[a * n + b] = w[b * n + a] = edge.weight;
+        }
+    }
+
+    SatCsr *csr = sat_csr_new(n, (SatCsrEdge *)edges->data, edges->len);
+    gint *parent = g_new(gint, n);
+    guint reached = sat_csr_prim(csr, 0, parent);
+    gdouble heap_total = 0;
+    for (guint v = 0; v < n; v++)
+        if (parent[v] >= 0) heap_total += w[v * n + parent[v]];
+
+    gboolean *in_tree = g_new0(gboolean, n);
+    gdouble *key = g_new(gdouble, n);
+    gdouble scan_total = 0;
+    guint scanned = 0;
+    for (guint v = 0; v < n; v++) key[v] = DBL_MAX;
+    key[0] = 0;
+    while (TRUE) {
+        gint u = -1;
+        for (guint v = 0; v < n; v++)
+            if (!in_tree[v] && key[v] < DBL_MAX && (u < 0 || key[v] < key[u])) u = v;
+        if (u < 0) break;
+        in_tree[u] = TRUE;
+        scan_total += key[u];
+        scanned++;
+        for (guint v = 0; v < n; v++)
+            if (!in_tree[v] && w[u * n + v] < key[v]) key[v] = w[u * n + v];
+    }
+
+    g_assert_cmpuint(reached, ==, scanned);
+    g_assert_cmpfloat_with_epsilon(heap_total, scan_total, 1e-9);
+
+    g_free(in_tree);
+    g_free(key);
+    g_free(parent);
+    g_free(w);
+    sat_csr_free(csr);
+    g_array_free(edges, TRUE);
+    g_rand_free(rand);
+}
+
+// Widest path against the max-min closure of a sparse random graph
+void graph_widest_test() {
+    const guint n = 40;
+    GRand *rand = g_rand_new_with_seed(37);
+    gdouble *w = g_new0(gdouble, n * n);
+    gdouble *best = g_new(gdouble, n * n);
+    GArray *edges = g_array_new(FALSE, FALSE, sizeof(SatCsrEdge));
+    GArray *path = g_array_new(FALSE, FALSE, sizeof(guint));
+
+    for (guint a = 0; a < n; a++) {
+        for (guint b = a + 1; b < n; b++) {
+            if (g_rand_double(rand) > 0.08) continue;
+            SatCsrEdge edge = {a, b, g_rand_double_range(rand, 1, 100)};
+            g_array_append_val(edges, edge);
+            w[a * n + b] = w[b * n + a] = edge.weight;
+        }
+    }
+
+    memcpy(best, w, n * n * sizeof(gdouble));
+    for (guint k = 0; k < n; k++)
+        for (guint i = 0; i < n; i++)
+            for (guint j = 0; j < n; j++)
+                best[i * n + j] = MAX(best[i * n + j], MIN(best[i * n + k], best[k * n + j]));
+
+    SatCsr *csr = sat_csr_new(n, (SatCsrEdge *)edges->data, edges->len);
+    for (guint dst = 1; dst < n; dst++) {
+        gdouble width = -1;
+        gboolean found = sat_csr_widest(csr, 0, dst, path, &width);
+
+        g_assert_cmpint(found, ==, best[dst] > 0);
+        if (!found) {
+            g_assert_cmpuint(path->len, ==, 0);
+            continue;
+        }
+        g_assert_cmpfloat(width, ==, best[dst]);
+
+        // the path is made of real edges and its weakest one is width
+        gdouble narrowest = DBL_MAX;
+        g_assert_cmpuint(g_array_index(path, guint, 0), ==, 0);
+        g_assert_cmpuint(g_array_index(path, guint, path->len - 1), ==, dst);
+        for (guint k = 1; k < path->len; k++) {
+            gdouble edge = w[g_array_index(path, guint, k - 1) * n + g_array_index(path, guint, k)];
+            g_assert_cmpfloat(edge, >, 0);
+            narrowest = MIN(narrowest, edge);
+        }
+        g_assert_cmpfloat(narrowest, ==, width);
+    }
+
+    sat_csr_free(csr);
+    g_array_free(path, TRUE);
+    g_array_free(edges, TRUE);
+    g_free(best);
+    g_free(w);
+    g_rand_free(rand);
+}
@@ -0,0 +1,105 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include <stdio.h>
+#include "../../sat-kdtree-utils.h"
+
+/**
+ * Times the per cycle satellite kd-tree update on random LEO constellations:
+ * the median build used by the module against inserting one satellite at a
+ * time, the nearest other satellite lookup the views do for every row and
+ * the neighbour queries used for link candidates, on each kd-tree backend.
+ *
+ * Usage: kdtree-bench [satellites ...], defaults to 1000 5000 20000
+ */
+
+#define REPEAT 20
+#define KNN 8
+#define LINK_RANGE 2000.0   // km
+
+static const struct {
+    KdtreeBackend backend;
+    const gchar *name;
+} backends[] = {
+    {KDTREE_BACKEND_NODES, "nodes"},
+    {KDTREE_BACKEND_FLAT, "flat double"},
+    {KDTREE_BACKEND_FLAT_FLOAT, "flat float"},
+};
+
+static void run_backend(guint b, sat_t *sats, guint n, GHashTable *table) {
+    Kdtree *tree = kdtree_new_backend(3, backends[b].backend);
+    GTimer *timer = g_timer_new();
+    sat_t **near = g_new(sat_t *, n);
+    gdouble dist[KNN];
+    gdouble insert, build, nearest, knn, range;
+    guint found = 0, in_range = 0;
+
+    // the flat backends build on the first query after inserting
+    g_timer_start(timer);
+    for (guint k = 0; k < REPEAT; k++) {
+        Kdtree *grown = kdtree_new_backend(3, backends[b].backend);
+        for (guint i = 0; i < n; i++) sat_kdtree_insert(grown, &sats[i]);
+        sat_kdtree_find_nearest_other(grown, &sats[0]);
+        kdtree_free(grown);
+    }
+    insert = g_timer_elapsed(timer, NULL) / REPEAT;
+
+    g_timer_start(timer);
+    for (guint k = 0; k < REPEAT; k++) sat_kdtree_rebuild(tree, table);
+    build = g_timer_elapsed(timer, NULL) / REPEAT;
+
+    g_timer_start(timer);
+    for (guint i = 0; i < n; i++) found += sat_kdtree_find_nearest_other(tree, &sats[i]) != NULL;
+    nearest = g_timer_elapsed(timer, NULL) / n;
+
+    g_timer_start(timer);
+    for (guint i = 0; i < n; i++) sat_kdtree_find_k_nearest(tree, &sats[i], KNN, near, dist);
+    knn = g_timer_elapsed(timer, NULL) / n;
+
+    g_timer_start(timer);
+    for (guint i = 0; i < n; i++) in_range += sat_kdtree_find_in_range(tree, &sats[i], LINK_RANGE, near, n);
+    range = g_timer_elapsed(timer, NULL) / n;
+
+    printf("%6u satellites %-11s  insert %8.3f ms  median build %8.3f ms  nearest other %7.3f us (%u found)"
+           "  %d nearest %7.3f us  within %.0f km %8.3f us (%.1f each)\n",
+           n, backends[b].name, insert * 1e3, build * 1e3, nearest * 1e6, found,
+           KNN, knn * 1e6, LINK_RANGE, range * 1e6, (gdouble)in_range / n);
+
+    kdtree_free(tree);
+    g_free(near);
+    g_timer_destroy(timer);
+}
+
+static void run(guint n, GRand *rand) {
+    sat_t *sats = g_new0(sat_t, n);
+    GHashTable *table = g_hash_table_new(g_int_hash, g_int_equal);
+
+    for (guint i = 0; i < n; i++) {
+        gdouble r = xkmper + g_rand_double_range(rand, 400, 1500);
+        gdouble lat = asin(g_rand_double_range(rand, -1, 1));
+        gdouble lon = g_rand_double_range(rand, -G_PI, G_PI);
+        sats[i].tle.catnr = i;
+        sats[i].pos.x = r * cos(lat) * cos(lon);
+        sats[i].pos.y = r * cos(lat) * sin(lon);
+        sats[i].pos.z = r * sin(lat);
+        g_hash_table_insert(table, &sats[i].tle.catnr, &sats[i]);
+    }
+
+    for (guint b = 0; b < G_N_ELEMENTS(backends); b++) run_backend(b, sats, n, table);
+
+    g_hash_table_destroy(table);
+    g_free(sats);
+}
+
+int main(int argc, char *argv[]) {
+    GRand *rand = g_rand_new_with_seed(38);
+    guint sizes[] = {1000, 5000, 20000};
+
+    if (argc > 1) {
+        for (gint i = 1; i < argc; i++) run((guint)g_ascii_strtoull(argv[i], NULL, 10), rand);
+    } else {
+        for (guint i = 0; i < G_N_ELEMENTS(sizes); i++) run(sizes[i], rand);
+    }
+
+    g_rand_free(rand);
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include <string.h>
+#include "../../sat-kdtree-utils.h"
+#include "test-headers.h"
+
+static gdouble dist2(const gdouble *a, const gdouble *b) {
+    return (a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]);
+}
+
+// The median built tree answers like a scan over all points
+void kdtree_build_nearest_test() {
+    const guint n = 2000;
+    GRand *rand = g_rand_new_with_seed(38);
+    gdouble *coords = g_new(gdouble, 3 * n);
+    gpointer *data = g_new(gpointer, n);
+
+    for (guint i = 0; i < 3 * n; i++)
+        coords[i] = g_rand_double_range(rand, -8000, 8000);
+    // repeated coordinates along the split axes
+    for (guint i = 0; i < n; i += 7)
+        coords[3 * i] = 100;
+    for (guint i = 0; i < n; i++)
+        data[i] = GUINT_TO_POINTER(i + 1);
+
+    Kdtree *tree = kdtree_new(3);
+    g_assert_true(kdtree_build(tree, coords, data, n));
+
+    for (guint q = 0; q < 300; q++) {
+        gdouble p[3], found[3];
+        guint best = 0;
+        for (guint k = 0; k < 3; k++) p[k] = g_rand_double_range(rand, -9000, 9000);
+        for (guint i = 1; i < n; i++)
+            if (dist2(p, coords + 3 * i) < dist2(p, coords + 3 * best)) best = i;
+
+        gpointer item = kdtree_nearest3(tree, p[0], p[1], p[2], &found[0], &found[1], &found[2]);
+        g_assert_nonnull(item);
+        g_assert_cmpfloat(dist2(p, found), ==, dist2(p, coords + 3 * best));
+
+        struct kdres *res = kd_nearest_range(tree->tree, p, 1500);
+        guint inside = 0;
+        for (guint i = 0; i < n; i++)
+            inside += dist2(p, coords + 3 * i) <= 1500 * 1500;
+        g_assert_cmpint(kd_res_size(res), ==, (gint)inside);
+        kd_res_free(res);
+    }
+
+    // building again replaces the old points
+    g_assert_true(kdtree_build(tree, coords, data, 1));
+    g_assert_true(kdtree_nearest3(tree, 0, 0, 0, NULL, NULL, NULL) == data[0]);
+    g_assert_true(kdtree_build(tree, NULL, NULL, 0));
+    g_assert_null(kdtree_nearest3(tree, 0, 0, 0, NULL, NULL, NULL));
+
+    kdtree_free(tree);
+    g_free(coords);
+    g_free(data);
+    g_rand_free(rand);
+}
+
+// Nearest other satellite follows the satellites after a rebuild
+void sat_kdtree_rebuild_test() {
+    const gint n = 50;
+    GRand *rand = g_rand_new_with_seed(39);
+    sat_t *sats = g_new0(sat_t, n);
+    GHashTable *table = g_hash_table_new(g_int_hash, g_int_equal);
+    Kdtree *tree = sat_kdtree_create();
+
+    for (gint i = 0; i < n; i++) {
+        sats[i].tle.catnr = i;
+        g_hash_table_insert(table, &sats[i].tle.catnr, &sats[i]);
+    }
+
+    for (gint step = 0; step < 3; step++) {
+        for (gint i = 0; i < n; i++) {
+            sats[i].pos.x = g_rand_double_range(rand, -7000, 7000);
+            sats[i].pos.y = g_rand_double_range(rand, -7000, 7000);
+            sats[i].pos.z = g_rand_double_range(rand, -7000, 7000);
+        }
+        sat_kdtree_rebuild(tree, table);
+
+        for (gint i = 0; i < n; i++) {
+            gdouble p[3] = {sats[i].pos.x, sats[i].pos.y, sats[i].pos.z};
+            gdouble best = G_MAXDOUBLE;
+            for (gint j = 0; j < n; j++) {
+                gdouble o[3] = {sats[j].pos.x, sats[j].pos.y, sats[j].pos.z};
+                if (j != i) best = MIN(best, dist2(p, o));
+            }
+
+            sat_t *nearest = sat_kdtree_find_nearest_other(tree, &sats[i]);
+            g_assert_nonnull(nearest);
+            g_assert_true(nearest != &sats[i]);
+            gdouble o[3] = {nearest->pos.x, nearest->pos.y, nearest->pos.z};
+            g_assert_cmpfloat(dist2(p, o), ==, best);
+        }
+    }
+
+    kdtree_free(tree);
+    g_hash_table_destroy(table);
+    g_free(sats);
+    g_rand_free(rand);
+}
+
+static int cmp_double(const void *a, const void *b) {
+    gdouble x = *(const gdouble *)a, y = *(const gdouble *)b;
+    return (x > y) - (x < y);
+}
+
+// k nearest and radius queries against sorted distances to every point
+void kdtree_knn_range_test() {
+    const guint n = 1500;
+    GRand *rand = g_rand_new_with_seed(40);
+    gdouble *coords = g_new(gdouble, 3 * n);
+    gpointer *data = g_new(gpointer, n);
+    gdouble *sorted = g_new(gdouble, n);
+    gpointer found[32];
+    gdouble found_d2[32];
+
+    for (guint i = 0; i < 3 * n; i++)
+        coords[i] = g_rand_double_range(rand, -8000, 8000);
+    for (guint i = 0; i < n; i++)
+        data[i] = &coords[3 * i];
+
+    Kdtree *tree = kdtree_new(3);
+    g_assert_true(kdtree_build(tree, coords, data, n));
+
+    for (guint q = 0; q < 100; q++) {
+        guint self = g_rand_int_range(rand, 0, n);
+        const gdouble *p = &coords[3 * self];
+        guint k = 1 + q % 32;
+
+        // the query point is in the tree, skipping it leaves the others
+        guint m = 0;
+        for (guint i = 0; i < n; i++)
+            if (i != self) sorted[m++] = dist2(p, coords + 3 * i);
+        qsort(sorted, m, sizeof(gdouble), cmp_double);
+
+        g_assert_cmpuint(kdtree_nearest_k(tree, p, k, data[self], found, found_d2), ==, k);
+        for (guint i = 0; i < k; i++) {
+            g_assert_true(found[i] != data[self]);
+            g_assert_cmpfloat(found_d2[i], ==, sorted[i]);
+            g_assert_cmpfloat(dist2(p, found[i]), ==, found_d2[i]);
+        }
+
+        // without skipping the point finds itself first
+        g_assert_cmpuint(kdtree_nearest_k(tree, p, 1, NULL, found, found_d2), ==, 1);
+        g_assert_true(found[0] == data[self]);
+
+        gdouble range = 0.5 * (sqrt(sorted[k - 1]) + sqrt(sorted[k]));
+        guint in_range = kdtree_within(tree, p, range, data[self], found, found_d2, 32);
+        g_assert_cmpuint(in_range, ==, k);
+        for (guint i = 0; i < in_range; i++) {
+            g_assert_true(found[i] != data[self]);
+            g_assert_cmpfloat(found_d2[i], <=, range * range);
+        }
+
+        // too short a buffer still reports how many are in range
+        g_assert_cmpuint(kdtree_within(tree, p, range, data[self], found, NULL, k / 2), ==, k);
+    }
+
+    // result set form comes back ordered
+    struct kdres *res = kd_nearest_n3(tree->tree, 0, 0, 0, 10);
+    gdouble origin[3] = {0, 0, 0}, last = -1;
+    g_assert_cmpint(kd_res_size(res), ==, 10);
+    while (!kd_res_end(res)) {
+        gdouble at[3];
+        kd_res_item(res, at);
+        g_assert_cmpfloat(dist2(origin, at), >=, last);
+        last = dist2(origin, at);
+        kd_res_next(res);
+    }
+    kd_res_free(res);
+
+    kdtree_free(tree);
+    g_free(sorted);
+    g_free(coords);
+    g_free(data);
+    g_rand_free(rand);
+}
+
+// Every backend gives the same neighbours, single precision to float accuracy
+void kdtree_backends_test() {
+    const KdtreeBackend backends[] = {KDTREE_BACKEND_NODES, KDTREE_BACKEND_FLAT, KDTREE_BACKEND_FLAT_FLOAT};
+    const guint n = 3000;
+    GRand *rand = g_rand_new_with_seed(41);
+    gdouble *coords = g_new(gdouble, 3 * n);
+    gpointer *data = g_new(gpointer, n);
+    gdouble *sorted = g_new(gdouble, n);
+    gpointer found[16];
+    gdouble found_d2[16];
+
+    for (guint i = 0; i < 3 * n; i++)
+        coords[i] = g_rand_double_range(rand, -8000, 8000);
+    for (guint i = 0; i < n; i++)
+        data[i] = &coords[3 * i];
+
+    for (guint b = 0; b < G_N_ELEMENTS(backends); b++) {
+        Kdtree *tree = kdtree_new_backend(3, backends[b]);
+        gdouble tol = backends[b] == KDTREE_BACKEND_FLAT_FLOAT ? 1e-5 : 0;
+
+        // points inserted one at a time are picked up by the next query
+        for (guint i = 0; i < n / 2; i++)
+            g_assert_true(kdtree_insert(tree, &coords[3 * i], data[i]));
+        g_assert_true(kdtree_nearest3(tree, coords[0], coords[1], coords[2], NULL, NULL, NULL) == data[0]);
+        g_assert_true(kdtree_build(tree, coords, data, n));
+
+        for (guint q = 0; q < 200; q++) {
+            guint self = g_rand_int_range(rand, 0, n);
+            const gdouble *p = &coords[3 * self];
+            guint k = 1 + q % 16, m = 0;
+
+            for (guint i = 0; i < n; i++)
+                if (i != self) sorted[m++] = dist2(p, coords + 3 * i);
+            qsort(sorted, m, sizeof(gdouble), cmp_double);
+
+            g_assert_cmpuint(kdtree_nearest_k(tree, p, k, data[self], found, found_d2), ==, k);
+            for (guint i = 0; i < k; i++) {
+                g_assert_true(found[i] != data[self]);
+                g_assert_cmpfloat(fabs(found_d2[i] - sorted[i]), <=, tol * sorted[i]);
+                g_assert_cmpfloat(fabs(dist2(p, found[i]) - sorted[i]), <=, tol * sorted[i]);
+            }
+
+            gdouble range = 0.5 * (sqrt(sorted[k - 1]) + sqrt(sorted[k]));
+            g_assert_cmpuint(kdtree_within(tree, p, range, data[self], found, NULL, 16), ==, k);
+            for (guint i = 0; i < k; i++)
+                g_assert_cmpfloat(dist2(p, found[i]), <=, sorted[k - 1] * (1 + tol));
+        }
+
+        kdtree_free(tree);
+    }
+
+    g_free(sorted);
+    g_free(coords);
+    g_free(data);
+    g_rand_free(rand);
+}
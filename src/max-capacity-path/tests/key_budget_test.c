@@ -0,0 +1,134 @@
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include "../key-budget.h"
+#include "../fibre-backbone.h"
+#include "../../qth-data.h"
+#include "../../skr-utils.h"
+#include "../../sgpsdp/sgp4sdp4.h"
+
+#include "test-headers.h"
+
+void key_budget_fibre_test() {
+    qth_t ogs1 = {.name="ogs1", .alt=0, .lat=45.0, .lon=-75.0};
+    qth_t ogs2 = {.name="ogs2", .alt=0, .lat=45.5, .lon=-75.0};
+    GSList *stations = g_slist_append(NULL, &ogs1);
+    stations = g_slist_append(stations, &ogs2);
+
+    GHashTable *fibre = fibre_backbone_from_distance(stations, FIBRE_DEFAULT_MAX_DISTANCE);
+    GHashTable *history = g_hash_table_new(g_int_hash, g_int_equal);
+    gdouble rate = lw_fibre_link(ground_distance(&ogs1, &ogs2));
+
+    KeyBudgetParams params = {
+        .t_start = 2460000.5,
+        .t_step = 0.01,
+        .threads = 2,
+        .station_consumption = rate / 2,
+        .fibre = fibre
+    };
+
+    key_budget_t *budget = run_key_budget(NULL, history, 11, stations, &params);
+
+    g_assert_cmpuint(budget->links->len, ==, 1);
+    g_assert_cmpuint(budget->events->len, ==, 1);
+    g_assert_true(g_array_index(budget->events, key_event_t, 0).type == key_LINK_UP);
+
+    key_link_t *link = &g_array_index(budget->links, key_link_t, 0);
+    g_assert_cmpfloat_with_epsilon(link->total, rate * 10 * 0.01, 1e-6 * rate);
+    g_assert_cmpfloat_with_epsilon(link->series[5], rate * 5 * 0.01, 1e-6 * rate);
+
+    //both ends hold the key, half of it is consumed
+    for (guint p = 0; p < 2; p++) {
+        key_pool_t *kp = &g_array_index(budget->pools, key_pool_t, p);
+        g_assert_cmpfloat_with_epsilon(kp->generated, link->total, 1e-6 * rate);
+        g_assert_cmpfloat_with_epsilon(kp->series[10], link->total / 2, 1e-6 * rate);
+        g_assert_cmpfloat(kp->deficit, ==, 0);
+    }
+    key_budget_free(budget);
+
+    //pool that can't hold a single step of key
+    params.pool_capacity = rate * 0.001;
+    params.station_consumption = rate;
+    budget = run_key_budget(NULL, history, 11, stations, &params);
+
+    key_pool_t *kp = &g_array_index(budget->pools, key_pool_t, 0);
+    g_assert_cmpfloat(kp->overflow, >, 0);
+    g_assert_cmpfloat(kp->deficit, >, 0);
+    g_assert_cmpfloat(kp->series[10], <=, params.pool_capacity);
+
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "key_budget_test.csv", NULL);
+    gchar *contents = NULL;
+    g_assert_true(key_budget_save_totals(budget, filename));
+    g_assert_true(g_file_get_contents(filename, &contents, NULL, NULL));
+    g_assert_true(g_str_has_prefix(contents, "node,generated"));
+    g_free(contents);
+
+    g_assert_true(key_budget_save_series(budget, filename));
+    g_assert_true(g_file_get_contents(filename, &contents, NULL, NULL));
+    g_assert_true(g_str_has_prefix(contents, "time,ogs1,ogs2"));
+    g_free(contents);
+
+    g_remove(filename);
+    g_free(filename);
+    key_budget_free(budget);
+    fibre_backbone_free(fibre);
+    g_hash_table_destroy(history);
+    g_slist_free(stations);
+}
+
+void key_budget_pass_test() {
+    qth_t ogs = {.name="ogs", .alt=0, .lat=45, .lon=10};
+    geodetic_t geo = {.lat = 45 * de2ra, .lon = 10 * de2ra, .alt = 0, .theta = 0};
+    vector_t pos, vel;
+    gdouble step = 0.0006944444444;
+    gdouble jul_utc = 2460000.5;
+
+    //overhead for two samples then on the other side of the earth
+    lw_sat_t sat_hist[4];
+    for (guint i = 0; i < 4; i++) {
+        Calculate_User_PosVel(jul_utc + i * step, &geo, &pos, &vel);
+        Magnitude(&pos);
+        gdouble scale = (i < 2 ? 1 : -1) * (pos.w + 500) / pos.w;
+
+        sat_hist[i].pos = (vector_t){.x = pos.x * scale, .y = pos.y * scale, .z = pos.z * scale};
+        sat_hist[i].vel = vel;
+        sat_hist[i].jul_utc = jul_utc + i * step;
+    }
+
+    sat_t sat = {.name = "sat", .nickname = "sat"};
+    sat.tle.catnr = 1;
+    GSList *sats = g_slist_append(NULL, &sat);
+    GSList *stations = g_slist_append(NULL, &ogs);
+
+    GHashTable *history = g_hash_table_new(g_int_hash, g_int_equal);
+    g_hash_table_insert(history, &sat.tle.catnr, sat_hist);
+
+    KeyBudgetParams params = {.t_start = jul_utc, .t_step = step, .threads = 1};
+    key_budget_t *budget = run_key_budget(sats, history, 4, stations, &params);
+
+    tdsp_node sat_node = {.node={.id = 1, .type=path_SATELLITE, .obj=&sat}};
+    tdsp_node ogs_node = {.node={.id = -1, .type=path_STATION, .obj=&ogs}};
+    gdouble r0 = MAX(get_inter_node_skr(&sat_node, &ogs_node, sat_hist, NULL, 0),
+                     get_inter_node_skr(&ogs_node, &sat_node, NULL, sat_hist, 0));
+    gdouble r1 = MAX(get_inter_node_skr(&sat_node, &ogs_node, sat_hist, NULL, 1),
+                     get_inter_node_skr(&ogs_node, &sat_node, NULL, sat_hist, 1));
+
+    g_assert_cmpfloat(r0, >, 0);
+    g_assert_cmpuint(budget->links->len, ==, 1);
+
+    key_link_t *link = &g_array_index(budget->links, key_link_t, 0);
+    gdouble expected = 0.5 * (r0 + r1) * step + 0.5 * r1 * step;
+    g_assert_cmpfloat_with_epsilon(link->total, expected, 1e-9 * expected);
+    g_assert_cmpfloat_with_epsilon(link->series[3], expected, 1e-9 * expected);
+
+    g_assert_cmpuint(budget->events->len, ==, 2);
+    key_event_t *up = &g_array_index(budget->events, key_event_t, 0);
+    key_event_t *down = &g_array_index(budget->events, key_event_t, 1);
+    g_assert_true(up->type == key_LINK_UP);
+    g_assert_true(down->type == key_LINK_DOWN);
+    g_assert_cmpfloat_with_epsilon(down->time, jul_utc + 2 * step, 1e-9);
+
+    key_budget_free(budget);
+    g_hash_table_destroy(history);
+    g_slist_free(sats);
+    g_slist_free(stations);
+}
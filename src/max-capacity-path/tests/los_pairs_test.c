@@ -0,0 +1,85 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include "../../los-pairs.h"
+#include "test-headers.h"
+
+// Random shell of satellites between 400 km and GEO altitude
+static los_positions *random_positions(guint n, guint32 seed) {
+    GRand *rand = g_rand_new_with_seed(seed);
+    los_positions *pos = los_positions_new(n);
+
+    for (guint i = 0; i < n; i++) {
+        gdouble r = EARTH_RADIUS + (i % 10 == 0 ? 35786 : g_rand_double_range(rand, 400, 2000));
+        gdouble lat = asin(g_rand_double_range(rand, -1, 1));
+        gdouble lon = g_rand_double_range(rand, -G_PI, G_PI);
+        pos->x[i] = r * cos(lat) * cos(lon);
+        pos->y[i] = r * cos(lat) * sin(lon);
+        pos->z[i] = r * sin(lat);
+    }
+    g_rand_free(rand);
+
+    return pos;
+}
+
+static gboolean *pair_mask(los_positions *pos, GArray *pairs) {
+    gboolean *mask = g_new0(gboolean, pos->n * pos->n);
+
+    for (guint k = 0; k < pairs->len; k++) {
+        SatCsrEdge *edge = &g_array_index(pairs, SatCsrEdge, k);
+        g_assert_cmpuint(edge->a, <, edge->b);
+        g_assert_false(mask[edge->a * pos->n + edge->b]);      //each pair once
+        mask[edge->a * pos->n + edge->b] = TRUE;
+    }
+
+    return mask;
+}
+
+// The grid must find exactly the pairs is_pos_los_clear passes
+void los_pairs_match_all_pairs_test() {
+    los_positions *pos = random_positions(400, 36);
+    GArray *pairs = los_clear_pairs(pos, 0);
+    gboolean *mask = pair_mask(pos, pairs);
+    guint expected = 0;
+
+    for (guint i = 0; i < pos->n; i++) {
+        for (guint j = i + 1; j < pos->n; j++) {
+            vector_t a = {pos->x[i], pos->y[i], pos->z[i], 0};
+            vector_t b = {pos->x[j], pos->y[j], pos->z[j], 0};
+            gboolean clear = is_pos_los_clear(&a, &b);
+            g_assert_cmpint(clear, ==, mask[i * pos->n + j]);
+            expected += clear;
+        }
+    }
+    g_assert_cmpuint(pairs->len, ==, expected);
+    g_assert_cmpuint(expected, >, 0);
+
+    g_free(mask);
+    g_array_free(pairs, TRUE);
+    los_positions_free(pos);
+}
+
+void los_pairs_range_test() {
+    const gdouble range = 1500;
+    los_positions *pos = random_positions(400, 37);
+    GArray *pairs = los_clear_pairs(pos, range);
+    gboolean *mask = pair_mask(pos, pairs);
+
+    for (guint i = 0; i < pos->n; i++) {
+        for (guint j = i + 1; j < pos->n; j++) {
+            vector_t a = {pos->x[i], pos->y[i], pos->z[i], 0};
+            vector_t b = {pos->x[j], pos->y[j], pos->z[j], 0};
+            gdouble d = dist_calc_driver(a.x, a.y, a.z, b.x, b.y, b.z);
+            g_assert_cmpint(d <= range && is_pos_los_clear(&a, &b), ==, mask[i * pos->n + j]);
+        }
+    }
+    for (guint k = 0; k < pairs->len; k++) {
+        SatCsrEdge *edge = &g_array_index(pairs, SatCsrEdge, k);
+        g_assert_cmpfloat_with_epsilon(edge->weight,
+            dist_calc_driver(pos->x[edge->a], pos->y[edge->a], pos->z[edge->a],
+                             pos->x[edge->b], pos->y[edge->b], pos->z[edge->b]), 1e-6);
+    }
+
+    g_free(mask);
+    g_array_free(pairs, TRUE);
+    los_positions_free(pos);
+}
@@ -0,0 +1,76 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include <string.h>
+#include "../path-util.h"
+#include "../../qth-data.h"
+#include "../../sgpsdp/sgp4sdp4.h"
+
+#include "test-headers.h"
+
+//sgpsdp test-001 elements (near earth)
+static const char *test_tle[3] = {
+    "TEST SAT SGP 001",
+    "1 88888U          80275.98708465  .00073094  13844-3  66816-4 0     9",
+    "2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518   103"
+};
+
+static void load_test_sat(sat_t *sat) {
+    char lines[3][80];
+    for (guint l = 0; l < 3; l++) g_strlcpy(lines[l], test_tle[l], 80);
+
+    memset(sat, 0, sizeof(sat_t));
+    g_assert_cmpint(Get_Next_Tle_Set(lines, &sat->tle), ==, 1);
+    select_ephemeris(sat);
+    sat->jul_epoch = Julian_Date_of_Epoch(sat->tle.epoch);
+}
+
+// Tracks are propagated once per satellite node, from its time to the next node's
+void max_path_tracks_test() {
+    sat_t sat;
+    load_test_sat(&sat);
+    sat_t original = sat;
+    qth_t ogs1 = {.name="ogs1", .alt=0, .lat=45.0, .lon=-75.0};
+    qth_t ogs2 = {.name="ogs2", .alt=0, .lat=45.5, .lon=-75.0};
+    gdouble t0 = sat.jul_epoch;
+    gdouble t1 = t0 + 14.5 / 1440.0;
+
+    max_path_t *result = calloc(1, sizeof(max_path_t));
+    path_node nodes[3] = {
+        {.time = t0, .type = path_STATION, .obj = &ogs1},
+        {.time = t0, .type = path_SATELLITE, .obj = &sat},
+        {.time = t1, .type = path_STATION, .obj = &ogs2}
+    };
+    for (guint i = 0; i < 3; i++) {
+        path_node *node = malloc(sizeof(path_node));
+        *node = nodes[i];
+        result->path = g_list_append(result->path, node);
+    }
+
+    GPtrArray *tracks = max_path_tracks(result);
+    g_assert_cmpuint(tracks->len, ==, 3);
+    g_assert_null(g_ptr_array_index(tracks, 0));
+    g_assert_null(g_ptr_array_index(tracks, 2));
+    g_assert_true(max_path_tracks(result) == tracks);
+
+    path_track_t *track = g_ptr_array_index(tracks, 1);
+    g_assert_cmpuint(track->len, ==, 15);
+    g_assert_cmpmem(&sat, sizeof(sat_t), &original, sizeof(sat_t));
+
+    //ends match the satellite at the node times
+    gdouble times[2] = {t0, t1};
+    guint index[2] = {0, track->len - 1};
+    for (guint k = 0; k < 2; k++) {
+        sat_t copy = original;
+        geodetic_t geodetic;
+        sat_at_time(&copy, times[k]);
+        Calculate_LatLonAlt(times[k], &copy.pos, &geodetic);
+        g_assert_cmpfloat_with_epsilon(track->lat[index[k]], Degrees(geodetic.lat), 1e-9);
+        g_assert_cmpfloat_with_epsilon(cos(Radians(track->lon[index[k]])), cos(geodetic.lon), 1e-9);
+    }
+    for (guint i = 0; i < track->len; i++) {
+        g_assert_cmpfloat(track->lon[i], >=, -180);
+        g_assert_cmpfloat(track->lon[i], <=, 180);
+    }
+
+    max_path_free(result);
+}
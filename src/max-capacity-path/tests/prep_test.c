@@ -0,0 +1,135 @@
+#include <glib/gi18n.h>
+#include <string.h>
+#include "../search-prep.h"
+#include "../satellite-history.h"
+#include "../../qth-data.h"
+#include "../../sgpsdp/sgp4sdp4.h"
+
+#include "test-headers.h"
+
+//sgpsdp test-001 (near earth) and test-002 (deep space) elements
+static const char *test_tle[2][3] = {
+    {"TEST SAT SGP 001",
+     "1 88888U          80275.98708465  .00073094  13844-3  66816-4 0     9",
+     "2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518   103"},
+    {"TEST SAT SDP 001",
+     "1 11801U          80230.29629788  .01431103  00000-0  14311-1 0     2",
+     "2 11801  46.7916 230.4354 7318036  47.4722  10.4117  2.28537848     2"}
+};
+
+typedef struct {
+    gdouble t_start;
+    gdouble t_step;
+    guint len;
+    guint stations;
+} loader_call;
+
+static void load_test_sat(sat_t *sat, guint i) {
+    char lines[3][80];
+    for (guint l = 0; l < 3; l++) g_strlcpy(lines[l], test_tle[i][l], 80);
+
+    memset(sat, 0, sizeof(sat_t));
+    g_assert_cmpint(Get_Next_Tle_Set(lines, &sat->tle), ==, 1);
+    select_ephemeris(sat);
+    sat->jul_epoch = Julian_Date_of_Epoch(sat->tle.epoch);
+}
+
+static GHashTable *fake_weather(gpointer user_data, GSList *ground_stations, gdouble t_start, gdouble t_step, guint len) {
+    loader_call *call = (loader_call *)user_data;
+    call->t_start = t_start;
+    call->t_step = t_step;
+    call->len = len;
+    call->stations = g_slist_length(ground_stations);
+
+    //stands in for file reads
+    g_usleep(50000);
+
+    GHashTable *weather = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, lw_weather_free);
+    for (GSList *elm = ground_stations; elm != NULL; elm = elm->next) {
+        lw_weather_t *w = lw_weather_new(len);
+        for (guint i = 0; i < len; i++) {
+            w->vis[i] = 10;
+            w->cn2[i] = 1e-15;
+        }
+        g_hash_table_insert(weather, ((qth_t *)elm->data)->name, w);
+    }
+
+    return weather;
+}
+
+void prep_matches_history_test() {
+    sat_t sats[2];
+    load_test_sat(&sats[0], 0);
+    load_test_sat(&sats[1], 1);
+    GSList *list = g_slist_append(NULL, &sats[0]);
+    list = g_slist_append(list, &sats[1]);
+
+    PrepParams params = {
+        .t_start = sats[0].jul_epoch,
+        .t_end = sats[0].jul_epoch + 0.5,
+        .t_step = 1.0 / 1440.0,
+        .threads = 2
+    };
+
+    guint expected_len = 0;
+    GHashTable *expected = generate_sat_pos_data(list, &expected_len, params.t_start, params.t_end, params.t_step);
+    search_prep_t *prep = prepare_search(list, NULL, &params);
+
+    g_assert_cmpuint(prep->sat_hist_len, ==, expected_len);
+    g_assert_null(prep->weather);
+    g_assert_cmpuint(g_hash_table_size(prep->sat_history), ==, 2);
+
+    for (guint s = 0; s < 2; s++) {
+        lw_sat_t *a = g_hash_table_lookup(expected, &sats[s].tle.catnr);
+        lw_sat_t *b = g_hash_table_lookup(prep->sat_history, &sats[s].tle.catnr);
+
+        g_assert_nonnull(b);
+        g_assert_cmpmem(a, expected_len * sizeof(lw_sat_t), b, expected_len * sizeof(lw_sat_t));
+    }
+
+    search_prep_free(prep);
+    g_hash_table_destroy(expected);
+    g_slist_free(list);
+}
+
+void prep_weather_loader_test() {
+    sat_t sat;
+    load_test_sat(&sat, 0);
+    GSList *list = g_slist_append(NULL, &sat);
+
+    qth_t ogs1 = {.name="ogs1", .alt=0, .lat=45.0, .lon=-75.0};
+    qth_t ogs2 = {.name="ogs2", .alt=0, .lat=45.5, .lon=-75.0};
+    GSList *stations = g_slist_append(NULL, &ogs1);
+    stations = g_slist_append(stations, &ogs2);
+
+    loader_call call = {0};
+    PrepParams params = {
+        .t_start = sat.jul_epoch,
+        .t_end = sat.jul_epoch + 0.1,
+        .t_step = 0.01,
+        .threads = 1,
+        .load_weather = fake_weather,
+        .loader_data = &call
+    };
+
+    search_prep_t *prep = prepare_search(list, stations, &params);
+
+    //loader sees the history grid
+    g_assert_cmpfloat(call.t_start, ==, params.t_start);
+    g_assert_cmpfloat(call.t_step, ==, params.t_step);
+    g_assert_cmpuint(call.len, ==, prep->sat_hist_len);
+    g_assert_cmpuint(call.stations, ==, 2);
+
+    g_assert_nonnull(prep->weather);
+    lw_weather_t *w = g_hash_table_lookup(prep->weather, "ogs2");
+    g_assert_nonnull(w);
+    g_assert_cmpuint(w->len, ==, prep->sat_hist_len);
+
+    g_assert_cmpfloat(prep->weather_time, >=, 0.04);
+    g_assert_cmpfloat(prep->total_time, >=, prep->weather_time);
+    g_assert_cmpfloat(prep->total_time, >=, prep->propagation_time);
+
+    search_prep_free(prep);
+    g_slist_free(stations);
+    g_slist_free(list);
+}
@@ -0,0 +1,71 @@
+#include <glib/gi18n.h>
+#include <math.h>
+#include "../../range-circle.h"
+#include "../../sgpsdp/sgp4sdp4.h"
+#include "test-headers.h"
+
+static gdouble arccos(gdouble x, gdouble y) {
+    if (x && y) {
+        if (y > 0.0)
+            return acos(x / y);
+        else if (y < 0.0)
+            return pi + acos(x / y);
+    }
+    return 0.0;
+}
+
+// The range circle the maps computed per point before the template
+static void direct_half(gdouble ssplat, gdouble ssplon, gdouble beta, gboolean north_pole,
+                        gdouble *lat, gdouble *lon) {
+    ssplat *= de2ra;
+    ssplon *= de2ra;
+    for (guint azi = 0; azi < RANGE_CIRCLE_POINTS; azi++) {
+        gdouble azimuth = de2ra * (double)azi;
+        gdouble rangelat = asin(sin(ssplat) * cos(beta) + cos(azimuth) * sin(beta) * cos(ssplat));
+        gdouble num = cos(beta) - (sin(ssplat) * sin(rangelat));
+        gdouble dem = cos(ssplat) * cos(rangelat);
+        gdouble rangelon;
+
+        if (azi == 0 && north_pole)
+            rangelon = ssplon + pi;
+        else if (fabs(num / dem) > 1.0)
+            rangelon = ssplon;
+        else
+            rangelon = ssplon - arccos(num, dem);
+
+        while (rangelon < -pi) rangelon += twopi;
+        while (rangelon > pi) rangelon -= twopi;
+
+        lat[azi] = rangelat / de2ra;
+        lon[azi] = rangelon / de2ra;
+    }
+}
+
+// Template points match the direct computation, also around and across the poles
+void range_circle_match_test() {
+    const gdouble lats[] = {0.0, 12.5, -33.0, 51.7, -64.0, 80.0, -88.0, 89.9};
+    const gdouble lons[] = {0.0, 179.8, -179.9, 45.0};
+    const gdouble footprints[] = {100.0, 4500.0, 9000.0, 16000.0};   // km, LEO to GEO
+    gdouble lat[RANGE_CIRCLE_POINTS], lon[RANGE_CIRCLE_POINTS];
+    gdouble want_lat[RANGE_CIRCLE_POINTS], want_lon[RANGE_CIRCLE_POINTS];
+
+    for (guint i = 0; i < G_N_ELEMENTS(lats); i++) {
+        for (guint j = 0; j < G_N_ELEMENTS(lons); j++) {
+            for (guint k = 0; k < G_N_ELEMENTS(footprints); k++) {
+                gdouble beta = 0.5 * footprints[k] / xkmper;
+                // covered when the pole is within beta of the sub-satellite point
+                gboolean north = (90.0 - lats[i]) * de2ra <= beta;
+
+                range_circle_half(lats[i], lons[j], beta, north, lat, lon);
+                direct_half(lats[i], lons[j], beta, north, want_lat, want_lon);
+
+                for (guint a = 0; a < RANGE_CIRCLE_POINTS; a++) {
+                    gdouble dlon = fabs(lon[a] - want_lon[a]);
+                    g_assert_cmpfloat_with_epsilon(lat[a], want_lat[a], 1e-9);
+                    // acos near 1 turns rounding into ~1e-6 degrees, far below a pixel
+                    g_assert_cmpfloat(MIN(dlon, 360.0 - dlon), <, 1e-5);
+                }
+            }
+        }
+    }
+}
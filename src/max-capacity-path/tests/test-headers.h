@@ -37,5 +37,52 @@ void tdsp_multi_paths_1_correct_test();
 
 void tdsp_end_transfers_away_test();
 
+void ensemble_sample_deterministic_test();
 
+void ensemble_percentile_test();
 
+void ensemble_weather_lowers_skr_test();
+
+void fibre_backbone_distance_test();
+
+void fibre_backbone_file_test();
+
+void fibre_transfer_time_test();
+
+void key_budget_fibre_test();
+
+void key_budget_pass_test();
+
+void prep_matches_history_test();
+
+void prep_weather_loader_test();
+
+void max_path_tracks_test();
+
+void graph_dijkstra_test();
+
+void graph_prim_test();
+
+void graph_widest_test();
+
+void los_pairs_match_all_pairs_test();
+
+void los_pairs_range_test();
+
+void kdtree_build_nearest_test();
+
+void sat_kdtree_rebuild_test();
+
+void kdtree_knn_range_test();
+
+void kdtree_backends_test();
+
+void range_circle_match_test();
+
+void event_finder_scan_test();
+
+void event_finder_budget_test();
+
+void event_queue_budget_test();
+
+void event_queue_expire_test();
@@ -35,5 +35,55 @@ int main (int argc, char *argv[]) {
 
     g_test_add_func("/tdsp_test.c/tdsp_end_transfers_away_test", tdsp_end_transfers_away_test);
 
+    g_test_add_func("/ensemble_test.c/ensemble_sample_deterministic_test", ensemble_sample_deterministic_test);
+
+    g_test_add_func("/ensemble_test.c/ensemble_percentile_test", ensemble_percentile_test);
+
+    g_test_add_func("/ensemble_test.c/ensemble_weather_lowers_skr_test", ensemble_weather_lowers_skr_test);
+
+    g_test_add_func("/fibre_test.c/fibre_backbone_distance_test", fibre_backbone_distance_test);
+
+    g_test_add_func("/fibre_test.c/fibre_backbone_file_test", fibre_backbone_file_test);
+
+    g_test_add_func("/fibre_test.c/fibre_transfer_time_test", fibre_transfer_time_test);
+
+    g_test_add_func("/key_budget_test.c/key_budget_fibre_test", key_budget_fibre_test);
+
+    g_test_add_func("/key_budget_test.c/key_budget_pass_test", key_budget_pass_test);
+
+    g_test_add_func("/prep_test.c/prep_matches_history_test", prep_matches_history_test);
+
+    g_test_add_func("/prep_test.c/prep_weather_loader_test", prep_weather_loader_test);
+
+    g_test_add_func("/path_util_test.c/max_path_tracks_test", max_path_tracks_test);
+
+    g_test_add_func("/graph_test.c/graph_dijkstra_test", graph_dijkstra_test);
+
+    g_test_add_func("/graph_test.c/graph_prim_test", graph_prim_test);
+
+    g_test_add_func("/graph_test.c/graph_widest_test", graph_widest_test);
+
+    g_test_add_func("/los_pairs_test.c/los_pairs_match_all_pairs_test", los_pairs_match_all_pairs_test);
+
+    g_test_add_func("/los_pairs_test.c/los_pairs_range_test", los_pairs_range_test);
+
+    g_test_add_func("/kdtree_test.c/kdtree_build_nearest_test", kdtree_build_nearest_test);
+
+    g_test_add_func("/kdtree_test.c/sat_kdtree_rebuild_test", sat_kdtree_rebuild_test);
+
+    g_test_add_func("/kdtree_test.c/kdtree_knn_range_test", kdtree_knn_range_test);
+
+    g_test_add_func("/kdtree_test.c/kdtree_backends_test", kdtree_backends_test);
+
+    g_test_add_func("/range_circle_test.c/range_circle_match_test", range_circle_match_test);
+
+    g_test_add_func("/event_finder_test.c/event_finder_scan_test", event_finder_scan_test);
+
+    g_test_add_func("/event_finder_test.c/event_finder_budget_test", event_finder_budget_test);
+
+    g_test_add_func("/event_queue_test.c/event_queue_budget_test", event_queue_budget_test);
+
+    g_test_add_func("/event_queue_test.c/event_queue_expire_test", event_queue_expire_test);
+
     return g_test_run();
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "../skr-utils.h"
 #include "../sgpsdp/sgp4sdp4.h"
 #include "satellite-history.h"
+#include "fibre-backbone.h"
 
 
 gdouble accum_pre_start(gdouble x_i_mid, gint start_i, gdouble t_start, gdouble time_step, tdsp_node *src, tdsp_node *dst, lw_sat_t *src_hist, lw_sat_t *dst_hist);
@@ -19,6 +20,15 @@ gdouble get_transfer_time(
         gdouble t_end,
         gdouble time_step) {
     
+    //fibre between ground stations has constant rate, no history lookups
+    if (src->node.type == path_STATION && dst->node.type == path_STATION) {
+        gdouble rate = fibre_edge_rate(src, dst);
+        if (rate <= 0) return G_MAXDOUBLE;
+
+        gdouble arrival = time + data_size / rate;
+        return (arrival > t_end ? G_MAXDOUBLE : arrival);
+    }
+
     lw_sat_t *src_sat_history = NULL;
     lw_sat_t *dst_sat_history = NULL;
 
@@ -36,6 +36,7 @@
 #include <glib.h>
 #include <glib/gi18n.h>
 
+#include "event-finder.h"
 #include "gtk-sat-data.h"
 #include "orbit-tools.h"
 #include "predict-tools.h"
@@ -44,14 +45,28 @@
 #include "sgpsdp/sgp4sdp4.h"
 #include "time-tools.h"
 
+/* State shared by the batch prediction workers */
+typedef struct {
+    qth_t          *qth;
+    const pass_cfg_t *cfg;
+    pass_batch_cb   done;
+    gpointer        data;
+    gint            stop;       /* set when done asked to skip the rest */
+} pass_batch_shared_t;
+
 static pass_t  *get_pass_engine(sat_t * sat_in, qth_t * qth, gdouble start,
-                                gdouble maxdt, gdouble min_el);
+                                gdouble maxdt, gdouble min_el,
+                                const pass_cfg_t * cfg);
 
 /**
  * \brief SGP4SDP4 driver for doing AOS/LOS calculations.
  * \param sat Pointer to the satellite data.
  * \param qth Pointer to the QTH data.
  * \param t The time for calculation (Julian Date)
+ *
+ * This is called from worker threads for different satellites at once, so
+ * it must only write to sat and must not touch global state such as the
+ * SGP4/SDP4 Flags.
  */
 void predict_calc(sat_t * sat, qth_t * qth, gdouble t)
 {
@@ -121,88 +136,19 @@ void predict_calc(sat_t * sat, qth_t * qth, gdouble t)
  * \return The time of the next AOS or 0.0 if the satellite has no AOS.
  *
  * This function finds the time of AOS for the first coming pass taking place
- * no earlier that start.
- * If the satellite is currently within range, the function first calls
- * find_los to get the next LOS time. Then the calculations are done using
- * the new start time.
+ * no earlier that start. If the satellite is currently within range, the
+ * current pass is skipped.
+ * The search brackets the horizon crossing and refines it with Brent's
+ * method, see event-finder.c. It gives up after EVENT_MAX_EVALS orbit
+ * propagations, also when there is no time limit.
  */
 gdouble find_aos(sat_t * sat, qth_t * qth, gdouble start, gdouble maxdt)
 {
-    gdouble         t = start;
-    gdouble         aostime = 0.0;
-
-    /* make sure current sat values are in sync with the time */
-    predict_calc(sat, qth, start);
-
     /* check whether satellite has aos */
     if (!has_aos(sat, qth))
         return 0.0;
 
-    if (sat->el > 0.0)
-        t = find_los(sat, qth, start, maxdt) + 0.014;   // +20 min
-
-    /* invalid time (potentially returned by find_los) */
-    if (t < 0.1)
-        return 0.0;
-
-    /* update satellite data */
-    predict_calc(sat, qth, t);
-
-    /* use upper time limit */
-    if (maxdt > 0.0)
-    {
-
-        /* coarse time steps */
-        while ((sat->el < -1.0) && (t <= (start + maxdt)))
-        {
-            t -= 0.00035 * (sat->el * ((sat->alt / 8400.0) + 0.46) - 2.0);
-            predict_calc(sat, qth, t);
-        }
-
-        /* fine steps */
-        while ((aostime == 0.0) && (t <= (start + maxdt)))
-        {
-
-            if (fabs(sat->el) < 0.005)
-            {
-                aostime = t;
-            }
-            else
-            {
-                t -= sat->el * sqrt(sat->alt) / 530000.0;
-                predict_calc(sat, qth, t);
-            }
-
-        }
-
-    }
-    /* don't use upper time limit */
-    else
-    {
-        /* coarse time steps */
-        while (sat->el < -1.0)
-        {
-            t -= 0.00035 * (sat->el * ((sat->alt / 8400.0) + 0.46) - 2.0);
-            predict_calc(sat, qth, t);
-        }
-
-        /* fine steps */
-        while (aostime == 0.0)
-        {
-
-            if (fabs(sat->el) < 0.005)
-            {
-                aostime = t;
-            }
-            else
-            {
-                t -= sat->el * sqrt(sat->alt) / 530000.0;
-                predict_calc(sat, qth, t);
-            }
-        }
-    }
-
-    return aostime;
+    return event_find_aos(sat, qth, start, maxdt, EVENT_RESOLUTION, NULL);
 }
 
 /**
@@ -216,101 +162,17 @@ gdouble find_aos(sat_t * sat, qth_t * qth, gdouble start, gdouble maxdt)
  * \return The time of the next LOS or 0.0 if the satellite has no LOS.
  *
  * This function finds the time of LOS for the first coming pass taking place
- * no earlier that start.
- * If the satellite is currently out of range, the function first calls
- * find_aos to get the next AOS time. Then the calculations are done using
- * the new start time.
- * The function has a built-in watchdog to ensure that we don't end up in
- * lengthy loops.
+ * no earlier that start. If the satellite is currently out of range, this is
+ * the LOS of the next pass.
+ * Like find_aos, the search is bounded by EVENT_MAX_EVALS orbit propagations.
  */
 gdouble find_los(sat_t * sat, qth_t * qth, gdouble start, gdouble maxdt)
 {
-    gdouble         t = start;
-    gdouble         lostime = 0.0;
-    gdouble         eltemp;
-
-    predict_calc(sat, qth, start);
-
     /* check whether satellite has aos */
     if (!has_aos(sat, qth))
-    {
-        return 0.0;
-    }
-
-    if (sat->el < 0.0)
-        t = find_aos(sat, qth, start, maxdt) + 0.001;   // +1.5 min
-
-    /* invalid time (potentially returned by find_aos) */
-    if (t < 0.01)
         return 0.0;
 
-    /* update satellite data */
-    predict_calc(sat, qth, t);
-
-    /* use upper time limit */
-    if (maxdt > 0.0)
-    {
-        /* coarse steps */
-        while ((sat->el >= 1.0) && (t <= (start + maxdt)))
-        {
-            t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
-            predict_calc(sat, qth, t);
-        }
-
-        /* fine steps */
-        while ((lostime == 0.0) && (t <= (start + maxdt)))
-        {
-            t += sat->el * sqrt(sat->alt) / 502500.0;
-            predict_calc(sat, qth, t);
-
-            if (fabs(sat->el) < 0.005)
-            {
-                /* Two things are true at LOS time, the elevation is a zero and
-                   sat is descending. This checks that those two are true. */
-                eltemp = sat->el;
-
-                /* check elevation 1 second earlier */
-                predict_calc(sat, qth, t - 1.0 / 86400.0);
-
-                if (sat->el > eltemp)
-                    lostime = t;
-            }
-        }
-    }
-    /* don't use upper limit */
-    else
-    {
-        /* coarse steps */
-        while (sat->el >= 1.0)
-        {
-            t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
-            predict_calc(sat, qth, t);
-        }
-
-        /* fine steps */
-        while (lostime == 0.0)
-        {
-            t += sat->el * sqrt(sat->alt) / 502500.0;
-            predict_calc(sat, qth, t);
-
-            if (fabs(sat->el) < 0.005)
-            {
-                /* two things are true at LOS time
-                   The elevation is a zero and descending.
-                   This checks that those two are true.
-                 */
-                eltemp = sat->el;
-
-                /*check elevation 1 second earlier */
-                predict_calc(sat, qth, t - 1.0 / 86400.0);
-
-                if (sat->el > eltemp)
-                    lostime = t;
-            }
-        }
-    }
-
-    return lostime;
+    return event_find_los(sat, qth, start, maxdt, EVENT_RESOLUTION, NULL);
 }
 
 /**
@@ -412,12 +274,11 @@ GSList         *get_next_passes(sat_t * sat, qth_t * qth, gdouble maxdt,
  */
 pass_t *get_pass(sat_t * sat_in, qth_t * qth, gdouble start, gdouble maxdt)
 {
-    int      min_ele = sat_cfg_get_int(SAT_CFG_INT_PRED_MIN_EL);
+    pass_cfg_t      cfg;
 
-    if (min_ele == 0)
-        min_ele = 1;
+    load_pass_cfg(&cfg);
 
-    return get_pass_engine(sat_in, qth, start, maxdt, min_ele);
+    return get_pass_engine(sat_in, qth, start, maxdt, cfg.min_el, &cfg);
 }
 
 /**
@@ -434,7 +295,28 @@ pass_t *get_pass(sat_t * sat_in, qth_t * qth, gdouble start, gdouble maxdt)
 pass_t         *get_pass_no_min_el(sat_t * sat_in, qth_t * qth, gdouble start,
                                    gdouble maxdt)
 {
-    return get_pass_engine(sat_in, qth, start, maxdt, 0.0);
+    pass_cfg_t      cfg;
+
+    load_pass_cfg(&cfg);
+
+    return get_pass_engine(sat_in, qth, start, maxdt, 0.0, &cfg);
+}
+
+/**
+ * \brief Read the prediction settings from sat-cfg.
+ * \param cfg The settings to fill in.
+ *
+ * The minimum elevation is the one get_pass uses, 0 is taken as 1 deg.
+ * sat-cfg is not thread safe, so this must be called on the main thread.
+ */
+void load_pass_cfg(pass_cfg_t * cfg)
+{
+    cfg->tres = sat_cfg_get_int(SAT_CFG_INT_PRED_RESOLUTION) / 86400.0;
+    cfg->num_entries = sat_cfg_get_int(SAT_CFG_INT_PRED_NUM_ENTRIES);
+    cfg->min_el = sat_cfg_get_int(SAT_CFG_INT_PRED_MIN_EL);
+
+    if (cfg->min_el == 0.0)
+        cfg->min_el = 1.0;
 }
 
 /**
@@ -443,6 +325,8 @@ pass_t         *get_pass_no_min_el(sat_t * sat_in, qth_t * qth, gdouble start,
  * \param qth Pointer to the location data.
  * \param start Starting time.
  * \param maxdt The maximum number of days to look ahead (0 for no limit).
+ * \param min_el The minimum elevation of the pass.
+ * \param cfg The prediction settings.
  * \return Pointer to a newly allocated pass_t structure or NULL if
  *         there was an error.
  *
@@ -460,7 +344,8 @@ pass_t         *get_pass_no_min_el(sat_t * sat_in, qth_t * qth, gdouble start,
  *       reversed
  */
 static pass_t  *get_pass_engine(sat_t * sat_in, qth_t * qth, gdouble start,
-                                gdouble maxdt, gdouble min_el)
+                                gdouble maxdt, gdouble min_el,
+                                const pass_cfg_t * cfg)
 {
     gdouble         aos = 0.0;  /* time of AOS */
     gdouble         tca = 0.0;  /* time of TCA */
@@ -483,7 +368,7 @@ static pass_t  *get_pass_engine(sat_t * sat_in, qth_t * qth, gdouble start,
     sat = memcpy(&sat_working, sat_in, sizeof(sat_t));
 
     /* get time resolution; sat-cfg stores it in seconds */
-    tres = sat_cfg_get_int(SAT_CFG_INT_PRED_RESOLUTION) / 86400.0;
+    tres = cfg->tres;
 
     /* loop until we find a pass with elevation > SAT_CFG_INT_PRED_MIN_EL
        or we run out of time
@@ -516,7 +401,7 @@ static pass_t  *get_pass_engine(sat_t * sat_in, qth_t * qth, gdouble start,
             dt = los - aos;
 
             /* get time step, which will give us the max number of entries */
-            step = dt / sat_cfg_get_int(SAT_CFG_INT_PRED_NUM_ENTRIES);
+            step = dt / cfg->num_entries;
 
             /* but if this is smaller than the required resolution
                we go with the resolution
@@ -662,10 +547,25 @@ static pass_t  *get_pass_engine(sat_t * sat_in, qth_t * qth, gdouble start,
  *       Therefore, the elements are prepended whereafter the GSList is
  *       reversed
  */
-// causes issues on 2nd iter onwards
-// check for memory leak
 GSList         *get_passes(sat_t * sat, qth_t * qth, gdouble start,
                            gdouble maxdt, guint num)
+{
+    pass_cfg_t      cfg;
+
+    load_pass_cfg(&cfg);
+
+    return get_passes_engine(sat, qth, start, maxdt, num, &cfg);
+}
+
+/**
+ * \brief Predict passes with the given settings.
+ *
+ * Does the work of get_passes without touching sat-cfg, so it can run on
+ * worker threads with settings read by load_pass_cfg on the main thread.
+ */
+GSList         *get_passes_engine(sat_t * sat, qth_t * qth, gdouble start,
+                                  gdouble maxdt, guint num,
+                                  const pass_cfg_t * cfg)
 {
     GSList         *passes = NULL;
     pass_t         *pass = NULL;
@@ -681,7 +581,7 @@ GSList         *get_passes(sat_t * sat, qth_t * qth, gdouble start,
 
     for (i = 0; i < num; i++)
     {
-        pass = get_pass(sat, qth, t, maxdt);
+        pass = get_pass_engine(sat, qth, t, maxdt, cfg->min_el, cfg);
 
         if (pass != NULL)
         {
@@ -720,6 +620,65 @@ GSList         *get_passes(sat_t * sat, qth_t * qth, gdouble start,
     return passes;
 }
 
+/** Thread pool function predicting the passes of one satellite. */
+static void get_passes_batch_job(gpointer data, gpointer user_data)
+{
+    pass_batch_t   *item = data;
+    pass_batch_shared_t *shared = user_data;
+
+    if (g_atomic_int_get(&shared->stop))
+        return;
+
+    item->passes = get_passes_engine(item->sat, shared->qth, item->start,
+                                     item->maxdt, item->num, shared->cfg);
+
+    if (shared->done != NULL && !shared->done(item, shared->data))
+        g_atomic_int_set(&shared->stop, TRUE);
+}
+
+/**
+ * rief Predict passes for several satellites in parallel.
+ * \param items The satellites with their time windows, n of them.
+ * \param n The number of items.
+ * \param qth Pointer to the observer data.
+ * \param cfg Prediction settings from load_pass_cfg.
+ * \param threads Number of worker threads, 0 uses the number of processors.
+ * \param done Called on a worker thread as soon as an item is done, or NULL.
+ * \param data User data for done.
+ *
+ * Each item gets the same passes in item->passes as from get_passes_engine.
+ * The workers never touch sat-cfg and only ever propagate their own copy of
+ * a satellite. When done returns FALSE the items not started yet are
+ * skipped and keep passes = NULL. The function returns when all items are
+ * done or skipped; the passes of each item are then the caller's.
+ */
+void get_passes_batch(pass_batch_t * items, guint n, qth_t * qth,
+                      const pass_cfg_t * cfg, guint threads,
+                      pass_batch_cb done, gpointer data)
+{
+    pass_batch_shared_t shared;
+    GThreadPool    *pool;
+    guint           i;
+
+    shared.qth = qth;
+    shared.cfg = cfg;
+    shared.done = done;
+    shared.data = data;
+    shared.stop = FALSE;
+
+    for (i = 0; i < n; i++)
+        items[i].passes = NULL;
+
+    pool = g_thread_pool_new(get_passes_batch_job, &shared,
+                             threads ? (gint) threads :
+                             (gint) g_get_num_processors(), TRUE, NULL);
+    for (i = 0; i < n; i++)
+        g_thread_pool_push(pool, &items[i], NULL);
+
+    /* waits for all queued satellites to finish */
+    g_thread_pool_free(pool, FALSE, TRUE);
+}
+
 pass_t         *copy_pass(pass_t * pass)
 {
     pass_t         *new;
@@ -78,6 +78,25 @@ typedef struct {
     gint      orbit;
 } pass_detail_t;
 
+/** \brief Prediction settings, read from sat-cfg once instead of per pass. */
+typedef struct {
+    gdouble     tres;        /*!< time resolution of the pass details in days */
+    gint        num_entries; /*!< number of pass details */
+    gdouble     min_el;      /*!< minimum elevation of a pass */
+} pass_cfg_t;
+
+/** \brief One satellite of a batch pass prediction. */
+typedef struct {
+    sat_t      *sat;      /*!< satellite, not modified */
+    gdouble     start;    /*!< start of the time window */
+    gdouble     maxdt;    /*!< length of the window in days, 0 for no limit */
+    guint       num;      /*!< number of passes to predict */
+    GSList     *passes;   /*!< result, GSList of pass_t in time order */
+} pass_batch_t;
+
+/* called on a worker thread when an item is done, FALSE skips the rest */
+typedef gboolean (*pass_batch_cb) (pass_batch_t *item, gpointer data);
+
 /* type casting macros */
 #define PASS(x) ((pass_t *) x)
 #define PASS_DETAIL(x) ((pass_detail_t *) x)
@@ -100,6 +119,16 @@ GSList *get_passes         (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt
 pass_t *get_current_pass   (sat_t *sat, qth_t *qth, gdouble start);
 pass_t *get_pass_no_min_el (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
 
+/* settings read on the main thread, for predictions on worker threads */
+void    load_pass_cfg      (pass_cfg_t *cfg);
+GSList *get_passes_engine  (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt,
+                            guint num, const pass_cfg_t *cfg);
+
+/* future events of several satellites, computed in parallel */
+void    get_passes_batch   (pass_batch_t *items, guint n, qth_t *qth,
+                            const pass_cfg_t *cfg, guint threads,
+                            pass_batch_cb done, gpointer data);
+
 /* copying */
 pass_t        *copy_pass         (pass_t *pass);
 GSList        *copy_pass_details (GSList *details);
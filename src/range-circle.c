@@ -0,0 +1,71 @@
+/*
+ * Range circle points from a unit circle template.
+ *
+ * The point at azimuth az on the circle of radius beta around latitude
+ * phi has sin(lat) = sin(phi) cos(beta) + cos(az) sin(beta) cos(phi), the
+ * unit circle rotated by phi. With cos(az) tabulated once, the per point
+ * work is one asin for the latitude and one acos for the longitude offset;
+ * cos(lat) follows from sin(lat) with a square root instead of a cos(asin()).
+ */
+#include <math.h>
+
+#include "range-circle.h"
+#include "sgpsdp/sgp4sdp4.h"
+
+static gdouble  cos_azi[RANGE_CIRCLE_POINTS];
+
+static void init_template(void)
+{
+    static gsize    done = 0;
+
+    if (g_once_init_enter(&done))
+    {
+        for (guint i = 0; i < RANGE_CIRCLE_POINTS; i++)
+            cos_azi[i] = cos(de2ra * i);
+        g_once_init_leave(&done, 1);
+    }
+}
+
+void range_circle_half(gdouble ssplat, gdouble ssplon, gdouble beta,
+                       gboolean north_pole, gdouble * lat, gdouble * lon)
+{
+    gdouble         sinlat, coslat, cosbeta, a, b;
+
+    init_template();
+
+    ssplat *= de2ra;
+    ssplon *= de2ra;
+    sinlat = sin(ssplat);
+    coslat = cos(ssplat);
+    cosbeta = cos(beta);
+    a = sinlat * cosbeta;
+    b = sin(beta) * coslat;
+
+    /* sin of the latitudes, rotated template */
+    for (guint i = 0; i < RANGE_CIRCLE_POINTS; i++)
+        lat[i] = a + cos_azi[i] * b;
+
+    for (guint i = 0; i < RANGE_CIRCLE_POINTS; i++)
+    {
+        gdouble         s = lat[i];
+        gdouble         num = cosbeta - sinlat * s;
+        gdouble         dem = coslat * sqrt(1.0 - s * s);
+        gdouble         rangelon;
+
+        /* dem is never negative, and arccos() of the maps was 0 for num == 0 */
+        if (i == 0 && north_pole)
+            rangelon = ssplon + pi;
+        else if (fabs(num / dem) > 1.0 || num == 0.0 || dem == 0.0)
+            rangelon = ssplon;
+        else
+            rangelon = ssplon - acos(num / dem);
+
+        while (rangelon < -pi)
+            rangelon += twopi;
+        while (rangelon > pi)
+            rangelon -= twopi;
+
+        lat[i] = asin(s) / de2ra;
+        lon[i] = rangelon / de2ra;
+    }
+}
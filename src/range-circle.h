@@ -0,0 +1,30 @@
+#ifndef __RANGE_CIRCLE_H__
+#define __RANGE_CIRCLE_H__
+
+#include <glib.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* One point per degree of azimuth over the left half of the circle */
+#define RANGE_CIRCLE_POINTS 180
+
+/*
+ * Left half of the range circle of angular radius beta (radians) around the
+ * sub-satellite point ssplat/ssplon (degrees), as lat/lon in degrees for
+ * azimuths 0 to 179. Same points as the gsat / KD2BD range circle the maps
+ * used to compute directly, north_pole puts the first one across the pole.
+ */
+void range_circle_half(gdouble ssplat, gdouble ssplon, gdouble beta,
+                       gboolean north_pole, gdouble * lat, gdouble * lon);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
@@ -1,203 +1,440 @@
 #include "sat-graph.h"
+#include "los-pairs.h"
 #include <stdlib.h>
 #include <string.h>
 #include <float.h>
 
-static gchar* make_edge_key(sat_t *a, sat_t *b)
-{
-    return g_strdup_printf("%p|%p",
-        (void *)(a < b ? a : b),
-        (void *)(a < b ? b : a));
-}
+/*
+ * Binary min heap of (key, vertex) used by Dijkstra and Prim. Vertices are
+ * pushed again instead of decreasing their key, stale entries are skipped
+ * when popped.
+ */
+typedef struct {
+    gdouble key;
+    guint v;
+} heap_entry;
 
-SatGraph* sat_graph_new(void)
+typedef struct {
+    heap_entry *nodes;
+    guint len;
+    guint size;
+} vertex_heap;
+
+static void heap_push(vertex_heap *h, gdouble key, guint v)
 {
-    SatGraph *graph = g_new0(SatGraph, 1);
-    graph->vertices = g_hash_table_new(g_direct_hash, g_direct_equal);
-    graph->edges = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
-    return graph;
+    if (h->len == h->size) {
+        h->size = h->size ? h->size * 2 : 64;
+        h->nodes = g_renew(heap_entry, h->nodes, h->size);
+    }
+
+    guint i = h->len++;
+    while (i > 0) {
+        guint parent = (i - 1) / 2;
+        if (h->nodes[parent].key <= key)
+            break;
+        h->nodes[i] = h->nodes[parent];
+        i = parent;
+    }
+    h->nodes[i].key = key;
+    h->nodes[i].v = v;
 }
 
-void sat_graph_add_vertex(SatGraph *graph, sat_t *sat)
+static heap_entry heap_pop(vertex_heap *h)
 {
-    if (!g_hash_table_contains(graph->vertices, sat))
-    {
-        g_hash_table_insert(graph->vertices, sat, NULL);
+    heap_entry min = h->nodes[0];
+    heap_entry last = h->nodes[--h->len];
+    guint i = 0;
+
+    while (TRUE) {
+        guint child = 2 * i + 1;
+        if (child >= h->len)
+            break;
+        if (child + 1 < h->len && h->nodes[child + 1].key < h->nodes[child].key)
+            child++;
+        if (last.key <= h->nodes[child].key)
+            break;
+        h->nodes[i] = h->nodes[child];
+        i = child;
     }
+    if (h->len > 0)
+        h->nodes[i] = last;
+
+    return min;
 }
 
-void sat_graph_add_edge(SatGraph *graph, sat_t *sat1, sat_t *sat2)
+SatCsr* sat_csr_new(guint n_vertices, const SatCsrEdge *edges, guint n_edges)
 {
-    if (!sat1 || !sat2 || sat1 == sat2) return;
+    SatCsr *csr = g_new0(SatCsr, 1);
+    guint *fill;
 
-    gdouble *dist = g_new(gdouble, 1);
-    *dist = dist_calc(sat1, sat2);
-    gchar *key = make_edge_key(sat1, sat2);
-    g_hash_table_insert(graph->edges, key, dist);
+    csr->n_vertices = n_vertices;
+    csr->n_entries = 2 * n_edges;
+    csr->row = g_new0(guint, n_vertices + 1);
+    csr->col = g_new(guint, csr->n_entries > 0 ? csr->n_entries : 1);
+    csr->weight = g_new(gdouble, csr->n_entries > 0 ? csr->n_entries : 1);
 
-    GList *neighbors1 = g_hash_table_lookup(graph->vertices, sat1);
-    GList *neighbors2 = g_hash_table_lookup(graph->vertices, sat2);
+    // count the degree of every vertex, then turn the counts into offsets
+    for (guint e = 0; e < n_edges; e++) {
+        csr->row[edges[e].a + 1]++;
+        csr->row[edges[e].b + 1]++;
+    }
+    for (guint v = 0; v < n_vertices; v++)
+        csr->row[v + 1] += csr->row[v];
 
-    neighbors1 = g_list_prepend(neighbors1, sat2);
-    neighbors2 = g_list_prepend(neighbors2, sat1);
+    fill = g_new(guint, n_vertices + 1);
+    memcpy(fill, csr->row, (n_vertices + 1) * sizeof(guint));
+    for (guint e = 0; e < n_edges; e++) {
+        guint a = edges[e].a, b = edges[e].b;
+        csr->col[fill[a]] = b;
+        csr->weight[fill[a]++] = edges[e].weight;
+        csr->col[fill[b]] = a;
+        csr->weight[fill[b]++] = edges[e].weight;
+    }
+    g_free(fill);
 
-    g_hash_table_insert(graph->vertices, sat1, neighbors1);
-    g_hash_table_insert(graph->vertices, sat2, neighbors2);
+    return csr;
 }
 
-void sat_graph_free(SatGraph *graph)
+void sat_csr_free(SatCsr *csr)
 {
-    g_hash_table_destroy(graph->vertices);
-    g_hash_table_destroy(graph->edges);
-    g_free(graph);
+    if (!csr)
+        return;
+    g_free(csr->row);
+    g_free(csr->col);
+    g_free(csr->weight);
+    g_free(csr);
 }
 
 // Dijkstra's Algorithm
-GList* sat_graph_dijkstra(SatGraph *graph, sat_t *start, sat_t *end)
+gboolean sat_csr_dijkstra(const SatCsr *csr, guint src, guint dst, GArray *path)
 {
-    GHashTable *dist = g_hash_table_new(g_direct_hash, g_direct_equal);
-    GHashTable *prev = g_hash_table_new(g_direct_hash, g_direct_equal);
-    GHashTable *visited = g_hash_table_new(g_direct_hash, g_direct_equal);
-    GQueue *queue = g_queue_new();
+    guint n = csr->n_vertices;
+    gdouble *dist;
+    gint *prev;
+    gboolean *done;
+    vertex_heap heap = {NULL, 0, 0};
+    gboolean found = FALSE;
 
-    GList *keys = g_hash_table_get_keys(graph->vertices);
-    for (GList *l = keys; l != NULL; l = l->next)
-    {
-        sat_t *sat = l->data;
-        gdouble *DBL_MAX_PTR = g_new(gdouble, 1);
-        *DBL_MAX_PTR = DBL_MAX;
-        g_hash_table_insert(dist, sat, DBL_MAX_PTR);
-        g_hash_table_insert(prev, sat, NULL);
+    g_array_set_size(path, 0);
+    if (src >= n || dst >= n)
+        return FALSE;
+
+    dist = g_new(gdouble, n);
+    prev = g_new(gint, n);
+    done = g_new0(gboolean, n);
+    for (guint v = 0; v < n; v++) {
+        dist[v] = DBL_MAX;
+        prev[v] = -1;
     }
-    g_list_free(keys);
 
-    gdouble *zero_ptr = g_new(gdouble, 1);
-    *zero_ptr = 0.0;
-    g_hash_table_replace(dist, start, zero_ptr);
-    g_queue_push_tail(queue, start);
+    dist[src] = 0.0;
+    heap_push(&heap, 0.0, src);
+    while (heap.len > 0) {
+        guint u = heap_pop(&heap).v;
+        if (done[u])
+            continue;
+        done[u] = TRUE;
+        if (u == dst) {
+            found = TRUE;
+            break;
+        }
 
-    while (!g_queue_is_empty(queue))
-    {
-        // Find unvisited vertex with smallest distance
-        sat_t *u = NULL;
-        gdouble min_dist = DBL_MAX;
-        for (GList *l = g_queue_peek_head_link(queue); l; l = l->next)
-        {
-            sat_t *s = l->data;
-            if (!g_hash_table_contains(visited, s))
-            {
-                gdouble d = *(gdouble *)g_hash_table_lookup(dist, s);
-                if (d < min_dist)
-                {
-                    u = s;
-                    min_dist = d;
-                }
+        for (guint k = csr->row[u]; k < csr->row[u + 1]; k++) {
+            guint v = csr->col[k];
+            gdouble alt = dist[u] + csr->weight[k];
+            if (!done[v] && alt < dist[v]) {
+                dist[v] = alt;
+                prev[v] = u;
+                heap_push(&heap, alt, v);
             }
         }
+    }
 
-        if (!u) break;
-        g_hash_table_insert(visited, u, GINT_TO_POINTER(TRUE));
-        g_queue_remove(queue, u);
+    if (found) {
+        for (gint v = dst; v >= 0; v = prev[v]) {
+            guint id = v;
+            g_array_prepend_val(path, id);
+        }
+    }
 
-        GList *neighbors = g_hash_table_lookup(graph->vertices, u);
-        for (GList *l = neighbors; l != NULL; l = l->next)
-        {
-            sat_t *v = l->data;
-            if (g_hash_table_contains(visited, v)) continue;
-
-            gchar *edge_key = make_edge_key(u, v);
-            gdouble *w = g_hash_table_lookup(graph->edges, edge_key);
-            g_free(edge_key);
-            gdouble *du = g_hash_table_lookup(dist, u);
-            gdouble alt = *du + *w;
-
-            if (alt < *(gdouble *)g_hash_table_lookup(dist, v)) 
-            {
-                gdouble *alt_ptr = g_new(gdouble, 1);
-                *alt_ptr = alt;
-                g_hash_table_replace(dist, v, alt_ptr);
-                g_hash_table_replace(prev, v, u);
-                g_queue_push_tail(queue, v);
+    g_free(heap.nodes);
+    g_free(dist);
+    g_free(prev);
+    g_free(done);
+    return found;
+}
+
+/*
+ * Widest (maximum bottleneck) path. Same as Dijkstra with the path length
+ * replaced by the smallest edge weight on it, largest first out of the heap.
+ * Edges with a weight <= 0 are never used.
+ */
+gboolean sat_csr_widest(const SatCsr *csr, guint src, guint dst, GArray *path, gdouble *width)
+{
+    guint n = csr->n_vertices;
+    gdouble *wide;
+    gint *prev;
+    gboolean *done;
+    vertex_heap heap = {NULL, 0, 0};
+    gboolean found = FALSE;
+
+    g_array_set_size(path, 0);
+    if (src >= n || dst >= n)
+        return FALSE;
+
+    wide = g_new(gdouble, n);
+    prev = g_new(gint, n);
+    done = g_new0(gboolean, n);
+    for (guint v = 0; v < n; v++) {
+        wide[v] = 0.0;
+        prev[v] = -1;
+    }
+
+    wide[src] = DBL_MAX;
+    heap_push(&heap, -DBL_MAX, src);
+    while (heap.len > 0) {
+        guint u = heap_pop(&heap).v;
+        if (done[u])
+            continue;
+        done[u] = TRUE;
+        if (u == dst) {
+            found = TRUE;
+            break;
+        }
+
+        for (guint k = csr->row[u]; k < csr->row[u + 1]; k++) {
+            guint v = csr->col[k];
+            gdouble w = MIN(wide[u], csr->weight[k]);
+            if (!done[v] && w > wide[v]) {
+                wide[v] = w;
+                prev[v] = u;
+                heap_push(&heap, -w, v);
             }
         }
     }
 
-    // Reconstruct path
-    GList *path = NULL;
-    for (sat_t *at = end; at != NULL; at = g_hash_table_lookup(prev, at))
+    if (found) {
+        for (gint v = dst; v >= 0; v = prev[v]) {
+            guint id = v;
+            g_array_prepend_val(path, id);
+        }
+        if (width)
+            *width = wide[dst];
+    }
+
+    g_free(heap.nodes);
+    g_free(wide);
+    g_free(prev);
+    g_free(done);
+    return found;
+}
+
+// Prim's Algorithm
+guint sat_csr_prim(const SatCsr *csr, guint root, gint *parent)
+{
+    guint n = csr->n_vertices;
+    gdouble *key;
+    gboolean *done;
+    vertex_heap heap = {NULL, 0, 0};
+    guint count = 0;
+
+    for (guint v = 0; v < n; v++)
+        parent[v] = -1;
+    if (root >= n)
+        return 0;
+
+    key = g_new(gdouble, n);
+    done = g_new0(gboolean, n);
+    for (guint v = 0; v < n; v++)
+        key[v] = DBL_MAX;
+
+    key[root] = 0.0;
+    heap_push(&heap, 0.0, root);
+    while (heap.len > 0) {
+        guint u = heap_pop(&heap).v;
+        if (done[u])
+            continue;
+        done[u] = TRUE;
+        count++;
+
+        for (guint k = csr->row[u]; k < csr->row[u + 1]; k++) {
+            guint v = csr->col[k];
+            if (!done[v] && csr->weight[k] < key[v]) {
+                key[v] = csr->weight[k];
+                parent[v] = u;
+                heap_push(&heap, key[v], v);
+            }
+        }
+    }
+
+    g_free(heap.nodes);
+    g_free(key);
+    g_free(done);
+    return count;
+}
+
+static guint vertex_id(SatGraph *graph, sat_t *sat)
+{
+    gpointer id = g_hash_table_lookup(graph->ids, sat);
+
+    if (id)
+        return GPOINTER_TO_UINT(id) - 1;
+
+    g_ptr_array_add(graph->sats, sat);
+    g_hash_table_insert(graph->ids, sat, GUINT_TO_POINTER(graph->sats->len));
+    return graph->sats->len - 1;
+}
+
+// CSR of the graph as it is now, rebuilt only if vertices or edges were added
+static SatCsr* graph_csr(SatGraph *graph)
+{
+    if (!graph->csr)
+        graph->csr = sat_csr_new(graph->sats->len,
+                                 (SatCsrEdge *)graph->edges->data, graph->edges->len);
+    return graph->csr;
+}
+
+static void graph_changed(SatGraph *graph)
+{
+    sat_csr_free(graph->csr);
+    graph->csr = NULL;
+}
+
+SatGraph* sat_graph_new(void)
+{
+    SatGraph *graph = g_new0(SatGraph, 1);
+    graph->ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+    graph->sats = g_ptr_array_new();
+    graph->edges = g_array_new(FALSE, FALSE, sizeof(SatCsrEdge));
+    return graph;
+}
+
+void sat_graph_add_vertex(SatGraph *graph, sat_t *sat)
+{
+    if (!g_hash_table_contains(graph->ids, sat))
+    {
+        vertex_id(graph, sat);
+        graph_changed(graph);
+    }
+}
+
+// Key of the undirected pair a - b in graph->pairs
+static gint64* pair_key(guint a, guint b)
+{
+    gint64 *key = g_new(gint64, 1);
+    *key = ((gint64)MIN(a, b) << 32) | MAX(a, b);
+    return key;
+}
+
+// Adds the edge unless sat1 - sat2 is already in the graph, in either direction
+void sat_graph_add_edge(SatGraph *graph, sat_t *sat1, sat_t *sat2)
+{
+    if (!sat1 || !sat2 || sat1 == sat2) return;
+
+    // edges added in bulk by sat_graph_new_los() are indexed on first use
+    if (!graph->pairs)
+    {
+        graph->pairs = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+        for (guint i = 0; i < graph->edges->len; i++)
+        {
+            SatCsrEdge *e = &g_array_index(graph->edges, SatCsrEdge, i);
+            g_hash_table_add(graph->pairs, pair_key(e->a, e->b));
+        }
+    }
+
+    SatCsrEdge edge;
+    edge.a = vertex_id(graph, sat1);
+    edge.b = vertex_id(graph, sat2);
+
+    gint64 *key = pair_key(edge.a, edge.b);
+    if (g_hash_table_contains(graph->pairs, key))
     {
-        path = g_list_prepend(path, at);
-        if (at == start) break;
+        g_free(key);
+        return;
     }
+    g_hash_table_add(graph->pairs, key);
+
+    edge.weight = dist_calc(sat1, sat2);
+    g_array_append_val(graph->edges, edge);
+    graph_changed(graph);
+}
+
+/*
+ * Graph over sats with an edge for every pair with clear LOS, found through
+ * the los-pairs grid instead of testing every pair. max_range <= 0 for no
+ * range limit beyond the horizon.
+ */
+SatGraph* sat_graph_new_los(GList *sats, gdouble max_range)
+{
+    SatGraph *graph = sat_graph_new();
+
+    for (GList *l = sats; l != NULL; l = l->next)
+        sat_graph_add_vertex(graph, l->data);
+
+    los_positions *pos = los_positions_from_sats(graph->sats);
+    GArray *pairs = los_clear_pairs(pos, max_range);
+    g_array_append_vals(graph->edges, pairs->data, pairs->len);
+
+    g_array_free(pairs, TRUE);
+    los_positions_free(pos);
+    graph_changed(graph);
+    return graph;
+}
+
+void sat_graph_free(SatGraph *graph)
+{
+    g_hash_table_destroy(graph->ids);
+    g_ptr_array_free(graph->sats, TRUE);
+    g_array_free(graph->edges, TRUE);
+    if (graph->pairs)
+        g_hash_table_destroy(graph->pairs);
+    sat_csr_free(graph->csr);
+    g_free(graph);
+}
+
+GList* sat_graph_dijkstra(SatGraph *graph, sat_t *start, sat_t *end)
+{
+    gpointer src = g_hash_table_lookup(graph->ids, start);
+    gpointer dst = g_hash_table_lookup(graph->ids, end);
+    GList *path = NULL;
+
+    if (!src || !dst)
+        return NULL;
 
-    if (path == NULL || path->data != start)
+    GArray *ids = g_array_new(FALSE, FALSE, sizeof(guint));
+    if (sat_csr_dijkstra(graph_csr(graph), GPOINTER_TO_UINT(src) - 1,
+                         GPOINTER_TO_UINT(dst) - 1, ids))
     {
-        g_list_free(path);
-        // No path found
-        path = NULL;
+        for (guint i = ids->len; i > 0; i--)
+            path = g_list_prepend(path, g_ptr_array_index(graph->sats,
+                                                          g_array_index(ids, guint, i - 1)));
     }
+    g_array_free(ids, TRUE);
 
-    g_hash_table_destroy(dist);
-    g_hash_table_destroy(prev);
-    g_hash_table_destroy(visited);
-    g_queue_free(queue);
     return path;
 }
 
-// Prim's Algorithm
+// Spanning tree of the component holding the first vertex added
 SatGraph* sat_graph_prims(SatGraph *graph)
 {
     SatGraph *mst = sat_graph_new();
-    GHashTable *visited = g_hash_table_new(g_direct_hash, g_direct_equal);
+    SatCsr *csr = graph_csr(graph);
 
-    GList *vertices = g_hash_table_get_keys(graph->vertices);
-    if (!vertices) return mst;
+    if (csr->n_vertices == 0) return mst;
 
-    sat_t *start = vertices->data;
-    g_hash_table_insert(visited, start, GINT_TO_POINTER(TRUE));
-    sat_graph_add_vertex(mst, start);
+    gint *parent = g_new(gint, csr->n_vertices);
+    sat_csr_prim(csr, 0, parent);
 
-    while (g_hash_table_size(visited) < g_hash_table_size(graph->vertices))
+    sat_graph_add_vertex(mst, g_ptr_array_index(graph->sats, 0));
+    for (guint v = 1; v < csr->n_vertices; v++)
     {
-        gdouble min_weight = DBL_MAX;
-        sat_t *from = NULL, *to = NULL;
+        if (parent[v] < 0) continue;
 
-        GList *visited_keys = g_hash_table_get_keys(visited);
-        for (GList *l = visited_keys; l != NULL; l = l->next)
-        {
-            sat_t *u = l->data;
-            GList *neighbors = g_hash_table_lookup(graph->vertices, u);
-            for (GList *n = neighbors; n != NULL; n = n->next)
-            {
-                sat_t *v = n->data;
-                if (g_hash_table_contains(visited, v)) continue;
-
-                gchar *key = make_edge_key(u, v);
-                gdouble *weight = g_hash_table_lookup(graph->edges, key);
-                g_free(key);
-                if (*weight < min_weight)
-                {
-                    min_weight = *weight;
-                    from = u;
-                    to = v;
-                }
-            }
-        }
-        g_list_free(visited_keys);
-
-        if (to)
-        {
-            sat_graph_add_vertex(mst, to);
-            sat_graph_add_edge(mst, from, to);
-            g_hash_table_insert(visited, to, GINT_TO_POINTER(TRUE));
-        }
-        else
-        {
-            break;  // No more reachable vertices
-        }
+        sat_t *to = g_ptr_array_index(graph->sats, v);
+        sat_graph_add_vertex(mst, to);
+        sat_graph_add_edge(mst, g_ptr_array_index(graph->sats, parent[v]), to);
     }
 
-    g_list_free(vertices);
-    g_hash_table_destroy(visited);
+    g_free(parent);
     return mst;
 }
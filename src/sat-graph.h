@@ -11,17 +11,56 @@ extern "C" {
 #endif
 /* *INDENT-ON* */
 
+// Undirected edge between two vertex ids
 typedef struct {
-    // Key: sat_t* (pointer), Value: GList* of neighbors (sat_t*)
-    GHashTable *vertices;
-    // Key: "sat1|sat2" string, Value: gdouble* (distance)
-    GHashTable *edges;
+    guint a;
+    guint b;
+    gdouble weight;
+} SatCsrEdge;
+
+/*
+ * Compressed sparse rows: the neighbours of vertex v are
+ * col[row[v]] .. col[row[v + 1] - 1], with matching weights.
+ * Every undirected edge is stored once in each direction.
+ */
+typedef struct {
+    guint n_vertices;
+    guint n_entries;    // 2 * number of edges
+    guint *row;         // n_vertices + 1 offsets
+    guint *col;
+    gdouble *weight;
+} SatCsr;
+
+SatCsr* sat_csr_new(guint n_vertices, const SatCsrEdge *edges, guint n_edges);
+void sat_csr_free(SatCsr *csr);
+
+// Fills path with the vertex ids from src to dst, FALSE when dst is unreachable
+gboolean sat_csr_dijkstra(const SatCsr *csr, guint src, guint dst, GArray *path);
+
+// Path from src to dst whose smallest weight is largest, width is that weight
+gboolean sat_csr_widest(const SatCsr *csr, guint src, guint dst, GArray *path, gdouble *width);
+
+// parent[v] is the tree neighbour of v towards root, -1 for root and unreached vertices
+guint sat_csr_prim(const SatCsr *csr, guint root, gint *parent);
+
+typedef struct {
+    // Key: sat_t* (pointer), Value: vertex id + 1
+    GHashTable *ids;
+    // sat_t* of each vertex id
+    GPtrArray *sats;
+    // All edges as SatCsrEdge, the CSR is rebuilt from these
+    GArray *edges;
+    // Key: gint64* vertex id pair, smaller id first, built on the first sat_graph_add_edge()
+    GHashTable *pairs;
+    // Built from edges on the first query after a change
+    SatCsr *csr;
 } SatGraph;
 
 // Graph functions
 SatGraph* sat_graph_new(void);
 void sat_graph_add_vertex(SatGraph *graph, sat_t *sat);
 void sat_graph_add_edge(SatGraph *graph, sat_t *sat1, sat_t *sat2);
+SatGraph* sat_graph_new_los(GList *sats, gdouble max_range);
 void sat_graph_free(SatGraph *graph);
 
 // Shortest path (Dijkstra)
@@ -2,11 +2,12 @@
 #include "sat-kdtree-utils.h"
 #include "kdtree-wrapper.h"
 #include "sgpsdp/sgp4sdp4.h"
+#include "orbit-tools.h"
 
 
 /* Usage example
 Kdtree *tree = sat_kdtree_create();
-sat_kdtree_insert_all(tree, satellites, num_sats);
+sat_kdtree_rebuild(tree, satellites);   // after every propagation step
 
 sat_t *target = satellites[0];
 sat_t *nearest = sat_kdtree_find_nearest_other(tree, target);
@@ -21,39 +22,67 @@ kdtree_free(tree);
 */
 
 Kdtree *sat_kdtree_create(void) {
-    return kdtree_new(3);
+    return kdtree_new_backend(3, KDTREE_BACKEND_FLAT);
 }
 
 void sat_kdtree_insert(Kdtree *tree, sat_t *sat) {
     kdtree_insert3(tree, sat->pos.x, sat->pos.y, sat->pos.z, sat);
 }
 
-sat_t *sat_kdtree_find_nearest_other(Kdtree *tree, const sat_t *query_sat) {
-    gdouble x = query_sat->pos.x;
-    gdouble y = query_sat->pos.y;
-    gdouble z = query_sat->pos.z;
+/*
+ * Positions change every tick, so the tree is built again from scratch with
+ * a median split rather than patched.
+ */
+void sat_kdtree_rebuild(Kdtree *tree, GHashTable *sats) {
+    guint n = g_hash_table_size(sats);
+    gdouble *coords = g_new(gdouble, 3 * (n > 0 ? n : 1));
+    gpointer *data = g_new(gpointer, n > 0 ? n : 1);
+    GHashTableIter iter;
+    gpointer key, value;
+    guint count = 0;
+
+    g_hash_table_iter_init(&iter, sats);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        sat_t *sat = SAT(value);
+        if (decayed(sat))
+            continue;
+        coords[3 * count] = sat->pos.x;
+        coords[3 * count + 1] = sat->pos.y;
+        coords[3 * count + 2] = sat->pos.z;
+        data[count++] = sat;
+    }
 
-    struct kdres *res = kd_nearest_range3(tree->tree, x, y, z, 1e6); // use large range
+    kdtree_build(tree, coords, data, count);
+    g_free(coords);
+    g_free(data);
+}
 
+sat_t *sat_kdtree_find_nearest_other(Kdtree *tree, const sat_t *query_sat) {
     sat_t *nearest = NULL;
-    gdouble min_dist = G_MAXDOUBLE;
-
-    while (!kd_res_end(res)) {
-        gdouble px, py, pz;
-        sat_t *candidate = (sat_t *)kd_res_item3(res, &px, &py, &pz);
-        if (candidate != query_sat) {
-            gdouble dx = px - x;
-            gdouble dy = py - y;
-            gdouble dz = pz - z;
-            gdouble dist = sqrt(dx * dx + dy * dy + dz * dz);
-            if (dist < min_dist) {
-                min_dist = dist;
-                nearest = candidate;
-            }
-        }
-        kd_res_next(res);
-    }
+    gdouble dist;
+
+    if (tree == NULL)
+        return NULL;
 
-    kd_res_free(res);
+    sat_kdtree_find_k_nearest(tree, query_sat, 1, &nearest, &dist);
     return nearest;
 }
+
+guint sat_kdtree_find_k_nearest(Kdtree *tree, const sat_t *query_sat, guint k,
+                                sat_t **nearest, gdouble *dist) {
+    gdouble pos[3] = {query_sat->pos.x, query_sat->pos.y, query_sat->pos.z};
+    guint n;
+
+    n = kdtree_nearest_k(tree, pos, k, query_sat, (gpointer *)nearest, dist);
+    for (guint i = 0; i < n; i++)
+        dist[i] = sqrt(dist[i]);
+
+    return n;
+}
+
+guint sat_kdtree_find_in_range(Kdtree *tree, const sat_t *query_sat, gdouble range_km,
+                               sat_t **found, guint max) {
+    gdouble pos[3] = {query_sat->pos.x, query_sat->pos.y, query_sat->pos.z};
+
+    return kdtree_within(tree, pos, range_km, query_sat, (gpointer *)found, NULL, max);
+}
@@ -6,7 +6,8 @@
 #include "sgpsdp/sgp4sdp4.h"
 
 /**
- * Create a 3D kd-tree for satellites.
+ * Create a 3D kd-tree for satellites, on the flat double precision backend
+ * since it is rebuilt every cycle.
  */
 Kdtree *sat_kdtree_create(void);
 
@@ -15,9 +16,31 @@ Kdtree *sat_kdtree_create(void);
  */
 void sat_kdtree_insert(Kdtree *tree, sat_t *sat);
 
+/**
+ * Replace the contents of the tree with the current positions of the
+ * satellites in sats (catnr -> sat_t). Decayed satellites are left out.
+ */
+void sat_kdtree_rebuild(Kdtree *tree, GHashTable *sats);
+
 /**
  * Find the nearest satellite to a given satellite (excluding itself).
  */
 sat_t *sat_kdtree_find_nearest_other(Kdtree *tree, const sat_t *query_sat);
 
+/**
+ * Find up to k satellites nearest to query_sat, closest first and excluding
+ * itself. dist gets their distances in km.
+ * Returns the number written to nearest.
+ */
+guint sat_kdtree_find_k_nearest(Kdtree *tree, const sat_t *query_sat, guint k,
+                                sat_t **nearest, gdouble *dist);
+
+/**
+ * Find the satellites within range_km of query_sat, excluding itself, for
+ * inter-satellite link candidates. At most max are written to found.
+ * Returns the number in range, larger than max if found was too short.
+ */
+guint sat_kdtree_find_in_range(Kdtree *tree, const sat_t *query_sat, gdouble range_km,
+                               sat_t **found, guint max);
+
 #endif // SATELLITE_KDTREE_UTILS_H
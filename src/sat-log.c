@@ -54,6 +54,7 @@ static gboolean initialised = FALSE;
 static GIOChannel *logfile = NULL;
 static sat_log_level_t loglevel = SAT_LOG_LEVEL_DEBUG;
 static gboolean debug_to_stderr = FALSE; // whether to also send debug msg to stderr
+static GMutex   log_lock;       /* messages also come from worker threads */
 
 /** String representation of debug levels. */
 const gchar    *debug_level_str[] = {
@@ -185,8 +186,10 @@ void sat_log_log(sat_log_level_t level, const gchar * fmt, ...)
        which will print the debug message and save it to
        a logfile
      */
+    g_mutex_lock(&log_lock);
     for (i = 0; i < numlines; i++)
         manage_debug_message(level, msgv[i]);
+    g_mutex_unlock(&log_lock);
 
     va_end(ap);
     g_strfreev(msgv);
@@ -0,0 +1,338 @@
+/*
+ * Constellation layer for the maps.
+ *
+ * With thousands of satellites the per satellite canvas items (marker, label,
+ * two shadows and two range circle parts) make every update and every redraw
+ * walk tens of thousands of GObjects. The layer keeps only packed lon/lat and
+ * footprint radius arrays and paints them after the canvas has drawn its own
+ * items, so the cost is one cairo path per frame. Footprints are drawn as
+ * small circles of 36 points instead of the 360 point range circles.
+ */
+#include <goocanvas.h>
+#include <math.h>
+
+#include "config-keys.h"
+#include "sat-map-layer.h"
+#include "sgpsdp/sgp4sdp4.h"
+
+#define FOOTPRINT_POINTS 36
+#define LABEL_FONT_SIZE 11.0    // pixels, close to "Sans 8"
+
+static void reserve(sat_map_layer * layer, guint n)
+{
+    if (n <= layer->capacity)
+        return;
+
+    layer->capacity = MAX(n, 2 * layer->capacity);
+    layer->sat = g_renew(sat_t *, layer->sat, layer->capacity);
+    layer->lon = g_renew(gfloat, layer->lon, layer->capacity);
+    layer->lat = g_renew(gfloat, layer->lat, layer->capacity);
+    layer->radius = g_renew(gfloat, layer->radius, layer->capacity);
+    layer->flags = g_renew(guint8, layer->flags, layer->capacity);
+}
+
+/* Same projection as lonlat_to_xy of the maps */
+static void project(const sat_map_layer * layer, gdouble lon, gdouble lat,
+                    gdouble * x, gdouble * y)
+{
+    *x = layer->x0 + (lon - layer->left_side_lon) * layer->width / 360.0;
+    *y = layer->y0 + (90.0 - lat) * layer->height / 180.0;
+    while (*x < 0)
+        *x += layer->width;
+    while (*x > layer->width)
+        *x -= layer->width;
+}
+
+static void set_source_rgba(cairo_t * cr, guint32 col)
+{
+    cairo_set_source_rgba(cr,
+                          ((col >> 24) & 0xFF) / 255.0,
+                          ((col >> 16) & 0xFF) / 255.0,
+                          ((col >> 8) & 0xFF) / 255.0, (col & 0xFF) / 255.0);
+}
+
+/*
+ * Footprint of satellite i as a small circle around the sub-satellite point,
+ * FALSE when it wraps around the map edge and cannot be filled.
+ */
+static gboolean footprint_points(const sat_map_layer * layer, guint i,
+                                 gdouble * xs, gdouble * ys)
+{
+    gdouble         lat = layer->lat[i] * de2ra;
+    gdouble         lon = layer->lon[i] * de2ra;
+    gdouble         r = layer->radius[i];
+    gboolean        closed = TRUE;
+
+    for (guint k = 0; k <= FOOTPRINT_POINTS; k++) {
+        gdouble         b = k * twopi / FOOTPRINT_POINTS;
+        gdouble         plat = asin(sin(lat) * cos(r) + cos(lat) * sin(r) * cos(b));
+        gdouble         plon = lon + atan2(sin(b) * sin(r) * cos(lat),
+                                           cos(r) - sin(lat) * sin(plat));
+
+        plon = fmod(plon + 3 * pi, twopi) - pi;
+        project(layer, plon / de2ra, plat / de2ra, &xs[k], &ys[k]);
+
+        if (k > 0 && fabs(xs[k] - xs[k - 1]) > layer->width / 2)
+            closed = FALSE;
+    }
+
+    return closed;
+}
+
+/* Adds the footprint to the path, broken where it jumps across the map edge */
+static void footprint_path(const sat_map_layer * layer, cairo_t * cr,
+                           const gdouble * xs, const gdouble * ys,
+                           gboolean closed)
+{
+    cairo_move_to(cr, xs[0], ys[0]);
+    for (guint k = 1; k <= FOOTPRINT_POINTS; k++) {
+        if (fabs(xs[k] - xs[k - 1]) > layer->width / 2)
+            cairo_move_to(cr, xs[k], ys[k]);
+        else
+            cairo_line_to(cr, xs[k], ys[k]);
+    }
+    if (closed)
+        cairo_close_path(cr);
+}
+
+/* Adds the footprints of the unselected satellites that are closed or not */
+static void footprints_path(const sat_map_layer * layer, cairo_t * cr,
+                            gboolean closed)
+{
+    gdouble         xs[FOOTPRINT_POINTS + 1], ys[FOOTPRINT_POINTS + 1];
+
+    for (guint i = 0; i < layer->n; i++) {
+        if ((layer->flags[i] & (SAT_MAP_LAYER_FOOTPRINT | SAT_MAP_LAYER_SELECTED))
+            != SAT_MAP_LAYER_FOOTPRINT)
+            continue;
+        if (footprint_points(layer, i, xs, ys) == closed)
+            footprint_path(layer, cr, xs, ys, closed);
+    }
+}
+
+static void draw_label(const sat_map_layer * layer, cairo_t * cr, guint i,
+                       guint32 col)
+{
+    cairo_text_extents_t ext;
+    gdouble         x, y;
+
+    project(layer, layer->lon[i], layer->lat[i], &x, &y);
+    cairo_text_extents(cr, layer->sat[i]->nickname, &ext);
+
+    /* keep the label on the map like the canvas labels do */
+    x -= ext.width / 2;
+    y += 2 + ext.height;
+    x = CLAMP(x, layer->x0, layer->x0 + layer->width - ext.width);
+    if (y > layer->y0 + layer->height)
+        y -= 4 + 2 * ext.height;
+
+    cairo_set_source_rgba(cr, 0, 0, 0, 0.8);
+    cairo_move_to(cr, x + 1, y + 1);
+    cairo_show_text(cr, layer->sat[i]->nickname);
+    set_source_rgba(cr, col);
+    cairo_move_to(cr, x, y);
+    cairo_show_text(cr, layer->sat[i]->nickname);
+}
+
+static gboolean on_draw(GtkWidget * canvas, cairo_t * cr, gpointer data)
+{
+    sat_map_layer  *layer = data;
+    gdouble         ox = 0, oy = 0, x, y;
+    gdouble         xs[FOOTPRINT_POINTS + 1], ys[FOOTPRINT_POINTS + 1];
+    gdouble         m = layer->marker_half;
+
+    if (layer->n == 0)
+        return FALSE;
+
+    /* canvas units to widget pixels */
+    goo_canvas_convert_to_pixels(GOO_CANVAS(canvas), &ox, &oy);
+
+    cairo_save(cr);
+    cairo_translate(cr, ox, oy);
+    cairo_scale(cr, goo_canvas_get_scale(GOO_CANVAS(canvas)),
+                goo_canvas_get_scale(GOO_CANVAS(canvas)));
+    cairo_rectangle(cr, layer->x0, layer->y0, layer->width, layer->height);
+    cairo_clip(cr);
+    cairo_set_line_width(cr, 1.0);
+
+    /* footprints, the ones wrapping around the map edge are not filled */
+    footprints_path(layer, cr, TRUE);
+    set_source_rgba(cr, layer->covcol);
+    cairo_fill_preserve(cr);
+    footprints_path(layer, cr, FALSE);
+    set_source_rgba(cr, layer->col);
+    cairo_stroke(cr);
+
+    /* markers of all satellites in one path */
+    for (guint i = 0; i < layer->n; i++) {
+        project(layer, layer->lon[i], layer->lat[i], &x, &y);
+        cairo_rectangle(cr, x - m, y - m, 2 * m, 2 * m);
+    }
+    cairo_fill(cr);
+
+    /* selected satellites on top, with their footprint and label */
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL,
+                           CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, LABEL_FONT_SIZE);
+    for (guint i = 0; i < layer->n; i++) {
+        if (!(layer->flags[i] & SAT_MAP_LAYER_SELECTED))
+            continue;
+
+        if (layer->flags[i] & SAT_MAP_LAYER_FOOTPRINT) {
+            gboolean        closed = footprint_points(layer, i, xs, ys);
+
+            footprint_path(layer, cr, xs, ys, closed);
+            if (closed) {
+                set_source_rgba(cr, layer->covcol);
+                cairo_fill_preserve(cr);
+            }
+            set_source_rgba(cr, layer->selcol);
+            cairo_stroke(cr);
+        }
+
+        project(layer, layer->lon[i], layer->lat[i], &x, &y);
+        set_source_rgba(cr, layer->selcol);
+        cairo_rectangle(cr, x - m, y - m, 2 * m, 2 * m);
+        cairo_fill(cr);
+        draw_label(layer, cr, i, layer->selcol);
+    }
+
+    if (layer->hover >= 0 && !(layer->flags[layer->hover] & SAT_MAP_LAYER_SELECTED))
+        draw_label(layer, cr, layer->hover, layer->col);
+
+    cairo_restore(cr);
+
+    return FALSE;
+}
+
+sat_map_layer  *sat_map_layer_new(GtkWidget * canvas, gdouble marker_half)
+{
+    sat_map_layer  *layer = g_new0(sat_map_layer, 1);
+
+    layer->canvas = canvas;
+    layer->hover = -1;
+    layer->marker_half = marker_half;
+    layer->draw_handler = g_signal_connect_after(canvas, "draw",
+                                                 G_CALLBACK(on_draw), layer);
+
+    return layer;
+}
+
+void sat_map_layer_free(sat_map_layer * layer)
+{
+    if (layer == NULL)
+        return;
+
+    g_signal_handler_disconnect(layer->canvas, layer->draw_handler);
+    g_free(layer->sat);
+    g_free(layer->lon);
+    g_free(layer->lat);
+    g_free(layer->radius);
+    g_free(layer->flags);
+    g_free(layer);
+}
+
+/**
+ * Whether a map showing sats should draw them with the layer.
+ *
+ * @param cfgdata Module configuration, BULK_THRESHOLD in section overrides
+ *                SAT_MAP_LAYER_DEFAULT_THRESHOLD. A negative value turns
+ *                the layer off.
+ */
+gboolean sat_map_use_layer(GKeyFile * cfgdata, const gchar * section,
+                           GHashTable * sats)
+{
+    gint            threshold = SAT_MAP_LAYER_DEFAULT_THRESHOLD;
+
+    if (cfgdata != NULL &&
+        g_key_file_has_key(cfgdata, section, MOD_CFG_MAP_BULK_THRESHOLD, NULL))
+        threshold = g_key_file_get_integer(cfgdata, section,
+                                           MOD_CFG_MAP_BULK_THRESHOLD, NULL);
+
+    return threshold >= 0 && sats != NULL &&
+        g_hash_table_size(sats) > (guint) threshold;
+}
+
+void sat_map_layer_set_projection(sat_map_layer * layer, gdouble x0,
+                                  gdouble y0, gdouble width, gdouble height,
+                                  gdouble left_side_lon)
+{
+    layer->x0 = x0;
+    layer->y0 = y0;
+    layer->width = width;
+    layer->height = height;
+    layer->left_side_lon = left_side_lon;
+}
+
+void sat_map_layer_set_colours(sat_map_layer * layer, guint32 col,
+                               guint32 selcol, guint32 covcol)
+{
+    layer->col = col;
+    layer->selcol = selcol;
+    layer->covcol = covcol;
+}
+
+void sat_map_layer_clear(sat_map_layer * layer)
+{
+    layer->n = 0;
+}
+
+void sat_map_layer_add(sat_map_layer * layer, sat_t * sat, guint8 flags)
+{
+    reserve(layer, layer->n + 1);
+
+    layer->sat[layer->n] = sat;
+    layer->lon[layer->n] = sat->ssplon;
+    layer->lat[layer->n] = sat->ssplat;
+    /* footprint is the diameter along the surface */
+    layer->radius[layer->n] = sat->footprint / (2 * xkmper);
+    layer->flags[layer->n] = flags;
+    layer->n++;
+}
+
+void sat_map_layer_commit(sat_map_layer * layer)
+{
+    if (layer->hover >= (gint) layer->n)
+        layer->hover = -1;
+    gtk_widget_queue_draw(layer->canvas);
+}
+
+static gint nearest_index(const sat_map_layer * layer, gdouble x, gdouble y,
+                          gdouble range)
+{
+    gdouble         best = range * range;
+    gint            found = -1;
+    gdouble         px, py;
+
+    for (guint i = 0; i < layer->n; i++) {
+        project(layer, layer->lon[i], layer->lat[i], &px, &py);
+        gdouble         d2 = (px - x) * (px - x) + (py - y) * (py - y);
+
+        if (d2 <= best) {
+            best = d2;
+            found = (gint) i;
+        }
+    }
+
+    return found;
+}
+
+sat_t          *sat_map_layer_pick(sat_map_layer * layer, gdouble x,
+                                   gdouble y, gdouble range)
+{
+    gint            i = nearest_index(layer, x, y, range);
+
+    return i < 0 ? NULL : layer->sat[i];
+}
+
+gboolean sat_map_layer_hover(sat_map_layer * layer, gdouble x, gdouble y)
+{
+    gint            i = nearest_index(layer, x, y, 2 * layer->marker_half + 3);
+
+    if (i == layer->hover)
+        return FALSE;
+
+    layer->hover = i;
+    gtk_widget_queue_draw(layer->canvas);
+    return TRUE;
+}
@@ -0,0 +1,88 @@
+#ifndef __SAT_MAP_LAYER_H__
+#define __SAT_MAP_LAYER_H__
+
+#include <glib.h>
+#include <gtk/gtk.h>
+
+#include "gtk-sat-data.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Maps switch to the layer above this many satellites, see MOD_CFG_MAP_BULK_THRESHOLD */
+#define SAT_MAP_LAYER_DEFAULT_THRESHOLD 500
+
+/* Per satellite drawing flags */
+#define SAT_MAP_LAYER_SELECTED  (1 << 0)
+#define SAT_MAP_LAYER_FOOTPRINT (1 << 1)
+
+/*
+ * Satellite markers, footprints and labels of a map drawn in one cairo pass
+ * over the canvas instead of six canvas items per satellite. Positions are
+ * kept in packed arrays that the owner refills every update; labels are only
+ * drawn for selected satellites and the one under the pointer.
+ */
+typedef struct {
+    GtkWidget      *canvas;     /* not owned */
+    gulong          draw_handler;
+
+    guint           n;
+    guint           capacity;
+    sat_t         **sat;        /* not owned */
+    gfloat         *lon;        /* degrees east */
+    gfloat         *lat;        /* degrees north */
+    gfloat         *radius;     /* footprint radius, radians of arc */
+    guint8         *flags;
+
+    gint            hover;      /* index under the pointer, -1 for none */
+
+    /* projection, same as the map's lonlat_to_xy */
+    gdouble         x0;
+    gdouble         y0;
+    gdouble         width;
+    gdouble         height;
+    gdouble         left_side_lon;
+
+    guint32         col;        /* satellite colour, RGBA */
+    guint32         selcol;     /* selected satellite colour */
+    guint32         covcol;     /* footprint fill colour */
+    gdouble         marker_half;
+} sat_map_layer;
+
+sat_map_layer  *sat_map_layer_new(GtkWidget * canvas, gdouble marker_half);
+void            sat_map_layer_free(sat_map_layer * layer);
+
+gboolean        sat_map_use_layer(GKeyFile * cfgdata, const gchar * section,
+                                  GHashTable * sats);
+
+void            sat_map_layer_set_projection(sat_map_layer * layer,
+                                             gdouble x0, gdouble y0,
+                                             gdouble width, gdouble height,
+                                             gdouble left_side_lon);
+void            sat_map_layer_set_colours(sat_map_layer * layer, guint32 col,
+                                          guint32 selcol, guint32 covcol);
+
+/* Refill: clear, add every satellite shown, then commit to redraw */
+void            sat_map_layer_clear(sat_map_layer * layer);
+void            sat_map_layer_add(sat_map_layer * layer, sat_t * sat,
+                                  guint8 flags);
+void            sat_map_layer_commit(sat_map_layer * layer);
+
+/* Satellite within range canvas units of (x, y), NULL when there is none */
+sat_t          *sat_map_layer_pick(sat_map_layer * layer, gdouble x,
+                                   gdouble y, gdouble range);
+
+/* Hover label follows the pointer, returns TRUE if it changed */
+gboolean        sat_map_layer_hover(sat_map_layer * layer, gdouble x,
+                                    gdouble y);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
@@ -0,0 +1,442 @@
+/*
+ * Simulation of the satellites of a module on its own thread.
+ *
+ * The thread propagates private copies of the module's satellites, keeps
+ * their AOS/LOS up to date with an event queue and writes the result into a
+ * snapshot buffer, splitting the propagation over a thread pool for large
+ * modules. There are three buffers: the main loop reads the front one, the
+ * simulation writes the back one and a finished snapshot waits in the
+ * middle. Publishing and picking up a snapshot are both one atomic swap of
+ * a buffer index, so neither side ever waits for the other, a snapshot is
+ * never written while it is read, and the simulation can produce snapshots
+ * faster or slower than the main loop shows them.
+ *
+ * The module time is extrapolated from the last clock the main loop set,
+ * so the simulation keeps pace with any throttle between module cycles.
+ */
+#include <math.h>
+
+#include "event-queue.h"
+#include "predict-tools.h"
+#include "sat-snapshot.h"
+
+// below this, starting the workers costs more than it saves
+#define SNAPSHOT_MIN_PARALLEL 64
+
+// satellites whose AOS/LOS may be recomputed in one snapshot, at least
+#define SNAPSHOT_EVENT_BUDGET 50
+
+// periods without a new clock after which the simulation pauses
+#define SNAPSHOT_IDLE_PERIODS 3
+
+// periods a snapshot may lag behind the clock and still be current
+#define SNAPSHOT_CURRENT_PERIODS 2
+
+// set on the middle buffer index when it holds a snapshot not picked up yet
+#define SNAPSHOT_FRESH 4
+
+typedef struct {
+    guint first;
+    guint last;
+} snapshot_chunk;
+
+typedef struct {
+    gdouble t;
+    sat_state_t *states;    // index-aligned with the satellites
+} snapshot_buf;
+
+typedef struct {
+    gdouble t;              // module time at mono
+    gint64 mono;            // monotonic time the clock was set at, usec
+    gint throttle;
+    gdouble maxdt;
+    guint period;
+    gdouble lat;
+    gdouble lon;
+    gdouble alt;
+} snapshot_clock;
+
+struct sat_snapshot {
+    GThreadPool *pool;
+    guint threads;
+
+    GPtrArray *sats;        // sat_t of the module, not owned, main loop only
+    sat_t *sim;             // private copies, simulation only
+    guint n;
+    event_queue *events;    // over the private copies
+    snapshot_chunk *chunks;
+    guint nchunks;
+
+    // step in progress, read-only for the workers
+    qth_t qth;
+    gdouble t;
+    sat_state_t *out;
+    GMutex pool_lock;
+    GCond pool_done;
+    guint pending;
+
+    // events are stale when time went backwards or the location moved
+    gboolean started;
+    gdouble last_t;
+    gdouble last_clock_t;
+    qth_small_t last_qth;
+
+    snapshot_buf bufs[3];
+    guint front;            // main loop
+    guint back;             // simulation
+    gint middle;            // swapped atomically, maybe with SNAPSHOT_FRESH
+
+    GThread *thread;
+    GMutex lock;            // clock and quit
+    GCond wake;
+    snapshot_clock clock;
+    gboolean quit;
+};
+
+static void state_save(sat_state_t *state, const sat_t *sat)
+{
+    state->catnum = sat->tle.catnr;
+    state->pos = sat->pos;
+    state->vel = sat->vel;
+    state->jul_utc = sat->jul_utc;
+    state->tsince = sat->tsince;
+    state->aos = sat->aos;
+    state->los = sat->los;
+    state->az = sat->az;
+    state->el = sat->el;
+    state->range = sat->range;
+    state->range_rate = sat->range_rate;
+    state->ssplat = sat->ssplat;
+    state->ssplon = sat->ssplon;
+    state->alt = sat->alt;
+    state->velo = sat->velo;
+    state->ma = sat->ma;
+    state->footprint = sat->footprint;
+    state->phase = sat->phase;
+    state->orbit = sat->orbit;
+}
+
+static void state_apply(const sat_state_t *state, sat_t *sat)
+{
+    sat->pos = state->pos;
+    sat->vel = state->vel;
+    sat->jul_utc = state->jul_utc;
+    sat->tsince = state->tsince;
+    sat->aos = state->aos;
+    sat->los = state->los;
+    sat->az = state->az;
+    sat->el = state->el;
+    sat->range = state->range;
+    sat->range_rate = state->range_rate;
+    sat->ssplat = state->ssplat;
+    sat->ssplon = state->ssplon;
+    sat->alt = state->alt;
+    sat->velo = state->velo;
+    sat->ma = state->ma;
+    sat->footprint = state->footprint;
+    sat->phase = state->phase;
+    sat->orbit = state->orbit;
+}
+
+// g_atomic_int_exchange() is too new for the GLib we build against
+static gint atomic_exchange(gint *atomic, gint value)
+{
+    gint old;
+
+    do {
+        old = g_atomic_int_get(atomic);
+    } while (!g_atomic_int_compare_and_exchange(atomic, old, value));
+
+    return old;
+}
+
+static void propagate_range(sat_snapshot *snap, guint first, guint last)
+{
+    for (guint i = first; i < last; i++) {
+        predict_calc(&snap->sim[i], &snap->qth, snap->t);
+        state_save(&snap->out[i], &snap->sim[i]);
+    }
+}
+
+static void propagate_chunk(gpointer data, gpointer user_data)
+{
+    snapshot_chunk *chunk = data;
+    sat_snapshot *snap = user_data;
+
+    propagate_range(snap, chunk->first, chunk->last);
+
+    g_mutex_lock(&snap->pool_lock);
+    if (--snap->pending == 0)
+        g_cond_signal(&snap->pool_done);
+    g_mutex_unlock(&snap->pool_lock);
+}
+
+// One snapshot into the back buffer, then publish it
+static void step(sat_snapshot *snap, const snapshot_clock *clock)
+{
+    snapshot_buf *buf = &snap->bufs[snap->back];
+    gdouble t = clock->t;
+    gboolean reversed;
+    guint budget;
+
+    if (clock->throttle)
+        t += clock->throttle * (g_get_monotonic_time() - clock->mono) / 8.64e10;
+
+    /* the extrapolation may overshoot the next clock the main loop sets, so
+       with time running forward only a clock going back is a reversal */
+    if (clock->throttle >= 0) {
+        reversed = snap->started && clock->t < snap->last_clock_t;
+        if (snap->started && !reversed)
+            t = MAX(t, snap->last_t);
+    } else {
+        reversed = snap->started && t < snap->last_t;
+    }
+
+    snap->qth.lat = clock->lat;
+    snap->qth.lon = clock->lon;
+    snap->qth.alt = clock->alt;
+
+    if (!snap->started || reversed || qth_small_dist(&snap->qth, snap->last_qth) > 1.0) {
+        event_queue_expire_all(snap->events);
+        qth_small_save(&snap->qth, &snap->last_qth);
+        snap->started = TRUE;
+    }
+    snap->last_t = t;
+    snap->last_clock_t = clock->t;
+
+    // every satellite can be recomputed within a minute
+    budget = (guint)((guint64)snap->n * clock->period / 60000) + 1;
+    event_queue_update(snap->events, &snap->qth, t, clock->maxdt, MAX(budget, SNAPSHOT_EVENT_BUDGET));
+
+    snap->t = t;
+    snap->out = buf->states;
+    if (snap->n < SNAPSHOT_MIN_PARALLEL || snap->threads < 2) {
+        propagate_range(snap, 0, snap->n);
+    } else {
+        snap->pending = snap->nchunks;
+        for (guint c = 0; c < snap->nchunks; c++)
+            g_thread_pool_push(snap->pool, &snap->chunks[c], NULL);
+
+        g_mutex_lock(&snap->pool_lock);
+        while (snap->pending > 0)
+            g_cond_wait(&snap->pool_done, &snap->pool_lock);
+        g_mutex_unlock(&snap->pool_lock);
+    }
+    buf->t = t;
+
+    snap->back = atomic_exchange(&snap->middle, snap->back | SNAPSHOT_FRESH) & ~SNAPSHOT_FRESH;
+}
+
+// Nobody picks up the waiting snapshot while paused, and it is old by then
+static void drop_fresh(sat_snapshot *snap)
+{
+    gint middle = g_atomic_int_get(&snap->middle);
+
+    // fails only when the main loop took it in the meantime
+    if (middle & SNAPSHOT_FRESH)
+        g_atomic_int_compare_and_exchange(&snap->middle, middle, middle & ~SNAPSHOT_FRESH);
+}
+
+static gpointer simulate(gpointer data)
+{
+    sat_snapshot *snap = data;
+    snapshot_clock clock;
+    gint64 next = g_get_monotonic_time();
+    gint64 now, period;
+
+    g_mutex_lock(&snap->lock);
+    while (!snap->quit) {
+        clock = snap->clock;
+        now = g_get_monotonic_time();
+        period = (gint64)MAX(clock.period, 1) * 1000;
+
+        // the main loop stopped showing snapshots, e.g. a hidden module
+        if (now - clock.mono > SNAPSHOT_IDLE_PERIODS * period) {
+            drop_fresh(snap);
+            g_cond_wait(&snap->wake, &snap->lock);
+            next = g_get_monotonic_time();
+            continue;
+        }
+        if (now < next) {
+            g_cond_wait_until(&snap->wake, &snap->lock, next);
+            continue;
+        }
+
+        g_mutex_unlock(&snap->lock);
+        step(snap, &clock);
+        next = MAX(next + period, g_get_monotonic_time());
+        g_mutex_lock(&snap->lock);
+    }
+    g_mutex_unlock(&snap->lock);
+
+    return NULL;
+}
+
+static void stop(sat_snapshot *snap)
+{
+    if (!snap->thread)
+        return;
+
+    g_mutex_lock(&snap->lock);
+    snap->quit = TRUE;
+    g_cond_signal(&snap->wake);
+    g_mutex_unlock(&snap->lock);
+
+    g_thread_join(snap->thread);
+    snap->thread = NULL;
+    snap->quit = FALSE;
+}
+
+static void clear(sat_snapshot *snap)
+{
+    event_queue_clear(snap->events);
+    g_ptr_array_set_size(snap->sats, 0);
+    g_free(snap->sim);
+    snap->sim = NULL;
+    snap->n = 0;
+    for (guint b = 0; b < 3; b++) {
+        g_free(snap->bufs[b].states);
+        snap->bufs[b].states = NULL;
+    }
+    g_free(snap->chunks);
+    snap->chunks = NULL;
+    snap->nchunks = 0;
+}
+
+sat_snapshot *sat_snapshot_new(guint threads)
+{
+    sat_snapshot *snap = g_new0(sat_snapshot, 1);
+
+    snap->threads = threads ? threads : g_get_num_processors();
+    snap->sats = g_ptr_array_new();
+    snap->events = event_queue_new();
+    g_mutex_init(&snap->pool_lock);
+    g_cond_init(&snap->pool_done);
+    g_mutex_init(&snap->lock);
+    g_cond_init(&snap->wake);
+    snap->pool = g_thread_pool_new(propagate_chunk, snap, (gint)snap->threads, FALSE, NULL);
+
+    return snap;
+}
+
+void sat_snapshot_free(sat_snapshot *snap)
+{
+    if (!snap)
+        return;
+
+    stop(snap);
+    clear(snap);
+
+    // nothing is queued outside a step
+    g_thread_pool_free(snap->pool, FALSE, TRUE);
+    g_mutex_clear(&snap->pool_lock);
+    g_cond_clear(&snap->pool_done);
+    g_mutex_clear(&snap->lock);
+    g_cond_clear(&snap->wake);
+
+    g_ptr_array_free(snap->sats, TRUE);
+    event_queue_free(snap->events);
+    g_free(snap);
+}
+
+void sat_snapshot_set_clock(sat_snapshot *snap, qth_t *qth, gdouble t, gint throttle,
+                            gdouble maxdt, guint period)
+{
+    g_mutex_lock(&snap->lock);
+    snap->clock.t = t;
+    snap->clock.mono = g_get_monotonic_time();
+    snap->clock.throttle = throttle;
+    snap->clock.maxdt = maxdt;
+    snap->clock.period = period;
+    snap->clock.lat = qth->lat;
+    snap->clock.lon = qth->lon;
+    snap->clock.alt = qth->alt;
+    g_cond_signal(&snap->wake);
+    g_mutex_unlock(&snap->lock);
+}
+
+void sat_snapshot_set_sats(sat_snapshot *snap, GHashTable *sats)
+{
+    GHashTableIter iter;
+    gpointer sat;
+    snapshot_clock clock;
+    guint size;
+
+    stop(snap);
+    clear(snap);
+
+    if (sats == NULL)
+        return;
+
+    // the copies share the name strings, which the simulation never touches
+    g_hash_table_iter_init(&iter, sats);
+    while (g_hash_table_iter_next(&iter, NULL, &sat))
+        g_ptr_array_add(snap->sats, sat);
+    snap->n = snap->sats->len;
+
+    snap->sim = g_new0(sat_t, MAX(snap->n, 1));
+    for (guint i = 0; i < snap->n; i++) {
+        snap->sim[i] = *SAT(g_ptr_array_index(snap->sats, i));
+        event_queue_add(snap->events, &snap->sim[i]);
+    }
+    for (guint b = 0; b < 3; b++)
+        snap->bufs[b].states = g_new0(sat_state_t, MAX(snap->n, 1));
+
+    // a few chunks per worker so an uneven split does not leave them idle
+    snap->nchunks = MIN(snap->n, 4 * snap->threads);
+    snap->chunks = g_new0(snapshot_chunk, MAX(snap->nchunks, 1));
+    size = snap->nchunks ? (snap->n + snap->nchunks - 1) / snap->nchunks : 0;
+    for (guint c = 0; c < snap->nchunks; c++) {
+        snap->chunks[c].first = MIN(c * size, snap->n);
+        snap->chunks[c].last = MIN((c + 1) * size, snap->n);
+    }
+
+    snap->front = 0;
+    snap->middle = 1;
+    snap->back = 2;
+    snap->started = FALSE;
+
+    // the first snapshot is ready before the views are drawn
+    g_mutex_lock(&snap->lock);
+    clock = snap->clock;
+    g_mutex_unlock(&snap->lock);
+    step(snap, &clock);
+    sat_snapshot_acquire(snap);
+    sat_snapshot_restore(snap);
+
+    snap->thread = g_thread_new("sat-snapshot", simulate, snap);
+}
+
+gboolean sat_snapshot_acquire(sat_snapshot *snap)
+{
+    if (!(g_atomic_int_get(&snap->middle) & SNAPSHOT_FRESH))
+        return FALSE;
+
+    snap->front = atomic_exchange(&snap->middle, snap->front) & ~SNAPSHOT_FRESH;
+
+    return TRUE;
+}
+
+gdouble sat_snapshot_time(sat_snapshot *snap)
+{
+    return snap->bufs[snap->front].t;
+}
+
+gboolean sat_snapshot_current(sat_snapshot *snap)
+{
+    gdouble lag;
+
+    // the clock is only written by the main loop, which is the caller
+    lag = SNAPSHOT_CURRENT_PERIODS * MAX(ABS(snap->clock.throttle), 1) *
+          MAX(snap->clock.period, 1) / 8.64e7;
+
+    return fabs(snap->bufs[snap->front].t - snap->clock.t) <= lag;
+}
+
+void sat_snapshot_restore(sat_snapshot *snap)
+{
+    sat_state_t *states = snap->bufs[snap->front].states;
+
+    for (guint i = 0; i < snap->sats->len; i++)
+        state_apply(&states[i], g_ptr_array_index(snap->sats, i));
+}
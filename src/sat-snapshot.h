@@ -0,0 +1,89 @@
+#ifndef __SAT_SNAPSHOT_H__
+#define __SAT_SNAPSHOT_H__
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/* Everything predict_calc() sets in a sat_t, plus the next AOS/LOS */
+typedef struct {
+    gint            catnum;
+    vector_t        pos;
+    vector_t        vel;
+    gdouble         jul_utc;
+    gdouble         tsince;
+    gdouble         aos;
+    gdouble         los;
+    gdouble         az;
+    gdouble         el;
+    gdouble         range;
+    gdouble         range_rate;
+    gdouble         ssplat;
+    gdouble         ssplon;
+    gdouble         alt;
+    gdouble         velo;
+    gdouble         ma;
+    gdouble         footprint;
+    gdouble         phase;
+    glong           orbit;
+} sat_state_t;
+
+/*
+ * State of all satellites of a module, produced by a simulation thread at
+ * its own rate. The thread works on private copies of the satellites and
+ * publishes every finished snapshot; the main loop picks up the newest one
+ * without locking and copies it into the module's satellites, which the
+ * views keep reading and scribbling on as before.
+ */
+typedef struct sat_snapshot sat_snapshot;
+
+// threads = 0 uses one per processor for the propagation
+sat_snapshot   *sat_snapshot_new(guint threads);
+void            sat_snapshot_free(sat_snapshot * snap);
+
+/*
+ * Module time t now, advancing throttle times faster than real time, the
+ * location, the AOS/LOS look ahead in days and the time between snapshots
+ * in msec. Called every module cycle; the simulation pauses when the calls
+ * stop for a few periods.
+ */
+void            sat_snapshot_set_clock(sat_snapshot * snap, qth_t * qth,
+                                       gdouble t, gint throttle,
+                                       gdouble maxdt, guint period);
+
+/*
+ * Stop the simulation and take copies of the satellites in sats, which
+ * must not change until the next call; NULL just stops. The first snapshot
+ * is computed and restored before this returns.
+ */
+void            sat_snapshot_set_sats(sat_snapshot * snap, GHashTable * sats);
+
+/* Switch to the newest finished snapshot, FALSE if there is none newer */
+gboolean        sat_snapshot_acquire(sat_snapshot * snap);
+
+/* Module time of the current snapshot */
+gdouble         sat_snapshot_time(sat_snapshot * snap);
+
+/*
+ * Whether the current snapshot is within a couple of periods of the last
+ * clock. It is not right after a paused simulation resumes, or after the
+ * time was set by hand, until the next snapshot is finished.
+ */
+gboolean        sat_snapshot_current(sat_snapshot * snap);
+
+/* Copy the current snapshot into the satellites given to set_sats */
+void            sat_snapshot_restore(sat_snapshot * snap);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
@@ -130,13 +130,9 @@ void Calculate_Obs(double _time, vector_t * pos,
 /* Correction is meaningless when apparent elevation is below horizon */
 //      obs_set->el = obs_set->el + Radians((1.02/tan(Radians(Degrees(el)+
 //                                                            10.3/(Degrees(el)+5.11))))/60);
-    if (obs_set->el >= 0)
-        SetFlag(VISIBLE_FLAG);
-    else
-    {
-        obs_set->el = el;       /*Reset to true elevation */
-        ClearFlag(VISIBLE_FLAG);
-    }
+
+/* VISIBLE_FLAG is not set here; nothing reads it and the global flags are
+   not safe to write from the threads predict_calc() runs on */
 }
 
 void Calculate_RADec_and_Obs(double _time, vector_t * pos, vector_t * vel,
@@ -20,6 +20,7 @@
 #include "skr-utils.h"
 #include "calc-dist-two-sat.h"
 #include "max-capacity-path/path-util.h"
+#include "max-capacity-path/fibre-backbone.h"
 
 /* Constant parameters for SKR calculation based on the provided Python scriptsand paper */
 #define ALPHA_MOD_AMP 2.236       // sqrt(5) -> Corresponds to VA = 5 SNU
@@ -32,9 +33,6 @@
 #define TRANSMITTER_OPTICS_EFF 0.95 // Transmitter optics efficiency (Tt)
 #define RECEIVER_OPTICS_EFF 0.95    // Receiver optics efficiency (Tr)
 #define POINTING_LOSS 0.1          // Pointing loss (Lp)
-#define ATMOSPHERE_THICKNESS 20.0  // Effective atmosphere thickness in km
-#define VISIBILITY 200.0           // Atmospheric visibility in km
-#define CN2 1e-16                  // Refractive index structure parameter (good conditions)
 #define P_TH 1e-6                  // Outage time fraction for scintillation
 #define INTER_SAT_APT_RADIUS 0.2   // Inter-satellite aperture radius (ra) in meters
 #define INTER_SAT_BEAM_WAIST 0.2   // Inter-satellite beam waist (w0) in meters
@@ -48,8 +46,8 @@ static gdouble key_rate_finite(gdouble transmittance, gdouble alpha, gdouble ksi
 static gdouble haversine_dist_calc(gdouble lat1, gdouble lon1, gdouble lat2, gdouble lon2);
 static gdouble atmosphere_length(gdouble elevation_angle, gdouble ogs_altitude_km);
 static gdouble ugaussian_Pinv_approx(gdouble p);
-static gdouble transmittance_downlink(gdouble link_dist_km, gdouble elevation_angle, gdouble ogs_altitude_km);
-static gdouble transmittance_uplink(gdouble link_dist_km, gdouble elevation_angle, gdouble ogs_altitude_km);
+static gdouble transmittance_downlink(gdouble link_dist_km, gdouble elevation_angle, gdouble ogs_altitude_km, gdouble visibility, gdouble cn2);
+static gdouble transmittance_uplink(gdouble link_dist_km, gdouble elevation_angle, gdouble ogs_altitude_km, gdouble visibility, gdouble cn2);
 static gdouble transmittance_inter_satellite(gdouble distance_km);
 static gdouble transmittance_fibre(gdouble distance_km);
 
@@ -220,10 +218,12 @@ static gdouble ugaussian_Pinv_approx(gdouble p)
  * @link_dist_km: The total link distance in km.
  * @elevation_angle: The satellite's elevation angle in degrees.
  * @ogs_altitude_km: The altitude of the ground station in km.
+ * @visibility: Atmospheric visibility at the ground station in km.
+ * @cn2: Refractive index structure parameter at the ground station.
  *
  * Return: The downlink transmittance (0 to 1).
  */
-static gdouble transmittance_downlink(gdouble link_dist_km, gdouble elevation_angle, gdouble ogs_altitude_km)
+static gdouble transmittance_downlink(gdouble link_dist_km, gdouble elevation_angle, gdouble ogs_altitude_km, gdouble visibility, gdouble cn2)
 {
     gdouble L_total_m = link_dist_km * 1000.0;
     gdouble L_atm_eff_km = atmosphere_length(elevation_angle, ogs_altitude_km);
@@ -235,11 +235,11 @@ static gdouble transmittance_downlink(gdouble link_dist_km, gdouble elevation_an
                                       TRANSMITTER_OPTICS_EFF * (1.0 - POINTING_LOSS) * RECEIVER_OPTICS_EFF));
 
     // Mie Scattering Loss (Kim Model)
-    gdouble p = (VISIBILITY >= 50.0) ? 1.6 :
-                (VISIBILITY >= 6.0)  ? 1.3 :
-                (VISIBILITY >= 1.0)  ? 0.16 * VISIBILITY + 0.34 :
-                (VISIBILITY >= 0.5)  ? VISIBILITY - 0.5 : 0.0;
-    gdouble mie_scat_db_per_km = (4.343 * 3.912 / VISIBILITY) * pow(WAVELENGTH / 550e-9, -p);
+    gdouble p = (visibility >= 50.0) ? 1.6 :
+                (visibility >= 6.0)  ? 1.3 :
+                (visibility >= 1.0)  ? 0.16 * visibility + 0.34 :
+                (visibility >= 0.5)  ? visibility - 0.5 : 0.0;
+    gdouble mie_scat_db_per_km = (4.343 * 3.912 / visibility) * pow(WAVELENGTH / 550e-9, -p);
     gdouble total_mie_loss_db = mie_scat_db_per_km * L_atm_eff_km;
 
     // Scintillation Loss
@@ -247,7 +247,7 @@ static gdouble transmittance_downlink(gdouble link_dist_km, gdouble elevation_an
     gdouble k = 2.0 * G_PI / WAVELENGTH;
 
     // Rytov variance (using analytical solution for the integral)
-    gdouble integral_result = CN2 * (6.0 / 11.0) * pow(L_atm_eff_m, 11.0 / 6.0);
+    gdouble integral_result = cn2 * (6.0 / 11.0) * pow(L_atm_eff_m, 11.0 / 6.0);
     gdouble rytov_var = 2.25 * pow(k, 7.0 / 6.0) * integral_result;
 
     // Scintillation index (spherical wave)
@@ -270,10 +270,12 @@ static gdouble transmittance_downlink(gdouble link_dist_km, gdouble elevation_an
  * @link_dist_km: The total link distance in km.
  * @elevation_angle: The satellite's elevation angle in degrees.
  * @ogs_altitude_km: The altitude of the ground station in km.
+ * @visibility: Atmospheric visibility at the ground station in km.
+ * @cn2: Refractive index structure parameter at the ground station.
  *
  * Return: The uplink transmittance (0 to 1).
  */
-static gdouble transmittance_uplink(gdouble link_dist_km, gdouble elevation_angle, gdouble ogs_altitude_km)
+static gdouble transmittance_uplink(gdouble link_dist_km, gdouble elevation_angle, gdouble ogs_altitude_km, gdouble visibility, gdouble cn2)
 {
     gdouble L_total_m = link_dist_km * 1000.0;
     gdouble L_atm_eff_km = atmosphere_length(elevation_angle, ogs_altitude_km);
@@ -285,11 +287,11 @@ static gdouble transmittance_uplink(gdouble link_dist_km, gdouble elevation_angl
                                       TRANSMITTER_OPTICS_EFF * (1.0 - POINTING_LOSS) * RECEIVER_OPTICS_EFF));
 
     // Mie Scattering Loss is the same
-    gdouble p = (VISIBILITY >= 50.0) ? 1.6 :
-                (VISIBILITY >= 6.0)  ? 1.3 :
-                (VISIBILITY >= 1.0)  ? 0.16 * VISIBILITY + 0.34 :
-                (VISIBILITY >= 0.5)  ? VISIBILITY - 0.5 : 0.0;
-    gdouble mie_scat_db_per_km = (4.343 * 3.912 / VISIBILITY) * pow(WAVELENGTH / 550e-9, -p);
+    gdouble p = (visibility >= 50.0) ? 1.6 :
+                (visibility >= 6.0)  ? 1.3 :
+                (visibility >= 1.0)  ? 0.16 * visibility + 0.34 :
+                (visibility >= 0.5)  ? visibility - 0.5 : 0.0;
+    gdouble mie_scat_db_per_km = (4.343 * 3.912 / visibility) * pow(WAVELENGTH / 550e-9, -p);
     gdouble total_mie_loss_db = mie_scat_db_per_km * L_atm_eff_km;
 
     // Scintillation Loss (Uplink has higher scintillation)
@@ -297,7 +299,7 @@ static gdouble transmittance_uplink(gdouble link_dist_km, gdouble elevation_angl
     gdouble k = 2.0 * G_PI / WAVELENGTH;
 
     // Rytov variance (using analytical solution for the integral)
-    gdouble integral_result = CN2 * (6.0 / 11.0) * pow(L_atm_eff_m, 11.0 / 6.0);
+    gdouble integral_result = cn2 * (6.0 / 11.0) * pow(L_atm_eff_m, 11.0 / 6.0);
     gdouble rytov_var = 2.25 * pow(k, 7.0 / 6.0) * integral_result;
 
     // Uplink scintillation index is higher
@@ -367,6 +369,31 @@ gdouble fibre_link(qth_t *ground1, qth_t *ground2)
     return key_rate_finite(T, ALPHA_MOD_AMP, EXCESS_NOISE);
 }
 
+//light weight version, rate of a fibre of given length in history units
+gdouble lw_fibre_link(gdouble distance_km)
+{
+    if (distance_km < 0) {
+        return 0.0;
+    }
+
+    gdouble T = transmittance_fibre(distance_km);
+
+    // (bits per second) * scale = (kilobytes per day)
+    return key_rate_finite(T, ALPHA_MOD_AMP, EXCESS_NOISE) * SKR_SCALE;
+}
+
+/*
+ * ground_distance() - Great-circle distance between two ground stations.
+ * @ground1: Pointer to the first ground station data structure.
+ * @ground2: Pointer to the second ground station data structure.
+ *
+ * Return: The distance in kilometers.
+ */
+gdouble ground_distance(qth_t *ground1, qth_t *ground2)
+{
+    return haversine_dist_calc(ground1->lat, ground1->lon, ground2->lat, ground2->lon);
+}
+
 /*
  * ground_to_sat_uplink() - Calculates the SKR for a ground-to-satellite uplink.
  * @ground: Pointer to the ground station data structure.
@@ -384,13 +411,13 @@ gdouble ground_to_sat_uplink(qth_t *ground, sat_t *sat)
     gdouble elevation = sat->el;
     gdouble qth_altitude = ground->alt / 1000.0;
 
-    gdouble T = transmittance_uplink(distance, elevation, qth_altitude);
+    gdouble T = transmittance_uplink(distance, elevation, qth_altitude, SKR_DEFAULT_VISIBILITY, SKR_DEFAULT_CN2);
 
     return key_rate_finite(T, ALPHA_MOD_AMP, EXCESS_NOISE);
 }
 
 //light weight version
-gdouble lw_ground_to_sat_uplink(qth_t *ground, gdouble elevation, gdouble range)
+gdouble lw_ground_to_sat_uplink(qth_t *ground, gdouble elevation, gdouble range, gdouble visibility, gdouble cn2)
 {
     if (!ground || elevation < 0) {
         return 0.0;
@@ -398,7 +425,7 @@ gdouble lw_ground_to_sat_uplink(qth_t *ground, gdouble elevation, gdouble range)
     
     gdouble qth_altitude = ground->alt / 1000.0;
 
-    gdouble T = transmittance_uplink(range, elevation, qth_altitude);
+    gdouble T = transmittance_uplink(range, elevation, qth_altitude, visibility, cn2);
 
     return key_rate_finite(T, ALPHA_MOD_AMP, EXCESS_NOISE) * SKR_SCALE;
 }
@@ -420,13 +447,13 @@ gdouble sat_to_ground_downlink(sat_t *sat, qth_t *ground)
     gdouble elevation = sat->el;
     gdouble qth_altitude = ground->alt / 1000.0;
 
-    gdouble T = transmittance_downlink(distance, elevation, qth_altitude);
+    gdouble T = transmittance_downlink(distance, elevation, qth_altitude, SKR_DEFAULT_VISIBILITY, SKR_DEFAULT_CN2);
 
     return key_rate_finite(T, ALPHA_MOD_AMP, EXCESS_NOISE);
 }
 
 //light weight version
-gdouble lw_sat_to_ground_downlink(qth_t *ground, gdouble elevation, gdouble range)
+gdouble lw_sat_to_ground_downlink(qth_t *ground, gdouble elevation, gdouble range, gdouble visibility, gdouble cn2)
 {
     if (!ground || elevation < 0) {
         return 0.0;
@@ -434,7 +461,7 @@ gdouble lw_sat_to_ground_downlink(qth_t *ground, gdouble elevation, gdouble rang
 
     gdouble qth_altitude = ground->alt / 1000.0;
 
-    gdouble T = transmittance_downlink(range, elevation, qth_altitude);
+    gdouble T = transmittance_downlink(range, elevation, qth_altitude, visibility, cn2);
 
     return key_rate_finite(T, ALPHA_MOD_AMP, EXCESS_NOISE) * SKR_SCALE;
 }
@@ -470,12 +497,38 @@ gdouble lw_inter_sat_link(vector_t *pos1, vector_t *pos2)
     gdouble distance = dist_calc_driver(
             pos1->x, pos1->y, pos1->z,
             pos2->x, pos2->y, pos2->z);
-    gdouble T = transmittance_inter_satellite(distance);
+
+    return lw_inter_sat_link_length(distance);
+}
+
+gdouble lw_inter_sat_link_length(gdouble distance_km)
+{
+    gdouble T = transmittance_inter_satellite(distance_km);
 
     // (bits per second) * scale = (kilobytes per day)
     return  key_rate_finite(T, ALPHA_MOD_AMP, EXCESS_NOISE) * SKR_SCALE;
 }
 
+/*
+ * The rate only falls with distance (transmittance falls, the key rate rises
+ * with transmittance), so the reach is found by bisection to a millimetre.
+ */
+gdouble inter_sat_link_reach(gdouble skr)
+{
+    gdouble lo = 0.0, hi = 1000.0;
+
+    if (lw_inter_sat_link_length(0.0) < skr) return 0.0;
+
+    while (lw_inter_sat_link_length(hi) >= skr && hi < 1e9) hi *= 2;
+    while (hi - lo > 1e-6) {
+        gdouble mid = 0.5 * (lo + hi);
+        if (lw_inter_sat_link_length(mid) >= skr) lo = mid;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
 
 /**
  * Calc topocentric range and elevation
@@ -496,8 +549,26 @@ void calc_topocentric_el_range(lw_sat_t *sat, qth_t *qth, gdouble *el, gdouble *
     *range = obs_set.range;
 }
 
+/**
+ * Atmosphere at a ground station node for history index i. Falls back to
+ * clear sky when the node has no weather samples for that index.
+ */
+static void node_atmosphere(tdsp_node *station, guint i, gdouble *vis, gdouble *cn2)
+{
+    lw_weather_t *weather = station->node.weather;
+
+    if (weather == NULL || i >= weather->len) {
+        *vis = SKR_DEFAULT_VISIBILITY;
+        *cn2 = SKR_DEFAULT_CN2;
+        return;
+    }
+
+    *vis = weather->vis[i];
+    *cn2 = weather->cn2[i];
+}
+
 gdouble get_inter_node_skr(tdsp_node *src, tdsp_node *dst, lw_sat_t *src_hist, lw_sat_t *dst_hist, guint i) {
-    gdouble el, range;
+    gdouble el, range, vis, cn2;
 
     if (src->node.type == path_SATELLITE && dst->node.type == path_SATELLITE) {
         return lw_inter_sat_link(&src_hist[i].pos, &dst_hist[i].pos);
@@ -505,14 +576,16 @@ gdouble get_inter_node_skr(tdsp_node *src, tdsp_node *dst, lw_sat_t *src_hist, l
     
     if (src->node.type == path_STATION && dst->node.type == path_SATELLITE) {
         calc_topocentric_el_range(&dst_hist[i], src->node.obj, &el, &range);
-        return lw_ground_to_sat_uplink(src->node.obj, el, range);
+        node_atmosphere(src, i, &vis, &cn2);
+        return lw_ground_to_sat_uplink(src->node.obj, el, range, vis, cn2);
     }
 
     if (src->node.type == path_SATELLITE && dst->node.type == path_STATION) {
         calc_topocentric_el_range(&src_hist[i], dst->node.obj, &el, &range);
-        return lw_sat_to_ground_downlink(dst->node.obj, el, range);
+        node_atmosphere(dst, i, &vis, &cn2);
+        return lw_sat_to_ground_downlink(dst->node.obj, el, range, vis, cn2);
     }
 
-    //if both ground stations, fiber optic link 
-    return 0.0;
+    //if both ground stations, fiber optic link, constant over time
+    return fibre_edge_rate(src, dst);
 }
\ No newline at end of file
@@ -15,6 +15,12 @@
 #include "qth-data.h"
 #include "max-capacity-path/link-capacity-path.h"
 
+/* Clear sky atmosphere, used for stations without weather data */
+#define SKR_DEFAULT_VISIBILITY 200.0    // Atmospheric visibility in km
+#define SKR_DEFAULT_CN2 1e-16           // Refractive index structure parameter (good conditions)
+
+#define ATMOSPHERE_THICKNESS 20.0       // Effective atmosphere thickness in km, Cn2 is averaged over it
+
 /*
  * fibre_link() - Calculates the SKR for a fiber link between two ground stations.
  * @ground1: Pointer to the first ground station data structure.
@@ -24,6 +30,23 @@
  */
 gdouble fibre_link(qth_t *ground1, qth_t *ground2);
 
+/*
+ * lw_fibre_link() - Calculates the SKR for a fiber of given length.
+ * @distance_km: Length of the fiber in km.
+ *
+ * Return: The calculated SKR in kilobytes per day (satellite history units).
+ */
+gdouble lw_fibre_link(gdouble distance_km);
+
+/*
+ * ground_distance() - Great-circle distance between two ground stations.
+ * @ground1: Pointer to the first ground station data structure.
+ * @ground2: Pointer to the second ground station data structure.
+ *
+ * Return: The distance in kilometers.
+ */
+gdouble ground_distance(qth_t *ground1, qth_t *ground2);
+
 /*
  * ground_to_sat_uplink() - Calculates the SKR for a ground-to-satellite uplink.
  * @ground: Pointer to the ground station data structure.
@@ -51,6 +74,61 @@ gdouble sat_to_ground_downlink(sat_t *sat, qth_t *ground);
  */
 gdouble inter_sat_link(sat_t *sat1, sat_t *sat2);
 
+/*
+ * lw_inter_sat_link() - SKR between two satellite positions.
+ * @pos1: ECI position of the first satellite in km.
+ * @pos2: ECI position of the second satellite in km.
+ *
+ * Return: The SKR in kilobytes per day, 0 when the Earth blocks the link.
+ */
+gdouble lw_inter_sat_link(vector_t *pos1, vector_t *pos2);
+
+/*
+ * lw_inter_sat_link_length() - SKR of an inter-satellite link of given length.
+ * @distance_km: Length of the link in km, line of sight is not checked.
+ *
+ * Return: The SKR in kilobytes per day, never increasing with distance.
+ */
+gdouble lw_inter_sat_link_length(gdouble distance_km);
+
+/*
+ * inter_sat_link_reach() - Longest inter-satellite link that still carries a rate.
+ * @skr: Rate in kilobytes per day.
+ *
+ * Return: The largest distance in km with lw_inter_sat_link_length() >= skr,
+ * 0 if not even a zero length link reaches it.
+ */
+gdouble inter_sat_link_reach(gdouble skr);
+
+/*
+ * lw_ground_to_sat_uplink() - SKR of an uplink seen at elevation and range.
+ * @ground: Pointer to the ground station data structure.
+ * @elevation: Elevation of the satellite in degrees.
+ * @range: Slant range in km.
+ * @visibility: Atmospheric visibility in km.
+ * @cn2: Refractive index structure parameter.
+ *
+ * Return: The SKR in kilobytes per day.
+ */
+gdouble lw_ground_to_sat_uplink(qth_t *ground, gdouble elevation, gdouble range, gdouble visibility, gdouble cn2);
+
+/*
+ * lw_sat_to_ground_downlink() - SKR of a downlink seen at elevation and range.
+ * Parameters as for lw_ground_to_sat_uplink().
+ *
+ * Return: The SKR in kilobytes per day.
+ */
+gdouble lw_sat_to_ground_downlink(qth_t *ground, gdouble elevation, gdouble range, gdouble visibility, gdouble cn2);
+
+/*
+ * calc_topocentric_el_range() - Elevation and range of a satellite from a ground station.
+ * @sat: Satellite position and velocity at sat->jul_utc.
+ * @qth: Ground station.
+ * @el: Output elevation in degrees.
+ * @range: Output slant range in km.
+ */
+void calc_topocentric_el_range(lw_sat_t *sat, qth_t *qth, gdouble *el, gdouble *range);
+
 //gdouble underwater_link(qth_t *station1, qth_t *station2);
 
 /**
@@ -60,6 +138,10 @@ gdouble inter_sat_link(sat_t *sat1, sat_t *sat2);
  * @src_hist: satellite history array, if source is a satellite.
  * @dst_hist: satellite history array, if destination is a satellite.
  * @i: index of hist to access right post.
+ *
+ * Ground station nodes use their weather samples at index i when present,
+ * otherwise clear sky conditions. Between two ground stations the constant
+ * rate of their fibre backbone edge is returned (0 if not connected).
  */
 gdouble get_inter_node_skr(tdsp_node *src, tdsp_node *dst, lw_sat_t *src_hist, lw_sat_t *dst_hist, guint i);
 
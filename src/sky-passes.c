@@ -0,0 +1,232 @@
+/*
+ * Pass predictions for the sky at a glance, computed in the background.
+ *
+ * Each request carries its own copy of the satellite, the location and the
+ * prediction settings, so the workers never read the module's sat_t while
+ * the main loop propagates it, nor sat-cfg while the preferences change it.
+ * A dispatcher thread hands the queued requests to get_passes_batch() and
+ * every prediction is queued as soon as its batch worker is done with it.
+ * The finished predictions are handed back through one idle source, so the
+ * widget can draw every satellite as soon as its passes are known instead
+ * of waiting for all of them.
+ */
+#include "predict-tools.h"
+#include "sky-passes.h"
+
+typedef struct {
+    sat_t sat;              // private copy, nickname points to the one below
+    gchar *nickname;
+    qth_t qth;              // location only
+    gdouble start;
+    gdouble maxdt;
+    guint num;
+    pass_cfg_t cfg;         // read from sat-cfg on the main thread
+    guint serial;
+    GSList *passes;
+} sky_passes_job;
+
+// One batch, index-aligned
+typedef struct {
+    sky_passes *sp;
+    sky_passes_job **jobs;
+    pass_batch_t *items;
+} sky_passes_batch;
+
+struct sky_passes {
+    GThread *thread;
+    GMutex lock;
+    GCond cond;
+    gboolean quit;          // the running batch stops, queued jobs are dropped
+    GQueue requests;        // jobs not handed to a batch yet
+    GQueue finished;        // jobs not handed to the main loop yet
+    guint idle_id;
+
+    sky_passes_ready_cb ready;
+    gpointer user_data;
+};
+
+static void job_free(sky_passes_job *job)
+{
+    free_passes(job->passes);
+    g_free(job->nickname);
+    g_free(job);
+}
+
+static gboolean dispatch_passes(gpointer data)
+{
+    sky_passes *sp = data;
+    GList *jobs;
+
+    g_mutex_lock(&sp->lock);
+    jobs = sp->finished.head;
+    g_queue_init(&sp->finished);
+    sp->idle_id = 0;
+    g_mutex_unlock(&sp->lock);
+
+    for (GList *elm = jobs; elm != NULL; elm = elm->next) {
+        sky_passes_job *job = elm->data;
+
+        sp->ready(job->sat.tle.catnr, job->serial, job->passes, sp->user_data);
+        job->passes = NULL;
+        job_free(job);
+    }
+    g_list_free(jobs);
+
+    return FALSE;
+}
+
+// Batch worker thread, the job goes to the main loop
+static gboolean batch_done(pass_batch_t *item, gpointer data)
+{
+    sky_passes_batch *batch = data;
+    sky_passes *sp = batch->sp;
+    sky_passes_job *job = batch->jobs[item - batch->items];
+    gboolean quit;
+
+    job->passes = item->passes;
+    item->passes = NULL;
+
+    g_mutex_lock(&sp->lock);
+    quit = sp->quit;
+    if (!quit) {
+        g_queue_push_tail(&sp->finished, job);
+        batch->jobs[item - batch->items] = NULL;
+        if (sp->idle_id == 0)
+            sp->idle_id = g_idle_add(dispatch_passes, sp);
+    }
+    g_mutex_unlock(&sp->lock);
+
+    return !quit;
+}
+
+// One batch takes the queued jobs as long as they share location and settings
+static guint take_batch(sky_passes *sp, sky_passes_job **jobs, guint max)
+{
+    sky_passes_job *first = g_queue_peek_head(&sp->requests);
+    guint n = 0;
+
+    while (n < max) {
+        sky_passes_job *job = g_queue_peek_head(&sp->requests);
+
+        if (job == NULL || job->qth.lat != first->qth.lat ||
+            job->qth.lon != first->qth.lon || job->qth.alt != first->qth.alt ||
+            job->cfg.tres != first->cfg.tres ||
+            job->cfg.num_entries != first->cfg.num_entries ||
+            job->cfg.min_el != first->cfg.min_el)
+            break;
+        jobs[n++] = g_queue_pop_head(&sp->requests);
+    }
+
+    return n;
+}
+
+static gpointer predict_passes(gpointer data)
+{
+    sky_passes *sp = data;
+    sky_passes_batch batch;
+    guint n;
+
+    batch.sp = sp;
+
+    g_mutex_lock(&sp->lock);
+    while (TRUE) {
+        while (!sp->quit && g_queue_is_empty(&sp->requests))
+            g_cond_wait(&sp->cond, &sp->lock);
+        if (sp->quit)
+            break;
+
+        n = g_queue_get_length(&sp->requests);
+        batch.jobs = g_new(sky_passes_job *, n);
+        n = take_batch(sp, batch.jobs, n);
+        g_mutex_unlock(&sp->lock);
+
+        batch.items = g_new(pass_batch_t, n);
+        for (guint i = 0; i < n; i++) {
+            batch.items[i].sat = &batch.jobs[i]->sat;
+            batch.items[i].start = batch.jobs[i]->start;
+            batch.items[i].maxdt = batch.jobs[i]->maxdt;
+            batch.items[i].num = batch.jobs[i]->num;
+        }
+        get_passes_batch(batch.items, n, &batch.jobs[0]->qth, &batch.jobs[0]->cfg,
+                         0, batch_done, &batch);
+
+        // jobs skipped or done after quit
+        for (guint i = 0; i < n; i++) {
+            if (batch.jobs[i] != NULL)
+                job_free(batch.jobs[i]);
+        }
+        g_free(batch.items);
+        g_free(batch.jobs);
+
+        g_mutex_lock(&sp->lock);
+    }
+    g_mutex_unlock(&sp->lock);
+
+    return NULL;
+}
+
+sky_passes *sky_passes_new(sky_passes_ready_cb ready, gpointer user_data)
+{
+    sky_passes *sp = g_new0(sky_passes, 1);
+
+    g_mutex_init(&sp->lock);
+    g_cond_init(&sp->cond);
+    g_queue_init(&sp->requests);
+    g_queue_init(&sp->finished);
+    sp->ready = ready;
+    sp->user_data = user_data;
+    sp->thread = g_thread_new("sky-passes", predict_passes, sp);
+
+    return sp;
+}
+
+void sky_passes_request(sky_passes *sp, const sat_t *sat, const qth_t *qth,
+                        gdouble start, gdouble maxdt, guint num, guint serial)
+{
+    sky_passes_job *job = g_new0(sky_passes_job, 1);
+
+    job->sat = *sat;
+    job->nickname = g_strdup(sat->nickname);
+    job->sat.name = job->nickname;
+    job->sat.nickname = job->nickname;
+    job->sat.website = NULL;
+    job->qth.lat = qth->lat;
+    job->qth.lon = qth->lon;
+    job->qth.alt = qth->alt;
+    job->start = start;
+    job->maxdt = maxdt;
+    job->num = num;
+    load_pass_cfg(&job->cfg);
+    job->serial = serial;
+
+    g_mutex_lock(&sp->lock);
+    g_queue_push_tail(&sp->requests, job);
+    g_cond_signal(&sp->cond);
+    g_mutex_unlock(&sp->lock);
+}
+
+void sky_passes_free(sky_passes *sp)
+{
+    sky_passes_job *job;
+
+    if (!sp)
+        return;
+
+    g_mutex_lock(&sp->lock);
+    sp->quit = TRUE;
+    g_cond_signal(&sp->cond);
+    g_mutex_unlock(&sp->lock);
+
+    // the running batch skips what it has not started yet
+    g_thread_join(sp->thread);
+
+    if (sp->idle_id)
+        g_source_remove(sp->idle_id);
+    while ((job = g_queue_pop_head(&sp->requests)) != NULL)
+        job_free(job);
+    while ((job = g_queue_pop_head(&sp->finished)) != NULL)
+        job_free(job);
+    g_mutex_clear(&sp->lock);
+    g_cond_clear(&sp->cond);
+    g_free(sp);
+}
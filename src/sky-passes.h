@@ -0,0 +1,39 @@
+#ifndef __SKY_PASSES_H__
+#define __SKY_PASSES_H__
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+typedef struct sky_passes sky_passes;
+
+/*
+ * Called from the main loop for every finished request, in the order they
+ * finish. passes is a GSList of pass_t in time order that the callback owns,
+ * serial is the value the request was made with.
+ */
+typedef void (*sky_passes_ready_cb)(guint catnum, guint serial, GSList *passes,
+                                    gpointer user_data);
+
+sky_passes *sky_passes_new(sky_passes_ready_cb ready, gpointer user_data);
+
+// Queue a prediction of up to num passes of sat over qth in [start, start + maxdt]
+void sky_passes_request(sky_passes *sp, const sat_t *sat, const qth_t *qth,
+                        gdouble start, gdouble maxdt, guint num, guint serial);
+
+// Drops queued requests, waits for running ones, no callback is made after this
+void sky_passes_free(sky_passes *sp);
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif
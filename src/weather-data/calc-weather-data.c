@@ -1,12 +1,17 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include <glib/gi18n.h>
 #include <gtk/gtk.h>
 #include <netcdf.h>
 
 #include "../sat-log.h"
 #include "../qth-data.h"
+#include "../skr-utils.h"
 #include "calc-weather-data.h"
+#include "cn2-profile.h"
+#include "weather-cache.h"
 
 /**
  * ToDo (func to create):
@@ -128,16 +133,692 @@ int get_a_value(int ncid) {
     return 0;
 }
 
+/* Cells are read in bounding boxes, a box holding this many times more grid
+ * points than its cells is split at its widest gap */
+#define WEATHER_BBOX_SPARSITY 64
+
+/* Most boxes read per variable, however many stations there are */
+#define WEATHER_MAX_BOXES 8
+
+/**
+ * \brief Position of the time, level, latitude and longitude dimensions in a
+ * variable's dimension list, -1 if the variable doesn't have it
+ */
+typedef struct {
+    int ndims;
+    int time;
+    int level;
+    int lat;
+    int lon;
+} var_layout;
+
+static gboolean dim_name_is(const char *name, const char *a, const char *b) {
+    return strcmp(name, a) == 0 || strcmp(name, b) == 0;
+}
+
+static int get_var_layout(int ncid, int varid, var_layout *layout) {
+    int retval;
+    int dimids[NC_MAX_VAR_DIMS];
+    char name[NC_MAX_NAME + 1];
+
+    if ((retval = nc_inq_varndims(ncid, varid, &layout->ndims)))
+        return retval;
+
+    if ((retval = nc_inq_vardimid(ncid, varid, dimids)))
+        return retval;
+
+    layout->time = layout->level = layout->lat = layout->lon = -1;
+    for (int d = 0; d < layout->ndims; d++) {
+        if ((retval = nc_inq_dimname(ncid, dimids[d], name)))
+            return retval;
+
+        if (dim_name_is(name, "valid_time", "time")) layout->time = d;
+        else if (dim_name_is(name, "pressure_level", "level")) layout->level = d;
+        else if (dim_name_is(name, "latitude", "lat")) layout->lat = d;
+        else if (dim_name_is(name, "longitude", "lon")) layout->lon = d;
+    }
+
+    if (layout->time < 0 || layout->lat < 0 || layout->lon < 0)
+        return NC_EBADDIM;
+
+    return NC_NOERR;
+}
+
+static int read_axis(int ncid, const char *name, const char *alt_name, gdouble **values, size_t *len) {
+    int retval, varid, dimid;
+
+    if (nc_inq_varid(ncid, name, &varid) && (retval = nc_inq_varid(ncid, alt_name, &varid)))
+        return retval;
+
+    if ((retval = nc_inq_vardimid(ncid, varid, &dimid)))
+        return retval;
+
+    if ((retval = nc_inq_dimlen(ncid, dimid, len)))
+        return retval;
+
+    *values = malloc(MAX(*len, 1) * sizeof(gdouble));
+    if ((retval = nc_get_var_double(ncid, varid, *values))) {
+        free(*values);
+        *values = NULL;
+    }
+
+    return retval;
+}
+
+static int read_grid_axes(int ncid, grid_axes *grid) {
+    int retval;
+    gdouble *lat = NULL, *lon = NULL;
+
+    if ((retval = read_axis(ncid, "latitude", "lat", &lat, &grid->n_lat)))
+        return retval;
+
+    if ((retval = read_axis(ncid, "longitude", "lon", &lon, &grid->n_lon))) {
+        free(lat);
+        return retval;
+    }
+
+    //ERA5 grids are regular, only the first two points are needed
+    grid->lat0 = lat[0];
+    grid->dlat = (grid->n_lat > 1 ? lat[1] - lat[0] : 1);
+    grid->lon0 = lon[0];
+    grid->dlon = (grid->n_lon > 1 ? lon[1] - lon[0] : 1);
+
+    free(lat);
+    free(lon);
+    return NC_NOERR;
+}
+
+//julian date of a proleptic gregorian calendar date
+static gdouble gregorian_to_julian(int year, int month, int day, int hour, int minute, gdouble second) {
+    int a = (14 - month) / 12;
+    int y = year + 4800 - a;
+    int m = month + 12 * a - 3;
+    long jdn = day + (153 * m + 2) / 5 + 365L * y + y / 4 - y / 100 + y / 400 - 32045;
+
+    return jdn - 0.5 + hour / 24.0 + minute / 1440.0 + second / 86400.0;
+}
+
+/**
+ * Reads the time coordinate and converts it to julian dates using its CF
+ * units attribute, e.g. "seconds since 1970-01-01" or
+ * "hours since 1900-01-01 00:00:00.0"
+ */
+static int read_time_axis(int ncid, gdouble **jd, size_t *len) {
+    int retval, varid;
+    size_t units_len;
+
+    if ((retval = read_axis(ncid, "valid_time", "time", jd, len)))
+        return retval;
+
+    if (nc_inq_varid(ncid, "valid_time", &varid) && (retval = nc_inq_varid(ncid, "time", &varid)))
+        return retval;
+
+    if ((retval = nc_inq_attlen(ncid, varid, "units", &units_len)))
+        return retval;
+
+    char *units = calloc(units_len + 1, sizeof(char));
+    if ((retval = nc_get_att_text(ncid, varid, "units", units))) {
+        free(units);
+        return retval;
+    }
+
+    char unit[16] = "";
+    int year = 1970, month = 1, day = 1, hour = 0, minute = 0;
+    gdouble second = 0;
+    int found = sscanf(units, "%15s since %d-%d-%d %d:%d:%lf", unit, &year, &month, &day, &hour, &minute, &second);
+    free(units);
+
+    if (found < 4) return NC_EINVAL;
+
+    gdouble per_day;
+    if (strcmp(unit, "seconds") == 0) per_day = 86400.0;
+    else if (strcmp(unit, "minutes") == 0) per_day = 1440.0;
+    else if (strcmp(unit, "hours") == 0) per_day = 24.0;
+    else if (strcmp(unit, "days") == 0) per_day = 1.0;
+    else return NC_EINVAL;
+
+    gdouble epoch = gregorian_to_julian(year, month, day, hour, minute, second);
+    for (size_t t = 0; t < *len; t++) {
+        (*jd)[t] = epoch + (*jd)[t] / per_day;
+    }
+
+    return NC_NOERR;
+}
+
+/**
+ * Fractional index of a longitude on the grid. Grids run 0 to 360 or -180 to
+ * 180, the station is wrapped into the grid's range. Regional grids are
+ * clamped to the closer edge.
+ */
+static gdouble grid_lon_index(grid_axes *grid, gdouble lon, gboolean *global) {
+    gdouble span = grid->dlon * grid->n_lon;
+    gdouble offset = fmod(lon - grid->lon0, 360.0);
+    if (offset < 0) offset += 360.0;
+
+    *global = (span >= 359.0);
+    if (*global) return offset / grid->dlon;
+
+    //west of the grid wraps to just below 360
+    if (offset > span + 0.5 * (360.0 - span)) offset -= 360.0;
+    return CLAMP(offset / grid->dlon, 0, (gdouble)grid->n_lon - 1);
+}
+
+/**
+ * Bilinear weights of the four grid points around a station. Stations
+ * beyond the edge of a regional grid take the edge values, global grids wrap
+ * around in longitude.
+ */
+grid_weights weather_grid_weights(grid_axes *grid, qth_t *ogs) {
+    grid_weights w;
+    gboolean global;
+
+    gdouble fy = CLAMP((ogs->lat - grid->lat0) / grid->dlat, 0, (gdouble)grid->n_lat - 1);
+    gdouble fx = grid_lon_index(grid, ogs->lon, &global);
+
+    size_t y0 = (size_t)floor(fy);
+    size_t x0 = (size_t)floor(fx);
+    size_t y1 = MIN(y0 + 1, grid->n_lat - 1);
+    size_t x1 = x0 + 1;
+    gdouble wy = fy - y0;
+    gdouble wx = fx - x0;
+
+    if (global) {
+        x0 %= grid->n_lon;
+        x1 %= grid->n_lon;
+    } else {
+        x1 = MIN(x1, grid->n_lon - 1);
+    }
+
+    w.corner[0] = (grid_cell){.ilat = y0, .ilon = x0};
+    w.corner[1] = (grid_cell){.ilat = y0, .ilon = x1};
+    w.corner[2] = (grid_cell){.ilat = y1, .ilon = x0};
+    w.corner[3] = (grid_cell){.ilat = y1, .ilon = x1};
+    w.weight[0] = (1 - wy) * (1 - wx);
+    w.weight[1] = (1 - wy) * wx;
+    w.weight[2] = wy * (1 - wx);
+    w.weight[3] = wy * wx;
+
+    return w;
+}
+
+static int read_packing(int ncid, int varid, gdouble *scale, gdouble *offset, gdouble *fill) {
+    *scale = 1.0;
+    *offset = 0.0;
+    *fill = NAN;
+
+    //attributes are optional, defaults kept when missing
+    nc_get_att_double(ncid, varid, "scale_factor", scale);
+    nc_get_att_double(ncid, varid, "add_offset", offset);
+    if (nc_get_att_double(ncid, varid, "_FillValue", fill))
+        nc_get_att_double(ncid, varid, "missing_value", fill);
+
+    return NC_NOERR;
+}
+
+/** \brief Cells order[first, first + n) and their bounding box */
+typedef struct {
+    guint first;
+    guint n;
+    size_t lat_min;
+    size_t lat_max;
+    size_t lon_min;
+    size_t lon_max;
+} cell_box;
+
+static void box_bounds(GArray *cells, guint *order, cell_box *box) {
+    box->lat_min = box->lon_min = G_MAXSIZE;
+    box->lat_max = box->lon_max = 0;
+
+    for (guint k = box->first; k < box->first + box->n; k++) {
+        grid_cell *cell = &g_array_index(cells, grid_cell, order[k]);
+        box->lat_min = MIN(box->lat_min, cell->ilat);
+        box->lat_max = MAX(box->lat_max, cell->ilat);
+        box->lon_min = MIN(box->lon_min, cell->ilon);
+        box->lon_max = MAX(box->lon_max, cell->ilon);
+    }
+}
+
+//grid points the box holds beyond what its cells allow for
+static size_t box_excess(cell_box *box) {
+    size_t points = (box->lat_max - box->lat_min + 1) * (box->lon_max - box->lon_min + 1);
+    size_t allowed = (size_t)WEATHER_BBOX_SPARSITY * box->n;
+
+    return points > allowed ? points - allowed : 0;
+}
+
+static gint cell_cmp_lat(gconstpointer a, gconstpointer b, gpointer data) {
+    grid_cell *ca = &g_array_index((GArray *)data, grid_cell, *(const guint *)a);
+    grid_cell *cb = &g_array_index((GArray *)data, grid_cell, *(const guint *)b);
+    return (ca->ilat > cb->ilat) - (ca->ilat < cb->ilat);
+}
+
+static gint cell_cmp_lon(gconstpointer a, gconstpointer b, gpointer data) {
+    grid_cell *ca = &g_array_index((GArray *)data, grid_cell, *(const guint *)a);
+    grid_cell *cb = &g_array_index((GArray *)data, grid_cell, *(const guint *)b);
+    return (ca->ilon > cb->ilon) - (ca->ilon < cb->ilon);
+}
+
+/**
+ * Sorts the cells of box along one axis and finds the widest gap between
+ * neighbouring cells.
+ *
+ * @param split output, number of cells before the gap
+ * @return the width of the gap in grid points
+ */
+static size_t widest_gap(GArray *cells, guint *order, cell_box *box, gboolean lat, guint *split) {
+    size_t gap = 0;
+
+    g_qsort_with_data(order + box->first, box->n, sizeof(guint),
+                      lat ? cell_cmp_lat : cell_cmp_lon, cells);
+
+    for (guint k = box->first + 1; k < box->first + box->n; k++) {
+        grid_cell *prev = &g_array_index(cells, grid_cell, order[k - 1]);
+        grid_cell *cell = &g_array_index(cells, grid_cell, order[k]);
+        size_t d = (lat ? cell->ilat - prev->ilat : cell->ilon - prev->ilon);
+
+        if (d > gap) {
+            gap = d;
+            *split = k - box->first;
+        }
+    }
+
+    return gap;
+}
+
+/**
+ * Groups the cells into at most WEATHER_MAX_BOXES bounding boxes. The box
+ * with the most grid points no cell needs is split at its widest gap until
+ * every box is dense enough or the limit is reached, so the number of reads
+ * stays bounded as stations are added.
+ *
+ * @param order output, the cells ordered box by box
+ * @return GArray of cell_box
+ */
+static GArray *plan_boxes(GArray *cells, guint *order) {
+    GArray *boxes = g_array_new(FALSE, FALSE, sizeof(cell_box));
+    cell_box all = {.first = 0, .n = cells->len};
+
+    if (cells->len == 0) return boxes;
+
+    for (guint c = 0; c < cells->len; c++) order[c] = c;
+    box_bounds(cells, order, &all);
+    g_array_append_val(boxes, all);
+
+    while (boxes->len < WEATHER_MAX_BOXES) {
+        guint worst = 0;
+        size_t excess = 0;
+
+        for (guint b = 0; b < boxes->len; b++) {
+            size_t e = box_excess(&g_array_index(boxes, cell_box, b));
+            if (e > excess) {
+                excess = e;
+                worst = b;
+            }
+        }
+        if (excess == 0) break;
+
+        cell_box *box = &g_array_index(boxes, cell_box, worst);
+        guint split_lat = 0, split_lon = 0;
+        size_t gap_lat = widest_gap(cells, order, box, TRUE, &split_lat);
+        size_t gap_lon = widest_gap(cells, order, box, FALSE, &split_lon);
+
+        //order is left sorted by longitude, sort again when splitting by latitude
+        guint split = split_lon;
+        if (gap_lat > gap_lon) {
+            widest_gap(cells, order, box, TRUE, &split);
+        }
+
+        cell_box rest = {.first = box->first + split, .n = box->n - split};
+        box->n = split;
+        box_bounds(cells, order, box);
+        box_bounds(cells, order, &rest);
+        g_array_append_val(boxes, rest);
+    }
+
+    return boxes;
+}
+
+/**
+ * Reads time steps [t0, t0 + nt) and levels [l0, l0 + nl) of a variable at
+ * every grid cell. The cells are grouped into at most WEATHER_MAX_BOXES
+ * bounding boxes, each read with one hyperslab. Packed values are unpacked,
+ * fill values become NAN.
+ *
+ * @param out   n_cells * nt * nl values, out[(c * nt + t) * nl + l]
+ */
+static int read_cells(
+        int ncid,
+        int varid,
+        var_layout *layout,
+        GArray *cells,
+        size_t t0,
+        size_t nt,
+        size_t l0,
+        size_t nl,
+        gfloat *out) {
+    int retval = NC_NOERR;
+    guint *order = g_new(guint, MAX(cells->len, 1));
+    GArray *boxes = plan_boxes(cells, order);
+
+    gdouble scale, offset, fill;
+    read_packing(ncid, varid, &scale, &offset, &fill);
+
+    size_t start[NC_MAX_VAR_DIMS] = {0};
+    size_t count[NC_MAX_VAR_DIMS];
+    for (int d = 0; d < layout->ndims; d++) count[d] = 1;
+
+    start[layout->time] = t0;
+    count[layout->time] = nt;
+    if (layout->level >= 0) {
+        start[layout->level] = l0;
+        count[layout->level] = nl;
+    }
+
+    for (guint b = 0; b < boxes->len && retval == NC_NOERR; b++) {
+        cell_box *box = &g_array_index(boxes, cell_box, b);
+
+        start[layout->lat] = box->lat_min;
+        start[layout->lon] = box->lon_min;
+        count[layout->lat] = box->lat_max - box->lat_min + 1;
+        count[layout->lon] = box->lon_max - box->lon_min + 1;
+
+        //element strides of the hyperslab, follows the file's dimension order
+        size_t stride[NC_MAX_VAR_DIMS];
+        size_t total = 1;
+        for (int d = layout->ndims - 1; d >= 0; d--) {
+            stride[d] = total;
+            total *= count[d];
+        }
+
+        gfloat *slab = malloc(total * sizeof(gfloat));
+        if ((retval = nc_get_vara_float(ncid, varid, start, count, slab))) {
+            free(slab);
+            break;
+        }
+
+        for (guint k = box->first; k < box->first + box->n; k++) {
+            guint c = order[k];
+            grid_cell *cell = &g_array_index(cells, grid_cell, c);
+            size_t base = (cell->ilat - box->lat_min) * stride[layout->lat] +
+                          (cell->ilon - box->lon_min) * stride[layout->lon];
+
+            for (size_t t = 0; t < nt; t++) {
+                for (size_t l = 0; l < nl; l++) {
+                    size_t i = base + t * stride[layout->time] +
+                               (layout->level >= 0 ? l * stride[layout->level] : 0);
+                    gfloat raw = slab[i];
+
+                    out[(c * nt + t) * nl + l] =
+                        (raw == (gfloat)fill ? NAN : (gfloat)(raw * scale + offset));
+                }
+            }
+        }
+        free(slab);
+    }
+
+    g_array_free(boxes, TRUE);
+    g_free(order);
+    return retval;
+}
+
 /**
- * file name to get data from
- *      don't use ncid. keep opening and closing file in close proximity, self contained
- * ground station (lat, long)
- * time period (start time, end time) in hours to match data
- *      get average rms of wind in vertical direction. 
- *      Otherwise its an extra dimension for no reason
- * 
- * stations within same 1 degree lat lon square will have same data
- *      can't optimize everything. Complicated scheme would be troublesome
+ * Finds the stored time steps covering [start_time, end_time].
+ * @return number of steps, 0 if the file doesn't overlap the window
+ */
+static size_t time_window(gdouble *jd, size_t len, gdouble start_time, gdouble end_time, size_t *t0) {
+    if (len == 0 || jd[len - 1] < start_time || jd[0] > end_time) return 0;
+
+    size_t first = 0;
+    while (first + 1 < len && jd[first + 1] <= start_time) first++;
+
+    size_t last = first;
+    while (last + 1 < len && jd[last] < end_time) last++;
+
+    *t0 = first;
+    return last - first + 1;
+}
+
+//index of the time step closest to time, jd ascending
+static size_t nearest_time(gdouble *jd, size_t len, gdouble time) {
+    size_t t = 0;
+    while (t + 1 < len && fabs(jd[t + 1] - time) <= fabs(jd[t] - time)) t++;
+
+    return t;
+}
+
+/**
+ * Maps stations to the grid cells around them, stations sharing cells share
+ * the entries.
+ * @param ogs_cell      output, 4 per station, index into the returned cells
+ *                      of each corner
+ * @param ogs_weight    output, 4 per station, bilinear weight of each corner
+ * @return GArray of grid_cell
+ */
+static GArray *station_cells(grid_axes *grid, GSList *OGS_list, guint *ogs_cell, gdouble *ogs_weight) {
+    GArray *cells = g_array_new(FALSE, FALSE, sizeof(grid_cell));
+    GHashTable *cell_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    guint n = 0;
+    for (GSList *ogs_elm = OGS_list; ogs_elm != NULL; ogs_elm = ogs_elm->next, n++) {
+        grid_weights w = weather_grid_weights(grid, (qth_t *)ogs_elm->data);
+
+        for (guint k = 0; k < 4; k++) {
+            grid_cell cell = w.corner[k];
+            gpointer key = GSIZE_TO_POINTER(cell.ilat * grid->n_lon + cell.ilon + 1);
+            gpointer found = g_hash_table_lookup(cell_index, key);
+
+            if (found == NULL) {
+                g_array_append_val(cells, cell);
+                found = GUINT_TO_POINTER(cells->len);
+                g_hash_table_insert(cell_index, key, found);
+            }
+            ogs_cell[4 * n + k] = GPOINTER_TO_UINT(found) - 1;
+            ogs_weight[4 * n + k] = w.weight[k];
+        }
+    }
+
+    g_hash_table_destroy(cell_index);
+    return cells;
+}
+
+//weighted sum of the corner series of one station at step t, series[cell * nt + t]
+static inline gdouble blend_corners(const gdouble *series, size_t nt, const guint *cell, const gdouble *weight, size_t t) {
+    return weight[0] * series[cell[0] * nt + t] + weight[1] * series[cell[1] * nt + t]
+        + weight[2] * series[cell[2] * nt + t] + weight[3] * series[cell[3] * nt + t];
+}
+
+static int open_weather_file(const gchar *filepath, int *ncid) {
+    int retval;
+
+    if ((retval = nc_open(filepath, NC_NOWRITE, ncid))) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to open %s with nc_open, returned %d"),
+            __func__, filepath, retval);
+    }
+
+    return retval;
+}
+
+static int find_weather_var(int ncid, const char *name, const char *description, int *varid, var_layout *layout) {
+    int retval;
+
+    if ((retval = nc_inq_varid(ncid, name, varid))) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to load %s variable id, returned %d"),
+            __func__, description, retval);
+        return retval;
+    }
+
+    if ((retval = get_var_layout(ncid, *varid, layout))) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: %s variable is not on a time, latitude, longitude grid (%s)"),
+            __func__, description, nc_strerror(retval));
+    }
+
+    return retval;
+}
+
+//factor to km, ERA5 visibility is in metres
+static gdouble visibility_scale(int ncid, int varid) {
+    size_t units_len = 0;
+    gdouble scale = 1.0;
+
+    if (nc_inq_attlen(ncid, varid, "units", &units_len) == NC_NOERR && units_len > 0) {
+        char *units = calloc(units_len + 1, sizeof(char));
+        if (nc_get_att_text(ncid, varid, "units", units) == NC_NOERR && strcmp(units, "m") == 0)
+            scale = 1e-3;
+        free(units);
+    }
+
+    return scale;
+}
+
+/**
+ * Visibility in km of every cell over the window, vis[c * nt + t].
+ * Sets the time axis of the window through jd, t0 and nt.
+ */
+static gdouble *load_visibility(int ncid, GSList *OGS_list, guint *ogs_cell, gdouble *ogs_weight, guint *n_cells,
+        gdouble start_time, gdouble end_time, gdouble **jd, size_t *t0, size_t *nt) {
+    int retval, varid;
+    var_layout layout;
+    grid_axes grid;
+    size_t time_len = 0;
+
+    if (find_weather_var(ncid, "vis", "visibility", &varid, &layout))
+        return NULL;
+
+    if ((retval = read_grid_axes(ncid, &grid)) || (retval = read_time_axis(ncid, jd, &time_len))) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to read visibility coordinates (%s)"),
+            __func__, nc_strerror(retval));
+        return NULL;
+    }
+
+    *nt = time_window(*jd, time_len, start_time, end_time, t0);
+    if (*nt == 0) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: visibility data doesn't cover %f - %f"),
+            __func__, start_time, end_time);
+        return NULL;
+    }
+
+    GArray *cells = station_cells(&grid, OGS_list, ogs_cell, ogs_weight);
+    *n_cells = cells->len;
+
+    gfloat *raw = malloc(MAX(cells->len, 1) * *nt * sizeof(gfloat));
+    if (cells->len > 0 && (retval = read_cells(ncid, varid, &layout, cells, *t0, *nt, 0, 1, raw))) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to read visibility (%s)"),
+            __func__, nc_strerror(retval));
+        free(raw);
+        g_array_free(cells, TRUE);
+        return NULL;
+    }
+
+    gdouble scale = visibility_scale(ncid, varid);
+    gdouble *vis = malloc(MAX(cells->len, 1) * *nt * sizeof(gdouble));
+    for (size_t i = 0; i < cells->len * *nt; i++) {
+        vis[i] = (isnan(raw[i]) ? SKR_DEFAULT_VISIBILITY : raw[i] * scale);
+    }
+
+    free(raw);
+    g_array_free(cells, TRUE);
+    return vis;
+}
+
+/**
+ * Path averaged Cn2 of every cell for each hour of the window from the u and
+ * v winds on pressure levels, cn2[c * nt + t]. Only the levels the
+ * Hufnagel-Valley wind average needs are read, every (cell, hour) profile is
+ * then reduced in one batch.
+ */
+static gdouble *load_cn2(int ncid, GSList *OGS_list, guint *ogs_cell, gdouble *ogs_weight, guint *n_cells,
+        gdouble start_time, gdouble end_time, gdouble **jd, size_t *nt) {
+    int retval, u_varid, v_varid;
+    var_layout u_layout, v_layout;
+    grid_axes grid;
+    size_t time_len = 0, n_levels = 0, t0 = 0;
+    gdouble *levels = NULL;
+
+    if (find_weather_var(ncid, "u", "u-component wind", &u_varid, &u_layout) ||
+        find_weather_var(ncid, "v", "v-component wind", &v_varid, &v_layout))
+        return NULL;
+
+    if ((retval = read_grid_axes(ncid, &grid)) ||
+        (retval = read_time_axis(ncid, jd, &time_len)) ||
+        (retval = read_axis(ncid, "pressure_level", "level", &levels, &n_levels))) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to read pressure level coordinates (%s)"),
+            __func__, nc_strerror(retval));
+        free(levels);
+        return NULL;
+    }
+
+    *nt = time_window(*jd, time_len, start_time, end_time, &t0);
+    hv_integrator *hv = hv_integrator_new(levels, n_levels, HV_GROUND_CN2, ATMOSPHERE_THICKNESS);
+    free(levels);
+
+    if (*nt == 0 || hv == NULL || hv->count == 0) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: pressure level data doesn't cover %f - %f"),
+            __func__, start_time, end_time);
+        hv_integrator_free(hv);
+        return NULL;
+    }
+
+    //windowed time axis
+    memmove(*jd, *jd + t0, *nt * sizeof(gdouble));
+
+    GArray *cells = station_cells(&grid, OGS_list, ogs_cell, ogs_weight);
+    *n_cells = cells->len;
+
+    size_t n_profiles = cells->len * *nt;
+    gfloat *u = malloc(MAX(n_profiles, 1) * hv->count * sizeof(gfloat));
+    gfloat *v = malloc(MAX(n_profiles, 1) * hv->count * sizeof(gfloat));
+    gdouble *cn2 = NULL;
+
+    if (cells->len > 0 &&
+        ((retval = read_cells(ncid, u_varid, &u_layout, cells, t0, *nt, hv->first, hv->count, u)) ||
+         (retval = read_cells(ncid, v_varid, &v_layout, cells, t0, *nt, hv->first, hv->count, v)))) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to read winds (%s)"),
+            __func__, nc_strerror(retval));
+    } else {
+        //missing winds count as calm
+        for (size_t i = 0; i < n_profiles * hv->count; i++) {
+            if (isnan(u[i])) u[i] = 0;
+            if (isnan(v[i])) v[i] = 0;
+        }
+
+        cn2 = malloc(MAX(n_profiles, 1) * sizeof(gdouble));
+        hv_cn2_batch(hv, u, v, n_profiles, cn2);
+    }
+
+    free(u);
+    free(v);
+    hv_integrator_free(hv);
+    g_array_free(cells, TRUE);
+    return cn2;
+}
+
+/**
+ * Loads the weather of every ground station over the time window.
+ *
+ * Each station is interpolated bilinearly between the four grid points around
+ * it, grid points shared by several stations are read once. Each variable is
+ * read with a few hyperslabs over bounding boxes of the needed points and the
+ * covering time range, at most WEATHER_MAX_BOXES of them, so the number of
+ * reads doesn't grow with the number of stations. Cn2 is derived
+ * from the winds with the Hufnagel-Valley model, once per (cell, hour), and
+ * matched to the visibility time steps.
+ *
+ * @param visibility_filepath   ERA5 single level file with vis
+ * @param cn2_filepath          ERA5 pressure level file with u and v winds
+ * @param OGS_list              GSList of qth_t
+ * @param start_time            julian date
+ * @param end_time              julian date
+ * @return {gchar *ogs name : ogs_weather_data *}, owns its values.
+ *         NULL if the files can't be read or don't cover the window
  */
 GHashTable *load_turbulence_data(
         gchar *visibility_filepath,
@@ -145,80 +826,381 @@ GHashTable *load_turbulence_data(
         GSList *OGS_list,
         gdouble start_time,
         gdouble end_time) {
-    int retval = 0;
-    int  vis_id, cn2_id;
+    int vis_id, cn2_id;
 
-    if ((retval = nc_open(visibility_filepath, NC_NOWRITE, &vis_id))) {
-        sat_log_log(SAT_LOG_LEVEL_ERROR, 
-            _("%s: Failed to open %s with nc_open, returned %d"), 
-            __func__, visibility_filepath, retval);
+    if (open_weather_file(visibility_filepath, &vis_id))
         return NULL;
-    }
 
-    if ((retval = nc_open(cn2_filepath, NC_NOWRITE, &cn2_id))) {
-        sat_log_log(SAT_LOG_LEVEL_ERROR, 
-            _("%s: Failed to open %s with nc_open, returned %d"), 
-            __func__, cn2_filepath, retval);
+    if (open_weather_file(cn2_filepath, &cn2_id)) {
+        nc_close(vis_id);
         return NULL;
     }
 
-    int vis_varid, cn2_varid_u, cn2_varid_v;
+    guint n_ogs = g_slist_length(OGS_list);
+    guint *vis_cell = malloc(4 * MAX(n_ogs, 1) * sizeof(guint));
+    guint *cn2_cell = malloc(4 * MAX(n_ogs, 1) * sizeof(guint));
+    gdouble *vis_weight = malloc(4 * MAX(n_ogs, 1) * sizeof(gdouble));
+    gdouble *cn2_weight = malloc(4 * MAX(n_ogs, 1) * sizeof(gdouble));
+    guint n_vis_cells = 0, n_cn2_cells = 0;
+    gdouble *vis_jd = NULL, *cn2_jd = NULL;
+    size_t t0 = 0, nt = 0, cn2_nt = 0;
 
-    if ((retval = nc_inq_varid(vis_id, "vis", &vis_varid))) {
-        sat_log_log(SAT_LOG_LEVEL_ERROR, 
-            _("%s: Failed to load visibility variable id, returned %d"), 
-            __func__, retval);
-        return NULL;
+    gdouble *vis = load_visibility(vis_id, OGS_list, vis_cell, vis_weight, &n_vis_cells, start_time, end_time, &vis_jd, &t0, &nt);
+    gdouble *cn2 = (vis != NULL ?
+        load_cn2(cn2_id, OGS_list, cn2_cell, cn2_weight, &n_cn2_cells, start_time, end_time, &cn2_jd, &cn2_nt) : NULL);
+
+    nc_close(vis_id);
+    nc_close(cn2_id);
+
+    GHashTable *table = NULL;
+    if (vis != NULL && cn2 != NULL) {
+        table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, ogs_weather_data_free);
+
+        //pressure level file may be on another time axis, match closest hour
+        size_t *cn2_t = malloc(nt * sizeof(size_t));
+        for (size_t t = 0; t < nt; t++) {
+            cn2_t[t] = nearest_time(cn2_jd, cn2_nt, vis_jd[t0 + t]);
+        }
+
+        guint n = 0;
+        for (GSList *ogs_elm = OGS_list; ogs_elm != NULL; ogs_elm = ogs_elm->next, n++) {
+            qth_t *ogs = (qth_t *)ogs_elm->data;
+
+            ogs_weather_data *entries = malloc(sizeof(ogs_weather_data));
+            entries->len = nt;
+            entries->start_time = vis_jd[t0];
+            entries->time_step = (nt > 1 ? vis_jd[t0 + 1] - vis_jd[t0] : 1.0 / 24.0);
+            entries->vis = malloc(nt * sizeof(gdouble));
+            entries->cn2 = malloc(nt * sizeof(gdouble));
+
+            for (size_t t = 0; t < nt; t++) {
+                entries->vis[t] = blend_corners(vis, nt, &vis_cell[4 * n], &vis_weight[4 * n], t);
+                entries->cn2[t] = blend_corners(cn2, cn2_nt, &cn2_cell[4 * n], &cn2_weight[4 * n], cn2_t[t]);
+            }
+
+            g_hash_table_insert(table, ogs->name, entries);
+        }
+
+        free(cn2_t);
     }
 
-    if ((retval = nc_inq_varid(cn2_id, "u", &cn2_varid_u))) {
-        sat_log_log(SAT_LOG_LEVEL_ERROR, 
-            _("%s: Failed to load u-component wind variable id, returned %d"), 
-            __func__, retval);
-        return NULL;
+    free(vis);
+    free(cn2);
+    free(vis_jd);
+    free(cn2_jd);
+    free(vis_cell);
+    free(cn2_cell);
+    free(vis_weight);
+    free(cn2_weight);
+
+    return table;
+}
+
+/**
+ * Converts every grid cell and time step of the source files into an open
+ * cache writer, one time step at a time. Cn2 is matched to the visibility
+ * time steps by closest hour, like load_turbulence_data().
+ */
+static gboolean write_weather_cache(int vis_id, int cn2_id, const gchar *cache_filepath, weather_cache_header *header) {
+    int retval, vis_varid, u_varid, v_varid;
+    var_layout vis_layout, u_layout, v_layout;
+    grid_axes grid, cn2_grid;
+    size_t n_time = 0, cn2_n_time = 0, n_levels = 0;
+    gdouble *jd = NULL, *cn2_jd = NULL, *levels = NULL;
+
+    if (find_weather_var(vis_id, "vis", "visibility", &vis_varid, &vis_layout) ||
+        find_weather_var(cn2_id, "u", "u-component wind", &u_varid, &u_layout) ||
+        find_weather_var(cn2_id, "v", "v-component wind", &v_varid, &v_layout))
+        return FALSE;
+
+    if ((retval = read_grid_axes(vis_id, &grid)) ||
+        (retval = read_grid_axes(cn2_id, &cn2_grid)) ||
+        (retval = read_time_axis(vis_id, &jd, &n_time)) ||
+        (retval = read_time_axis(cn2_id, &cn2_jd, &cn2_n_time)) ||
+        (retval = read_axis(cn2_id, "pressure_level", "level", &levels, &n_levels))) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to read weather coordinates (%s)"),
+            __func__, nc_strerror(retval));
+        free(jd);
+        free(cn2_jd);
+        free(levels);
+        return FALSE;
     }
 
-    if ((retval = nc_inq_varid(cn2_id, "v", &cn2_varid_v))) {
-        sat_log_log(SAT_LOG_LEVEL_ERROR, 
-            _("%s: Failed to load v-component wind variable id, returned %d"), 
-            __func__, retval);
-        return NULL;
+    //tiles are addressed by step number, the time axis must be regular
+    gdouble time_step = (n_time > 1 ? jd[1] - jd[0] : 1.0 / 24.0);
+    gboolean regular = TRUE;
+    for (size_t t = 0; t < n_time; t++) {
+        if (fabs(jd[t] - (jd[0] + t * time_step)) > 1e-6) regular = FALSE;
     }
 
-    //figure out time. hours only. usually only searching 24 hours.
-    int start_hour = (int)start_time;
-    int end_hour = (int)end_time;
+    hv_integrator *hv = hv_integrator_new(levels, n_levels, HV_GROUND_CN2, ATMOSPHERE_THICKNESS);
+    free(levels);
+
+    if (grid.n_lat != cn2_grid.n_lat || grid.n_lon != cn2_grid.n_lon ||
+        fabs(grid.lat0 - cn2_grid.lat0) > 1e-6 || fabs(grid.lon0 - cn2_grid.lon0) > 1e-6 ||
+        !regular || n_time == 0 || cn2_n_time == 0 || hv == NULL || hv->count == 0) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Weather files can't be cached, both need the same grid, regular time steps and winds"),
+            __func__);
+        free(jd);
+        free(cn2_jd);
+        hv_integrator_free(hv);
+        return FALSE;
+    }
+
+    header->n_lat = grid.n_lat;
+    header->n_lon = grid.n_lon;
+    header->n_time = n_time;
+    header->lat0 = grid.lat0;
+    header->dlat = grid.dlat;
+    header->lon0 = grid.lon0;
+    header->dlon = grid.dlon;
+    header->start_time = jd[0];
+    header->time_step = time_step;
+    header->ground_cn2 = HV_GROUND_CN2;
+    header->thickness = ATMOSPHERE_THICKNESS;
+
+    //whole grid, read_cells() then does one hyperslab per variable and time step
+    size_t n_cells = grid.n_lat * grid.n_lon;
+    GArray *cells = g_array_sized_new(FALSE, FALSE, sizeof(grid_cell), n_cells);
+    for (size_t lat = 0; lat < grid.n_lat; lat++) {
+        for (size_t lon = 0; lon < grid.n_lon; lon++) {
+            grid_cell cell = {.ilat = lat, .ilon = lon};
+            g_array_append_val(cells, cell);
+        }
+    }
 
-    int time_diff = end_hour - start_hour;
+    gdouble scale = visibility_scale(vis_id, vis_varid);
+    gfloat *vis_block = malloc(WEATHER_CACHE_TIME_BLOCK * n_cells * sizeof(gfloat));
+    gfloat *cn2_block = malloc(WEATHER_CACHE_TIME_BLOCK * n_cells * sizeof(gfloat));
+    gfloat *u = malloc(n_cells * hv->count * sizeof(gfloat));
+    gfloat *v = malloc(n_cells * hv->count * sizeof(gfloat));
+    gdouble *cn2 = malloc(n_cells * sizeof(gdouble));
 
-    //load visibility data
-    //if (retval = nc_get_vara_double(vis_id, vis_id, ));
+    weather_cache_writer *writer = weather_cache_writer_new(cache_filepath, header);
+    gboolean ok = (writer != NULL);
+
+    for (size_t t0 = 0; ok && t0 < n_time; t0 += WEATHER_CACHE_TIME_BLOCK) {
+        for (size_t b = 0; ok && b < WEATHER_CACHE_TIME_BLOCK; b++) {
+            gfloat *vis_out = vis_block + b * n_cells;
+            gfloat *cn2_out = cn2_block + b * n_cells;
+            size_t t = t0 + b;
+
+            //padding past the last time step
+            if (t >= n_time) {
+                for (size_t c = 0; c < n_cells; c++) vis_out[c] = cn2_out[c] = NAN;
+                continue;
+            }
+
+            size_t cn2_t = nearest_time(cn2_jd, cn2_n_time, jd[t]);
+            if ((retval = read_cells(vis_id, vis_varid, &vis_layout, cells, t, 1, 0, 1, vis_out)) ||
+                (retval = read_cells(cn2_id, u_varid, &u_layout, cells, cn2_t, 1, hv->first, hv->count, u)) ||
+                (retval = read_cells(cn2_id, v_varid, &v_layout, cells, cn2_t, 1, hv->first, hv->count, v))) {
+                sat_log_log(SAT_LOG_LEVEL_ERROR,
+                    _("%s: Failed to read time step %zu (%s)"),
+                    __func__, t, nc_strerror(retval));
+                ok = FALSE;
+                break;
+            }
+
+            //missing winds count as calm, missing visibility stays NAN until lookup
+            for (size_t i = 0; i < n_cells * hv->count; i++) {
+                if (isnan(u[i])) u[i] = 0;
+                if (isnan(v[i])) v[i] = 0;
+            }
+            hv_cn2_batch(hv, u, v, n_cells, cn2);
+
+            for (size_t c = 0; c < n_cells; c++) {
+                vis_out[c] = (gfloat)(vis_out[c] * scale);
+                cn2_out[c] = (gfloat)cn2[c];
+            }
+        }
+
+        ok = ok && weather_cache_write_block(writer, vis_block, cn2_block);
+    }
+
+    if (writer != NULL)
+        ok = weather_cache_writer_finish(writer, ok);
+
+    free(vis_block);
+    free(cn2_block);
+    free(u);
+    free(v);
+    free(cn2);
+    free(jd);
+    free(cn2_jd);
+    hv_integrator_free(hv);
+    g_array_free(cells, TRUE);
+    return ok;
+}
+
+/**
+ * One time conversion of the ERA5 files into a memory mappable tile cache,
+ * see weather-cache.h for the layout. Only visibility and the derived Cn2 are
+ * kept, so later searches skip NetCDF decoding and the wind levels entirely.
+ *
+ * @param visibility_filepath   ERA5 single level file with vis
+ * @param cn2_filepath          ERA5 pressure level file with u and v winds
+ * @param cache_filepath        written through a temporary file, replaced
+ *                              only on success
+ * @return TRUE if the cache was written
+ */
+gboolean build_weather_cache(
+        const gchar *visibility_filepath,
+        const gchar *cn2_filepath,
+        const gchar *cache_filepath) {
+    int vis_id, cn2_id;
+    weather_cache_header header;
+    memset(&header, 0, sizeof(header));
+
+    //stamped before reading, so a source replaced during the conversion
+    //leaves the cache stale
+    if (!weather_cache_stamp(visibility_filepath, &header.sources[0]) ||
+        !weather_cache_stamp(cn2_filepath, &header.sources[1])) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to stat %s or %s"),
+            __func__, visibility_filepath, cn2_filepath);
+        return FALSE;
+    }
+
+    if (open_weather_file(visibility_filepath, &vis_id))
+        return FALSE;
+
+    if (open_weather_file(cn2_filepath, &cn2_id)) {
+        nc_close(vis_id);
+        return FALSE;
+    }
+
+    gboolean ok = write_weather_cache(vis_id, cn2_id, cache_filepath, &header);
+
+    nc_close(vis_id);
+    nc_close(cn2_id);
+
+    if (ok) {
+        sat_log_log(SAT_LOG_LEVEL_INFO,
+            _("%s: Wrote weather cache %s (%u x %u cells, %u time steps)"),
+            __func__, cache_filepath, header.n_lat, header.n_lon, header.n_time);
+    }
+
+    return ok;
+}
+
+/**
+ * Same as load_turbulence_data() but served from a tile cache next to the
+ * source files. The cache is (re)built first when it is missing or older
+ * than its sources, and the NetCDF files are read directly if that fails.
+ *
+ * @param cache_filepath    cache file, NULL reads the source files directly
+ * @return {gchar *ogs name : ogs_weather_data *}, owns its values.
+ *         NULL if the data doesn't cover the window
+ */
+GHashTable *load_cached_turbulence_data(
+        gchar *visibility_filepath,
+        gchar *cn2_filepath,
+        gchar *cache_filepath,
+        GSList *OGS_list,
+        gdouble start_time,
+        gdouble end_time) {
+    weather_cache_t *cache = NULL;
+
+    if (cache_filepath != NULL) {
+        cache = weather_cache_open(cache_filepath, visibility_filepath, cn2_filepath);
+
+        if (cache == NULL && build_weather_cache(visibility_filepath, cn2_filepath, cache_filepath))
+            cache = weather_cache_open(cache_filepath, visibility_filepath, cn2_filepath);
+    }
+
+    if (cache == NULL)
+        return load_turbulence_data(visibility_filepath, cn2_filepath, OGS_list, start_time, end_time);
+
+    GHashTable *table = weather_cache_lookup(cache, OGS_list, start_time, end_time);
+    weather_cache_close(cache);
+
+    if (table == NULL) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: weather cache %s doesn't cover %f - %f"),
+            __func__, cache_filepath, start_time, end_time);
+    }
+
+    return table;
+}
+
+/**
+ * Resamples station weather onto the satellite history time grid, linearly
+ * between the stored time steps so link rates change smoothly across hour
+ * boundaries instead of jumping. Samples outside the stored steps hold the
+ * edge value.
+ *
+ * The bracketing step and weight of each history sample only depend on the
+ * time axes, they are computed once and reused by every station on the same
+ * axis, leaving one multiply-add per sample and field.
+ *
+ * @param ogs_weather   {gchar *ogs name : ogs_weather_data *}, output of
+ *                      load_turbulence_data()
+ * @param OGS_list      GSList of qth_t
+ * @param t_start       julian date of history index 0
+ * @param t_step        history time step in days
+ * @param len           history length
+ * @return {gchar *ogs name : lw_weather_t *}, owns its values. Stations
+ *         without weather are left out and default to clear sky
+ */
+GHashTable *weather_to_history_grid(
+        GHashTable *ogs_weather,
+        GSList *OGS_list,
+        gdouble t_start,
+        gdouble t_step,
+        guint len) {
+    GHashTable *weather = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, lw_weather_free);
+    guint *index = malloc(MAX(len, 1) * sizeof(guint));
+    gdouble *frac = malloc(MAX(len, 1) * sizeof(gdouble));
+    gdouble axis_start = NAN, axis_step = NAN;
+    size_t axis_len = 0;
 
-    GHashTable *table = g_hash_table_new(g_str_hash, g_str_equal);
     for (GSList *ogs_elm = OGS_list; ogs_elm != NULL; ogs_elm = ogs_elm->next) {
         qth_t *ogs = (qth_t *)ogs_elm->data;
+        ogs_weather_data *src = g_hash_table_lookup(ogs_weather, ogs->name);
 
-        ogs_weather_data *entries = malloc(sizeof(ogs_weather_data));
+        if (src == NULL || src->len == 0) continue;
 
-        gdouble *vis_data = malloc(time_diff * sizeof(gdouble));
+        if (src->start_time != axis_start || src->time_step != axis_step || src->len != axis_len) {
+            axis_start = src->start_time;
+            axis_step = src->time_step;
+            axis_len = src->len;
 
-        //pull value for this ogs (lat, lon) in giant chunk,
-        // then iterate through to calculate
+            for (guint i = 0; i < len; i++) {
+                gdouble x = CLAMP((t_start + i * t_step - axis_start) / axis_step, 0, (gdouble)axis_len - 1);
 
-        for (int time = 0; time < end_hour - start_hour; time++) {
+                //the final step uses the last interval, so index + 1 stays in range
+                index[i] = (axis_len > 1 ? MIN((guint)floor(x), axis_len - 2) : 0);
+                frac[i] = x - index[i];
+            }
+        }
 
-            //get visibility values
-            //nc_get_vara_double()
-            vis_data[time] = 1.0;
+        lw_weather_t *out = lw_weather_new(len);
+        size_t next = (src->len > 1 ? 1 : 0);
 
-            //get cn2 values
-            //nc_get_vara_float()
+        for (guint i = 0; i < len; i++) {
+            const gdouble *vis = src->vis + index[i];
+            const gdouble *cn2 = src->cn2 + index[i];
+
+            out->vis[i] = vis[0] + frac[i] * (vis[next] - vis[0]);
+            out->cn2[i] = cn2[0] + frac[i] * (cn2[next] - cn2[0]);
         }
 
-        entries->vis = vis_data;
-        entries->len = time_diff;
-        g_hash_table_insert(table, &ogs->name, entries);
+        g_hash_table_insert(weather, ogs->name, out);
     }
 
-    return table;
-}
\ No newline at end of file
+    free(index);
+    free(frac);
+    return weather;
+}
+
+void ogs_weather_data_free(gpointer data) {
+    ogs_weather_data *entries = (ogs_weather_data *)data;
+    if (entries == NULL) return;
+
+    free(entries->vis);
+    free(entries->cn2);
+    free(entries);
+}
@@ -1,10 +1,41 @@
 #include <glib/gi18n.h>
 #include "../qth-data.h"
 
+#ifndef CALC_WEATHER_DATA_H
+#define CALC_WEATHER_DATA_H
+
+/** \brief Regular latitude longitude grid of a file */
+typedef struct {
+    size_t n_lat;
+    size_t n_lon;
+    gdouble lat0;
+    gdouble dlat;
+    gdouble lon0;
+    gdouble dlon;
+} grid_axes;
+
+/** \brief Grid point weather is read from, shared by every station next to it */
+typedef struct {
+    size_t ilat;
+    size_t ilon;
+} grid_cell;
+
+/** \brief Bilinear interpolation of a station between its four grid points */
+typedef struct {
+    grid_cell corner[4];
+    gdouble weight[4];      //sum to 1
+} grid_weights;
+
+/**
+ * \brief Weather time series of one ground station, interpolated between the
+ * grid points around it. Sample i is at start_time + (i * time_step).
+ */
 typedef struct {
     size_t len;
-    gdouble *cn2;
-    gdouble *vis;
+    gdouble *cn2;           //refractive index structure parameter
+    gdouble *vis;           //visibility in km
+    gdouble start_time;     //julian date of sample 0
+    gdouble time_step;      //in days, hourly for ERA5
 } ogs_weather_data;
 
 GHashTable *load_turbulence_data(
@@ -12,4 +43,30 @@ GHashTable *load_turbulence_data(
         gchar *cn2_filepath,
         GSList *OGS_list,
         gdouble start_time,
-        gdouble end_time);
\ No newline at end of file
+        gdouble end_time);
+
+GHashTable *load_cached_turbulence_data(
+        gchar *visibility_filepath,
+        gchar *cn2_filepath,
+        gchar *cache_filepath,
+        GSList *OGS_list,
+        gdouble start_time,
+        gdouble end_time);
+
+gboolean build_weather_cache(
+        const gchar *visibility_filepath,
+        const gchar *cn2_filepath,
+        const gchar *cache_filepath);
+
+GHashTable *weather_to_history_grid(
+        GHashTable *ogs_weather,
+        GSList *OGS_list,
+        gdouble t_start,
+        gdouble t_step,
+        guint len);
+
+grid_weights weather_grid_weights(grid_axes *grid, qth_t *ogs);
+
+void ogs_weather_data_free(gpointer data);
+
+#endif
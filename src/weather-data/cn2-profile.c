@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <math.h>
+#include <glib/gi18n.h>
+
+#include "cn2-profile.h"
+
+#define HV_QUADRATURE_STEPS 4000    //simpson intervals for the wind independent terms
+
+typedef struct {
+    gdouble height;
+    guint level;
+} level_height;
+
+static gint compare_height(gconstpointer a, gconstpointer b);
+static gdouble hv_weighted_integral(gint term, gdouble thickness, gdouble ground_cn2);
+
+/**
+ * Height of a pressure level in the 1976 standard atmosphere.
+ * @param pressure_hpa  pressure in hPa
+ * @return geopotential height in m, valid up to 32 km
+ */
+gdouble pressure_to_altitude(gdouble pressure_hpa) {
+    //troposphere, constant lapse rate
+    if (pressure_hpa >= 226.32)
+        return 44330.8 * (1.0 - pow(pressure_hpa / 1013.25, 0.190263));
+
+    //lower stratosphere, isothermal to 20 km
+    if (pressure_hpa >= 54.749)
+        return 11000.0 + 6341.62 * log(226.32 / pressure_hpa);
+
+    return 20000.0 + 216650.0 * (pow(pressure_hpa / 54.749, -0.0292712) - 1.0);
+}
+
+/**
+ * Hufnagel-Valley Cn2 profile.
+ * @param height        m above ground
+ * @param wind_rms      rms wind speed between 5 and 20 km in m/s
+ * @param ground_cn2    Cn2 at ground level
+ */
+gdouble hv_cn2_at(gdouble height, gdouble wind_rms, gdouble ground_cn2) {
+    return 0.00594 * pow(wind_rms / 27.0, 2) * pow(1e-5 * height, 10) * exp(-height / 1000.0)
+        + 2.7e-16 * exp(-height / 1500.0)
+        + ground_cn2 * exp(-height / 100.0);
+}
+
+/**
+ * Builds the integrator for the pressure levels of a file.
+ *
+ * Wind speed is interpolated linearly in height between levels and held
+ * constant beyond the outermost ones, which makes the mean square wind over
+ * 5 - 20 km a fixed weighted sum of the levels. The HV profile is averaged
+ * over the atmosphere with the same (L - z)^(5/6) path weighting as the
+ * Rytov variance in skr-utils.c, so the result can be used in its place.
+ *
+ * @param pressure_hpa  level pressures, any order
+ * @param thickness_km  height of the turbulent atmosphere, ATMOSPHERE_THICKNESS
+ */
+hv_integrator *hv_integrator_new(const gdouble *pressure_hpa, guint n_levels, gdouble ground_cn2, gdouble thickness_km) {
+    if (n_levels == 0) return NULL;
+
+    hv_integrator *hv = malloc(sizeof(hv_integrator));
+    hv->n_levels = n_levels;
+    hv->weights = calloc(n_levels, sizeof(gdouble));
+
+    level_height *sorted = malloc(n_levels * sizeof(level_height));
+    for (guint l = 0; l < n_levels; l++) {
+        sorted[l].height = pressure_to_altitude(pressure_hpa[l]);
+        sorted[l].level = l;
+    }
+    qsort(sorted, n_levels, sizeof(level_height), compare_height);
+
+    gdouble low = HV_WIND_LOW;
+    gdouble high = HV_WIND_HIGH;
+    gdouble span = high - low;
+
+    //held constant below the lowest and above the highest level
+    if (sorted[0].height > low)
+        hv->weights[sorted[0].level] += (MIN(sorted[0].height, high) - low) / span;
+
+    if (sorted[n_levels - 1].height < high)
+        hv->weights[sorted[n_levels - 1].level] += (high - MAX(sorted[n_levels - 1].height, low)) / span;
+
+    //exact integral of the linear interpolant over each overlapping segment
+    for (guint k = 0; k + 1 < n_levels; k++) {
+        gdouble h0 = sorted[k].height;
+        gdouble h1 = sorted[k + 1].height;
+        gdouble x0 = MAX(h0, low);
+        gdouble x1 = MIN(h1, high);
+
+        if (x1 <= x0 || h1 <= h0) continue;
+
+        gdouble dh = h1 - h0;
+        gdouble lower = (h1 * (x1 - x0) - 0.5 * (x1 * x1 - x0 * x0)) / dh;
+        gdouble upper = (0.5 * (x1 * x1 - x0 * x0) - h0 * (x1 - x0)) / dh;
+
+        hv->weights[sorted[k].level] += lower / span;
+        hv->weights[sorted[k + 1].level] += upper / span;
+    }
+    free(sorted);
+
+    hv->first = n_levels;
+    guint last = 0;
+    for (guint l = 0; l < n_levels; l++) {
+        if (hv->weights[l] == 0) continue;
+
+        hv->first = MIN(hv->first, l);
+        last = l;
+    }
+    hv->count = (hv->first < n_levels ? last - hv->first + 1 : 0);
+
+    gdouble thickness = thickness_km * 1000.0;
+    gdouble norm = (11.0 / 6.0) * pow(thickness, -11.0 / 6.0);
+
+    hv->c1 = norm * hv_weighted_integral(0, thickness, ground_cn2) / (27.0 * 27.0);
+    hv->c0 = norm * (hv_weighted_integral(1, thickness, ground_cn2) + hv_weighted_integral(2, thickness, ground_cn2));
+
+    return hv;
+}
+
+/**
+ * Path averaged Cn2 of many wind profiles at once.
+ *
+ * Only levels [first, first + count) are used, callers read just those.
+ *
+ * @param u         n_profiles * count eastward wind in m/s, u[p * count + (l - first)]
+ * @param v         northward wind, same layout
+ * @param cn2       n_profiles outputs
+ */
+void hv_cn2_batch(hv_integrator *hv, const gfloat *u, const gfloat *v, size_t n_profiles, gdouble *cn2) {
+    const gdouble *w = hv->weights + hv->first;
+
+    for (size_t p = 0; p < n_profiles; p++) {
+        const gfloat *pu = u + p * hv->count;
+        const gfloat *pv = v + p * hv->count;
+        gdouble mean_square = 0;
+
+        for (guint l = 0; l < hv->count; l++) {
+            mean_square += w[l] * ((gdouble)pu[l] * pu[l] + (gdouble)pv[l] * pv[l]);
+        }
+
+        cn2[p] = hv->c0 + hv->c1 * mean_square;
+    }
+}
+
+void hv_integrator_free(hv_integrator *hv) {
+    if (hv == NULL) return;
+
+    free(hv->weights);
+    free(hv);
+}
+
+static gint compare_height(gconstpointer a, gconstpointer b) {
+    gdouble x = ((const level_height *)a)->height;
+    gdouble y = ((const level_height *)b)->height;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Simpson integral of one HV term times (L - h)^(5/6) over [0, L].
+ * term 0 is the wind term for a 27 m/s wind, 1 the background, 2 the ground layer.
+ */
+static gdouble hv_weighted_integral(gint term, gdouble thickness, gdouble ground_cn2) {
+    gdouble step = thickness / HV_QUADRATURE_STEPS;
+    gdouble sum = 0;
+
+    for (guint i = 0; i <= HV_QUADRATURE_STEPS; i++) {
+        gdouble h = i * step;
+        gdouble profile;
+
+        if (term == 0) profile = 0.00594 * pow(1e-5 * h, 10) * exp(-h / 1000.0);
+        else if (term == 1) profile = 2.7e-16 * exp(-h / 1500.0);
+        else profile = ground_cn2 * exp(-h / 100.0);
+
+        gdouble f = profile * pow(thickness - h, 5.0 / 6.0);
+        gdouble coeff = (i == 0 || i == HV_QUADRATURE_STEPS) ? 1.0 : (i % 2 == 1 ? 4.0 : 2.0);
+
+        sum += coeff * f;
+    }
+
+    return sum * step / 3.0;
+}
@@ -0,0 +1,36 @@
+#include <glib/gi18n.h>
+
+#ifndef CN2_PROFILE_H
+#define CN2_PROFILE_H
+
+#define HV_GROUND_CN2 1.7e-14       //Hufnagel-Valley 5/7 ground level turbulence
+#define HV_WIND_LOW 5000.0          //m, rms wind is taken between these heights
+#define HV_WIND_HIGH 20000.0
+
+/**
+ * \brief Precomputed Hufnagel-Valley integrator for a fixed set of pressure
+ * levels. The path averaged Cn2 is linear in the mean square wind, so each
+ * profile reduces to one weighted sum over the levels:
+ *
+ *      cn2 = c0 + c1 * sum(weights[l] * (u[l]^2 + v[l]^2))
+ */
+typedef struct {
+    guint n_levels;
+    guint first;            //levels outside [first, first + count) have zero weight
+    guint count;
+    gdouble *weights;       //per level, mean square wind over HV_WIND_LOW - HV_WIND_HIGH
+    gdouble c0;             //wind independent part of averaged Cn2
+    gdouble c1;             //averaged Cn2 per (m/s)^2 of mean square wind
+} hv_integrator;
+
+gdouble pressure_to_altitude(gdouble pressure_hpa);
+
+gdouble hv_cn2_at(gdouble height, gdouble wind_rms, gdouble ground_cn2);
+
+hv_integrator *hv_integrator_new(const gdouble *pressure_hpa, guint n_levels, gdouble ground_cn2, gdouble thickness_km);
+
+void hv_cn2_batch(hv_integrator *hv, const gfloat *u, const gfloat *v, size_t n_profiles, gdouble *cn2);
+
+void hv_integrator_free(hv_integrator *hv);
+
+#endif
@@ -0,0 +1,174 @@
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <math.h>
+
+#include "../../skr-utils.h"
+#include "../calc-weather-data.h"
+#include "../cn2-profile.h"
+#include "../weather-cache.h"
+#include "test-headers.h"
+
+#define TILING_LAT 40
+#define TILING_LON 70
+#define TILING_TIME 30
+
+static gchar *test_path(const gchar *name) {
+    return g_build_filename(g_get_tmp_dir(), name, NULL);
+}
+
+static void assert_same_weather(GHashTable *expected, GHashTable *actual, const gchar *name) {
+    ogs_weather_data *e = g_hash_table_lookup(expected, name);
+    ogs_weather_data *a = g_hash_table_lookup(actual, name);
+
+    g_assert_nonnull(a);
+    g_assert_cmpuint(a->len, ==, e->len);
+    g_assert_cmpfloat_with_epsilon(a->start_time, e->start_time, 1e-9);
+    g_assert_cmpfloat_with_epsilon(a->time_step, e->time_step, 1e-9);
+
+    //cache stores single precision
+    for (size_t t = 0; t < e->len; t++) {
+        g_assert_cmpfloat_with_epsilon(a->vis[t], e->vis[t], 1e-6 * e->vis[t]);
+        g_assert_cmpfloat_with_epsilon(a->cn2[t], e->cn2[t], 1e-6 * e->cn2[t]);
+    }
+}
+
+//several tiles and time blocks, written and read back without NetCDF
+void cache_tiling_test() {
+    gchar *cache_path = test_path("cache_tiling_test.wcache");
+
+    weather_cache_header header = {0};
+    header.n_lat = TILING_LAT;
+    header.n_lon = TILING_LON;
+    header.n_time = TILING_TIME;
+    header.lat0 = 90;
+    header.dlat = -0.25;
+    header.lon0 = 0;
+    header.dlon = 0.25;
+    header.start_time = 2460310.5;
+    header.time_step = 1.0 / 24.0;
+    header.ground_cn2 = HV_GROUND_CN2;
+    header.thickness = ATMOSPHERE_THICKNESS;
+
+    weather_cache_writer *writer = weather_cache_writer_new(cache_path, &header);
+    g_assert_nonnull(writer);
+
+    size_t n_cells = TILING_LAT * TILING_LON;
+    gfloat *vis = malloc(WEATHER_CACHE_TIME_BLOCK * n_cells * sizeof(gfloat));
+    gfloat *cn2 = malloc(WEATHER_CACHE_TIME_BLOCK * n_cells * sizeof(gfloat));
+
+    for (size_t t0 = 0; t0 < TILING_TIME; t0 += WEATHER_CACHE_TIME_BLOCK) {
+        for (size_t b = 0; b < WEATHER_CACHE_TIME_BLOCK; b++) {
+            for (size_t c = 0; c < n_cells; c++) {
+                vis[b * n_cells + c] = (gfloat)(c * 100 + t0 + b);
+                cn2[b * n_cells + c] = -(gfloat)(c * 100 + t0 + b);
+            }
+        }
+        g_assert_true(weather_cache_write_block(writer, vis, cn2));
+    }
+    g_assert_true(weather_cache_writer_finish(writer, TRUE));
+
+    weather_cache_t *cache = weather_cache_open(cache_path, NULL, NULL);
+    g_assert_nonnull(cache);
+
+    for (size_t lat = 0; lat < TILING_LAT; lat++) {
+        for (size_t lon = 0; lon < TILING_LON; lon++) {
+            for (size_t t = 0; t < TILING_TIME; t++) {
+                gfloat expected = (gfloat)((lat * TILING_LON + lon) * 100 + t);
+                g_assert_cmpfloat(weather_cache_value(cache, WEATHER_FIELD_VIS, lat, lon, t), ==, expected);
+                g_assert_cmpfloat(weather_cache_value(cache, WEATHER_FIELD_CN2, lat, lon, t), ==, -expected);
+            }
+        }
+    }
+    g_assert_true(isnan(weather_cache_value(cache, WEATHER_FIELD_VIS, TILING_LAT, 0, 0)));
+    g_assert_true(isnan(weather_cache_value(cache, WEATHER_FIELD_VIS, 0, 0, TILING_TIME)));
+
+    weather_cache_close(cache);
+    free(vis);
+    free(cn2);
+    g_remove(cache_path);
+    g_free(cache_path);
+}
+
+void cache_round_trip_test() {
+    gchar *sfc_path = test_path("cache_test_sfc.nc");
+    gchar *plev_path = test_path("cache_test_plev.nc");
+    gchar *cache_path = test_path("cache_test.wcache");
+    write_synthetic_weather(sfc_path, plev_path);
+    g_remove(cache_path);
+
+    qth_t ogs_a = {.name="ogs a", .alt=0, .lat=45.1, .lon=10.1};
+    qth_t ogs_c = {.name="ogs c", .alt=0, .lat=44.0, .lon=12.0};
+    GSList *list = g_slist_append(NULL, &ogs_a);
+    list = g_slist_append(list, &ogs_c);
+
+    gdouble start = 2460310.5 + 0.5 / 24.0;
+    gdouble end = start + 2.0 / 24.0;
+    GHashTable *direct = load_turbulence_data(sfc_path, plev_path, list, start, end);
+
+    //first call converts, second is served from the existing cache
+    GHashTable *cached = load_cached_turbulence_data(sfc_path, plev_path, cache_path, list, start, end);
+    g_assert_true(g_file_test(cache_path, G_FILE_TEST_EXISTS));
+    assert_same_weather(direct, cached, "ogs a");
+    assert_same_weather(direct, cached, "ogs c");
+    g_hash_table_destroy(cached);
+
+    weather_cache_t *cache = weather_cache_open(cache_path, sfc_path, plev_path);
+    g_assert_nonnull(cache);
+    cached = weather_cache_lookup(cache, list, start, end);
+    assert_same_weather(direct, cached, "ogs a");
+    assert_same_weather(direct, cached, "ogs c");
+    g_assert_null(weather_cache_lookup(cache, list, start + 1, end + 1));
+    weather_cache_close(cache);
+
+    g_hash_table_destroy(cached);
+    g_hash_table_destroy(direct);
+    g_slist_free(list);
+    g_remove(sfc_path);
+    g_remove(plev_path);
+    g_remove(cache_path);
+    g_free(sfc_path);
+    g_free(plev_path);
+    g_free(cache_path);
+}
+
+void cache_invalidation_test() {
+    gchar *sfc_path = test_path("cache_stale_sfc.nc");
+    gchar *plev_path = test_path("cache_stale_plev.nc");
+    gchar *cache_path = test_path("cache_stale.wcache");
+    write_synthetic_weather(sfc_path, plev_path);
+
+    g_assert_true(build_weather_cache(sfc_path, plev_path, cache_path));
+
+    weather_cache_t *cache = weather_cache_open(cache_path, sfc_path, plev_path);
+    g_assert_nonnull(cache);
+    weather_cache_close(cache);
+
+    //source touched after the conversion
+    GStatBuf buf;
+    g_assert_cmpint(g_stat(plev_path, &buf), ==, 0);
+    struct utimbuf times = {.actime = buf.st_atime, .modtime = buf.st_mtime + 60};
+    g_assert_cmpint(g_utime(plev_path, &times), ==, 0);
+    g_assert_null(weather_cache_open(cache_path, sfc_path, plev_path));
+
+    //rebuilt on the next load
+    qth_t ogs = {.name="ogs", .alt=0, .lat=45, .lon=10};
+    GSList *list = g_slist_append(NULL, &ogs);
+    GHashTable *table = load_cached_turbulence_data(sfc_path, plev_path, cache_path, list, 2460310.5, 2460310.5);
+    g_assert_nonnull(table);
+    cache = weather_cache_open(cache_path, sfc_path, plev_path);
+    g_assert_nonnull(cache);
+    weather_cache_close(cache);
+
+    //anything that isn't a complete cache is ignored
+    g_assert_true(g_file_set_contents(cache_path, "not a cache", -1, NULL));
+    g_assert_null(weather_cache_open(cache_path, sfc_path, plev_path));
+
+    g_hash_table_destroy(table);
+    g_slist_free(list);
+    g_remove(sfc_path);
+    g_remove(plev_path);
+    g_remove(cache_path);
+    g_free(sfc_path);
+    g_free(plev_path);
+    g_free(cache_path);
+}
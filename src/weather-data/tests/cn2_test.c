@@ -0,0 +1,187 @@
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <math.h>
+#include <netcdf.h>
+
+#include "../../skr-utils.h"
+#include "../calc-weather-data.h"
+#include "../cn2-profile.h"
+#include "test-headers.h"
+
+#define N_TIME 4
+#define N_LEVEL 5
+#define N_LAT 3
+#define N_LON 4
+
+static const gdouble pressure[N_LEVEL] = {1000, 500, 250, 100, 50};
+
+//path averaged Cn2 straight from the profile, reference for the integrator
+static gdouble reference_cn2(gdouble wind_rms) {
+    gdouble thickness = ATMOSPHERE_THICKNESS * 1000.0;
+    guint steps = 20000;
+    gdouble step = thickness / steps;
+    gdouble sum = 0;
+
+    for (guint i = 0; i <= steps; i++) {
+        gdouble h = i * step;
+        gdouble coeff = (i == 0 || i == steps) ? 1.0 : (i % 2 == 1 ? 4.0 : 2.0);
+        sum += coeff * hv_cn2_at(h, wind_rms, HV_GROUND_CN2) * pow(thickness - h, 5.0 / 6.0);
+    }
+
+    return (11.0 / 6.0) * pow(thickness, -11.0 / 6.0) * sum * step / 3.0;
+}
+
+void cn2_pressure_altitude_test() {
+    g_assert_cmpfloat_with_epsilon(pressure_to_altitude(1013.25), 0, 1e-6);
+    g_assert_cmpfloat_with_epsilon(pressure_to_altitude(226.32), 11000, 1);
+    g_assert_cmpfloat_with_epsilon(pressure_to_altitude(54.749), 20000, 5);
+    g_assert_cmpfloat(pressure_to_altitude(10), >, pressure_to_altitude(50));
+}
+
+void cn2_hv_batch_test() {
+    hv_integrator *hv = hv_integrator_new(pressure, N_LEVEL, HV_GROUND_CN2, ATMOSPHERE_THICKNESS);
+
+    gdouble total = 0;
+    for (guint l = 0; l < N_LEVEL; l++) total += hv->weights[l];
+    g_assert_cmpfloat_with_epsilon(total, 1.0, 1e-12);
+
+    //1000 hPa only reaches into 5 - 20 km through the interpolation to 500 hPa
+    g_assert_cmpuint(hv->first, ==, 0);
+    g_assert_cmpuint(hv->count, ==, N_LEVEL);
+    g_assert_cmpfloat(hv->weights[0], <, hv->weights[2]);
+
+    //two profiles, uniform 30 m/s and calm
+    gfloat u[2 * N_LEVEL], v[2 * N_LEVEL];
+    for (guint l = 0; l < hv->count; l++) {
+        u[l] = 18;
+        v[l] = 24;
+        u[hv->count + l] = 0;
+        v[hv->count + l] = 0;
+    }
+
+    gdouble cn2[2];
+    hv_cn2_batch(hv, u, v, 2, cn2);
+
+    g_assert_cmpfloat_with_epsilon(cn2[0], reference_cn2(30), 1e-3 * cn2[0]);
+    g_assert_cmpfloat_with_epsilon(cn2[1], reference_cn2(0), 1e-3 * cn2[1]);
+    g_assert_cmpfloat(cn2[0], >, cn2[1]);
+
+    hv_integrator_free(hv);
+}
+
+static void write_axis(int ncid, int varid, const gdouble *values) {
+    g_assert_cmpint(nc_put_var_double(ncid, varid, values), ==, NC_NOERR);
+}
+
+//ERA5 layout: latitude descending, longitude 0 - 360, winds on (time, level, lat, lon)
+void write_synthetic_weather(const gchar *sfc_path, const gchar *plev_path) {
+    int ncid, time_dim, level_dim, lat_dim, lon_dim;
+    int time_var, level_var, lat_var, lon_var, vis_var, u_var, v_var;
+    const char *time_units = "hours since 2024-01-01 00:00:00";
+
+    gdouble time[N_TIME] = {0, 1, 2, 3};
+    gdouble lat[N_LAT] = {46, 45, 44};
+    gdouble lon[N_LON] = {9, 10, 11, 12};
+
+    g_assert_cmpint(nc_create(sfc_path, NC_CLOBBER, &ncid), ==, NC_NOERR);
+    nc_def_dim(ncid, "valid_time", N_TIME, &time_dim);
+    nc_def_dim(ncid, "latitude", N_LAT, &lat_dim);
+    nc_def_dim(ncid, "longitude", N_LON, &lon_dim);
+    nc_def_var(ncid, "valid_time", NC_DOUBLE, 1, &time_dim, &time_var);
+    nc_def_var(ncid, "latitude", NC_DOUBLE, 1, &lat_dim, &lat_var);
+    nc_def_var(ncid, "longitude", NC_DOUBLE, 1, &lon_dim, &lon_var);
+    int vis_dims[3] = {time_dim, lat_dim, lon_dim};
+    nc_def_var(ncid, "vis", NC_FLOAT, 3, vis_dims, &vis_var);
+    nc_put_att_text(ncid, time_var, "units", strlen(time_units), time_units);
+    nc_put_att_text(ncid, vis_var, "units", 1, "m");
+    nc_enddef(ncid);
+
+    gfloat vis[N_TIME][N_LAT][N_LON];
+    for (guint t = 0; t < N_TIME; t++)
+        for (guint y = 0; y < N_LAT; y++)
+            for (guint x = 0; x < N_LON; x++)
+                vis[t][y][x] = 10000 + 1000 * t + 100 * y + x;
+
+    write_axis(ncid, time_var, time);
+    write_axis(ncid, lat_var, lat);
+    write_axis(ncid, lon_var, lon);
+    g_assert_cmpint(nc_put_var_float(ncid, vis_var, &vis[0][0][0]), ==, NC_NOERR);
+    g_assert_cmpint(nc_close(ncid), ==, NC_NOERR);
+
+    g_assert_cmpint(nc_create(plev_path, NC_CLOBBER, &ncid), ==, NC_NOERR);
+    nc_def_dim(ncid, "valid_time", N_TIME, &time_dim);
+    nc_def_dim(ncid, "pressure_level", N_LEVEL, &level_dim);
+    nc_def_dim(ncid, "latitude", N_LAT, &lat_dim);
+    nc_def_dim(ncid, "longitude", N_LON, &lon_dim);
+    nc_def_var(ncid, "valid_time", NC_DOUBLE, 1, &time_dim, &time_var);
+    nc_def_var(ncid, "pressure_level", NC_DOUBLE, 1, &level_dim, &level_var);
+    nc_def_var(ncid, "latitude", NC_DOUBLE, 1, &lat_dim, &lat_var);
+    nc_def_var(ncid, "longitude", NC_DOUBLE, 1, &lon_dim, &lon_var);
+    int wind_dims[4] = {time_dim, level_dim, lat_dim, lon_dim};
+    nc_def_var(ncid, "u", NC_FLOAT, 4, wind_dims, &u_var);
+    nc_def_var(ncid, "v", NC_FLOAT, 4, wind_dims, &v_var);
+    nc_put_att_text(ncid, time_var, "units", strlen(time_units), time_units);
+    nc_enddef(ncid);
+
+    //uniform 10 m/s everywhere except a 40 m/s jet over (44N, 12E)
+    gfloat u[N_TIME][N_LEVEL][N_LAT][N_LON];
+    gfloat v[N_TIME][N_LEVEL][N_LAT][N_LON];
+    for (guint t = 0; t < N_TIME; t++)
+        for (guint l = 0; l < N_LEVEL; l++)
+            for (guint y = 0; y < N_LAT; y++)
+                for (guint x = 0; x < N_LON; x++) {
+                    gboolean jet = (y == 2 && x == 3);
+                    u[t][l][y][x] = (jet ? 24 : 6);
+                    v[t][l][y][x] = (jet ? 32 : 8);
+                }
+
+    write_axis(ncid, time_var, time);
+    write_axis(ncid, level_var, pressure);
+    write_axis(ncid, lat_var, lat);
+    write_axis(ncid, lon_var, lon);
+    g_assert_cmpint(nc_put_var_float(ncid, u_var, &u[0][0][0][0]), ==, NC_NOERR);
+    g_assert_cmpint(nc_put_var_float(ncid, v_var, &v[0][0][0][0]), ==, NC_NOERR);
+    g_assert_cmpint(nc_close(ncid), ==, NC_NOERR);
+}
+
+void cn2_synthetic_file_test() {
+    gchar *sfc_path = g_build_filename(g_get_tmp_dir(), "cn2_test_sfc.nc", NULL);
+    gchar *plev_path = g_build_filename(g_get_tmp_dir(), "cn2_test_plev.nc", NULL);
+    write_synthetic_weather(sfc_path, plev_path);
+
+    //a and b share a cell
+    qth_t ogs_a = {.name="ogs a", .alt=0, .lat=45.1, .lon=10.1};
+    qth_t ogs_b = {.name="ogs b", .alt=0, .lat=44.9, .lon=9.9};
+    qth_t ogs_c = {.name="ogs c", .alt=0, .lat=44.0, .lon=12.0};
+    GSList *list = g_slist_append(NULL, &ogs_a);
+    list = g_slist_append(list, &ogs_b);
+    list = g_slist_append(list, &ogs_c);
+
+    //2024-01-01 01:00 to 02:00
+    gdouble start = 2460310.5 + 1.0 / 24.0;
+    GHashTable *table = load_turbulence_data(sfc_path, plev_path, list, start, start + 1.0 / 24.0);
+    g_assert_nonnull(table);
+
+    ogs_weather_data *a = g_hash_table_lookup(table, "ogs a");
+    ogs_weather_data *b = g_hash_table_lookup(table, "ogs b");
+    ogs_weather_data *c = g_hash_table_lookup(table, "ogs c");
+
+    g_assert_cmpuint(a->len, ==, 2);
+    g_assert_cmpfloat_with_epsilon(a->start_time, start, 1e-9);
+    g_assert_cmpfloat_with_epsilon(a->time_step, 1.0 / 24.0, 1e-9);
+
+    //visibility converted to km, t = 1 between lat 46 - 45 and lon 10 - 11
+    g_assert_cmpfloat_with_epsilon(a->vis[0], 11.0911, 1e-6);
+    g_assert_cmpfloat_with_epsilon(c->vis[1], 12.203, 1e-6);
+
+    g_assert_cmpfloat(a->cn2[0], ==, b->cn2[0]);
+    g_assert_cmpfloat_with_epsilon(a->cn2[0], reference_cn2(10), 1e-3 * a->cn2[0]);
+    g_assert_cmpfloat_with_epsilon(c->cn2[1], reference_cn2(40), 1e-3 * c->cn2[1]);
+
+    g_hash_table_destroy(table);
+    g_slist_free(list);
+    g_remove(sfc_path);
+    g_remove(plev_path);
+    g_free(sfc_path);
+    g_free(plev_path);
+}
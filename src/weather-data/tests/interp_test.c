@@ -0,0 +1,116 @@
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <math.h>
+
+#include "../../skr-utils.h"
+#include "../calc-weather-data.h"
+#include "test-headers.h"
+
+void interp_grid_weights_test() {
+    grid_axes era5 = {.n_lat = 721, .n_lon = 1440, .lat0 = 90, .dlat = -0.25, .lon0 = 0, .dlon = 0.25};
+
+    //on a grid point all weight goes to it
+    qth_t exact = {.name="exact", .lat=45.0, .lon=10.0};
+    grid_weights w = weather_grid_weights(&era5, &exact);
+    g_assert_cmpuint(w.corner[0].ilat, ==, 180);
+    g_assert_cmpuint(w.corner[0].ilon, ==, 40);
+    g_assert_cmpfloat_with_epsilon(w.weight[0], 1.0, 1e-12);
+
+    qth_t middle = {.name="middle", .lat=44.875, .lon=10.125};
+    w = weather_grid_weights(&era5, &middle);
+    for (guint k = 0; k < 4; k++) g_assert_cmpfloat_with_epsilon(w.weight[k], 0.25, 1e-12);
+    g_assert_cmpuint(w.corner[3].ilat, ==, 181);
+    g_assert_cmpuint(w.corner[3].ilon, ==, 41);
+
+    //global grids wrap between the last and first longitude
+    qth_t date_line = {.name="wrap", .lat=0, .lon=-0.05};
+    w = weather_grid_weights(&era5, &date_line);
+    g_assert_cmpuint(w.corner[0].ilon, ==, 1439);
+    g_assert_cmpuint(w.corner[1].ilon, ==, 0);
+    g_assert_cmpfloat_with_epsilon(w.weight[1], 0.8, 1e-9);
+
+    //regional grids take the closest edge
+    grid_axes europe = {.n_lat = 3, .n_lon = 4, .lat0 = 46, .dlat = -1, .lon0 = 9, .dlon = 1};
+    qth_t west = {.name="west", .lat=50, .lon=-5};
+    w = weather_grid_weights(&europe, &west);
+    g_assert_cmpuint(w.corner[0].ilat, ==, 0);
+    g_assert_cmpuint(w.corner[0].ilon, ==, 0);
+    g_assert_cmpfloat_with_epsilon(w.weight[0], 1.0, 1e-12);
+
+    gdouble total = 0;
+    qth_t any = {.name="any", .lat=44.3, .lon=11.6};
+    w = weather_grid_weights(&europe, &any);
+    for (guint k = 0; k < 4; k++) total += w.weight[k];
+    g_assert_cmpfloat_with_epsilon(total, 1.0, 1e-12);
+}
+
+void interp_bilinear_load_test() {
+    gchar *sfc_path = g_build_filename(g_get_tmp_dir(), "interp_test_sfc.nc", NULL);
+    gchar *plev_path = g_build_filename(g_get_tmp_dir(), "interp_test_plev.nc", NULL);
+    write_synthetic_weather(sfc_path, plev_path);
+
+    //synthetic visibility is linear in both indices, bilinear interpolation is exact
+    qth_t ogs = {.name="ogs", .alt=0, .lat=44.5, .lon=10.5};
+    GSList *list = g_slist_append(NULL, &ogs);
+
+    GHashTable *table = load_turbulence_data(sfc_path, plev_path, list, 2460310.5, 2460310.5 + 3.0 / 24.0);
+    ogs_weather_data *w = g_hash_table_lookup(table, "ogs");
+
+    g_assert_cmpuint(w->len, ==, 4);
+    for (size_t t = 0; t < w->len; t++) {
+        g_assert_cmpfloat_with_epsilon(w->vis[t], (10000 + 1000 * t + 150 + 1.5) / 1000.0, 1e-6);
+    }
+
+    g_hash_table_destroy(table);
+    g_slist_free(list);
+    g_remove(sfc_path);
+    g_remove(plev_path);
+    g_free(sfc_path);
+    g_free(plev_path);
+}
+
+void interp_history_grid_test() {
+    qth_t ogs_a = {.name="ogs a"};
+    qth_t ogs_b = {.name="ogs b"};
+    qth_t ogs_c = {.name="ogs c"};
+    GSList *list = g_slist_append(NULL, &ogs_a);
+    list = g_slist_append(list, &ogs_b);
+    list = g_slist_append(list, &ogs_c);
+
+    gdouble hour = 1.0 / 24.0;
+    gdouble vis[3] = {10, 20, 40};
+    gdouble cn2[3] = {1e-15, 3e-15, 2e-15};
+    gdouble single = 7;
+
+    ogs_weather_data a = {.len = 3, .vis = vis, .cn2 = cn2, .start_time = 2460310.5, .time_step = hour};
+    ogs_weather_data b = {.len = 1, .vis = &single, .cn2 = &single, .start_time = 2460310.5, .time_step = hour};
+    GHashTable *loaded = g_hash_table_new(g_str_hash, g_str_equal);
+    g_hash_table_insert(loaded, "ogs a", &a);
+    g_hash_table_insert(loaded, "ogs b", &b);
+
+    //15 minute history from 30 minutes before the first sample to past the last
+    guint len = 14;
+    GHashTable *weather = weather_to_history_grid(loaded, list, 2460310.5 - 0.5 * hour, 0.25 * hour, len);
+
+    //julian dates leave about 1e-8 of a step of rounding
+    lw_weather_t *wa = g_hash_table_lookup(weather, "ogs a");
+    g_assert_cmpuint(wa->len, ==, len);
+    g_assert_cmpfloat_with_epsilon(wa->vis[0], 10, 1e-6);
+    g_assert_cmpfloat_with_epsilon(wa->vis[2], 10, 1e-6);
+    g_assert_cmpfloat_with_epsilon(wa->vis[3], 12.5, 1e-6);
+    g_assert_cmpfloat_with_epsilon(wa->vis[6], 20, 1e-6);
+    g_assert_cmpfloat_with_epsilon(wa->vis[8], 30, 1e-6);
+    g_assert_cmpfloat_with_epsilon(wa->vis[10], 40, 1e-6);
+    g_assert_cmpfloat_with_epsilon(wa->vis[13], 40, 1e-6);
+    g_assert_cmpfloat_with_epsilon(wa->cn2[4], 2e-15, 1e-21);
+    g_assert_cmpfloat_with_epsilon(wa->cn2[9], 2.25e-15, 1e-21);
+
+    lw_weather_t *wb = g_hash_table_lookup(weather, "ogs b");
+    for (guint i = 0; i < len; i++) g_assert_cmpfloat(wb->vis[i], ==, 7);
+
+    g_assert_null(g_hash_table_lookup(weather, "ogs c"));
+
+    g_hash_table_destroy(weather);
+    g_hash_table_destroy(loaded);
+    g_slist_free(list);
+}
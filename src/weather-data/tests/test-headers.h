@@ -0,0 +1,23 @@
+#include <glib/gi18n.h>
+
+#define UNUSED(x) (void)(x)
+
+void cn2_pressure_altitude_test();
+
+void cn2_hv_batch_test();
+
+void cn2_synthetic_file_test();
+
+void write_synthetic_weather(const gchar *sfc_path, const gchar *plev_path);
+
+void cache_tiling_test();
+
+void cache_round_trip_test();
+
+void cache_invalidation_test();
+
+void interp_grid_weights_test();
+
+void interp_bilinear_load_test();
+
+void interp_history_grid_test();
@@ -33,22 +33,26 @@ int main() {
     list = g_slist_append(list, &ogs2);
     list = g_slist_append(list, &ogs3);
     
-    GHashTable *table = load_turbulence_data(vis_filepath, cn2_filepath, list, 0, 12);
+    //first 12 hours of 2024-01-01, julian dates
+    GHashTable *table = load_turbulence_data(vis_filepath, cn2_filepath, list, 2460310.5, 2460311.0);
 
     if (table == NULL) {
         printf("ERROR occured: returned NULL\n");
         return 0;
     }
     
-    GList *keys = g_hash_table_get_keys(table);
-    for(GList *k = keys; k != NULL; k = k->next) {
-        ogs_weather_data *data = (ogs_weather_data *)g_hash_table_lookup(table, k->data);
-        printf("ogs: %s\n", ((qth_t *)k->data)->name);
+    for (GSList *elm = list; elm != NULL; elm = elm->next) {
+        qth_t *ogs = (qth_t *)elm->data;
+        ogs_weather_data *data = (ogs_weather_data *)g_hash_table_lookup(table, ogs->name);
+        printf("ogs: %s\n", ogs->name);
 
         for (size_t i = 0; i < data->len; i++) {
-            printf("\tvis: %f\n", data->vis[i]);
+            printf("\t%f vis: %f cn2: %e\n", data->start_time + i * data->time_step, data->vis[i], data->cn2[i]);
         }
     }
+
+    g_hash_table_destroy(table);
+    g_slist_free(list);
     
     return 0;
 }
@@ -0,0 +1,27 @@
+#include <glib/gi18n.h>
+#include "test-headers.h"
+
+int main (int argc, char *argv[]) {
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/cn2_test.c/cn2_pressure_altitude_test", cn2_pressure_altitude_test);
+
+    g_test_add_func("/cn2_test.c/cn2_hv_batch_test", cn2_hv_batch_test);
+
+    g_test_add_func("/cn2_test.c/cn2_synthetic_file_test", cn2_synthetic_file_test);
+
+    g_test_add_func("/cache_test.c/cache_tiling_test", cache_tiling_test);
+
+    g_test_add_func("/cache_test.c/cache_round_trip_test", cache_round_trip_test);
+
+    g_test_add_func("/cache_test.c/cache_invalidation_test", cache_invalidation_test);
+
+    g_test_add_func("/interp_test.c/interp_grid_weights_test", interp_grid_weights_test);
+
+    g_test_add_func("/interp_test.c/interp_bilinear_load_test", interp_bilinear_load_test);
+
+    g_test_add_func("/interp_test.c/interp_history_grid_test", interp_history_grid_test);
+
+    return g_test_run();
+}
@@ -0,0 +1,331 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+#include "../sat-log.h"
+#include "../skr-utils.h"
+#include "cn2-profile.h"
+#include "weather-cache.h"
+
+struct weather_cache_writer {
+    FILE *file;
+    gchar *path;
+    gchar *tmp_path;            //written here and renamed on success, readers never see half a cache
+    weather_cache_header header;
+    guint64 *index;
+    guint64 offset;             //where the next tile goes
+    guint block;                //next time block to write
+    gfloat *tile;
+};
+
+static size_t tile_values(const weather_cache_header *header) {
+    return (size_t)WEATHER_N_FIELDS * header->tile * header->tile * header->time_block;
+}
+
+static size_t index_len(const weather_cache_header *header) {
+    return (size_t)header->n_blocks * header->n_tiles_lat * header->n_tiles_lon;
+}
+
+/**
+ * Size and modification time of a source file.
+ * @return FALSE if the file can't be stat'ed
+ */
+gboolean weather_cache_stamp(const gchar *filepath, weather_cache_source *source) {
+    GStatBuf buf;
+
+    if (filepath == NULL || g_stat(filepath, &buf) != 0)
+        return FALSE;
+
+    source->size = (guint64)buf.st_size;
+    source->mtime = (gint64)buf.st_mtime;
+    return TRUE;
+}
+
+/**
+ * Starts writing a cache file.
+ *
+ * The caller fills the grid, time axis, Hufnagel-Valley parameters and source
+ * stamps of the header, the tiling is filled in here. Blocks of
+ * WEATHER_CACHE_TIME_BLOCK time steps are then written in order with
+ * weather_cache_write_block() and the file completed with weather_cache_writer_finish().
+ *
+ * @return NULL if the file can't be created
+ */
+weather_cache_writer *weather_cache_writer_new(const gchar *cache_path, weather_cache_header *header) {
+    weather_cache_writer *writer = calloc(1, sizeof(weather_cache_writer));
+
+    writer->header = *header;
+    weather_cache_header *h = &writer->header;
+    memcpy(h->magic, WEATHER_CACHE_MAGIC, sizeof(h->magic));
+    h->version = WEATHER_CACHE_VERSION;
+    h->tile = WEATHER_CACHE_TILE;
+    h->time_block = WEATHER_CACHE_TIME_BLOCK;
+    h->n_tiles_lat = (h->n_lat + h->tile - 1) / h->tile;
+    h->n_tiles_lon = (h->n_lon + h->tile - 1) / h->tile;
+    h->n_blocks = (h->n_time + h->time_block - 1) / h->time_block;
+    h->reserved = 0;
+
+    writer->path = g_strdup(cache_path);
+    writer->tmp_path = g_strdup_printf("%s.tmp", cache_path);
+    writer->index = calloc(MAX(index_len(h), 1), sizeof(guint64));
+    writer->tile = malloc(tile_values(h) * sizeof(gfloat));
+    writer->offset = sizeof(weather_cache_header) + index_len(h) * sizeof(guint64);
+
+    writer->file = g_fopen(writer->tmp_path, "wb");
+    if (writer->file == NULL) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to create %s"),
+            __func__, writer->tmp_path);
+        weather_cache_writer_finish(writer, FALSE);
+        return NULL;
+    }
+
+    //placeholder, the index is only known once every tile is written
+    if (fwrite(h, sizeof(weather_cache_header), 1, writer->file) != 1 ||
+        (index_len(h) > 0 && fwrite(writer->index, sizeof(guint64), index_len(h), writer->file) != index_len(h))) {
+        weather_cache_writer_finish(writer, FALSE);
+        return NULL;
+    }
+
+    return writer;
+}
+
+/**
+ * Writes the next time block of the whole grid as tiles.
+ *
+ * @param vis   time_block * n_lat * n_lon visibility values, vis[(t * n_lat + lat) * n_lon + lon],
+ *              time steps past the end of the data NAN
+ * @param cn2   Cn2, same layout
+ */
+gboolean weather_cache_write_block(weather_cache_writer *writer, const gfloat *vis, const gfloat *cn2) {
+    weather_cache_header *h = &writer->header;
+    const gfloat *fields[WEATHER_N_FIELDS] = {vis, cn2};
+    size_t n_cells = (size_t)h->n_lat * h->n_lon;
+    size_t tile_len = tile_values(h);
+
+    if (writer->block >= h->n_blocks) return FALSE;
+
+    for (guint ty = 0; ty < h->n_tiles_lat; ty++) {
+        for (guint tx = 0; tx < h->n_tiles_lon; tx++) {
+            gfloat *out = writer->tile;
+
+            for (guint f = 0; f < WEATHER_N_FIELDS; f++) {
+                for (guint cy = 0; cy < h->tile; cy++) {
+                    for (guint cx = 0; cx < h->tile; cx++) {
+                        size_t lat = (size_t)ty * h->tile + cy;
+                        size_t lon = (size_t)tx * h->tile + cx;
+                        gboolean inside = (lat < h->n_lat && lon < h->n_lon);
+
+                        for (guint t = 0; t < h->time_block; t++) {
+                            *out++ = (inside ? fields[f][t * n_cells + lat * h->n_lon + lon] : NAN);
+                        }
+                    }
+                }
+            }
+
+            if (fwrite(writer->tile, sizeof(gfloat), tile_len, writer->file) != tile_len) {
+                sat_log_log(SAT_LOG_LEVEL_ERROR,
+                    _("%s: Failed to write %s"),
+                    __func__, writer->tmp_path);
+                return FALSE;
+            }
+
+            writer->index[((size_t)writer->block * h->n_tiles_lat + ty) * h->n_tiles_lon + tx] = writer->offset;
+            writer->offset += tile_len * sizeof(gfloat);
+        }
+    }
+
+    writer->block++;
+    return TRUE;
+}
+
+/**
+ * Completes the cache file and frees the writer.
+ * @param keep  FALSE discards the file, e.g. after a failed conversion
+ * @return TRUE if the cache was written in full and moved into place
+ */
+gboolean weather_cache_writer_finish(weather_cache_writer *writer, gboolean keep) {
+    weather_cache_header *h = &writer->header;
+    gboolean ok = keep && writer->file != NULL && writer->block == h->n_blocks;
+
+    if (ok) {
+        ok = (fseek(writer->file, 0, SEEK_SET) == 0 &&
+            fwrite(h, sizeof(weather_cache_header), 1, writer->file) == 1 &&
+            (index_len(h) == 0 || fwrite(writer->index, sizeof(guint64), index_len(h), writer->file) == index_len(h)));
+    }
+
+    if (writer->file != NULL && fclose(writer->file) != 0)
+        ok = FALSE;
+
+    if (ok && g_rename(writer->tmp_path, writer->path) != 0) {
+        sat_log_log(SAT_LOG_LEVEL_ERROR,
+            _("%s: Failed to move %s to %s"),
+            __func__, writer->tmp_path, writer->path);
+        ok = FALSE;
+    }
+
+    if (!ok && writer->file != NULL)
+        g_remove(writer->tmp_path);
+
+    g_free(writer->path);
+    g_free(writer->tmp_path);
+    free(writer->index);
+    free(writer->tile);
+    free(writer);
+
+    return ok;
+}
+
+static gboolean source_unchanged(const weather_cache_source *stored, const gchar *filepath) {
+    weather_cache_source current;
+
+    //no source to compare with, trust the cache
+    if (filepath == NULL) return TRUE;
+
+    return weather_cache_stamp(filepath, &current) &&
+        current.size == stored->size && current.mtime == stored->mtime;
+}
+
+/**
+ * Maps a cache file for reading.
+ *
+ * The cache is rejected if it is truncated, was written by another format
+ * version or with other Hufnagel-Valley parameters, or if either source file
+ * changed size or modification time since the conversion.
+ *
+ * @param visibility_filepath   source the cache must match, NULL skips the check
+ * @param cn2_filepath          source the cache must match, NULL skips the check
+ * @return NULL if the cache is missing or stale, close with weather_cache_close()
+ */
+weather_cache_t *weather_cache_open(const gchar *cache_path, const gchar *visibility_filepath, const gchar *cn2_filepath) {
+    GError *error = NULL;
+    GMappedFile *file = g_mapped_file_new(cache_path, FALSE, &error);
+
+    if (file == NULL) {
+        g_clear_error(&error);
+        return NULL;
+    }
+
+    const gchar *data = g_mapped_file_get_contents(file);
+    gsize len = g_mapped_file_get_length(file);
+    const weather_cache_header *h = (const weather_cache_header *)data;
+    const gchar *reason = NULL;
+
+    if (len < sizeof(weather_cache_header) || strncmp(h->magic, WEATHER_CACHE_MAGIC, sizeof(h->magic)) != 0)
+        reason = "not a weather cache";
+    else if (h->version != WEATHER_CACHE_VERSION || h->tile == 0 || h->time_block == 0)
+        reason = "unsupported version";
+    else if (len < sizeof(weather_cache_header) + index_len(h) * sizeof(guint64) +
+            index_len(h) * tile_values(h) * sizeof(gfloat))
+        reason = "truncated";
+    else if (h->ground_cn2 != HV_GROUND_CN2 || h->thickness != ATMOSPHERE_THICKNESS)
+        reason = "converted with other turbulence parameters";
+    else if (!source_unchanged(&h->sources[0], visibility_filepath) || !source_unchanged(&h->sources[1], cn2_filepath))
+        reason = "source files changed";
+
+    if (reason != NULL) {
+        sat_log_log(SAT_LOG_LEVEL_INFO,
+            _("%s: Ignoring %s (%s)"),
+            __func__, cache_path, reason);
+        g_mapped_file_unref(file);
+        return NULL;
+    }
+
+    weather_cache_t *cache = malloc(sizeof(weather_cache_t));
+    cache->file = file;
+    cache->data = data;
+    cache->header = h;
+    cache->index = (const guint64 *)(data + sizeof(weather_cache_header));
+
+    return cache;
+}
+
+/**
+ * Value of one field at a grid cell and time step.
+ * @return NAN outside the grid or where the source had no value
+ */
+gfloat weather_cache_value(weather_cache_t *cache, weather_field field, size_t ilat, size_t ilon, size_t t) {
+    const weather_cache_header *h = cache->header;
+
+    if (field >= WEATHER_N_FIELDS || ilat >= h->n_lat || ilon >= h->n_lon || t >= h->n_time)
+        return NAN;
+
+    size_t block = t / h->time_block;
+    size_t tile = (block * h->n_tiles_lat + ilat / h->tile) * h->n_tiles_lon + ilon / h->tile;
+    const gfloat *values = (const gfloat *)(cache->data + cache->index[tile]);
+
+    size_t cell = (ilat % h->tile) * h->tile + ilon % h->tile;
+    return values[((size_t)field * h->tile * h->tile + cell) * h->time_block + t % h->time_block];
+}
+
+/**
+ * Weather of every ground station over the time window, same result as
+ * load_turbulence_data() on the cache's source files.
+ *
+ * @return {gchar *ogs name : ogs_weather_data *}, owns its values.
+ *         NULL if the cache doesn't cover the window
+ */
+GHashTable *weather_cache_lookup(weather_cache_t *cache, GSList *OGS_list, gdouble start_time, gdouble end_time) {
+    const weather_cache_header *h = cache->header;
+    gdouble last_time = h->start_time + (h->n_time - 1) * h->time_step;
+
+    if (h->n_time == 0 || last_time < start_time || h->start_time > end_time)
+        return NULL;
+
+    //last step at or before the start to first step at or after the end
+    gdouble first = floor((start_time - h->start_time) / h->time_step + 1e-9);
+    gdouble last = ceil((end_time - h->start_time) / h->time_step - 1e-9);
+    size_t t0 = (size_t)CLAMP(first, 0, (gdouble)h->n_time - 1);
+    size_t t1 = (size_t)CLAMP(last, (gdouble)t0, (gdouble)h->n_time - 1);
+    size_t nt = t1 - t0 + 1;
+
+    grid_axes grid = {
+        .n_lat = h->n_lat,
+        .n_lon = h->n_lon,
+        .lat0 = h->lat0,
+        .dlat = h->dlat,
+        .lon0 = h->lon0,
+        .dlon = h->dlon
+    };
+
+    GHashTable *table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, ogs_weather_data_free);
+
+    for (GSList *ogs_elm = OGS_list; ogs_elm != NULL; ogs_elm = ogs_elm->next) {
+        qth_t *ogs = (qth_t *)ogs_elm->data;
+        grid_weights w = weather_grid_weights(&grid, ogs);
+
+        ogs_weather_data *entries = malloc(sizeof(ogs_weather_data));
+        entries->len = nt;
+        entries->start_time = h->start_time + t0 * h->time_step;
+        entries->time_step = h->time_step;
+        entries->vis = malloc(nt * sizeof(gdouble));
+        entries->cn2 = malloc(nt * sizeof(gdouble));
+
+        for (size_t t = 0; t < nt; t++) {
+            entries->vis[t] = 0;
+            entries->cn2[t] = 0;
+
+            for (guint k = 0; k < 4; k++) {
+                gfloat vis = weather_cache_value(cache, WEATHER_FIELD_VIS, w.corner[k].ilat, w.corner[k].ilon, t0 + t);
+                gfloat cn2 = weather_cache_value(cache, WEATHER_FIELD_CN2, w.corner[k].ilat, w.corner[k].ilon, t0 + t);
+
+                entries->vis[t] += w.weight[k] * (isnan(vis) ? SKR_DEFAULT_VISIBILITY : vis);
+                entries->cn2[t] += w.weight[k] * (isnan(cn2) ? SKR_DEFAULT_CN2 : cn2);
+            }
+        }
+
+        g_hash_table_insert(table, ogs->name, entries);
+    }
+
+    return table;
+}
+
+void weather_cache_close(weather_cache_t *cache) {
+    if (cache == NULL) return;
+
+    g_mapped_file_unref(cache->file);
+    free(cache);
+}
@@ -0,0 +1,82 @@
+#include <glib/gi18n.h>
+#include "calc-weather-data.h"
+
+#ifndef WEATHER_CACHE_H
+#define WEATHER_CACHE_H
+
+#define WEATHER_CACHE_MAGIC "SKRWTHR"    //7 chars and the terminator fill magic[8]
+#define WEATHER_CACHE_VERSION 1
+#define WEATHER_CACHE_TILE 32           //grid cells per tile side
+#define WEATHER_CACHE_TIME_BLOCK 24     //time steps per tile
+
+typedef enum {
+    WEATHER_FIELD_VIS = 0,              //visibility in km, NAN where the source had no value
+    WEATHER_FIELD_CN2,                  //path averaged Cn2
+    WEATHER_N_FIELDS
+} weather_field;
+
+/** \brief Source file a cache was converted from, a change in either marks the cache stale */
+typedef struct {
+    guint64 size;
+    gint64 mtime;
+} weather_cache_source;
+
+/**
+ * \brief Fixed size header at the start of a cache file. It is followed by the
+ * tile index, one guint64 file offset per tile ordered (block, tile lat,
+ * tile lon), then the tiles. Each tile holds gfloat values ordered
+ * [field][cell lat][cell lon][time], so the series of one cell inside a time
+ * block is contiguous. Edge tiles are padded with NAN.
+ *
+ * Values are stored in host byte order, the magic doubles as an endianness check.
+ */
+typedef struct {
+    gchar magic[8];
+    guint32 version;
+    guint32 tile;
+    guint32 time_block;
+    guint32 n_lat;
+    guint32 n_lon;
+    guint32 n_time;
+    guint32 n_tiles_lat;
+    guint32 n_tiles_lon;
+    guint32 n_blocks;
+    guint32 reserved;
+    gdouble lat0;                       //grid axes, same meaning as in grid_axes
+    gdouble dlat;
+    gdouble lon0;
+    gdouble dlon;
+    gdouble start_time;                 //julian date of time step 0
+    gdouble time_step;                  //days
+    gdouble ground_cn2;                 //Hufnagel-Valley parameters the Cn2 was derived with
+    gdouble thickness;
+    weather_cache_source sources[2];    //visibility file, pressure level file
+} weather_cache_header;
+
+/** \brief Read only view of a memory mapped cache file */
+typedef struct {
+    GMappedFile *file;
+    const weather_cache_header *header;
+    const guint64 *index;
+    const gchar *data;                  //start of the file, tile offsets are relative to it
+} weather_cache_t;
+
+typedef struct weather_cache_writer weather_cache_writer;
+
+gboolean weather_cache_stamp(const gchar *filepath, weather_cache_source *source);
+
+weather_cache_writer *weather_cache_writer_new(const gchar *cache_path, weather_cache_header *header);
+
+gboolean weather_cache_write_block(weather_cache_writer *writer, const gfloat *vis, const gfloat *cn2);
+
+gboolean weather_cache_writer_finish(weather_cache_writer *writer, gboolean keep);
+
+weather_cache_t *weather_cache_open(const gchar *cache_path, const gchar *visibility_filepath, const gchar *cn2_filepath);
+
+gfloat weather_cache_value(weather_cache_t *cache, weather_field field, size_t ilat, size_t ilon, size_t t);
+
+GHashTable *weather_cache_lookup(weather_cache_t *cache, GSList *OGS_list, gdouble start_time, gdouble end_time);
+
+void weather_cache_close(weather_cache_t *cache);
+
+#endif